@@ -0,0 +1,394 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <libexplain/closedir.h>
+#include <libexplain/fclose.h>
+#include <libexplain/fopen.h>
+#include <libexplain/getc.h>
+#include <libexplain/opendir.h>
+#include <libexplain/output.h>
+#include <libexplain/program_name.h>
+#include <libexplain/readdir.h>
+#include <libexplain/stat.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include <lib/rcstring/accumulator.h>
+
+#include <lib/batch.h>
+
+
+void
+batch_read_list(const rcstring &filename, rcstring_list &images)
+{
+    bool use_stdin = (filename == "-");
+    FILE *fp =
+        (use_stdin ? stdin : explain_fopen_or_die(filename.c_str(), "r"));
+    rcstring_accumulator line;
+    for (;;)
+    {
+        int c = explain_getc_or_die(fp);
+        if (c != EOF && c != '\n')
+        {
+            line.push_back(c);
+            continue;
+        }
+        rcstring name = line.mkstr().trim();
+        line.clear();
+        if (!name.empty() && name[0] != '#')
+            images.push_back(name);
+        if (c == EOF)
+            break;
+    }
+    if (!use_stdin)
+        explain_fclose_or_die(fp);
+}
+
+
+void
+batch_walk(const rcstring &path, rcstring_list &images)
+{
+    struct stat st;
+    explain_stat_or_die(path.c_str(), &st);
+    if (!S_ISDIR(st.st_mode))
+    {
+        images.push_back(path);
+        return;
+    }
+
+    std::vector<rcstring> names;
+    DIR *dp = explain_opendir_or_die(path.c_str());
+    for (;;)
+    {
+        dirent *dep = explain_readdir_or_die(dp);
+        if (!dep)
+            break;
+        rcstring name(dep->d_name);
+        if (name[0] == '.')
+            continue;
+        names.push_back(name);
+    }
+    explain_closedir_or_die(dp);
+    std::sort(names.begin(), names.end());
+
+    for (size_t j = 0; j < names.size(); ++j)
+    {
+        rcstring child = path + "/" + names[j];
+        explain_stat_or_die(child.c_str(), &st);
+        if (S_ISDIR(st.st_mode) || S_ISREG(st.st_mode))
+            batch_walk(child, images);
+    }
+}
+
+
+struct batch_job
+{
+    rcstring image;
+    bool done;
+    bool failed;
+    double seconds;
+    rcstring_list messages;
+    rcstring_list notes;
+    char *text;
+    size_t text_size;
+};
+
+
+struct batch_pool
+{
+    pthread_mutex_t lock;
+    std::vector<batch_job> jobs;
+    size_t next;
+    size_t next_to_report;
+    size_t failures;
+    batch_action_t action;
+    FILE *summary;
+};
+
+
+//
+// The batch_failure class is thrown when a disk image's action reports
+// a fatal error, to abandon that disk image rather than the whole batch.
+//
+class batch_failure { };
+
+
+//
+// The current_job variable is used to remember which job (if any) the
+// calling thread is working on, so that error messages can be
+// attributed to the right disk image.
+//
+static __thread batch_job *current_job;
+
+
+static void
+batch_message(explain_output_t *, const char *text)
+{
+    if (current_job)
+    {
+        current_job->messages.push_back(text);
+        return;
+    }
+    fprintf(stderr, "%s: %s\n", explain_program_name_get(), text);
+}
+
+
+//
+// When a job fails, the exception thrown here unwinds through
+// libexplain's C stack frames (explain_output_error_and_die and
+// friends) back to batch_worker.  That is safe because libexplain is
+// compiled with unwind tables and holds no locks or heap memory of its
+// own at that point; lib/meson.build refuses to configure against a
+// libexplain where this does not work.  Worker code reports system
+// call failures via lib/explain_mt.h, which serializes the formatting.
+//
+static void
+batch_exit(explain_output_t *, int status)
+{
+    if (current_job)
+        throw batch_failure();
+    exit(status);
+}
+
+
+static const explain_output_vtable_t batch_vtable =
+{
+    0, // destructor
+    batch_message,
+    batch_exit,
+    sizeof(explain_output_t)
+};
+
+
+void
+batch_note(const char *name, const rcstring &json)
+{
+    if (!current_job)
+        return;
+    current_job->notes.push_back
+    (
+        rcstring::printf("%s: %s", rcstring(name).quote_json().c_str(),
+            json.c_str())
+    );
+}
+
+
+static double
+now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec + ts.tv_nsec * 1e-9);
+}
+
+
+static void
+run_one(batch_job &job, batch_action_t action)
+{
+    job.text = 0;
+    job.text_size = 0;
+    FILE *fp = open_memstream(&job.text, &job.text_size);
+    if (!fp)
+    {
+        job.failed = true;
+        job.messages.push_back(rcstring::printf("open_memstream: %s",
+            strerror(errno)));
+        return;
+    }
+
+    current_job = &job;
+    double start = now();
+    try
+    {
+        action(job.image, fp);
+    }
+    catch (batch_failure &)
+    {
+        job.failed = true;
+    }
+    job.seconds = now() - start;
+    current_job = 0;
+    fclose(fp);
+}
+
+
+static void
+report(const batch_job &job, FILE *summary)
+{
+    if (job.text_size)
+        fwrite(job.text, 1, job.text_size, stdout);
+    if (!summary)
+    {
+        for (size_t j = 0; j < job.messages.size(); ++j)
+        {
+            fprintf(stderr, "%s: %s\n", explain_program_name_get(),
+                job.messages[j].c_str());
+        }
+        return;
+    }
+
+    rcstring_accumulator ac;
+    for (size_t j = 0; j < job.messages.size(); ++j)
+    {
+        if (j)
+            ac.push_back(", ");
+        ac.push_back(job.messages[j].quote_json());
+    }
+    rcstring_accumulator extra;
+    for (size_t j = 0; j < job.notes.size(); ++j)
+    {
+        extra.push_back(", ");
+        extra.push_back(job.notes[j]);
+    }
+    fprintf
+    (
+        summary,
+        "{\"image\": %s, \"status\": \"%s\", \"seconds\": %.3f, "
+            "\"messages\": [%s]%s}\n",
+        job.image.quote_json().c_str(),
+        (job.failed ? "failed" : "ok"),
+        job.seconds,
+        ac.mkstr().c_str(),
+        extra.mkstr().c_str()
+    );
+}
+
+
+static void *
+batch_worker(void *arg)
+{
+    batch_pool *pool = (batch_pool *)arg;
+    for (;;)
+    {
+        pthread_mutex_lock(&pool->lock);
+        size_t n = pool->next;
+        if (n < pool->jobs.size())
+            ++pool->next;
+        pthread_mutex_unlock(&pool->lock);
+        if (n >= pool->jobs.size())
+            return 0;
+
+        batch_job &job = pool->jobs[n];
+        run_one(job, pool->action);
+
+        //
+        // Report every job which is finished, and not preceded by one
+        // which isn't, so that the output comes out in order.
+        //
+        pthread_mutex_lock(&pool->lock);
+        job.done = true;
+        while
+        (
+            pool->next_to_report < pool->jobs.size()
+        &&
+            pool->jobs[pool->next_to_report].done
+        )
+        {
+            batch_job &rjob = pool->jobs[pool->next_to_report++];
+            report(rjob, pool->summary);
+            if (rjob.failed)
+                ++pool->failures;
+            free(rjob.text);
+            rjob.text = 0;
+            rjob.messages.clear();
+            rjob.notes.clear();
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+
+size_t
+batch_run(const rcstring_list &images, batch_action_t action, unsigned jobs,
+    FILE *summary)
+{
+#ifndef HAVE_EXPLAIN_UNWIND
+    //
+    // Without unwind tables in libexplain, batch_exit can't get a
+    // failed job out, see lib/meson.build.
+    //
+    explain_output_error_and_die
+    (
+        "batch mode is not available, libexplain was built without "
+        "unwind tables"
+    );
+#endif
+    if (jobs == 0)
+    {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        jobs = (ncpu > 0 ? ncpu : 1);
+    }
+    if (jobs > images.size())
+        jobs = images.size();
+
+    batch_pool pool;
+    pool.next = 0;
+    pool.next_to_report = 0;
+    pool.failures = 0;
+    pool.action = action;
+    pool.summary = summary;
+    pool.jobs.resize(images.size());
+    for (size_t j = 0; j < images.size(); ++j)
+    {
+        batch_job &job = pool.jobs[j];
+        job.image = images[j];
+        job.done = false;
+        job.failed = false;
+        job.seconds = 0;
+        job.text = 0;
+        job.text_size = 0;
+    }
+
+    //
+    // Route error messages to the job they belong to, and turn fatal
+    // errors into batch_failure exceptions, instead of exiting.
+    //
+    explain_output_register(explain_output_new(&batch_vtable));
+
+    //
+    // Start the threads.  This thread works too, so if a thread can't
+    // be started, the work still gets done.
+    //
+    pthread_mutex_init(&pool.lock, 0);
+    std::vector<pthread_t> threads;
+    for (unsigned j = 1; j < jobs; ++j)
+    {
+        pthread_t tid;
+        if (pthread_create(&tid, 0, batch_worker, &pool) != 0)
+            break;
+        threads.push_back(tid);
+    }
+    batch_worker(&pool);
+    for (size_t j = 0; j < threads.size(); ++j)
+        pthread_join(threads[j], 0);
+    pthread_mutex_destroy(&pool.lock);
+
+    explain_output_register(0);
+    fflush(stdout);
+    fflush(summary);
+    return pool.failures;
+}
@@ -0,0 +1,105 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#ifndef LIB_BATCH_H
+#define LIB_BATCH_H
+
+#include <cstdio>
+
+#include <lib/rcstring/list.h>
+
+/**
+  * The batch_action_t type is used to represent the work to be done
+  * on each disk image of a batch.  Errors are reported in the usual way
+  * (explain_output_error_and_die, and so on); the batch takes note of
+  * them, and carries on with the next disk image.
+  *
+  * @param image
+  *     The file name of the disk image.
+  * @param fp
+  *     Where to print any output.
+  */
+typedef void (*batch_action_t)(const rcstring &image, FILE *fp);
+
+/**
+  * The batch_read_list function is used to read a list of disk image
+  * file names, one per line.  Blank lines, and lines starting with a
+  * hash (#) character, are ignored.
+  *
+  * @param filename
+  *     The file to read, or "-" for the standard input.
+  * @param images
+  *     Where to put the disk image file names.
+  */
+void batch_read_list(const rcstring &filename, rcstring_list &images);
+
+/**
+  * The batch_walk function is used to find all of the files below the
+  * given path, in a predictable (sorted) order.  Names starting with a
+  * dot are skipped.
+  *
+  * @param path
+  *     A file, or a directory to be searched recursively.
+  * @param images
+  *     Where to put the names of the files found.
+  */
+void batch_walk(const rcstring &path, rcstring_list &images);
+
+/**
+  * The batch_run function is used to perform the same action on many
+  * disk images, several at a time.
+  *
+  * The output of each disk image is printed on the standard output as a
+  * whole, in the order the disk images were given, no matter which
+  * finishes first.  A summary line (JSON) for each disk image, giving
+  * its status, how long it took and any error messages, is printed on
+  * the summary stream, also in order.
+  *
+  * Batch mode is not available if libexplain was built without unwind
+  * tables (see lib/meson.build); it is a fatal error to call batch_run.
+  *
+  * @param images
+  *     The file names of the disk images.
+  * @param action
+  *     The action to perform on each disk image.
+  * @param jobs
+  *     The number of disk images to work on at once, or zero for one
+  *     per processor.
+  * @param summary
+  *     Where to print the summary lines, or NULL for no summary lines,
+  *     in which case any error messages are printed on the standard
+  *     error instead.
+  * @returns
+  *     the number of disk images which failed.
+  */
+size_t batch_run(const rcstring_list &images, batch_action_t action,
+    unsigned jobs, FILE *summary);
+
+/**
+  * The batch_note function may be called by a batch action to add a
+  * field to the summary line of the disk image it is working on.  It
+  * does nothing when called outside of a batch.
+  *
+  * @param name
+  *     The name of the field.
+  * @param json
+  *     The value of the field, already in JSON form.
+  */
+void batch_note(const char *name, const rcstring &json);
+
+#endif // LIB_BATCH_H
@@ -0,0 +1,222 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <libexplain/output.h>
+
+#include <lib/debug.h>
+#include <lib/dedup_store.h>
+#include <lib/explain_mt.h>
+#include <lib/fnv1a.h>
+#include <lib/statistics.h>
+
+
+dedup_store::~dedup_store()
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    if (index_fd >= 0)
+    {
+        // This also releases the lock.
+        close(index_fd);
+        index_fd = -1;
+    }
+    if (chunks_fd >= 0)
+    {
+        close(chunks_fd);
+        chunks_fd = -1;
+    }
+}
+
+
+dedup_store::dedup_store(const rcstring &a_dirname, bool a_writable) :
+    dirname(a_dirname),
+    writable(a_writable),
+    chunks_fd(-1),
+    index_fd(-1),
+    nchunks(0)
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    rcstring chunks_path = dirname + "/chunks";
+    if (!writable)
+    {
+        chunks_fd = explain_mt_open_or_die(chunks_path.c_str(), O_RDONLY, 0);
+        return;
+    }
+
+    struct stat st;
+    if (stat(dirname.c_str(), &st) < 0 && errno == ENOENT)
+        explain_mt_mkdir_or_die(dirname.c_str(), 0777);
+
+    //
+    // The lock is held on the index, for as long as the store is open,
+    // so that only one writer at a time appends chunks.  Readers do not
+    // need the lock, because nothing they can see ever changes.
+    //
+    rcstring index_path = dirname + "/index";
+    int mode = O_RDWR | O_CREAT;
+    index_fd = explain_mt_open_or_die(index_path.c_str(), mode, 0666);
+    explain_mt_flock_or_die(index_fd, LOCK_EX);
+    chunks_fd = explain_mt_open_or_die(chunks_path.c_str(), mode, 0666);
+    load_index();
+}
+
+
+dedup_store::pointer
+dedup_store::create(const rcstring &a_dirname, bool a_writable)
+{
+    return pointer(new dedup_store(a_dirname, a_writable));
+}
+
+
+static unsigned long long
+get_u64(const unsigned char *data)
+{
+    unsigned long long result = 0;
+    for (int j = 7; j >= 0; --j)
+        result = (result << 8) | data[j];
+    return result;
+}
+
+
+static void
+put_u64(unsigned char *data, unsigned long long value)
+{
+    for (int j = 0; j < 8; ++j)
+    {
+        data[j] = value;
+        value >>= 8;
+    }
+}
+
+
+void
+dedup_store::load_index(void)
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    struct stat st;
+    explain_mt_fstat_or_die(index_fd, &st);
+    size_t index_count = st.st_size / 8;
+    explain_mt_fstat_or_die(chunks_fd, &st);
+    size_t chunks_count = st.st_size / chunk_size;
+
+    //
+    // Each chunk is written before its index entry.  If an earlier
+    // writer was interrupted, there may be a chunk (or part of one)
+    // without an index entry, or part of an index entry; nothing refers
+    // to either of them, so they are discarded.
+    //
+    nchunks = (index_count < chunks_count ? index_count : chunks_count);
+    explain_mt_ftruncate_or_die(index_fd, (off_t)nchunks * 8);
+    explain_mt_ftruncate_or_die(chunks_fd, (off_t)nchunks * chunk_size);
+
+    std::vector<unsigned char> buffer((size_t)nchunks * 8);
+    if (!buffer.empty())
+        explain_mt_pread_or_die(index_fd, &buffer[0], buffer.size(), 0);
+    for (unsigned j = 0; j < nchunks; ++j)
+        by_hash.insert(by_hash_t::value_type(get_u64(&buffer[j * 8]), j));
+    DEBUG(1, "%u chunks", nchunks);
+}
+
+
+int
+dedup_store::read(unsigned chunk_number, unsigned offset, void *data,
+    size_t nbytes) const
+{
+    if (offset + nbytes > chunk_size)
+        return -EINVAL;
+    off_t pos = (off_t)chunk_number * chunk_size + offset;
+    statistics::add(statistics::image_reads);
+    ssize_t n = ::pread(chunks_fd, data, nbytes, pos);
+    if (n < 0)
+        return -errno;
+    if ((size_t)n != nbytes)
+    {
+        // The chunk ought to be there; the store has been damaged.
+        return -EIO;
+    }
+    statistics::add(statistics::image_read_bytes, nbytes);
+    return 0;
+}
+
+
+int
+dedup_store::get_backing_fd(unsigned chunk_number, unsigned offset,
+    off_t &pos) const
+{
+    pos = (off_t)chunk_number * chunk_size + offset;
+    return chunks_fd;
+}
+
+
+unsigned
+dedup_store::insert(const void *data)
+{
+    unsigned long long hash = fnv1a_64(data, chunk_size);
+    std::pair<by_hash_t::const_iterator, by_hash_t::const_iterator> range =
+        by_hash.equal_range(hash);
+    for (by_hash_t::const_iterator it = range.first; it != range.second; ++it)
+    {
+        //
+        // The hash only says the chunks may be the same; the data says
+        // whether they are.
+        //
+        unsigned char buffer[chunk_size];
+        explain_mt_pread_or_die
+        (
+            chunks_fd,
+            buffer,
+            chunk_size,
+            (off_t)it->second * chunk_size
+        );
+        if (0 == memcmp(buffer, data, chunk_size))
+            return it->second;
+    }
+
+    unsigned chunk_number = nchunks;
+    explain_mt_pwrite_or_die
+    (
+        chunks_fd,
+        data,
+        chunk_size,
+        (off_t)chunk_number * chunk_size
+    );
+    unsigned char entry[8];
+    put_u64(entry, hash);
+    explain_mt_pwrite_or_die(index_fd, entry, 8, (off_t)chunk_number * 8);
+    by_hash.insert(by_hash_t::value_type(hash, chunk_number));
+    ++nchunks;
+    return chunk_number;
+}
+
+
+void
+dedup_store::sync(void)
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    if (!writable)
+        return;
+    explain_mt_fsync_or_die(chunks_fd);
+    explain_mt_fsync_or_die(index_fd);
+}
@@ -0,0 +1,205 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#ifndef LIB_DEDUP_STORE_H
+#define LIB_DEDUP_STORE_H
+
+#include <map>
+#include <boost/shared_ptr.hpp>
+
+#include <lib/rcstring.h>
+
+/**
+  * The dedup_store class is used to represent a store of 512-byte
+  * chunks of disk image data, shared by many disk images, in which each
+  * distinct chunk is kept only once.  See sector_io_dedup for how disk
+  * images refer to the chunks.
+  *
+  * The store is a directory containing two files: "chunks" holds the
+  * chunks end to end, and "index" holds the 64-bit hash of each chunk,
+  * in the same order.  Chunks are only ever appended, so a chunk number,
+  * once given out, is good for as long as the store exists.
+  *
+  * Only one process at a time may add chunks to a store; any number
+  * may read it, even while chunks are being added.
+  */
+class dedup_store
+{
+public:
+    typedef boost::shared_ptr<dedup_store> pointer;
+
+    enum { chunk_size = 512 };
+
+    /**
+      * The destructor.
+      */
+    virtual ~dedup_store();
+
+private:
+    /**
+      * The constructor.  It is private on purpose, use the #create
+      * class method instead.
+      *
+      * @param dirname
+      *     The directory containing the store.
+      * @param writable
+      *     true if chunks are to be added to the store, false if it is
+      *     only to be read.
+      */
+    dedup_store(const rcstring &dirname, bool writable);
+
+public:
+    /**
+      * The create class method is used to create new dynamically
+      * allocated instances of this class.  When writable, the store is
+      * created if it does not already exist, and locked against other
+      * writers.  Errors are fatal.
+      *
+      * @param dirname
+      *     The directory containing the store.
+      * @param writable
+      *     true if chunks are to be added to the store, false if it is
+      *     only to be read.
+      */
+    static pointer create(const rcstring &dirname, bool writable);
+
+    /**
+      * The read method is used to read part of a chunk.
+      *
+      * @param chunk_number
+      *     The number of the chunk to read.
+      * @param offset
+      *     The offset within the chunk of the first byte to read.
+      * @param data
+      *     Where to put the data.
+      * @param nbytes
+      *     The number of bytes to read; offset + nbytes may not exceed
+      *     #chunk_size.
+      * @returns
+      *     zero on success, or -errno on error.
+      */
+    int read(unsigned chunk_number, unsigned offset, void *data,
+        size_t nbytes) const;
+
+    /**
+      * The get_backing_fd method is used to obtain the file, and the
+      * position within it, where part of a chunk is stored, so that
+      * it may be read directly (see sector_io::get_backing_fd).
+      *
+      * @param chunk_number
+      *     The number of the chunk of interest.
+      * @param offset
+      *     The offset within the chunk of the first byte of interest.
+      * @param pos
+      *     Where to put the position of the byte within the file.
+      * @returns
+      *     the file descriptor.
+      */
+    int get_backing_fd(unsigned chunk_number, unsigned offset, off_t &pos)
+        const;
+
+    /**
+      * The insert method is used to add a chunk to the store, unless an
+      * identical chunk is already there.  Errors are fatal.
+      *
+      * @param data
+      *     The #chunk_size bytes of the chunk.
+      * @returns
+      *     the number of the chunk with this content.
+      */
+    unsigned insert(const void *data);
+
+    /**
+      * The sync method is used to make sure all of the chunks added so
+      * far are on the disk, before anything refers to them.  Errors are
+      * fatal.
+      */
+    void sync(void);
+
+    /**
+      * The size method is used to obtain the number of chunks in the
+      * store.  Only meaningful for a writable store.
+      */
+    unsigned size(void) const { return nchunks; }
+
+private:
+    /**
+      * The dirname instance variable is used to remember the directory
+      * containing the store.
+      */
+    rcstring dirname;
+
+    /**
+      * The writable instance variable is used to remember whether or
+      * not chunks may be added to the store.
+      */
+    bool writable;
+
+    /**
+      * The chunks_fd instance variable is used to remember the file
+      * descriptor of the file holding the chunks.
+      */
+    int chunks_fd;
+
+    /**
+      * The index_fd instance variable is used to remember the file
+      * descriptor of the file holding the hashes, or -1 if the store
+      * is only being read.
+      */
+    int index_fd;
+
+    /**
+      * The nchunks instance variable is used to remember the number of
+      * chunks in the store (when writable).
+      */
+    unsigned nchunks;
+
+    typedef std::multimap<unsigned long long, unsigned> by_hash_t;
+
+    /**
+      * The by_hash instance variable is used to remember the chunk
+      * numbers of the chunks in the store, indexed by their hash (when
+      * writable).  Different chunks may have the same hash, so the
+      * content is always compared as well.
+      */
+    by_hash_t by_hash;
+
+    /**
+      * The load_index method is used to read the index of a writable
+      * store, and to discard any chunks which were written without
+      * their index entry (by a writer which was interrupted).
+      */
+    void load_index(void);
+
+    /**
+      * The default constructor.  Do not use.
+      */
+    dedup_store();
+
+    /**
+      * The copy constructor.  Do not use.
+      */
+    dedup_store(const dedup_store &);
+
+    /**
+      * The assignment operator.  Do not use.
+      */
+    dedup_store &operator=(const dedup_store &);
+};
+
+#endif // LIB_DEDUP_STORE_H
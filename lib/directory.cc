@@ -28,6 +28,7 @@
 #include <lib/directory/entry/file.h>
 #include <lib/directory/entry/volume_label.h>
 #include <lib/hexdump.h>
+#include <lib/statistics.h>
 
 
 directory::~directory()
@@ -42,9 +43,18 @@ directory::directory(
 ) :
     deeper(a_deeper),
     byte_sex(a_byte_sex),
+    journal_warned(false),
+    last_written_valid(false),
+    batch_depth(0),
+    batch_pending(false),
+    batch_aborted(false),
+    used_blocks(0),
+    largest_free(-1),
+    inode_number(2),
     text_on_the_fly_flag(false)
 {
     DEBUG(1, "%s", __PRETTY_FUNCTION__);
+    memset(fsck_errors, 0, sizeof(fsck_errors));
 }
 
 
@@ -53,6 +63,7 @@ directory::meta_read(concern_t concern_level)
 {
     DEBUG(1, "%s", __PRETTY_FUNCTION__);
     int number_of_errors = 0;
+    memset(fsck_errors, 0, sizeof(fsck_errors));
     unsigned char buffer[2048];
     int err = deeper->read(0x400, buffer, sizeof(buffer));
     if (err < 0)
@@ -82,7 +93,7 @@ directory::meta_read(concern_t concern_level)
     DEBUG(3, "data:\n%s", hexdump(bp, 26).c_str());
     volume_label = directory_entry_volume_label::create(this, bp, deeper);
     bp += 26;
-    number_of_errors += volume_label->fsck(concern_level);
+    fsck_errors[fsck_class_label] += volume_label->fsck(concern_level);
 
     //
     // Slurp all of the directory entries.
@@ -104,15 +115,24 @@ directory::meta_read(concern_t concern_level)
                 (long)fnum
             );
             volume_label->set_num_files(fnum);
-            ++number_of_errors;
+            ++fsck_errors[fsck_class_count];
             break;
         }
         directory_entry::pointer dep =
             directory_entry_file::create(this, bp, deeper);
         files.push_back(dep);
-        number_of_errors += dep->fsck(concern_level);
+        fsck_errors[fsck_class_entry] += dep->fsck(concern_level);
     }
 
+    //
+    // Look for a file relocation which was interrupted, and finish it
+    // (or undo it) before anything else looks at the file data.
+    //
+    err = journal_recover(concern_level);
+    if (err < 0)
+        return err;
+    fsck_errors[fsck_class_journal] += err;
+
     if (concern_level >= concern_check)
     {
         // Make sure all files are in block order.
@@ -130,7 +150,7 @@ directory::meta_read(concern_t concern_level)
         if (out_of_block_order)
         {
             explain_output_error("directory entries not in block order");
-            ++number_of_errors;
+            ++fsck_errors[fsck_class_order];
             // We always fix this error.
             files.sort_by_first_block();
         }
@@ -152,7 +172,7 @@ directory::meta_read(concern_t concern_level)
                     dep->get_first_block(),
                     block_num
                 );
-                ++number_of_errors;
+                ++fsck_errors[fsck_class_overlap];
                 if (concern_level >= concern_repair)
                     dep->fsck_first_block(block_num);
             }
@@ -174,13 +194,23 @@ directory::meta_read(concern_t concern_level)
                     dep->get_last_block(),
                     volume_label->get_eov_block()
                 );
-                ++number_of_errors;
+                ++fsck_errors[fsck_class_extent];
                 if (concern_level >= concern_repair)
                     dep->fsck_last_block(volume_label->get_eov_block());
             }
         }
     }
 
+    //
+    // Now that the extents are settled, initialize the free space
+    // counters.
+    //
+    used_blocks = calc_used_blocks();
+    largest_free = -1;
+
+    for (int j = 0; j < fsck_class_max; ++j)
+        number_of_errors += fsck_errors[j];
+
     //
     // If we repaired anything, write the meta data back out.
     //
@@ -255,11 +285,27 @@ directory::mkfs(const rcstring &volid, bool twin)
     assert(files.empty());
     volume_label =
         directory_entry_volume_label::create(this, name, deeper, twin);
+    used_blocks = calc_used_blocks();
+    largest_free = -1;
 }
 
 
 int
 directory::meta_sync(void)
+{
+    DEBUG(1, "%s", __PRETTY_FUNCTION__);
+    if (batch_depth > 0)
+    {
+        assert(!deeper->is_read_only());
+        batch_pending = true;
+        return 0;
+    }
+    return meta_sync_now();
+}
+
+
+int
+directory::meta_sync_now(void)
 {
     DEBUG(1, "%s", __PRETTY_FUNCTION__);
     if (deeper->is_read_only())
@@ -297,9 +343,23 @@ directory::meta_sync(void)
     }
 
     //
-    // Write the data to the disk.
+    // If the directory is the same as last time, there is no need to
+    // write it again.  This is common: many operations touch the
+    // directory only to find nothing in it has changed.  The sync is
+    // still needed, for the sake of the file data.
     //
     assert(bp < buffer + sizeof(buffer));
+    statistics::add(statistics::meta_syncs);
+    if (last_written_valid && !memcmp(buffer, last_written, sizeof(buffer)))
+    {
+        statistics::add(statistics::meta_syncs_avoided);
+        return deeper->sync();
+    }
+
+    //
+    // Write the data to the disk.
+    //
+    last_written_valid = false;
     int erk = deeper->write(0x400, buffer, sizeof(buffer));
     if (erk < 0)
         return erk;
@@ -317,6 +377,14 @@ directory::meta_sync(void)
         if (erk < 0)
             return erk;
     }
+    memcpy(last_written, buffer, sizeof(buffer));
+    last_written_valid = true;
+
+    //
+    // A batch in progress can now only be rolled back as far as this.
+    //
+    if (batch_depth > 0)
+        batch_snapshot();
 
     //
     // Make sure it all arrives on the medium.
@@ -351,6 +419,8 @@ directory::add_new_file(directory_entry::pointer dep)
     assert(files.size() < volume_label->maximum_directory_entries());
     volume_label->update_timestamp();
     files.push_back(dep);
+    used_blocks += dep->size_in_blocks();
+    largest_free = -1;
     return meta_sync();
 }
 
@@ -360,6 +430,8 @@ directory::delete_existing_file(directory_entry *dep)
 {
     DEBUG(1, "%s", __PRETTY_FUNCTION__);
     assert(!deeper->is_read_only());
+    used_blocks -= dep->size_in_blocks();
+    largest_free = -1;
     files.erase(dep);
     volume_label->update_timestamp();
 }
@@ -410,7 +482,20 @@ directory::move_gap_after(directory_entry *dep)
     assert(idx != (size_t)(-1));
     unsigned low_block = volume_label->get_last_block();
     unsigned high_block = volume_label->get_eov_block();
-    bool changed = false;
+    largest_free = -1;
+
+    //
+    // It is entirely possible that nothing will change, because this
+    // method will be called each time we are asked to write data to a
+    // file, and it will probably (not always, but probably) be the same
+    // file as the last time.
+    //
+    // Each time a file is actually moved, the directory is written
+    // before the next file is moved, and only then is the journal
+    // record discarded.  That way the directory on the medium always
+    // describes where the data really is, apart from the one move the
+    // journal knows about.
+    //
 
     // Move stuff down
     for (size_t j = 0; j <= idx; ++j)
@@ -420,7 +505,14 @@ directory::move_gap_after(directory_entry *dep)
         if (err < 0)
             return err;
         if (err > 0)
-            changed = true;
+        {
+            err = meta_sync_now();
+            if (err < 0)
+                return err;
+            err = get_journal()->commit();
+            if (err < 0)
+                return err;
+        }
         low_block = mdep->get_last_block();
     }
 
@@ -432,22 +524,22 @@ directory::move_gap_after(directory_entry *dep)
         if (err < 0)
             return err;
         if (err > 0)
-            changed = true;
+        {
+            err = meta_sync_now();
+            if (err < 0)
+                return err;
+            err = get_journal()->commit();
+            if (err < 0)
+                return err;
+        }
         high_block = mdep->get_first_block();
     }
 
     //
-    // It is entirely possible that nothing has changed, because this
-    // method will be called each time we are asked to write data to a
-    // file, and it will probably (not always, but probably) be the same
-    // file as the last time.
+    // All of the files are now packed together, either side of the
+    // gap, so the gap is the only free extent.
     //
-    if (changed)
-    {
-        int err = meta_sync();
-        if (err < 0)
-            return err;
-    }
+    largest_free = high_block - low_block;
 
     // Let them know how big the gap is.
     return (high_block - low_block);
@@ -498,6 +590,69 @@ directory::calc_used_blocks(void)
 }
 
 
+int
+directory::calc_largest_free(void)
+    const
+{
+    int largest = 0;
+    int block_num = volume_label->get_last_block();
+    for (size_t j = 0; j < files.size(); ++j)
+    {
+        directory_entry::pointer dep = files[j];
+        int gap = dep->get_first_block() - block_num;
+        if (largest < gap)
+            largest = gap;
+        block_num = dep->get_last_block();
+    }
+    int gap = volume_label->get_eov_block() - block_num;
+    if (largest < gap)
+        largest = gap;
+    return largest;
+}
+
+
+int
+directory::largest_free_extent(void)
+{
+    if (largest_free < 0)
+        largest_free = calc_largest_free();
+    return largest_free;
+}
+
+
+void
+directory::extent_changed(directory_entry *dep, int old_num_blocks)
+{
+    int delta = dep->size_in_blocks() - old_num_blocks;
+    if (delta == 0)
+        return;
+    used_blocks += delta;
+    if (largest_free < 0)
+        return;
+
+    //
+    // The entry grew or shrank into the gap immediately after it.
+    // A gap growing is easy to account for; a gap shrinking only
+    // matters if it could have been the largest one.
+    //
+    int gap = sizeof_gap_after(dep);
+    if (delta < 0)
+    {
+        if (largest_free < gap)
+            largest_free = gap;
+    }
+    else if (gap + delta >= largest_free)
+        largest_free = -1;
+}
+
+
+ino_t
+directory::next_inode_number(void)
+{
+    return ++inode_number;
+}
+
+
 int
 directory::statfs(struct statvfs *st)
 {
@@ -506,7 +661,7 @@ directory::statfs(struct statvfs *st)
     st->f_bsize = 512;
     st->f_frsize = st->f_bsize;
     st->f_blocks = volume_label->get_eov_block();
-    st->f_bfree = st->f_blocks - calc_used_blocks();
+    st->f_bfree = st->f_blocks - used_blocks;
     st->f_bavail = st->f_bfree;
     st->f_files = volume_label->maximum_directory_entries();
     st->f_ffree = st->f_files - files.size();
@@ -528,6 +683,32 @@ directory::get_volume_name(void)
 }
 
 
+void
+directory::convert_text_on_the_fly(void)
+{
+    DEBUG(1, "%s", __PRETTY_FUNCTION__);
+    if (text_on_the_fly_flag)
+        return;
+    text_on_the_fly_flag = true;
+
+    //
+    // The directory entries were created by meta_read, before we knew
+    // text files were to be translated.  Re-create the text file
+    // entries, so that they are translated too.
+    //
+    for (size_t j = 0; j < files.size(); ++j)
+    {
+        directory_entry::pointer dep = files[j];
+        if (!dep->is_text_kind())
+            continue;
+        unsigned char data[26];
+        memset(data, 0, sizeof(data));
+        dep->meta_write(data);
+        files.replace(j, directory_entry_file::create(this, data, deeper));
+    }
+}
+
+
 int
 directory::wipe_unused(void)
 {
@@ -541,8 +722,12 @@ directory::wipe_unused(void)
         assert(!"can't wipe unused from read-only disk image");
         return -EROFS;
     }
-    char zero[512];
-    memset(zero, 0, sizeof(zero));
+
+    //
+    // Zero each gap between files as a single range, rather than
+    // block by block.  The sector I/O layer is able to do this with
+    // large writes, or by punching holes in the disk image file.
+    //
     int curblock = volume_label->size_in_blocks();
     for (size_t j = 0; j < files.size(); ++j)
     {
@@ -550,37 +735,38 @@ directory::wipe_unused(void)
 
         // wipe unallocated blocks between the last file and this file
         int first_block = fp->get_first_block();
-        while (curblock < first_block)
+        if (curblock < first_block)
         {
-            deeper->write(curblock << 9, zero, sizeof(zero));
-            ++curblock;
-        }
-
-        // within the last block of the file, wipe any unused bytes
-        unsigned partial = fp->get_size_in_bytes() & 511;
-        if (partial)
-        {
-            unsigned blknum = curblock + fp->size_in_blocks() - 1;
-            unsigned addr = (blknum << 9) + partial;
-            unsigned tail_size = 512 - partial;
-            deeper->write(addr, zero, tail_size);
+            int err =
+                deeper->write_zero
+                (
+                    (off_t)curblock << 9,
+                    (size_t)(first_block - curblock) << 9
+                );
+            if (err < 0)
+                return err;
         }
 
-        // FIXME: within code files, the UCSD native compiler does not
-        // bother to make sure unused bytes in the files are reset to
-        // zero.  The result is that random memory from the cmpilation
-        // is present, sometime as source code.  We should zero the tail
-        // ends of each codefile segment, as well.
+        // wipe the unused parts of the file's own extent
+        int err = fp->wipe_unused();
+        if (err < 0)
+            return err;
 
-        curblock += fp->size_in_blocks();
+        curblock = fp->get_last_block();
     }
     int high_block = volume_label->get_eov_block();
-    while (curblock < high_block)
+    if (curblock < high_block)
     {
-        deeper->write(curblock << 9, zero, sizeof(zero));
-        ++curblock;
+        int err =
+            deeper->write_zero
+            (
+                (off_t)curblock << 9,
+                (size_t)(high_block - curblock) << 9
+            );
+        if (err < 0)
+            return err;
     }
-    return 0;
+    return deeper->sync();
 }
 
 
@@ -19,10 +19,15 @@
 #ifndef LIB_DIRECTORY_H
 #define LIB_DIRECTORY_H
 
+#include <cstdio>
+#include <ctime>
+#include <vector>
+
 #include <lib/byte_sex.h>
 #include <lib/concern.h>
 #include <lib/directory/entry/list.h>
 #include <lib/directory/entry/volume_label.h>
+#include <lib/directory/journal.h>
 #include <lib/rcstring.h>
 #include <lib/sector_io.h>
 
@@ -116,11 +121,76 @@ public:
       * in the directory) to ensure it has been written to the disk
       * medium.
       *
+      * Within a batch (see #begin_batch) it only makes a note that the
+      * directory needs to be written, and the directory is written once,
+      * when the batch is committed.
+      *
       * @returns
       *     zero for success, or -errno on error.
       */
     int meta_sync(void);
 
+    /**
+      * The begin_batch method is used to start a batch of changes to
+      * the directory.  Until the batch is committed, changes are only
+      * made in memory, rather than writing the directory (and syncing
+      * the medium) after each one.  This makes operations on many files
+      * much faster.
+      *
+      * File relocations are the exception: the directory is always
+      * written after each file is moved, so that the intent journal
+      * can be relied upon.
+      *
+      * Batches may be nested; only the outermost batch writes the
+      * directory.  Use the #batch class, rather than calling this
+      * method directly, to be sure the batch is finished.
+      */
+    void begin_batch(void);
+
+    /**
+      * The commit_batch method is used to finish a batch of changes to
+      * the directory, writing the directory if anything changed.  If
+      * the directory can not be written, or the batch was abandoned
+      * (see #abort_batch) the changes are rolled back, in memory, to
+      * the directory most recently written to the medium.
+      *
+      * @returns
+      *     zero for success, or -errno on error.
+      */
+    int commit_batch(void);
+
+    /**
+      * The abort_batch method is used to abandon a batch of changes to
+      * the directory.  The changes are rolled back, in memory, to the
+      * directory most recently written to the medium, when the
+      * outermost batch finishes.
+      *
+      * Note that file data already written is not restored; the
+      * directory just no longer refers to it.
+      */
+    void abort_batch(void);
+
+    /**
+      * The batch class is used to hold a batch of changes to a
+      * directory open (see #begin_batch) for the lifetime of the batch
+      * object.  The batch must be committed explicitly; if it is
+      * destroyed first (for example, while an exception is being
+      * thrown) it is abandoned.
+      */
+    class batch
+    {
+    public:
+        batch(directory &a_dir) : dir(a_dir), done(false)
+            { dir.begin_batch(); }
+        ~batch() { if (!done) dir.abort_batch(); }
+        int commit(void) { done = true; return dir.commit_batch(); }
+    private:
+        directory &dir;
+        bool done;
+        batch(const batch &);
+        batch &operator=(const batch &);
+    };
+
     /**
       * The meta_read method is used to read the volume meta-data (the
       * volume directory) from the medium and into the instance variables.
@@ -157,6 +227,50 @@ public:
       */
     int add_new_file(directory_entry::pointer dep);
 
+    /**
+      * The new_file struct is used to describe a file to be added to
+      * the volume by the #add_new_files method.
+      */
+    struct new_file
+    {
+        /**
+          * The name of the file.
+          */
+        rcstring name;
+
+        /**
+          * The contents of the file, exactly as they are to appear on
+          * the medium (text files must already be encoded).
+          */
+        std::vector<unsigned char> data;
+
+        /**
+          * The time the file was last modified.
+          */
+        time_t mtime;
+    };
+
+    typedef std::vector<new_file> new_file_list;
+
+    /**
+      * The add_new_files method is used to add many files to the volume
+      * at once.  Files of the same name are replaced.
+      *
+      * Rather than growing each file in turn (possibly moving other
+      * files out of the way, every time) the new files are laid out end
+      * to end after the last file on the volume, their data is written
+      * in a single sequential pass, and the directory is written once,
+      * at the end.  If the free space is not all at the end of the
+      * volume, the volume is crunched first.
+      *
+      * @param list
+      *     The files to add.
+      * @returns
+      *     zero on success, or -errno on error.  If there is not
+      *     enough room for all of the files, none of them are added.
+      */
+    int add_new_files(const new_file_list &list);
+
     /**
       * The delete_exiting_file method is used to delete a file from the
       * volume, and release the data blocks being used.
@@ -219,6 +333,30 @@ public:
       */
     int move_gap_after(directory_entry *dep);
 
+    /**
+      * The relocate_extent method is used to move the data blocks of a
+      * file to another location on the medium.  The move is recorded
+      * in an intent journal as it progresses, so that if it is
+      * interrupted it can be rolled forward (or back) the next time
+      * the volume is opened read-write.
+      *
+      * The journal record is discarded by the #move_gap_after method,
+      * once the directory reflecting the new location has been written.
+      *
+      * @param name
+      *     The name of the file being moved.
+      * @param from_block
+      *     The present first block of the file.
+      * @param to_block
+      *     The new first block of the file.
+      * @param num_blocks
+      *     The size of the file, in blocks.
+      * @returns
+      *     zero on success, or -errno on error.
+      */
+    int relocate_extent(const rcstring &name, unsigned from_block,
+        unsigned to_block, unsigned num_blocks);
+
     /**
       * The sizeof_gap_after method is used to determine how many blocks
       * are available beyond the end of the file's allocated extent.
@@ -233,13 +371,50 @@ public:
     /**
       * Get file system statistics
       *
-      * The 'f_type' and 'f_fsid' fields are ignored
+      * The 'f_type' and 'f_fsid' fields are ignored.  This method is
+      * called often (df(1) and file managers poll it), so it uses the
+      * incrementally maintained block counters, rather than walking
+      * the directory.
       *
       * @returns
       *     zero on success, -errno on error.
       */
     int statfs(struct statvfs *st);
 
+    /**
+      * The largest_free_extent method is used to obtain the size of
+      * the largest contiguous run of unused blocks.  The UCSD p-System
+      * itself (unlike this file system) never moves files, so this is
+      * the largest file it is able to write.
+      *
+      * @returns
+      *     the number of blocks
+      */
+    int largest_free_extent(void);
+
+    /**
+      * The extent_changed method is used by directory entries to tell
+      * the directory that the number of blocks allocated to the entry
+      * has changed, so that the free space counters may be kept up to
+      * date.  It must be called after the entry has been updated.
+      *
+      * @param dep
+      *     The directory entry that changed.
+      * @param old_num_blocks
+      *     The number of blocks the entry used before the change.
+      */
+    void extent_changed(directory_entry *dep, int old_num_blocks);
+
+    /**
+      * The next_inode_number method is used by directory entries to
+      * obtain an inode number when they are created.  Inode numbers are
+      * unique within the volume, and stay the same when a file grows,
+      * shrinks or moves.  Files are numbered in directory order when
+      * the volume is read, so the numbers are the same from one mount
+      * to the next, unless the directory changes in between.
+      */
+    ino_t next_inode_number(void);
+
     /**
       * The factor class method is used to open the disk image a file
       * and figure out how to access its contents.
@@ -261,6 +436,40 @@ public:
     static directory *factory(const rcstring &filaname, bool read_only = false,
         concern_t concern = concern_blithe);
 
+    /**
+      * The try_factory class method is used to open the disk image in
+      * a file, like the factory class method, except that a file which
+      * can not be opened, or does not contain a UCSD p-System volume,
+      * is reported to the caller, rather than being a fatal error.
+      * This is for programs which look at many files, some of which
+      * may not be disk images.
+      *
+      * @param filename
+      *     The file name of the file which may contain a UCSD p-System
+      *     filesystem disk image.
+      * @param read_only
+      *     True if the disk image is to be opened read-only.
+      * @param interleave
+      *     The interleaving of the disk image, as understood by the
+      *     sector_io::interleave_factory class method.  If it is empty,
+      *     the disk image is sniffed (see sector_io::guess_interleaving)
+      *     and the interleaving found is put here, so that the caller
+      *     may skip the sniffing next time.
+      * @param concern
+      *     The level of concern to display about the data integrity of
+      *     the disk image.  Defaults to "blithe" meaning no checking.
+      * @returns
+      *     A pointer to a dynamically allocated directory, or NULL if
+      *     the file is not a disk image.  Use the delete operator when
+      *     you are done with it.
+      *
+      * @note
+      *     Disk images in the IMD and TD0 formats are only checked for
+      *     their magic numbers; a corrupt one is still a fatal error.
+      */
+    static directory *try_factory(const rcstring &filename, bool read_only,
+        rcstring &interleave, concern_t concern = concern_blithe);
+
     enum sort_by_t
     {
         sort_by_block,
@@ -272,15 +481,17 @@ public:
 
     /**
       * The print_listing method is used to print a directory listing,
-      * independent of mounting the file system.  The listing is printed
-      * on the standard output stream.
+      * independent of mounting the file system.
       *
       * @param verbose
       *     Whether or not to issue a long (verbose) listing.
       * @param sort_by
       *     What criterion to sort the entries by.
+      * @param fp
+      *     The stream to print the listing on.
       */
-    void print_listing(bool verbose = false, sort_by_t sort_by = sort_by_block);
+    void print_listing(bool verbose = false, sort_by_t sort_by = sort_by_block,
+        FILE *fp = stdout);
 
     /**
       * The get_volume_name method is used to obtain the name of the
@@ -291,9 +502,10 @@ public:
     /**
       * The convert_text_on_the_fly method is used to enable the
       * conversion of text files between Unix and UCSD formats
-      * on-the-fly.
+      * on-the-fly.  Text files already in the directory are converted,
+      * too.
       */
-    void convert_text_on_the_fly(void) { text_on_the_fly_flag = true; }
+    void convert_text_on_the_fly(void);
 
     /**
       * The text_on_the_fly method is used to determine whether or not
@@ -314,6 +526,12 @@ public:
       * accounted for in the directory, wiping any "left over" content.
       * Not only is this more secure (things you didn't intent to stay
       * on this disk don't) but this disk images compress better, too.
+      *
+      * The unused tail of each file's last block is also wiped, as are
+      * the unused tails of code segments within code files.
+      *
+      * @returns
+      *     zero on success, or -errno on error.
       */
     int wipe_unused(void);
 
@@ -344,6 +562,58 @@ public:
       */
     bool check_for_system_files(void);
 
+    /**
+      * The fsck_class_t type is used to represent the different classes
+      * of format error found by the #meta_read and #fsck_deep methods.
+      */
+    enum fsck_class_t
+    {
+        fsck_class_label,
+        fsck_class_entry,
+        fsck_class_count,
+        fsck_class_order,
+        fsck_class_overlap,
+        fsck_class_extent,
+        fsck_class_journal,
+        fsck_class_code,
+        fsck_class_text,
+        fsck_class_max
+    };
+
+    /**
+      * The fsck_class_name class method is used to obtain a short name
+      * for a class of format error, suitable for use in reports.
+      *
+      * @param which
+      *     The class of error of interest.
+      */
+    static const char *fsck_class_name(fsck_class_t which);
+
+    /**
+      * The fsck_deep method is used to check the contents of the files
+      * in the volume, not just the directory: the segment dictionaries
+      * of code files, and the page structure of text files.  Nothing is
+      * repaired.  Each file is read once, in block order, several files
+      * at a time.  Problems are reported in block order.
+      *
+      * @param jobs
+      *     The number of files to check at once, or zero for one per
+      *     processor.
+      * @returns
+      *     the number of problems found.
+      */
+    int fsck_deep(unsigned jobs = 1);
+
+    /**
+      * The get_fsck_errors method is used to obtain the number of format
+      * errors of the given class found when the directory was read, or
+      * by the #fsck_deep method.
+      *
+      * @param which
+      *     The class of error of interest.
+      */
+    int get_fsck_errors(fsck_class_t which) const;
+
 private:
     /**
       * The deeper instance variable is used to remember the sector I/O
@@ -370,12 +640,149 @@ private:
     directory_entry_list files;
 
     /**
-      * The calc_used_blocks method is used to calculate how many blocks
-      * are in use at present.  This method is used by the statfs
+      * The journal instance variable is used to remember the intent
+      * journal used to make file relocations crash-safe.  Access it via
+      * the #get_journal method.
+      */
+    directory_journal::pointer journal;
+
+    /**
+      * The journal_warned instance variable is used to remember whether
+      * or not we have already warned that the journal could not be
+      * written.
+      */
+    bool journal_warned;
+
+    /**
+      * The last_written instance variable is used to remember the
+      * directory blocks most recently written by the #meta_sync method,
+      * so that writing them again, unchanged, can be skipped.
+      */
+    unsigned char last_written[2048];
+
+    /**
+      * The last_written_valid instance variable is used to remember
+      * whether the #last_written instance variable holds anything yet.
+      */
+    bool last_written_valid;
+
+    /**
+      * The batch_depth instance variable is used to remember how many
+      * batches (see #begin_batch) are in progress.
+      */
+    int batch_depth;
+
+    /**
+      * The batch_pending instance variable is used to remember whether
+      * or not the directory has changed since the batch began, and so
+      * needs to be written when it is committed.
+      */
+    bool batch_pending;
+
+    /**
+      * The batch_aborted instance variable is used to remember whether
+      * or not the batch in progress has been abandoned.
+      */
+    bool batch_aborted;
+
+    /**
+      * The batch_files instance variable is used to remember the
+      * directory entries as they were when the directory was last
+      * written, so that a batch can be rolled back.
+      */
+    std::vector<directory_entry::pointer> batch_files;
+
+    /**
+      * The batch_meta instance variable is used to remember the on-disk
+      * form of the volume label and the directory entries (the same
+      * order as #batch_files) when the directory was last written, so
+      * that a batch can be rolled back.
+      */
+    std::vector<unsigned char> batch_meta;
+
+    /**
+      * The batch_snapshot method is used to remember the directory as
+      * it is now, to be able to roll back to it later.
+      */
+    void batch_snapshot(void);
+
+    /**
+      * The batch_rollback method is used to restore the directory, in
+      * memory, to the state remembered by the #batch_snapshot method.
+      */
+    void batch_rollback(void);
+
+    /**
+      * The meta_sync_now method is used to write the directory to the
+      * medium, even within a batch.  It is the heart of the #meta_sync
       * method.
+      *
+      * @returns
+      *     zero for success, or -errno on error.
+      */
+    int meta_sync_now(void);
+
+    /**
+      * The get_journal method is used to obtain the intent journal for
+      * this volume, creating it if necessary.
+      */
+    directory_journal::pointer get_journal(void);
+
+    /**
+      * The journal_recover method is used by the #meta_read method to
+      * look for a relocation which was interrupted, and roll it forward
+      * or back.
+      *
+      * @param concern_level
+      *     The level of concern to display about the data integrity of
+      *     the disk image.
+      * @returns
+      *     the number of errors found, or -errno on error.
+      */
+    int journal_recover(concern_t concern_level);
+
+    /**
+      * The calc_used_blocks method is used to calculate how many blocks
+      * are in use at present, by walking the directory.  It is used to
+      * (re)initialize the #used_blocks instance variable.
       */
     int calc_used_blocks(void) const;
 
+    /**
+      * The calc_largest_free method is used to calculate the size of
+      * the largest gap between files, by walking the directory.
+      */
+    int calc_largest_free(void) const;
+
+    /**
+      * The used_blocks instance variable is used to remember how many
+      * blocks are in use, including the volume label.  It is set when
+      * the directory is read, and adjusted as entries come and go and
+      * change size.
+      */
+    int used_blocks;
+
+    /**
+      * The largest_free instance variable is used to remember the size
+      * of the largest contiguous run of unused blocks, or -1 if it must
+      * be recalculated.  It is adjusted when that can be done cheaply,
+      * and otherwise invalidated.
+      */
+    int largest_free;
+
+    /**
+      * The inode_number instance variable is used to remember the
+      * inode number most recently handed out by #next_inode_number.
+      * The volume label is inode 2, so files start from 3.
+      */
+    ino_t inode_number;
+
+    /**
+      * The fsck_errors instance variable is used to remember how many
+      * format errors of each class were found by the #meta_read method.
+      */
+    int fsck_errors[fsck_class_max];
+
     /**
       * The text_on_the_fly_flag instance variable is used to remember
       * whether or not text files are to be converted to and from Unix
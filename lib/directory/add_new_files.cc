@@ -0,0 +1,207 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <map>
+
+#include <lib/debug.h>
+#include <lib/directory.h>
+#include <lib/directory/entry/file.h>
+
+
+int
+directory::add_new_files(const new_file_list &list)
+{
+    DEBUG(1, "%s", __PRETTY_FUNCTION__);
+    if (deeper->is_read_only())
+    {
+        //
+        // All read-only errors should be caught long before this.
+        // It's too late to undo it if you get to here.
+        //
+        assert(0);
+        return -EROFS;
+    }
+
+    //
+    // If the same name is given more than once, the last one wins,
+    // exactly as if they had been added one at a time.
+    //
+    std::map<rcstring, size_t> by_name;
+    for (size_t j = 0; j < list.size(); ++j)
+    {
+        rcstring name = list[j].name.upcase().substring(0, 15);
+        if (name.empty())
+            return -EINVAL;
+        by_name[name] = j;
+    }
+    std::vector<size_t> order;
+    for (size_t j = 0; j < list.size(); ++j)
+    {
+        rcstring name = list[j].name.upcase().substring(0, 15);
+        if (by_name[name] == j)
+            order.push_back(j);
+    }
+
+    //
+    // Make sure everything will fit, before changing anything.
+    // Files being replaced give back their space, and their
+    // directory entries.
+    //
+    std::vector<directory_entry::pointer> replaced;
+    int replaced_blocks = 0;
+    int needed_blocks = 0;
+    for (size_t j = 0; j < order.size(); ++j)
+    {
+        const new_file &nf = list[order[j]];
+        directory_entry::pointer dep = find(nf.name.upcase());
+        if (dep)
+        {
+            replaced.push_back(dep);
+            replaced_blocks += dep->size_in_blocks();
+        }
+        needed_blocks += (nf.data.size() + 511) >> 9;
+    }
+    if
+    (
+        files.size() - replaced.size() + order.size()
+    >
+        volume_label->maximum_directory_entries()
+    )
+        return -ENOSPC;
+    int free_blocks =
+        volume_label->get_eov_block() - (used_blocks - replaced_blocks);
+    if (needed_blocks > free_blocks)
+        return -ENOSPC;
+
+    //
+    // The new files go end to end after the last file.  If the free
+    // space isn't all there, crunch the volume first, once, rather than
+    // moving files around for each new file in turn.
+    //
+    // Crunching writes the directory, so do it while the files being
+    // replaced are still in it, if that makes enough room.  That way
+    // the medium goes on describing the old files until the new data
+    // is in place.
+    //
+    int first_block = first_empty_block();
+    if
+    (
+        needed_blocks > volume_label->get_eov_block() - first_block
+    &&
+        needed_blocks <= volume_label->get_eov_block() - used_blocks
+    )
+    {
+        int err = crunch();
+        if (err < 0)
+            return err;
+    }
+
+    //
+    // Forget the files being replaced.  This only happens in memory;
+    // the medium still describes them until the directory is written.
+    //
+    for (size_t j = 0; j < replaced.size(); ++j)
+        delete_existing_file(replaced[j]);
+
+    //
+    // If the new files only fit in the space of the files they
+    // replace, crunch again now that they are gone.  This writes the
+    // directory without the old files before the new data is written;
+    // there is no safer order, because the new data overwrites the old.
+    //
+    first_block = first_empty_block();
+    if (needed_blocks > volume_label->get_eov_block() - first_block)
+    {
+        int err = crunch();
+        if (err < 0)
+            return err;
+        first_block = first_empty_block();
+        assert(needed_blocks <= volume_label->get_eov_block() - first_block);
+    }
+
+    //
+    // Write all of the data in one sequential pass.  The unused tail
+    // of each file's last block is written as zero, so that no stale
+    // data is left there.
+    //
+    if (needed_blocks > 0)
+    {
+        std::vector<unsigned char> buffer((size_t)needed_blocks << 9);
+        size_t pos = 0;
+        for (size_t j = 0; j < order.size(); ++j)
+        {
+            const new_file &nf = list[order[j]];
+            if (!nf.data.empty())
+                memcpy(&buffer[pos], &nf.data[0], nf.data.size());
+            pos += ((nf.data.size() + 511) >> 9) << 9;
+        }
+        int err = deeper->write((off_t)first_block << 9, &buffer[0],
+            buffer.size());
+        if (err < 0)
+            return err;
+    }
+
+    //
+    // Now add the directory entries, and write the directory, once.
+    //
+    int block = first_block;
+    for (size_t j = 0; j < order.size(); ++j)
+    {
+        const new_file &nf = list[order[j]];
+        rcstring name = nf.name.upcase();
+        int num_blocks = (nf.data.size() + 511) >> 9;
+        directory_entry::pointer dep =
+            directory_entry_file::create
+            (
+                this,
+                name,
+                directory_entry::dfkind_from_extension(name),
+                block,
+                num_blocks,
+                deeper
+            );
+        struct timespec tv[2];
+        tv[0].tv_sec = nf.mtime;
+        tv[0].tv_nsec = 0;
+        tv[1] = tv[0];
+        dep->utime_ns(tv);
+
+        //
+        // The entry was created with whole blocks.  Set the number of
+        // bytes in the last block by way of its encoded form, the same
+        // way the directory is read from the medium.
+        //
+        unsigned char data[26];
+        memset(data, 0, sizeof(data));
+        dep->meta_write(data);
+        int last_byte = nf.data.size() & 511;
+        put_word(data + 22, (last_byte ? last_byte : 512));
+        dep = directory_entry_file::create(this, data, deeper);
+
+        files.push_back(dep);
+        used_blocks += num_blocks;
+        block += num_blocks;
+    }
+    largest_free = -1;
+    volume_label->update_timestamp();
+    return meta_sync();
+}
@@ -0,0 +1,122 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cassert>
+#include <cerrno>
+
+#include <lib/debug.h>
+#include <lib/directory.h>
+
+
+void
+directory::begin_batch(void)
+{
+    DEBUG(1, "%s", __PRETTY_FUNCTION__);
+    if (batch_depth++ > 0)
+        return;
+    batch_pending = false;
+    batch_aborted = false;
+
+    //
+    // Outside of a batch, every change is written as it is made, so
+    // what is in memory now is what is on the medium.
+    //
+    batch_snapshot();
+}
+
+
+int
+directory::commit_batch(void)
+{
+    DEBUG(1, "%s", __PRETTY_FUNCTION__);
+    assert(batch_depth > 0);
+    if (--batch_depth > 0)
+        return 0;
+
+    if (batch_aborted)
+    {
+        batch_rollback();
+        return -ECANCELED;
+    }
+    int err = 0;
+    if (batch_pending)
+        err = meta_sync_now();
+    if (err < 0)
+    {
+        batch_rollback();
+        return err;
+    }
+    batch_files.clear();
+    batch_meta.clear();
+    return 0;
+}
+
+
+void
+directory::abort_batch(void)
+{
+    DEBUG(1, "%s", __PRETTY_FUNCTION__);
+    assert(batch_depth > 0);
+    batch_aborted = true;
+    if (--batch_depth > 0)
+        return;
+    batch_rollback();
+}
+
+
+void
+directory::batch_snapshot(void)
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    batch_files.clear();
+    batch_meta.assign(26 * (files.size() + 1), 0);
+    volume_label->meta_write(&batch_meta[0]);
+    for (size_t j = 0; j < files.size(); ++j)
+    {
+        directory_entry::pointer dep = files[j];
+        batch_files.push_back(dep);
+        dep->meta_write(&batch_meta[26 * (j + 1)]);
+    }
+}
+
+
+void
+directory::batch_rollback(void)
+{
+    DEBUG(1, "%s", __PRETTY_FUNCTION__);
+    assert(batch_meta.size() == 26 * (batch_files.size() + 1));
+
+    //
+    // The same directory entry objects are used again (other people
+    // may be holding pointers to them), rather than making new ones.
+    //
+    volume_label->meta_read(&batch_meta[0]);
+    files.clear();
+    for (size_t j = 0; j < batch_files.size(); ++j)
+    {
+        directory_entry::pointer dep = batch_files[j];
+        dep->meta_read(&batch_meta[26 * (j + 1)]);
+        files.push_back(dep);
+    }
+    used_blocks = calc_used_blocks();
+    largest_free = -1;
+
+    batch_files.clear();
+    batch_meta.clear();
+}
@@ -103,14 +103,15 @@ directory_entry::put_date(unsigned char *data, time_t value)
     // |           year            |        day        |     month     |
     // +---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+---+
     //
-    struct tm *tmp = localtime(&value);
+    struct tm tm;
+    localtime_r(&value, &tm);
     unsigned x =
         (
-            (tmp->tm_mon + 1)
+            (tm.tm_mon + 1)
         +
-            (tmp->tm_mday << 4)
+            (tm.tm_mday << 4)
         +
-            ((tmp->tm_year % 100) << 9)
+            ((tm.tm_year % 100) << 9)
         );
     parent->put_word(data, x);
 }
@@ -229,6 +230,28 @@ directory_entry::write(off_t offset, const void *data, size_t nbytes)
 }
 
 
+int
+directory_entry::get_backing_fd(off_t, size_t &, off_t &, bool)
+    const
+{
+    return -1;
+}
+
+
+int
+directory_entry::touch(void)
+{
+    return -ENOSYS;
+}
+
+
+int
+directory_entry::copy_range(off_t, const directory_entry &, off_t, size_t)
+{
+    return -EOPNOTSUPP;
+}
+
+
 int
 directory_entry::statfs(struct statvfs *st)
 {
@@ -275,6 +298,14 @@ directory_entry::fsync(int)
 }
 
 
+int
+directory_entry::prepare_write_back(void)
+{
+    // Most files are written straight through, there is nothing to do.
+    return 0;
+}
+
+
 int
 directory_entry::setxattr(const char *, const char *, size_t, int)
 {
@@ -490,6 +521,21 @@ directory_entry::dfkind_from_extension(const rcstring &name)
 }
 
 
+int
+directory_entry::wipe_unused(void)
+{
+    // Nothing to wipe, by default.
+    return 0;
+}
+
+
+void
+directory_entry::fsck_contents(rcstring_list &)
+{
+    // Nothing to check, by default.
+}
+
+
 rcstring
 directory_entry::get_full_name()
     const
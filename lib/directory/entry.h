@@ -20,6 +20,7 @@
 #define LIB_DIRECTORY_ENTRY_H
 
 #include <lib/config.h>
+#include <cstdio>
 #include <ctime>
 #include <sys/types.h>
 #include <boost/shared_ptr.hpp>
@@ -64,8 +65,9 @@ public:
       * Get file attributes.
       *
       * Similar to the stat() system call.  The 'st_dev' and
-      * 'st_blksize' fields are ignored.  The 'st_ino' field is ignored
-      * except if the 'use_ino' mount option is given.
+      * 'st_blksize' fields are ignored.  The 'st_ino' field must be
+      * unique within the volume, and must not change while the volume
+      * is mounted, even if the file is moved.
       *
       * @param stbuf
       *     Where to put the file meta-date
@@ -264,6 +266,67 @@ public:
       */
     virtual int write(off_t offset, const void *data, size_t nbytes);
 
+    /**
+      * The get_backing_fd method is used to discover whether a range of
+      * the file's contents is stored, as is and contiguously, in the
+      * disk image file.  If it is, the data may be read (or overwritten)
+      * through the disk image file directly, rather than being copied
+      * by the #read (or #write) method.
+      *
+      * @param offset
+      *     How far into the file the range starts.
+      * @param nbytes
+      *     The size of the range.  When reading, it is reduced to stop
+      *     at the end of the file.
+      * @param pos
+      *     Where to put the position of the range within the disk image
+      *     file.
+      * @param writing
+      *     true if the data is to be overwritten, in which case the
+      *     range must lie within the file (the file must not grow), or
+      *     false if the data is to be read.
+      * @returns
+      *     the file descriptor of the disk image file, or -1 if the
+      *     #read or #write method must be used (the default).
+      */
+    virtual int get_backing_fd(off_t offset, size_t &nbytes, off_t &pos,
+        bool writing) const;
+
+    /**
+      * The touch method is used to update the last-modified time of the
+      * file, and write the directory, after the file's contents have
+      * been overwritten through the disk image file directly (see
+      * #get_backing_fd).
+      *
+      * @returns
+      *     zero on success, -errno on error.
+      */
+    virtual int touch(void);
+
+    /**
+      * The copy_range method is used to copy part of another file on
+      * the same volume into this file, entirely within the disk image,
+      * rather than reading it into memory and writing it out again.
+      * This file is grown first (if necessary) so that its extent only
+      * moves once, and the directory is written once, at the end.
+      *
+      * @param offset
+      *     How far into this file to copy the data to.
+      * @param src
+      *     The file to copy the data from.  It may be this file.
+      * @param src_offset
+      *     How far into the source file the data starts.
+      * @param nbytes
+      *     How many bytes to copy.  The copy stops at the end of the
+      *     source file.
+      * @returns
+      *     the number of bytes copied, or -errno on error.  The default
+      *     returns -EOPNOTSUPP, meaning the caller must copy the data
+      *     with the #read and #write methods.
+      */
+    virtual int copy_range(off_t offset, const directory_entry &src,
+        off_t src_offset, size_t nbytes);
+
     /**
       * Get file system statistics
       *
@@ -330,6 +393,18 @@ public:
       */
     virtual int fsync(int);
 
+    /**
+      * The prepare_write_back method is used to convert any cached
+      * file contents into their on-disk form, ready for a following
+      * #flush, #release or #fsync to write them.  It does not change
+      * the medium, so the caller need only hold the volume for reading
+      * (and the file against writes) while the conversion is done.
+      *
+      * @returns
+      *     zero on success, -errno on error.
+      */
+    virtual int prepare_write_back(void);
+
     /**
       * Set extended attributes.
       *
@@ -483,6 +558,17 @@ public:
       */
     virtual void meta_write(unsigned char *data) const = 0;
 
+    /**
+      * The meta_read method is used to decode the on-disk format of the
+      * meta data for this directory entry, replacing the values held in
+      * memory.  It is the inverse of the #meta_write method, and is used
+      * to roll back changes to the directory.
+      *
+      * @param data
+      *     The on-disk data to decode.
+      */
+    virtual void meta_read(const unsigned char *data) = 0;
+
     /**
       * The get_first_block method is used to obtain the block number of
       * the first block of this file.
@@ -560,10 +646,37 @@ public:
 
     /**
       * The print_listing method is used to print a directory listing,
-      * independent of mounting the file system.  The listing is printed
-      * on the standard output stream.
+      * independent of mounting the file system.
+      *
+      * @param fp
+      *     The stream to print the listing on.
+      * @param verbose
+      *     Whether or not to issue a long (verbose) listing.
+      */
+    virtual void print_listing(FILE *fp, bool verbose = false) = 0;
+
+    /**
+      * The wipe_unused method is used to write zero bytes to all parts
+      * of the file's extent which do not contain file data, such as
+      * the unused tail of the last block.  Used by the
+      * directory::wipe_unused method.
+      *
+      * @returns
+      *     zero on success, or -errno on error
+      */
+    virtual int wipe_unused(void);
+
+    /**
+      * The fsck_contents method is used to perform consistency checks
+      * on the contents of the file, as opposed to its directory entry.
+      * Nothing is repaired.  Used by the directory::fsck_deep method,
+      * which may call it from several threads at once, for different
+      * directory entries.
+      *
+      * @param problems
+      *     Where to put a description of each problem found.
       */
-    virtual void print_listing(bool verbose = false) = 0;
+    virtual void fsck_contents(rcstring_list &problems);
 
     virtual time_t get_mtime(void) const = 0;
 
@@ -54,7 +54,8 @@ directory_entry_file::directory_entry_file(
     status(false),
     name(a_name.substring(0, 15)),
     dlastbyte(512),
-    when(time(0))
+    when(time(0)),
+    inode_number(a_parent->next_inode_number())
 {
 }
 
@@ -71,7 +72,8 @@ directory_entry_file::directory_entry_file(
     dfkind(untypedfile),
     status(false),
     dlastbyte(512),
-    when(0)
+    when(0),
+    inode_number(a_parent->next_inode_number())
 {
     meta_read(a_data);
 }
@@ -225,7 +227,12 @@ directory_entry_file::getattr(struct stat *stbuf)
     stbuf->st_nlink = 1;
     stbuf->st_size = get_current_size();
     stbuf->st_blocks = dlastblock - dfirstblock;
-    stbuf->st_ino = (long)(void *)this;
+
+    //
+    // Not the first block: a zero length file shares it with the file
+    // after it, and it changes when the file is moved.
+    //
+    stbuf->st_ino = inode_number;
     stbuf->st_blksize = 512;
     stbuf->st_uid = getuid();
     stbuf->st_gid = getgid();
@@ -312,8 +319,46 @@ directory_entry_file::truncate(off_t size)
     //
     // Deal with the cases where we are growing the file extent.
     //
-    // First, look to see if the gap after this file is sufficient for
-    // this new file size, and use the existing gap if at all possible.
+    int err = make_room(size);
+    if (err < 0)
+        return err;
+
+    //
+    // If necessary, write zero to pad the file to the stated size.
+    //
+    long cur_size = get_current_size();
+    if (size > (off_t)cur_size)
+    {
+        off_t pos = ((off_t)dfirstblock << 9) + cur_size;
+        err = deeper->write_zero(pos, size - cur_size);
+        if (err < 0)
+            return err;
+    }
+
+    //
+    // Adjust the file length.
+    //
+    int old_num_blocks = dlastblock - dfirstblock;
+    dlastblock = dfirstblock + ((size + 511) >> 9);
+    dlastbyte = size & 511;
+    if (dlastbyte == 0)
+        dlastbyte = 512;
+    time(&when);
+    get_parent()->extent_changed(this, old_num_blocks);
+
+    //
+    // Be sure to write out new file size back out to the medium.
+    //
+    return get_parent()->meta_sync();
+}
+
+
+int
+directory_entry_file::make_room(off_t size)
+{
+    //
+    // Look to see if the gap after this file is sufficient for this
+    // new file size, and use the existing gap if at all possible.
     // This skips expensive reads and writes to the disk relocating the
     // files to make a gap that we don't need.
     //
@@ -340,32 +385,7 @@ directory_entry_file::truncate(off_t size)
         if (size > ((off_t)(dlastblock + gap_size - dfirstblock) << 9))
             return -ENOSPC;
     }
-
-    //
-    // If necessary, write zero to pad the file to the stated size.
-    //
-    long cur_size = get_current_size();
-    if (size > (off_t)cur_size)
-    {
-        off_t pos = ((off_t)dfirstblock << 9) + cur_size;
-        int err = deeper->write_zero(pos, size - cur_size);
-        if (err < 0)
-            return err;
-    }
-
-    //
-    // Adjust the file length.
-    //
-    dlastblock = dfirstblock + ((size + 511) >> 9);
-    dlastbyte = size & 511;
-    if (dlastbyte == 0)
-        dlastbyte = 512;
-    time(&when);
-
-    //
-    // Be sure to write out new file size back out to the medium.
-    //
-    return get_parent()->meta_sync();
+    return 0;
 }
 
 
@@ -375,7 +395,7 @@ directory_entry_file::utime_ns(const struct timespec *buf)
     if (deeper->is_read_only())
         return -EROFS;
     // ignore buf[0] (st_atime)
-    when = buf[0].tv_sec; // st_mtime
+    when = buf[1].tv_sec; // st_mtime
     return 0;
 }
 
@@ -397,6 +417,137 @@ directory_entry_file::read(off_t offset, void *data, size_t nbytes)
 }
 
 
+int
+directory_entry_file::get_backing_fd(off_t offset, size_t &nbytes, off_t &pos,
+    bool writing) const
+{
+    if (offset < 0)
+        return -1;
+    long cur_size = get_current_size();
+    if (writing)
+    {
+        if (deeper->is_read_only())
+            return -1;
+        if ((size_t)offset + nbytes > (size_t)cur_size)
+            return -1;
+    }
+    else
+    {
+        if (offset >= (off_t)cur_size)
+            return -1;
+        if ((size_t)offset + nbytes > (size_t)cur_size)
+            nbytes = cur_size - offset;
+    }
+    if (nbytes == 0)
+        return -1;
+    off_t from = ((off_t)dfirstblock << 9) + offset;
+    return deeper->get_backing_fd(from, nbytes, pos);
+}
+
+
+int
+directory_entry_file::touch(void)
+{
+    if (deeper->is_read_only())
+        return -EROFS;
+    time(&when);
+    return get_parent()->meta_sync();
+}
+
+
+int
+directory_entry_file::copy_range(off_t offset, const directory_entry &src,
+    off_t src_offset, size_t nbytes)
+{
+    DEBUG(2, "directory_entry_file::copy_range(offset = %ld, src = %s, "
+        "src_offset = %ld, nbytes = %ld)", (long)offset,
+        src.get_name().quote_c().c_str(), (long)src_offset, (long)nbytes);
+    if (deeper->is_read_only())
+        return -EROFS;
+    if (offset < 0 || src_offset < 0)
+        return -EINVAL;
+
+    //
+    // Only plain files on the same volume are stored as is, in a single
+    // extent.  The contents of a text file converted on the fly are
+    // not what is on the disk.
+    //
+    const directory_entry_file *sp =
+        dynamic_cast<const directory_entry_file *>(&src);
+    if
+    (
+        !sp
+    ||
+        dynamic_cast<const directory_entry_file_text *>(sp)
+    ||
+        sp->get_parent() != get_parent()
+    )
+        return -EOPNOTSUPP;
+
+    long src_size = sp->get_current_size();
+    if (src_offset >= (off_t)src_size)
+        return 0;
+    if ((size_t)src_offset + nbytes > (size_t)src_size)
+        nbytes = src_size - src_offset;
+    if (nbytes == 0)
+        return 0;
+
+    //
+    // Make room for all of the data first, so that the extent grows
+    // once, however much data there is.
+    //
+    // NOTE: this may move the source file, as well as this file, so
+    // the positions are not calculated until afterwards.
+    //
+    long cur_size = get_current_size();
+    off_t new_size = offset + nbytes;
+    if (new_size > (off_t)cur_size)
+    {
+        int err = make_room(new_size);
+        if (err < 0)
+            return err;
+    }
+    if (offset > (off_t)cur_size)
+    {
+        off_t pos = ((off_t)dfirstblock << 9) + cur_size;
+        int err = deeper->write_zero(pos, offset - cur_size);
+        if (err < 0)
+            return err;
+    }
+
+    //
+    // Copy the data in bulk, within the disk image.
+    //
+    int err =
+        deeper->copy_bytes
+        (
+            ((off_t)dfirstblock << 9) + offset,
+            ((off_t)sp->dfirstblock << 9) + src_offset,
+            nbytes
+        );
+    if (err < 0)
+        return err;
+
+    //
+    // Update the meta-data once.
+    //
+    if (new_size > (off_t)cur_size)
+    {
+        int old_num_blocks = dlastblock - dfirstblock;
+        dlastblock = dfirstblock + ((new_size + 511) >> 9);
+        dlastbyte = new_size & 511;
+        if (dlastbyte == 0)
+            dlastbyte = 512;
+        get_parent()->extent_changed(this, old_num_blocks);
+    }
+    time(&when);
+    err = get_parent()->meta_sync();
+    if (err < 0)
+        return err;
+    return nbytes;
+}
+
+
 int
 directory_entry_file::write(off_t offset, const void *data, size_t nbytes)
 {
@@ -543,7 +694,9 @@ directory_entry_file::write(off_t offset, const void *data, size_t nbytes)
         return err;
 
     // calc new dlastblock
+    int old_num_blocks = dlastblock - dfirstblock;
     dlastblock = dfirstblock + ((offset + nbytes + 511) >> 9);
+    get_parent()->extent_changed(this, old_num_blocks);
 
     // calc new dlastbyte
     dlastbyte = (offset + nbytes) & 511;
@@ -593,13 +746,13 @@ directory_entry_file::relocate(unsigned to_block)
     if (to_block == (unsigned)dfirstblock)
         return 0;
     int num_blocks = dlastblock - dfirstblock;
+
+    //
+    // The directory takes care of journaling the move, so that it can
+    // be recovered if it is interrupted.
+    //
     int err =
-        deeper->relocate_bytes
-        (
-            to_block << 9,
-            dfirstblock << 9,
-            num_blocks << 9
-        );
+        get_parent()->relocate_extent(name, dfirstblock, to_block, num_blocks);
     if (err < 0)
         return err;
     dfirstblock = to_block;
@@ -612,7 +765,7 @@ directory_entry_file::relocate(unsigned to_block)
 int
 directory_entry_file::fsck(concern_t concern_level)
 {
-    if (concern_level >= concern_blithe)
+    if (concern_level <= concern_blithe)
         return 0;
     int number_of_errors = 0;
     if (dlastblock < dfirstblock)
@@ -689,16 +842,16 @@ directory_entry_file::fsck(concern_t concern_level)
         name = name.substring(0, 15);
         ++number_of_errors;
     }
-    if (dlastblock < 1 || dlastblock > 512)
+    if (dlastbyte < 1 || dlastbyte > 512)
     {
         explain_output_error
         (
-            "directory entry %s: dlastblock wrong (%d)",
+            "directory entry %s: dlastbyte wrong (%d)",
             name.quote_c().c_str(),
-            dlastblock
+            dlastbyte
         );
         // Always fix this error.
-        dlastblock = 12;
+        dlastbyte = 512;
         ++number_of_errors;
     }
     if ((padding22 & 0xFC00) != 0)
@@ -738,30 +891,129 @@ directory_entry_file::fsck_last_block(int blknum)
 }
 
 
+int
+directory_entry_file::wipe_unused(void)
+{
+    DEBUG(1, "%s", __PRETTY_FUNCTION__);
+    if (dfirstblock >= dlastblock)
+        return 0;
+
+    //
+    // Within the last block of the file, wipe any unused bytes.
+    //
+    if (dlastbyte < 512)
+    {
+        off_t addr = ((off_t)(dlastblock - 1) << 9) + dlastbyte;
+        int err = deeper->write_zero(addr, 512 - dlastbyte);
+        if (err < 0)
+            return err;
+    }
+
+    //
+    // Within code files, the UCSD native compiler does not bother to
+    // make sure unused bytes in the files are reset to zero.  The
+    // result is that random memory from the compilation is present,
+    // sometimes as source code.
+    //
+    if (dfkind == codefile)
+        return wipe_segment_tails();
+    return 0;
+}
+
+
+int
+directory_entry_file::wipe_segment_tails(void)
+{
+    //
+    // The segment dictionary occupies the first block of the code file.
+    //
+    //     0..63    16 x { code address (block), code length (bytes) }
+    //     64..191  16 x segment name (8 bytes)
+    //     192..223 16 x segment kind
+    //     224..255 16 x interface text address (block)
+    //     256..287 16 x segment info
+    //
+    // The version lives in the top three bits of the segment info.
+    // Versions II, II.1 and III measure code length in bytes; later
+    // versions measure it in words, and follow the code with
+    // relocation data, so we leave those alone.
+    //
+    unsigned char dict[512];
+    int err = deeper->read((off_t)dfirstblock << 9, dict, sizeof(dict));
+    if (err < 0)
+        return err;
+    unsigned num_blocks = dlastblock - dfirstblock;
+    for (unsigned seg = 0; seg < 16; ++seg)
+    {
+        unsigned code_addr = get_word(dict + 4 * seg);
+        unsigned code_leng = get_word(dict + 4 * seg + 2);
+        unsigned version = (get_word(dict + 256 + 2 * seg) >> 13) & 7;
+        if (code_leng == 0 || (code_leng & 511) == 0)
+            continue;
+        if (version < 1 || version > 3)
+            continue;
+        unsigned end_block = code_addr + ((code_leng + 511) >> 9);
+        if (code_addr == 0 || end_block > num_blocks)
+        {
+            DEBUG(2, "%s: segment %u out of range", name.c_str(), seg);
+            continue;
+        }
+
+        //
+        // Be paranoid: if any other segment, or any interface text,
+        // claims to start within this segment, the dictionary is not
+        // to be trusted.
+        //
+        bool ok = true;
+        for (unsigned k = 0; k < 16; ++k)
+        {
+            unsigned other_code = get_word(dict + 4 * k);
+            unsigned other_text = get_word(dict + 224 + 2 * k);
+            if (k != seg && other_code > code_addr && other_code < end_block)
+                ok = false;
+            if (other_text > code_addr && other_text < end_block)
+                ok = false;
+        }
+        if (!ok)
+        {
+            DEBUG(2, "%s: segment %u overlaps", name.c_str(), seg);
+            continue;
+        }
+
+        off_t addr = ((off_t)(dfirstblock + code_addr) << 9) + code_leng;
+        err = deeper->write_zero(addr, 512 - (code_leng & 511));
+        if (err < 0)
+            return err;
+    }
+    return 0;
+}
+
+
 void
-directory_entry_file::print_listing(bool verbose)
+directory_entry_file::print_listing(FILE *fp, bool verbose)
 {
     // The name of the file.
-    printf("%-15.15s ", name.c_str());
+    fprintf(fp, "%-15.15s ", name.c_str());
 
     // The original printed the dlastblock-dfirstblock here, rather than
     // the file size in bytes.
     if (verbose)
-        printf("%4d %3d ", dfirstblock, dlastblock);
-    printf("%6.6s ", pretty_size(get_size_in_bytes()).c_str());
+        fprintf(fp, "%4d %3d ", dfirstblock, dlastblock);
+    fprintf(fp, "%6.6s ", pretty_size(get_size_in_bytes()).c_str());
 
     // The date last modified of the file
     // (no time was actually tracked).
-    struct tm *tmp = localtime(&when);
+    struct tm tm;
+    localtime_r(&when, &tm);
     char buffer[20];
-    strftime(buffer, sizeof(buffer), "%e-%b-%y", tmp);
-    printf("%9.9s ", buffer);
+    strftime(buffer, sizeof(buffer), "%e-%b-%y", &tm);
+    fprintf(fp, "%9.9s ", buffer);
 
     // The original printed dfirstblock and dlastbyte here.  We omit
     // them completely (the size in bytes, above, is more useful).
 
     // Print the file kind.
-    printf("%s\n", dfkind_name(dfkind));
+    fprintf(fp, "%s\n", dfkind_name(dfkind));
 }
 
 
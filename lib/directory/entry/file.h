@@ -141,6 +141,17 @@ protected:
     // See base class for documentation.
     int write(off_t offset, const void *data, size_t nbytes);
 
+    // See base class for documentation.
+    int get_backing_fd(off_t offset, size_t &nbytes, off_t &pos,
+        bool writing) const;
+
+    // See base class for documentation.
+    int touch(void);
+
+    // See base class for documentation.
+    int copy_range(off_t offset, const directory_entry &src,
+        off_t src_offset, size_t nbytes);
+
     // See base class for documentation.
     size_t get_name_maxlen() const;
 
@@ -163,7 +174,16 @@ protected:
     void fsck_last_block(int blknum);
 
     // See base class for documentation.
-    void print_listing(bool verbose);
+    void print_listing(FILE *fp, bool verbose);
+
+    // See base class for documentation.
+    void meta_read(const unsigned char *data);
+
+    // See base class for documentation.
+    int wipe_unused(void);
+
+    // See base class for documentation.
+    void fsck_contents(rcstring_list &problems);
 
     // See base class for documentation.
     dfkind_t get_file_kind() const;
@@ -239,13 +259,11 @@ private:
     time_t when;
 
     /**
-      * The meta_read method is used to parse the on-disk 26-byte
-      * representation of the meta data into our instance variables.
-      *
-      * @param data
-      *     The data to be parsed.
+      * The inode_number instance variable is used to remember the
+      * inode number of the file, as given by the parent directory's
+      * next_inode_number method.
       */
-    void meta_read(const unsigned char *data);
+    ino_t inode_number;
 
     /**
       * The meta_write method is used to encode our instance variables
@@ -257,6 +275,58 @@ private:
       */
     void meta_write(unsigned char *data) const;
 
+    /**
+      * The wipe_segment_tails method is used to zero the unused tail
+      * of the last block of each code segment in a code file, as
+      * described by the segment dictionary in the first block.
+      *
+      * @returns
+      *     zero on success, or -errno on error
+      */
+    int wipe_segment_tails(void);
+
+    /**
+      * The fsck_code_file method is used to check that the segment
+      * dictionary of a code file describes segments which lie within
+      * the file, and do not overlap.
+      *
+      * @param dict
+      *     The first block of the file.
+      * @param problems
+      *     Where to put a description of each problem found.
+      */
+    void fsck_code_file(const unsigned char *dict,
+        rcstring_list &problems) const;
+
+    /**
+      * The fsck_text_file method is used to check the structure of a
+      * text file: the 1KB header, then 1KB pages of whole lines, each
+      * page padded with NUL characters, with DLE indent sequences only
+      * at the start of lines.
+      *
+      * @param data
+      *     The contents of the file.
+      * @param size
+      *     The size of the file, in bytes.
+      * @param problems
+      *     Where to put a description of each problem found.
+      */
+    void fsck_text_file(const unsigned char *data, size_t size,
+        rcstring_list &problems) const;
+
+    /**
+      * The make_room method is used to make sure the file's extent,
+      * plus the gap after it, is large enough for the file to grow to
+      * the given size, moving the gap (and possibly this file) if
+      * necessary.  The file's size is not changed.
+      *
+      * @param size
+      *     The size (in bytes) the file is about to grow to.
+      * @returns
+      *     zero on success, or -errno on error
+      */
+    int make_room(off_t size);
+
     /**
       * The get_current_size method is used to calculate the size in
       * bytes of the file.
@@ -0,0 +1,247 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cctype>
+#include <cstring>
+#include <vector>
+
+#include <lib/debug.h>
+#include <lib/directory/entry/file.h>
+#include <lib/rcstring/list.h>
+
+
+void
+directory_entry_file::fsck_contents(rcstring_list &problems)
+{
+    DEBUG(1, "%s", __PRETTY_FUNCTION__);
+    if (dfkind != codefile && dfkind != textfile)
+        return;
+    if (dlastblock <= dfirstblock)
+    {
+        problems.push_back
+        (
+            dfkind == codefile
+        ?
+            "too short for a segment dictionary"
+        :
+            "too short for a text header"
+        );
+        return;
+    }
+
+    //
+    // Each file is read exactly once, in one piece.  Code files only
+    // need their segment dictionary.
+    //
+    size_t size = ((size_t)(dlastblock - dfirstblock - 1) << 9) + dlastbyte;
+    if (dfkind == codefile)
+        size = 512;
+    std::vector<unsigned char> data(size);
+    int err = deeper->read((off_t)dfirstblock << 9, &data[0], size);
+    if (err < 0)
+    {
+        problems.push_back(rcstring::printf("read: %s", strerror(-err)));
+        return;
+    }
+
+    if (dfkind == codefile)
+        fsck_code_file(&data[0], problems);
+    else
+        fsck_text_file(&data[0], size, problems);
+}
+
+
+void
+directory_entry_file::fsck_code_file(const unsigned char *dict,
+    rcstring_list &problems) const
+{
+    //
+    // See wipe_segment_tails for the layout of the segment dictionary.
+    //
+    unsigned num_blocks = dlastblock - dfirstblock;
+    unsigned seg_begin[16];
+    unsigned seg_end[16];
+    for (unsigned seg = 0; seg < 16; ++seg)
+    {
+        seg_begin[seg] = 0;
+        seg_end[seg] = 0;
+        unsigned code_addr = get_word(dict + 4 * seg);
+        unsigned code_leng = get_word(dict + 4 * seg + 2);
+        unsigned text_addr = get_word(dict + 224 + 2 * seg);
+        unsigned version = (get_word(dict + 256 + 2 * seg) >> 13) & 7;
+        const char *np = (const char *)dict + 64 + 8 * seg;
+        rcstring seg_name = rcstring(np, strnlen(np, 8)).trim();
+        if (text_addr >= num_blocks)
+        {
+            problems.push_back
+            (
+                rcstring::printf
+                (
+                    "segment %u %s: interface text (block %u) beyond end "
+                        "of file (%u blocks)",
+                    seg,
+                    seg_name.quote_c().c_str(),
+                    text_addr,
+                    num_blocks
+                )
+            );
+        }
+        if (code_leng == 0)
+            continue;
+
+        //
+        // Versions II, II.1 and III measure code length in bytes, later
+        // versions measure it in words.
+        //
+        unsigned nbytes = (version > 3 ? 2 * code_leng : code_leng);
+        unsigned end_block = code_addr + ((nbytes + 511) >> 9);
+        if (code_addr == 0 || end_block > num_blocks)
+        {
+            problems.push_back
+            (
+                rcstring::printf
+                (
+                    "segment %u %s: code (blocks %u to %u) outside file "
+                        "(blocks 1 to %u)",
+                    seg,
+                    seg_name.quote_c().c_str(),
+                    code_addr,
+                    end_block - 1,
+                    num_blocks - 1
+                )
+            );
+            continue;
+        }
+        for (unsigned k = 0; k < seg; ++k)
+        {
+            if (code_addr < seg_end[k] && seg_begin[k] < end_block)
+            {
+                problems.push_back
+                (
+                    rcstring::printf
+                    (
+                        "segment %u %s: code overlaps segment %u",
+                        seg,
+                        seg_name.quote_c().c_str(),
+                        k
+                    )
+                );
+                break;
+            }
+        }
+        seg_begin[seg] = code_addr;
+        seg_end[seg] = end_block;
+    }
+}
+
+
+void
+directory_entry_file::fsck_text_file(const unsigned char *data, size_t size,
+    rcstring_list &problems) const
+{
+    //
+    // The file starts with a 1KB header, used by the editor.  If it
+    // holds lines of text, the header is missing.
+    //
+    unsigned num_blocks = dlastblock - dfirstblock;
+    if (num_blocks < 2 || size < 1024)
+    {
+        problems.push_back("too short for a text header");
+        return;
+    }
+    if (num_blocks & 1)
+    {
+        problems.push_back
+        (
+            rcstring::printf
+            (
+                "size (%u blocks) not a whole number of 1KB pages",
+                num_blocks
+            )
+        );
+    }
+    if (isprint(data[0]) && memchr(data, '\r', 1024) && data[1023] == 0)
+        problems.push_back("text header missing (header holds text)");
+
+    //
+    // Each page holds whole lines, terminated by CR, and is padded
+    // with NUL characters.  DLE, followed by an indent count (plus
+    // 32), may only appear at the start of a line.  Only the first
+    // problem in each page is reported.
+    //
+    for (size_t page_start = 1024; page_start < size; page_start += 1024)
+    {
+        size_t page_end = page_start + 1024;
+        if (page_end > size)
+            page_end = size;
+        unsigned page = (page_start >> 10);
+        bool line_start = true;
+        const char *what = 0;
+        size_t pos = page_start;
+        for (; pos < page_end; ++pos)
+        {
+            unsigned char c = data[pos];
+            if (c == 0)
+            {
+                if (!line_start)
+                {
+                    what = "last line not terminated";
+                    break;
+                }
+                while (pos < page_end && data[pos] == 0)
+                    ++pos;
+                if (pos < page_end)
+                    what = "data after NUL padding";
+                break;
+            }
+            if (c == 16)
+            {
+                if (!line_start)
+                {
+                    what = "DLE not at start of line";
+                    break;
+                }
+                ++pos;
+                if (pos >= page_end || data[pos] < 32)
+                {
+                    what = "DLE without indent";
+                    break;
+                }
+                line_start = false;
+                continue;
+            }
+            line_start = (c == '\r');
+        }
+        if (!what && pos >= page_end && !line_start)
+            what = "last line not terminated";
+        if (what)
+        {
+            problems.push_back
+            (
+                rcstring::printf
+                (
+                    "page %u, offset %u: %s",
+                    page,
+                    (unsigned)(pos - page_start),
+                    what
+                )
+            );
+        }
+    }
+}
@@ -32,6 +32,7 @@
 #include <lib/output/memory.h>
 #include <lib/output/text_decode.h>
 #include <lib/output/text_encode.h>
+#include <lib/statistics.h>
 
 
 directory_entry_file_text::~directory_entry_file_text()
@@ -43,7 +44,10 @@ directory_entry_file_text::~directory_entry_file_text()
 directory_entry_file_text::directory_entry_file_text(directory *a_prnt,
         const rcstring &a_name, int a_blk, int a_nblks,
         const sector_io::pointer &a_deeper) :
-    directory_entry_file(a_prnt, a_name, textfile, a_blk, a_nblks, a_deeper)
+    directory_entry_file(a_prnt, a_name, textfile, a_blk, a_nblks, a_deeper),
+    decoded_size(-1),
+    dirty(false),
+    encoded_address(0)
 {
     DEBUG(2, "%s", __PRETTY_FUNCTION__);
 }
@@ -51,7 +55,10 @@ directory_entry_file_text::directory_entry_file_text(directory *a_prnt,
 
 directory_entry_file_text::directory_entry_file_text(directory *a_parent,
         const unsigned char *a_data, const sector_io::pointer &a_deeper) :
-    directory_entry_file(a_parent, a_data, a_deeper)
+    directory_entry_file(a_parent, a_data, a_deeper),
+    decoded_size(-1),
+    dirty(false),
+    encoded_address(0)
 {
     DEBUG(2, "%s", __PRETTY_FUNCTION__);
 }
@@ -82,9 +89,9 @@ directory_entry_file_text::slurp(void)
     DEBUG(2, "%s", __PRETTY_FUNCTION__);
     // we can't use input_psystem because that will call our read
     // method, and not our parent's read method.
+    std::vector<char> raw;
+    raw.reserve(directory_entry_file::get_size_in_bytes());
     off_t address = 0;
-    output_memory::mpointer omp = output_memory::create();
-    output::pointer op = output_text_decode::create(omp);
     for (;;)
     {
         char data[1 << 14];
@@ -93,13 +100,142 @@ directory_entry_file_text::slurp(void)
             return output_memory::mpointer();
         if (n == 0)
             break;
-        op->write(data, n);
+        raw.insert(raw.end(), data, data + n);
         address += n;
     }
+
+    //
+    // Large files are decoded using several threads.
+    //
+    output_memory::mpointer omp = output_memory::create();
+    output_text_decode::decode_parallel
+    (
+        (raw.empty() ? 0 : &raw[0]),
+        raw.size(),
+        omp
+    );
+    omp->flush();
     return omp;
 }
 
 
+int
+directory_entry_file_text::decode_pages(size_t first, size_t last,
+    const output::pointer &out) const
+{
+    DEBUG(2, "%s: %ld %ld", __PRETTY_FUNCTION__, (long)first, (long)last);
+    // we can't use input_psystem because that will call our read
+    // method, and not our parent's read method.
+    output::pointer op = output_text_decode::create(out, true, first == 0);
+    off_t address = (off_t)first << 10;
+    size_t page = first;
+    while (page < last)
+    {
+        char data[1 << 14];
+        size_t nbytes = sizeof(data);
+        if (last - page < (sizeof(data) >> 10))
+            nbytes = (last - page) << 10;
+        int n = directory_entry_file::read(address, data, nbytes);
+        if (n < 0)
+            return n;
+        if (n == 0)
+            break;
+
+        //
+        // Pages are given to the decoder one at a time, so that the
+        // decision about whether or not the file has a header is
+        // always made by looking at the first page alone.
+        //
+        for (int j = 0; j < n; j += 1024)
+            op->write(data + j, (n - j < 1024 ? n - j : 1024));
+        address += n;
+        page += (n + 1023) >> 10;
+    }
+    op->flush();
+    return 0;
+}
+
+
+int
+directory_entry_file_text::scan(std::vector<text_page> *index)
+    const
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    output_text_decode::counter decoded_bytes;
+    off_t decoded = 0;
+    off_t address = 0;
+    for (;;)
+    {
+        char data[1 << 14];
+        int n = directory_entry_file::read(address, data, sizeof(data));
+        if (n < 0)
+            return n;
+        if (n == 0)
+            break;
+        for (int j = 0; j < n; j += 1024)
+        {
+            if (index)
+            {
+                text_page tp;
+                tp.address = decoded;
+                tp.line_start = decoded_bytes.at_start_of_line();
+                index->push_back(tp);
+            }
+            int len = (n - j < 1024 ? n - j : 1024);
+            decoded += decoded_bytes.count(data + j, len);
+        }
+        address += n;
+    }
+    if (index)
+    {
+        text_page tp;
+        tp.address = decoded;
+        tp.line_start = true;
+        index->push_back(tp);
+    }
+    DEBUG(3, "decoded_size = %ld", (long)decoded);
+    decoded_size = decoded;
+    return 0;
+}
+
+
+int
+directory_entry_file_text::build_page_index(void)
+    const
+{
+    mutex::locker hold(index_lock);
+    if (!page_index.empty())
+    {
+        statistics::add(statistics::text_index_hits);
+        return 0;
+    }
+    statistics::add(statistics::text_index_misses);
+    std::vector<text_page> result;
+    int err = scan(&result);
+    if (err < 0)
+        return err;
+    page_index.swap(result);
+    return 0;
+}
+
+
+off_t
+directory_entry_file_text::get_decoded_size(void)
+    const
+{
+    if (cache)
+        return cache->size();
+    mutex::locker hold(index_lock);
+    if (decoded_size < 0)
+    {
+        int err = scan(0);
+        if (err < 0)
+            return err;
+    }
+    return decoded_size;
+}
+
+
 int
 directory_entry_file_text::getattr(struct stat *stbuf)
 {
@@ -107,13 +243,13 @@ directory_entry_file_text::getattr(struct stat *stbuf)
     directory_entry_file::getattr(stbuf);
 
     //
-    // build the decoded text to extract the size
+    // Use the decoded text, if we have it, otherwise count how big the
+    // decoded text would be, without decoding it.
     //
-    if (!cache)
-        cache = slurp();
-    if (!cache)
-        return -ENOMEM;
-    stbuf->st_size = cache->size();
+    off_t size = get_decoded_size();
+    if (size < 0)
+        return size;
+    stbuf->st_size = size;
 
     return 0;
 }
@@ -131,73 +267,136 @@ directory_entry_file_text::truncate(off_t size)
     //
     if (!cache)
        cache = slurp();
+    if (!cache)
+        return -EIO;
 
     //
     // truncate the memory image (or pad it as given) to make it the
     // desired size.
     //
     cache->truncate_to(size, '\n');
+    page_index.clear();
+    decoded_size = -1;
+    encoder.reset();
+    encoded.reset();
+    prepared.reset();
+    dirty = true;
 
     //
-    // Now re-encode the memory image to be the appropriate on-disk form.
+    // A truncate(2) system call is not followed by a release, so the
+    // on-disk form must be brought up to date immediately.
     //
-    output_memory::mpointer omp = output_memory::create();
+    return write_back();
+}
+
+
+int
+directory_entry_file_text::read(off_t offset, void *data, size_t nbytes)
+    const
+{
+    if (offset < 0)
+        return -EINVAL;
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+
+    //
+    // If the file is being written, the in-memory copy is the only
+    // correct version of the text.
+    //
+    if (cache)
     {
-        output::pointer op = output_text_encode::create(omp);
-        op->write(cache->get_data(), cache->size());
+        if ((size_t)offset > cache->size())
+            return 0;
+        if (offset + nbytes > cache->size())
+            nbytes = cache->size() - offset;
+        memcpy(data, cache->get_data() + offset, nbytes);
+        return nbytes;
     }
-    DEBUG(3, "omp->size() = %ld", long(omp->size()));
-    omp->flush();
 
     //
-    // truncate ourselves to oblivion
+    // sanity check against the decoded size
     //
-    int err = directory_entry_file::truncate(0);
+    int err = build_page_index();
     if (err < 0)
         return err;
+    size_t npages = page_index.size() - 1;
+    off_t size = page_index[npages].address;
+    if (offset >= size)
+        return 0;
+    if (offset + (off_t)nbytes > size)
+        nbytes = size - offset;
+    if (nbytes == 0)
+        return 0;
 
     //
-    // Now write the in-memory UCSD form to disk.
+    // Find the last page which starts at or before the offset, and
+    // then back up to a page which starts at the start of a line.
     //
-    DEBUG(2, "about to write");
-    return directory_entry_file::write(0, omp->get_data(), omp->size());
+    size_t lo = 0;
+    size_t hi = npages;
+    while (lo + 1 < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (page_index[mid].address <= offset)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    size_t first = lo;
+    while (first > 0 && !page_index[first].line_start)
+        --first;
+
+    //
+    // Find the first page which starts after the end of the data.
+    //
+    size_t last = lo + 1;
+    while (last < npages && page_index[last].address < offset + (off_t)nbytes)
+        ++last;
+
+    //
+    // Decode only the pages covering the requested range.
+    //
+    output_memory::mpointer omp = output_memory::create();
+    err = decode_pages(first, last, omp);
+    if (err < 0)
+        return err;
+    omp->flush();
+    size_t skip = offset - page_index[first].address;
+    if (skip + nbytes > omp->size())
+        return -EIO;
+    memcpy(data, omp->get_data() + skip, nbytes);
+    return nbytes;
 }
 
 
 int
-directory_entry_file_text::read(off_t offset, void *data, size_t nbytes)
+directory_entry_file_text::get_backing_fd(off_t, size_t &, off_t &, bool)
     const
 {
-    if (offset < 0)
-        return -EINVAL;
-    DEBUG(2, "%s", __PRETTY_FUNCTION__);
-
     //
-    // read in the whole text file
+    // The on-disk text is encoded, and not at all what the file's
+    // contents look like.
     //
-    if (!cache)
-        cache = slurp();
+    return -1;
+}
 
-    //
-    // sanity check against in-memory copy
-    //
-    assert(offset >= 0);
-    if ((size_t)offset > cache->size())
-        return 0;
-    if (offset + nbytes > cache->size())
-        nbytes = cache->size() - offset;
 
+int
+directory_entry_file_text::copy_range(off_t, const directory_entry &, off_t,
+    size_t)
+{
     //
-    // transfer data from in memory copy
+    // For the same reason, the text must go through the #write method
+    // to be encoded.
     //
-    memcpy(data, cache->get_data() + offset, nbytes);
-    return nbytes;
+    return -EOPNOTSUPP;
 }
 
 
 int
 directory_entry_file_text::write(off_t offset, const void *data, size_t nbytes)
 {
+    if (offset < 0)
+        return -EINVAL;
     DEBUG(2, "%s", __PRETTY_FUNCTION__);
     DEBUG(3, "offset = %ld", (long)offset);
     DEBUG(3, "nbytes = %ld", (long)nbytes);
@@ -206,7 +405,13 @@ directory_entry_file_text::write(off_t offset, const void *data, size_t nbytes)
     //
     if (!cache)
         cache = slurp();
+    if (!cache)
+        return -EIO;
     DEBUG(3, "cache->size() = %ld", long(cache->size()));
+    bool appending = (!dirty && (size_t)offset == cache->size());
+    page_index.clear();
+    decoded_size = -1;
+    prepared.reset();
 
     //
     // overwrite the text data at the specified location
@@ -215,15 +420,112 @@ directory_entry_file_text::write(off_t offset, const void *data, size_t nbytes)
     DEBUG(3, "cache->size() = %ld", long(cache->size()));
 
     //
-    // Now re-encode the memory image to be the appropriate on-disk form.
+    // The on-disk form is not re-encoded until the file is flushed or
+    // released, except for data appended to the end of the file, which
+    // can be encoded a page at a time as it arrives.
     //
-    output_memory::mpointer omp = output_memory::create();
+    if (appending)
     {
-        output::pointer op = output_text_encode::create(omp);
-        op->write(cache->get_data(), cache->size());
+        int err = append(data, nbytes);
+        if (err < 0)
+            return err;
     }
-    DEBUG(3, "omp->size() = %ld", long(omp->size()));
-    omp->flush();
+    else
+    {
+        encoder.reset();
+        encoded.reset();
+        dirty = true;
+    }
+    return nbytes;
+}
+
+
+int
+directory_entry_file_text::append(const void *data, size_t nbytes)
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    if (!encoder)
+    {
+        //
+        // Start encoding the file from the beginning.  This happens
+        // once for each run of appends, so a file written sequentially
+        // is only encoded once.
+        //
+        int err = directory_entry_file::truncate(0);
+        if (err < 0)
+            return err;
+        encoded = output_memory::create();
+        encoder = output_text_encode::create(encoded);
+        encoded_address = 0;
+        encoder->write(cache->get_data(), cache->size());
+    }
+    else
+        encoder->write(data, nbytes);
+
+    //
+    // Get the completed lines out of the encoder, and write any
+    // completed pages to disk.
+    //
+    encoder->flush();
+    return write_encoded(true);
+}
+
+
+int
+directory_entry_file_text::write_encoded(bool whole_pages_only)
+{
+    encoded->flush();
+    size_t nbytes = encoded->size();
+    if (whole_pages_only)
+        nbytes &= ~(size_t)1023;
+    if (nbytes == 0)
+        return 0;
+    DEBUG(3, "write %ld bytes at %ld", (long)nbytes, (long)encoded_address);
+    int n = directory_entry_file::write(encoded_address, encoded->get_data(),
+        nbytes);
+    if (n < 0)
+        return n;
+    assert((size_t)n == nbytes);
+    encoded_address += nbytes;
+
+    //
+    // Keep the partial page, if any, for next time.
+    //
+    rcstring rest(encoded->get_data() + nbytes, encoded->size() - nbytes);
+    encoded->truncate_to(0);
+    encoded->write(rest.c_str(), rest.size());
+    encoded->flush();
+    return 0;
+}
+
+
+int
+directory_entry_file_text::write_back(void)
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    if (encoder)
+    {
+        //
+        // Finishing the encoder writes out the last line, and pads the
+        // last page with NUL characters.
+        //
+        encoder.reset();
+        int err = write_encoded(false);
+        encoded.reset();
+        if (err < 0)
+            return err;
+    }
+    if (!dirty)
+        return 0;
+
+    //
+    // Now re-encode the memory image to be the appropriate on-disk form,
+    // unless #prepare_write_back has already done so.
+    //
+    output_memory::mpointer omp = prepared;
+    prepared.reset();
+    if (!omp)
+        omp = encode_cache();
 
     //
     // truncate ourselves to oblivion
@@ -233,14 +535,40 @@ directory_entry_file_text::write(off_t offset, const void *data, size_t nbytes)
         return err;
 
     //
-    // Now write the in-memory form to disk.
+    // Now write the in-memory UCSD form to disk.
     //
     DEBUG(2, "about to write");
-    int n2 = directory_entry_file::write(0, omp->get_data(), omp->size());
-    if (n2 < 0)
-        return n2;
-    assert((size_t)n2 == omp->size());
-    return nbytes;
+    int n = directory_entry_file::write(0, omp->get_data(), omp->size());
+    if (n < 0)
+        return n;
+    assert((size_t)n == omp->size());
+    dirty = false;
+    return 0;
+}
+
+
+output_memory::mpointer
+directory_entry_file_text::encode_cache(void)
+    const
+{
+    output_memory::mpointer omp = output_memory::create();
+    {
+        output::pointer op = output_text_encode::create(omp);
+        op->write(cache->get_data(), cache->size());
+    }
+    DEBUG(3, "omp->size() = %ld", long(omp->size()));
+    omp->flush();
+    return omp;
+}
+
+
+int
+directory_entry_file_text::prepare_write_back(void)
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    if (dirty && !prepared)
+        prepared = encode_cache();
+    return 0;
 }
 
 
@@ -249,15 +577,60 @@ directory_entry_file_text::get_size_in_bytes(void)
     const
 {
     DEBUG(2, "%s", __PRETTY_FUNCTION__);
-    if (!cache)
-        cache = slurp();
-    return cache->size();
+    off_t size = get_decoded_size();
+    if (size < 0)
+        return 0;
+    return size;
+}
+
+
+int
+directory_entry_file_text::flush(void)
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    return write_back();
+}
+
+
+void
+directory_entry_file_text::meta_read(const unsigned char *data)
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    directory_entry_file::meta_read(data);
+
+    //
+    // The file's extent may have changed, so anything remembered about
+    // its contents can no longer be trusted.
+    //
+    cache.reset();
+    page_index.clear();
+    decoded_size = -1;
+    encoder.reset();
+    encoded.reset();
+    prepared.reset();
+    encoded_address = 0;
+    dirty = false;
 }
 
 
 int
 directory_entry_file_text::release()
 {
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    int err = write_back();
     cache.reset();
-    return 0;
+    prepared.reset();
+    dirty = false;
+    return err;
+}
+
+
+int
+directory_entry_file_text::fsync(int data_only)
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    int err = write_back();
+    if (err < 0)
+        return err;
+    return directory_entry_file::fsync(data_only);
 }
@@ -19,7 +19,10 @@
 #ifndef LIB_DIRECTORY_ENTRY_FILE_TEXT_H
 #define LIB_DIRECTORY_ENTRY_FILE_TEXT_H
 
+#include <vector>
+
 #include <lib/directory/entry/file.h>
+#include <lib/mutex.h>
 #include <lib/output/memory.h>
 
 /**
@@ -117,12 +120,32 @@ protected:
     // See base class for documentation
     int write(off_t offset, const void *data, size_t nbytes);
 
+    // See base class for documentation.
+    void meta_read(const unsigned char *data);
+
+    // See base class for documentation.
+    int get_backing_fd(off_t offset, size_t &nbytes, off_t &pos,
+        bool writing) const;
+
+    // See base class for documentation.
+    int copy_range(off_t offset, const directory_entry &src,
+        off_t src_offset, size_t nbytes);
+
     // See base class for documentation
     size_t get_size_in_bytes(void) const;
 
+    // See base class for documentation
+    int flush(void);
+
     // See base class for documentation
     int release();
 
+    // See base class for documentation
+    int fsync(int data_only);
+
+    // See base class for documentation
+    int prepare_write_back(void);
+
 private:
     /**
       * The slurp method is used to read in the text file and convert it
@@ -136,6 +159,177 @@ private:
       */
     mutable output_memory::mpointer cache;
 
+    /**
+      * The text_page class is used to represent the position of one
+      * on-disk page of the text file, within the decoded text.
+      */
+    struct text_page
+    {
+        /**
+          * The address instance variable is used to remember the byte
+          * address, within the decoded text, of the first character
+          * decoded from this page.
+          */
+        off_t address;
+
+        /**
+          * The line_start instance variable is used to remember whether
+          * or not this page starts at the start of a line.  Pages
+          * written by the text editor always do, which allows them to
+          * be decoded independently of the pages before them.
+          */
+        bool line_start;
+    };
+
+    /**
+      * The page_index instance variable is used to remember where each
+      * 1KB page of the on-disk file lands in the decoded text (the
+      * header is page zero).  There is one extra entry at the end,
+      * holding the decoded size of the file.  It is empty if the index
+      * has yet to be built, or the file has been written since.
+      */
+    mutable std::vector<text_page> page_index;
+
+    /**
+      * The decoded_size instance variable is used to remember the size
+      * of the decoded text, or -1 if it has yet to be calculated or the
+      * file has been written since.
+      */
+    mutable off_t decoded_size;
+
+    /**
+      * The index_lock instance variable is used to serialize the lazy
+      * calculation of #page_index and #decoded_size, because several
+      * threads may be reading the file at once, each holding only a
+      * read lock on the directory entry.
+      */
+    mutable mutex index_lock;
+
+    /**
+      * The scan method is used to read the on-disk file once, counting
+      * the size of the decoded text without decoding it, and setting
+      * #decoded_size.
+      *
+      * @param index
+      *     Where to record the position of each page within the decoded
+      *     text, or NULL if only the size is wanted.
+      * @returns
+      *     zero on success, or -errno on error.
+      */
+    int scan(std::vector<text_page> *index) const;
+
+    /**
+      * The get_decoded_size method is used to obtain the size of the
+      * decoded text, calculating it if necessary.
+      *
+      * @returns
+      *     the size in bytes, or -errno on error.
+      */
+    off_t get_decoded_size(void) const;
+
+    /**
+      * The build_page_index method is used to scan the on-disk file,
+      * once, to build the #page_index.
+      *
+      * @returns
+      *     zero on success, or -errno on error.
+      */
+    int build_page_index(void) const;
+
+    /**
+      * The decode_pages method is used to decode a range of on-disk
+      * pages.
+      *
+      * @param first
+      *     The first page to decode.  Page zero is the header.
+      * @param last
+      *     One past the last page to decode.
+      * @param out
+      *     Where to write the decoded text.
+      * @returns
+      *     zero on success, or -errno on error.
+      */
+    int decode_pages(size_t first, size_t last,
+        const output::pointer &out) const;
+
+    /**
+      * The dirty instance variable is used to remember whether or not
+      * the #cache has been modified in a way that requires the whole
+      * file to be re-encoded when it is next written back.
+      */
+    bool dirty;
+
+    /**
+      * The encoder instance variable is used to remember the text
+      * encoder used to translate data appended to the end of the file.
+      * It is only non-NULL while the file is being written sequentially.
+      */
+    output::pointer encoder;
+
+    /**
+      * The encoded instance variable is used to remember the output of
+      * the #encoder which has yet to be written to disk.
+      */
+    output_memory::mpointer encoded;
+
+    /**
+      * The prepared instance variable is used to remember the on-disk
+      * form of the whole of the #cache, as encoded by the
+      * #prepare_write_back method, ready for #write_back to write.
+      * It is reset whenever the #cache changes.
+      */
+    output_memory::mpointer prepared;
+
+    /**
+      * The encoded_address instance variable is used to remember the
+      * byte address, within the on-disk file, at which the contents of
+      * the #encoded buffer are to be written.
+      */
+    off_t encoded_address;
+
+    /**
+      * The append method is used to encode data which has just been
+      * appended to the #cache.  Whole pages of encoded data are written
+      * to disk as soon as they are complete.
+      *
+      * @param data
+      *     The data appended to the cache.
+      * @param nbytes
+      *     The number of bytes of data.
+      * @returns
+      *     zero on success, or -errno on error.
+      */
+    int append(const void *data, size_t nbytes);
+
+    /**
+      * The write_encoded method is used to write the encoded data held
+      * in the #encoded buffer to disk.
+      *
+      * @param whole_pages_only
+      *     If true, only write complete 1KB pages, leaving any partial
+      *     page in the buffer.  If false, write everything.
+      * @returns
+      *     zero on success, or -errno on error.
+      */
+    int write_encoded(bool whole_pages_only);
+
+    /**
+      * The write_back method is used to make sure the on-disk form of
+      * the file reflects the contents of the #cache.  Appended data
+      * only requires the last page to be finished; other changes
+      * require the whole file to be re-encoded.
+      *
+      * @returns
+      *     zero on success, or -errno on error.
+      */
+    int write_back(void);
+
+    /**
+      * The encode_cache method is used to encode the whole of the
+      * #cache into its on-disk form, in memory.
+      */
+    output_memory::mpointer encode_cache(void) const;
+
     /**
       * The default constructor.  Do not use.
       */
@@ -68,6 +68,14 @@ directory_entry_list::nth(size_t n)
 }
 
 
+void
+directory_entry_list::replace(size_t n, directory_entry::pointer dep)
+{
+    if (n < length)
+        list[n] = dep;
+}
+
+
 directory_entry::pointer
 directory_entry_list::find(const rcstring &filename)
     const
@@ -155,6 +163,15 @@ directory_entry_list::erase(directory_entry *dep)
 }
 
 
+void
+directory_entry_list::clear()
+{
+    for (size_t j = 0; j < length; ++j)
+        list[j].reset();
+    length = 0;
+}
+
+
 bool
 directory_entry_list::erase(directory_entry::pointer dep)
 {
@@ -88,6 +88,17 @@ public:
 
     directory_entry::pointer operator[](size_t n) const { return nth(n); }
 
+    /**
+      * The replace method is used to replace the N'th entry in the list
+      * with a different directory entry, without changing its position.
+      *
+      * @param n
+      *     The ordinal number of the entry to be replaced.
+      * @param dep
+      *     Pointer to the replacement directory entry.
+      */
+    void replace(size_t n, directory_entry::pointer dep);
+
     /**
       * The back method is used to obtain the last entry in the list.
       *
@@ -150,6 +161,13 @@ public:
       */
     bool erase(directory_entry *dep);
 
+    /**
+      * The clear method is used to remove all of the directory entries
+      * from the list.  The entries will not be deleted, only removed
+      * from the list.
+      */
+    void clear();
+
     /**
       * The sort_by_first_block method is used to sort the directory
       * entries by the number of the forst block of each directory
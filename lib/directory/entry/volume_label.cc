@@ -490,12 +490,13 @@ directory_entry_volume_label::fsck_last_block(int blknum)
 
 
 void
-directory_entry_volume_label::print_listing(bool verbose)
+directory_entry_volume_label::print_listing(FILE *fp, bool)
 {
-    struct tm *tmp = localtime(&when);
+    struct tm tm;
+    localtime_r(&when, &tm);
     char buffer[20];
-    strftime(buffer, sizeof(buffer), "%Y-%m-%d", tmp);
-    printf("Last mounted %s\n", buffer);
+    strftime(buffer, sizeof(buffer), "%Y-%m-%d", &tm);
+    fprintf(fp, "Last mounted %s\n", buffer);
 }
 
 
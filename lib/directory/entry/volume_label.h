@@ -108,6 +108,9 @@ public:
       */
     void meta_write(unsigned char *data) const;
 
+    // See base class for documentation.
+    void meta_read(const unsigned char *data);
+
     /**
       * The set_num_files method is used to set the number of files
       * field of the volume label immediately before writing out the
@@ -191,7 +194,7 @@ public:
     void fsck_last_block(int blknum);
 
     // See base class for documentation.
-    void print_listing(bool verbose);
+    void print_listing(FILE *fp, bool verbose);
 
     // See base class for documentation.
     size_t get_size_in_bytes(void) const;
@@ -267,15 +270,6 @@ private:
       */
     size_t max_dir_ents;
 
-    /**
-      * The meta_read method is used to read the on-disk data about the
-      * directory, and load the instance variables from it.
-      *
-      * @param data
-      *     The data to decode into the instance variables.
-      */
-    void meta_read(const unsigned char *data);
-
     /**
       * The calc_max_dir_ents is used to calculate the maximum number of
       * directory entries, once the first and last block are known.
@@ -80,40 +80,68 @@ directory::factory(const rcstring &filename, bool read_only, concern_t level)
         level = concern_check;
     sector_io::pointer disk =
         interleaved_raw_sector_io(filename, read_only);
-    directory *dir = new directory(disk);
-    int err = dir->meta_read(level);
-    if (err < 0)
+
+    //
+    // Some disk image formats (IMD, dedup, chunked) can only be read.
+    // Say so now, rather than fail on the first write.  Merely checking
+    // the volume doesn't write anything.
+    //
+    if (!read_only && level != concern_check && disk->is_read_only())
     {
-        //
-        // If we can't read the volume, make sure the mount fails as well.
-        //
         explain_output_error_and_die
         (
-            "read %s: %s",
-            filename.c_str(),
-            strerror(-err)
+            "%s: this disk image format is read-only",
+            filename.c_str()
         );
     }
-    if (err > 0)
+
+    directory *dir = new directory(disk);
+    try
     {
-        if (level >= concern_repair)
+        int err = dir->meta_read(level);
+        if (err < 0)
         {
+            //
+            // If we can't read the volume, make sure the mount fails as
+            // well.
+            //
             explain_output_error_and_die
             (
-                "%s: repaired %d format error%s",
+                "read %s: %s",
+                filename.c_str(),
+                strerror(-err)
+            );
+        }
+        if (err > 0)
+        {
+            if (level >= concern_repair)
+            {
+                explain_output_error_and_die
+                (
+                    "%s: repaired %d format error%s",
+                    filename.c_str(),
+                    err,
+                    (err == 1 ? "" : "s")
+                );
+                // NOTREACHED
+            }
+            explain_output_error
+            (
+                "%s: warning: found %d format error%s",
                 filename.c_str(),
                 err,
                 (err == 1 ? "" : "s")
             );
-            // NOTREACHED
         }
-        explain_output_error
-        (
-            "%s: warning: found %d format error%s",
-            filename.c_str(),
-            err,
-            (err == 1 ? "" : "s")
-        );
+    }
+    catch (...)
+    {
+        //
+        // In batch mode a fatal error throws (see lib/batch.cc) rather
+        // than exits, so don't leak the directory on the way out.
+        //
+        delete dir;
+        throw;
     }
     return dir;
 }
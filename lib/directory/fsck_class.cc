@@ -0,0 +1,69 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cassert>
+
+#include <lib/directory.h>
+
+
+const char *
+directory::fsck_class_name(fsck_class_t which)
+{
+    switch (which)
+    {
+    case fsck_class_label:
+        return "label";
+
+    case fsck_class_entry:
+        return "entry";
+
+    case fsck_class_count:
+        return "count";
+
+    case fsck_class_order:
+        return "order";
+
+    case fsck_class_overlap:
+        return "overlap";
+
+    case fsck_class_extent:
+        return "extent";
+
+    case fsck_class_journal:
+        return "journal";
+
+    case fsck_class_code:
+        return "code";
+
+    case fsck_class_text:
+        return "text";
+
+    case fsck_class_max:
+        break;
+    }
+    return "???";
+}
+
+
+int
+directory::get_fsck_errors(fsck_class_t which) const
+{
+    assert(which >= 0 && which < fsck_class_max);
+    return fsck_errors[which];
+}
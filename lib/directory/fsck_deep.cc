@@ -0,0 +1,123 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <libexplain/output.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <vector>
+
+#include <lib/debug.h>
+#include <lib/directory.h>
+#include <lib/mutex.h>
+#include <lib/rcstring/list.h>
+
+
+struct fsck_deep_pool
+{
+    mutex lock;
+    const directory_entry_list *files;
+    size_t next;
+    std::vector<rcstring_list> problems;
+};
+
+
+static void *
+fsck_deep_worker(void *arg)
+{
+    fsck_deep_pool *pool = (fsck_deep_pool *)arg;
+    for (;;)
+    {
+        //
+        // Files are handed out in block order, so the disk image is
+        // read more or less sequentially.
+        //
+        size_t n;
+        {
+            mutex::locker locked(pool->lock);
+            n = pool->next;
+            if (n >= pool->files->size())
+                return 0;
+            ++pool->next;
+        }
+        (*pool->files)[n]->fsck_contents(pool->problems[n]);
+    }
+}
+
+
+int
+directory::fsck_deep(unsigned jobs)
+{
+    DEBUG(1, "%s", __PRETTY_FUNCTION__);
+    if (jobs == 0)
+    {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        jobs = (ncpu > 0 ? ncpu : 1);
+    }
+    if (jobs > files.size())
+        jobs = files.size();
+
+    fsck_deep_pool pool;
+    pool.files = &files;
+    pool.next = 0;
+    pool.problems.resize(files.size());
+
+    //
+    // This thread works too, so if a thread can't be started, the work
+    // still gets done.
+    //
+    std::vector<pthread_t> threads;
+    for (unsigned j = 1; j < jobs; ++j)
+    {
+        pthread_t tid;
+        if (pthread_create(&tid, 0, fsck_deep_worker, &pool) != 0)
+            break;
+        threads.push_back(tid);
+    }
+    fsck_deep_worker(&pool);
+    for (size_t j = 0; j < threads.size(); ++j)
+        pthread_join(threads[j], 0);
+
+    //
+    // The problems are reported from this thread, so that they appear
+    // in block order, and reach the same place as the other messages.
+    //
+    fsck_errors[fsck_class_code] = 0;
+    fsck_errors[fsck_class_text] = 0;
+    int number_of_errors = 0;
+    for (size_t j = 0; j < files.size(); ++j)
+    {
+        directory_entry::pointer dep = files[j];
+        const rcstring_list &p = pool.problems[j];
+        for (size_t k = 0; k < p.size(); ++k)
+        {
+            explain_output_error
+            (
+                "file %s: %s",
+                dep->get_name().quote_c().c_str(),
+                p[k].c_str()
+            );
+            if (dep->get_file_kind() == directory_entry::codefile)
+                ++fsck_errors[fsck_class_code];
+            else
+                ++fsck_errors[fsck_class_text];
+            ++number_of_errors;
+        }
+    }
+    return number_of_errors;
+}
@@ -0,0 +1,267 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cassert>
+#include <cstring>
+
+#include <lib/byte_sex.h>
+#include <lib/debug.h>
+#include <lib/directory/journal.h>
+#include <lib/directory/journal/sidecar.h>
+#include <lib/directory/journal/twin.h>
+
+
+//
+// The on-disk layout of a journal slot.  All values are little-endian,
+// independent of the byte sex of the volume.
+//
+//   0..7     magic number
+//   8..11    sequence number
+//   12..13   from block
+//   14..15   to block
+//   16..17   number of blocks
+//   18..19   progress (number of blocks copied)
+//   20       length of file name
+//   21..35   file name
+//   508..511 checksum of bytes 0..507
+//
+static const char magic[8] = { 'P', 'S', 'Y', 'S', 'J', 'R', 'N', 'L' };
+
+
+static unsigned long
+checksum(const unsigned char *data)
+{
+    // FNV-1a, 32 bits
+    unsigned long h = 2166136261uL;
+    for (size_t j = 0; j < 508; ++j)
+    {
+        h ^= data[j];
+        h = (h * 16777619uL) & 0xFFFFFFFFuL;
+    }
+    return h;
+}
+
+
+static void
+put_long(unsigned char *data, unsigned long value)
+{
+    byte_sex_put_word_le(data, value & 0xFFFF);
+    byte_sex_put_word_le(data + 2, (value >> 16) & 0xFFFF);
+}
+
+
+static unsigned long
+get_long(const unsigned char *data)
+{
+    return
+        (
+            (unsigned long)byte_sex_get_word_le(data)
+        |
+            ((unsigned long)byte_sex_get_word_le(data + 2) << 16)
+        );
+}
+
+
+directory_journal::~directory_journal()
+{
+}
+
+
+directory_journal::directory_journal() :
+    sequence(0)
+{
+}
+
+
+directory_journal::pointer
+directory_journal::factory(const sector_io::pointer &deeper, bool twin)
+{
+    if (twin)
+        return directory_journal_twin::create(deeper);
+    return directory_journal_sidecar::create(deeper->get_filename());
+}
+
+
+bool
+directory_journal::record::source_intact(void)
+    const
+{
+    if (progress == 0)
+        return true;
+    if (from_block + num_blocks <= to_block)
+        return true;
+    if (to_block + num_blocks <= from_block)
+        return true;
+    return false;
+}
+
+
+int
+directory_journal::write_record(void)
+{
+    unsigned char data[512];
+    memset(data, 0, sizeof(data));
+    ++sequence;
+    memcpy(data, magic, sizeof(magic));
+    put_long(data + 8, sequence);
+    byte_sex_put_word_le(data + 12, current.from_block);
+    byte_sex_put_word_le(data + 14, current.to_block);
+    byte_sex_put_word_le(data + 16, current.num_blocks);
+    byte_sex_put_word_le(data + 18, current.progress);
+    size_t len = current.name.size();
+    if (len > 15)
+        len = 15;
+    data[20] = len;
+    memcpy(data + 21, current.name.c_str(), len);
+    put_long(data + 508, checksum(data));
+    return write_slot(sequence & 1, data);
+}
+
+
+int
+directory_journal::begin(const rcstring &name, unsigned from_block,
+    unsigned to_block, unsigned num_blocks)
+{
+    DEBUG(1, "%s", __PRETTY_FUNCTION__);
+    current.name = name;
+    current.from_block = from_block;
+    current.to_block = to_block;
+    current.num_blocks = num_blocks;
+    current.progress = 0;
+    return write_record();
+}
+
+
+int
+directory_journal::progress(unsigned num_blocks_done)
+{
+    DEBUG(2, "%s: %u", __PRETTY_FUNCTION__, num_blocks_done);
+    assert(num_blocks_done <= current.num_blocks);
+    current.progress = num_blocks_done;
+    return write_record();
+}
+
+
+int
+directory_journal::commit(void)
+{
+    DEBUG(1, "%s", __PRETTY_FUNCTION__);
+    current = record();
+    return erase();
+}
+
+
+int
+directory_journal::pending(record &rec)
+{
+    DEBUG(1, "%s", __PRETTY_FUNCTION__);
+    bool found = false;
+    unsigned long best = 0;
+    for (int slot = 0; slot < 2; ++slot)
+    {
+        unsigned char data[512];
+        int err = read_slot(slot, data);
+        if (err < 0)
+            return err;
+        if (err == 0)
+            continue;
+        if (0 != memcmp(data, magic, sizeof(magic)))
+            continue;
+        if (get_long(data + 508) != checksum(data))
+        {
+            DEBUG(1, "journal slot %d checksum mismatch", slot);
+            continue;
+        }
+        unsigned long seq = get_long(data + 8);
+        if (found && seq < best)
+            continue;
+        found = true;
+        best = seq;
+        size_t len = data[20];
+        if (len > 15)
+            len = 15;
+        current.name = rcstring((const char *)data + 21, len);
+        current.from_block = byte_sex_get_word_le(data + 12);
+        current.to_block = byte_sex_get_word_le(data + 14);
+        current.num_blocks = byte_sex_get_word_le(data + 16);
+        current.progress = byte_sex_get_word_le(data + 18);
+        if (current.progress > current.num_blocks)
+            current.progress = current.num_blocks;
+    }
+    if (!found)
+        return 0;
+    sequence = best;
+    rec = current;
+    return 1;
+}
+
+
+int
+directory_journal::resume(const sector_io::pointer &deeper)
+{
+    DEBUG(1, "%s", __PRETTY_FUNCTION__);
+    unsigned from = current.from_block;
+    unsigned to = current.to_block;
+    unsigned n = current.num_blocks;
+    if (from == to)
+        return 0;
+    unsigned distance = (from < to ? to - from : from - to);
+    unsigned chunk = (distance < n ? distance : n);
+    while (current.progress < n)
+    {
+        unsigned done = current.progress;
+        unsigned len = n - done;
+        if (len > chunk)
+            len = chunk;
+
+        //
+        // When moving down, copy from the front of the file.  When
+        // moving up, copy from the back of the file.  Either way the
+        // destination chunk never overlaps the source data which has
+        // yet to be copied.
+        //
+        unsigned src = from + done;
+        unsigned dst = to + done;
+        if (from < to)
+        {
+            src = from + n - done - len;
+            dst = to + n - done - len;
+        }
+        int err =
+            deeper->relocate_bytes
+            (
+                (off_t)dst << 9,
+                (off_t)src << 9,
+                (size_t)len << 9
+            );
+        if (err < 0)
+            return err;
+
+        //
+        // The data must be on the medium before the journal says it is.
+        //
+        err = deeper->sync();
+        if (err < 0)
+            return err;
+        err = progress(done + len);
+        if (err < 0)
+            return err;
+    }
+    return 0;
+}
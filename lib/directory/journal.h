@@ -0,0 +1,259 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#ifndef LIB_DIRECTORY_JOURNAL_H
+#define LIB_DIRECTORY_JOURNAL_H
+
+#include <boost/shared_ptr.hpp>
+
+#include <lib/rcstring.h>
+#include <lib/sector_io.h>
+
+/**
+  * The directory_journal class is used to represent an intent journal,
+  * recording the file extent relocation currently in progress.  If the
+  * relocation is interrupted (power failure, crash, kill -9) the
+  * journal contains enough information to roll the relocation forward
+  * (or back) the next time the disk image is opened read-write.
+  *
+  * The journal holds at most one record.  Records are written
+  * alternately into two 512-byte slots, each with a sequence number
+  * and a checksum, so that a torn write of one slot always leaves the
+  * previous record intact in the other.
+  */
+class directory_journal
+{
+public:
+    typedef boost::shared_ptr<directory_journal> pointer;
+
+    /**
+      * The destructor.
+      */
+    virtual ~directory_journal();
+
+    /**
+      * The factory class method is used to create a journal appropriate
+      * to the given volume.
+      *
+      * @param deeper
+      *     The sector I/O used to access the volume.
+      * @param twin
+      *     true if the volume has a second copy of the directory (the
+      *     volume label extends to block 10), in which case the journal
+      *     is kept within the second copy; false if there is only one
+      *     copy of the directory, in which case the journal is kept in
+      *     a sidecar file next to the disk image.
+      */
+    static pointer factory(const sector_io::pointer &deeper, bool twin);
+
+    /**
+      * The record class is used to represent the details of a single
+      * extent relocation.
+      */
+    struct record
+    {
+        record() : from_block(0), to_block(0), num_blocks(0), progress(0) { }
+
+        /**
+          * The name of the file being relocated.
+          */
+        rcstring name;
+
+        /**
+          * The first block of the file before the relocation.
+          */
+        unsigned from_block;
+
+        /**
+          * The first block of the file after the relocation.
+          */
+        unsigned to_block;
+
+        /**
+          * The size of the file, in blocks.
+          */
+        unsigned num_blocks;
+
+        /**
+          * The number of blocks known to have been copied.  When moving
+          * down the medium blocks are copied from the front of the
+          * file, when moving up they are copied from the back.
+          */
+        unsigned progress;
+
+        /**
+          * The source_intact method is used to determine whether or
+          * not the original extent is still unmodified, and thus the
+          * relocation may be rolled back simply by forgetting it.
+          */
+        bool source_intact(void) const;
+    };
+
+    /**
+      * The begin method is used to record the intent to relocate a
+      * file's extent.  It must be called before any data is moved.
+      *
+      * @param name
+      *     The name of the file being relocated.
+      * @param from_block
+      *     The first block of the file before the relocation.
+      * @param to_block
+      *     The first block of the file after the relocation.
+      * @param num_blocks
+      *     The size of the file, in blocks.
+      * @returns
+      *     zero on success, or -errno on error.
+      */
+    int begin(const rcstring &name, unsigned from_block, unsigned to_block,
+        unsigned num_blocks);
+
+    /**
+      * The progress method is used to record how far the relocation
+      * has proceeded.  The data blocks must have been synced to the
+      * medium before this method is called.
+      *
+      * @param num_blocks_done
+      *     The number of blocks copied so far.
+      * @returns
+      *     zero on success, or -errno on error.
+      */
+    int progress(unsigned num_blocks_done);
+
+    /**
+      * The commit method is used to discard the journal record, once
+      * the directory has been written to reflect the relocation.
+      *
+      * @returns
+      *     zero on success, or -errno on error.
+      */
+    int commit(void);
+
+    /**
+      * The pending method is used to read back any journal record left
+      * over from an interrupted relocation.
+      *
+      * @param rec
+      *     where to put the details of the interrupted relocation
+      * @returns
+      *     1 if a record was found, 0 if there is no record, or -errno
+      *     on error.
+      */
+    int pending(record &rec);
+
+    /**
+      * The resume method is used to copy the remaining data blocks of
+      * a relocation, updating the journal as it goes.  It is used both
+      * to perform a relocation after #begin has been called, and to
+      * roll forward an interrupted relocation.
+      *
+      * The data is copied in chunks no larger than the distance moved,
+      * so that no chunk ever overwrites its own source.  This makes
+      * copying a chunk a second time harmless, which is what allows an
+      * interrupted relocation to be resumed from the last recorded
+      * progress.
+      *
+      * @param deeper
+      *     The sector I/O used to access the volume data.
+      * @returns
+      *     zero on success, or -errno on error.
+      */
+    int resume(const sector_io::pointer &deeper);
+
+    /**
+      * The get_location method is used to obtain a human readable
+      * description of where the journal is kept, for error messages.
+      */
+    virtual rcstring get_location(void) const = 0;
+
+protected:
+    /**
+      * The default constructor.
+      * For use by derived classes only.
+      */
+    directory_journal();
+
+    /**
+      * The read_slot method is used to read the raw data of a journal
+      * slot.
+      *
+      * @param slot
+      *     The slot number, 0 or 1.
+      * @param data
+      *     Where to put the 512 bytes of data.
+      * @returns
+      *     1 if the slot was read, 0 if the slot does not exist, or
+      *     -errno on error.
+      */
+    virtual int read_slot(int slot, unsigned char *data) = 0;
+
+    /**
+      * The write_slot method is used to write the raw data of a journal
+      * slot, and make sure it has arrived on the medium.
+      *
+      * @param slot
+      *     The slot number, 0 or 1.
+      * @param data
+      *     The 512 bytes of data to be written.
+      * @returns
+      *     zero on success, or -errno on error.
+      */
+    virtual int write_slot(int slot, const unsigned char *data) = 0;
+
+    /**
+      * The erase method is used to remove all trace of the journal
+      * records.
+      *
+      * @returns
+      *     zero on success, or -errno on error.
+      */
+    virtual int erase(void) = 0;
+
+private:
+    /**
+      * The current instance variable is used to remember the details of
+      * the relocation in progress.
+      */
+    record current;
+
+    /**
+      * The sequence instance variable is used to remember the sequence
+      * number of the most recently written journal record.
+      */
+    unsigned sequence;
+
+    /**
+      * The write_record method is used to encode the #current record
+      * and write it to the next slot.
+      *
+      * @returns
+      *     zero on success, or -errno on error.
+      */
+    int write_record(void);
+
+    /**
+      * The copy constructor.  Do not use.
+      */
+    directory_journal(const directory_journal &);
+
+    /**
+      * The assignment operator.  Do not use.
+      */
+    directory_journal &operator=(const directory_journal &);
+};
+
+#endif // LIB_DIRECTORY_JOURNAL_H
@@ -0,0 +1,114 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <lib/debug.h>
+#include <lib/directory/journal/sidecar.h>
+
+
+directory_journal_sidecar::~directory_journal_sidecar()
+{
+    if (fd >= 0)
+        close(fd);
+    fd = -1;
+}
+
+
+directory_journal_sidecar::directory_journal_sidecar(
+    const rcstring &image_filename
+) :
+    filename(image_filename + ".journal"),
+    fd(-1)
+{
+}
+
+
+directory_journal::pointer
+directory_journal_sidecar::create(const rcstring &image_filename)
+{
+    return pointer(new directory_journal_sidecar(image_filename));
+}
+
+
+rcstring
+directory_journal_sidecar::get_location(void)
+    const
+{
+    return filename;
+}
+
+
+int
+directory_journal_sidecar::read_slot(int slot, unsigned char *data)
+{
+    int rfd = fd;
+    if (rfd < 0)
+    {
+        rfd = open(filename.c_str(), O_RDONLY);
+        if (rfd < 0)
+            return (errno == ENOENT ? 0 : -errno);
+    }
+    ssize_t n = pread(rfd, data, 512, (off_t)slot << 9);
+    int err = errno;
+    if (rfd != fd)
+        close(rfd);
+    if (n < 0)
+        return -err;
+    return (n == 512);
+}
+
+
+int
+directory_journal_sidecar::write_slot(int slot, const unsigned char *data)
+{
+    if (fd < 0)
+    {
+        fd = open(filename.c_str(), O_RDWR | O_CREAT, 0666);
+        if (fd < 0)
+            return -errno;
+        DEBUG(2, "journal %s opened", filename.quote_c().c_str());
+    }
+    ssize_t n = pwrite(fd, data, 512, (off_t)slot << 9);
+    if (n < 0)
+        return -errno;
+    if (n != 512)
+        return -ENOSPC;
+    if (fsync(fd) < 0)
+        return -errno;
+    return 0;
+}
+
+
+int
+directory_journal_sidecar::erase(void)
+{
+    if (fd >= 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+    if (unlink(filename.c_str()) < 0 && errno != ENOENT)
+        return -errno;
+    return 0;
+}
@@ -0,0 +1,101 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#ifndef LIB_DIRECTORY_JOURNAL_SIDECAR_H
+#define LIB_DIRECTORY_JOURNAL_SIDECAR_H
+
+#include <lib/directory/journal.h>
+
+/**
+  * The directory_journal_sidecar class is used to represent an intent
+  * journal kept in a separate file next to the disk image (the disk
+  * image file name with ".journal" appended).  The file only exists
+  * while a relocation is in progress.
+  */
+class directory_journal_sidecar:
+    public directory_journal
+{
+public:
+    /**
+      * The destructor.
+      */
+    virtual ~directory_journal_sidecar();
+
+private:
+    /**
+      * The constructor.
+      * It is private on purpose, use the #create class method instead.
+      *
+      * @param image_filename
+      *     The name of the disk image file being journaled.
+      */
+    directory_journal_sidecar(const rcstring &image_filename);
+
+public:
+    /**
+      * The create class method is used to create new dynamically
+      * allocated instances of this class.
+      *
+      * @param image_filename
+      *     The name of the disk image file being journaled.
+      */
+    static pointer create(const rcstring &image_filename);
+
+protected:
+    // See base class for documentation.
+    rcstring get_location(void) const;
+
+    // See base class for documentation.
+    int read_slot(int slot, unsigned char *data);
+
+    // See base class for documentation.
+    int write_slot(int slot, const unsigned char *data);
+
+    // See base class for documentation.
+    int erase(void);
+
+private:
+    /**
+      * The filename instance variable is used to remember the name of
+      * the journal file.
+      */
+    rcstring filename;
+
+    /**
+      * The fd instance variable is used to remember the file descriptor
+      * of the open journal file, or -1 if it is not open.
+      */
+    int fd;
+
+    /**
+      * The default constructor.  Do not use.
+      */
+    directory_journal_sidecar();
+
+    /**
+      * The copy constructor.  Do not use.
+      */
+    directory_journal_sidecar(const directory_journal_sidecar &);
+
+    /**
+      * The assignment operator.  Do not use.
+      */
+    directory_journal_sidecar &operator=(const directory_journal_sidecar &);
+};
+
+#endif // LIB_DIRECTORY_JOURNAL_SIDECAR_H
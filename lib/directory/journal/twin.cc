@@ -0,0 +1,101 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+
+#include <lib/directory/journal/twin.h>
+
+
+//
+// The directory starts at block 2, the second copy at block 6.
+//
+#define PRIMARY_OFFSET 0x400
+#define TWIN_OFFSET 0xC00
+
+
+directory_journal_twin::~directory_journal_twin()
+{
+}
+
+
+directory_journal_twin::directory_journal_twin(
+    const sector_io::pointer &a_deeper
+) :
+    deeper(a_deeper)
+{
+}
+
+
+directory_journal::pointer
+directory_journal_twin::create(const sector_io::pointer &a_deeper)
+{
+    return pointer(new directory_journal_twin(a_deeper));
+}
+
+
+rcstring
+directory_journal_twin::get_location(void)
+    const
+{
+    return
+        rcstring::printf
+        (
+            "%s: second directory copy",
+            deeper->get_filename().c_str()
+        );
+}
+
+
+int
+directory_journal_twin::read_slot(int slot, unsigned char *data)
+{
+    int err = deeper->read(TWIN_OFFSET + (slot << 9), data, 512);
+    if (err < 0)
+        return err;
+    return 1;
+}
+
+
+int
+directory_journal_twin::write_slot(int slot, const unsigned char *data)
+{
+    int err = deeper->write(TWIN_OFFSET + (slot << 9), data, 512);
+    if (err < 0)
+        return err;
+    return deeper->sync();
+}
+
+
+int
+directory_journal_twin::erase(void)
+{
+    //
+    // Erasing the journal means making the second copy of the directory
+    // the same as the first again.  The directory::meta_sync method
+    // can't be relied on to do it: it doesn't write a directory which
+    // hasn't changed since it last wrote it.
+    //
+    unsigned char buffer[2048];
+    int err = deeper->read(PRIMARY_OFFSET, buffer, sizeof(buffer));
+    if (err < 0)
+        return err;
+    err = deeper->write(TWIN_OFFSET, buffer, sizeof(buffer));
+    if (err < 0)
+        return err;
+    return deeper->sync();
+}
@@ -0,0 +1,98 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#ifndef LIB_DIRECTORY_JOURNAL_TWIN_H
+#define LIB_DIRECTORY_JOURNAL_TWIN_H
+
+#include <lib/directory/journal.h>
+
+/**
+  * The directory_journal_twin class is used to represent an intent
+  * journal kept in the second copy of the directory, on volumes which
+  * have one (the volume label extends to block 10).
+  *
+  * The second copy is only used for recovery.  Once the relocation is
+  * complete, erasing the journal copies the first copy of the directory
+  * over it again.
+  */
+class directory_journal_twin:
+    public directory_journal
+{
+public:
+    /**
+      * The destructor.
+      */
+    virtual ~directory_journal_twin();
+
+private:
+    /**
+      * The constructor.
+      * It is private on purpose, use the #create class method instead.
+      *
+      * @param deeper
+      *     The sector I/O used to access the volume.
+      */
+    directory_journal_twin(const sector_io::pointer &deeper);
+
+public:
+    /**
+      * The create class method is used to create new dynamically
+      * allocated instances of this class.
+      *
+      * @param deeper
+      *     The sector I/O used to access the volume.
+      */
+    static pointer create(const sector_io::pointer &deeper);
+
+protected:
+    // See base class for documentation.
+    rcstring get_location(void) const;
+
+    // See base class for documentation.
+    int read_slot(int slot, unsigned char *data);
+
+    // See base class for documentation.
+    int write_slot(int slot, const unsigned char *data);
+
+    // See base class for documentation.
+    int erase(void);
+
+private:
+    /**
+      * The deeper instance variable is used to remember the sector I/O
+      * used to access the volume.
+      */
+    sector_io::pointer deeper;
+
+    /**
+      * The default constructor.  Do not use.
+      */
+    directory_journal_twin();
+
+    /**
+      * The copy constructor.  Do not use.
+      */
+    directory_journal_twin(const directory_journal_twin &);
+
+    /**
+      * The assignment operator.  Do not use.
+      */
+    directory_journal_twin &operator=(const directory_journal_twin &);
+};
+
+#endif // LIB_DIRECTORY_JOURNAL_TWIN_H
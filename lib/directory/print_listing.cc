@@ -67,10 +67,9 @@ private:
 
 
 void
-directory::print_listing(bool verbose, sort_by_t sort_by)
+directory::print_listing(bool verbose, sort_by_t sort_by, FILE *fp)
 {
-    printf("%s:\n", volume_label->get_name().c_str());
-    unsigned num_blocks = volume_label->get_last_block();
+    fprintf(fp, "%s:\n", volume_label->get_name().c_str());
     int num_files = 0;
     typedef std::vector<directory_entry::pointer> entries_t;
     entries_t entries;
@@ -80,24 +79,31 @@ directory::print_listing(bool verbose, sort_by_t sort_by)
         if (!dep)
             break;
         entries.push_back(dep);
-        num_blocks += dep->size_in_blocks();
     }
     std::sort(entries.begin(), entries.end(), sorter(sort_by));
     for (entries_t::iterator it = entries.begin(); it != entries.end(); ++it)
-        (*it)->print_listing(verbose);
-    printf
+        (*it)->print_listing(fp, verbose);
+    fprintf
     (
+        fp,
         "%ld of %ld files\n",
         long(num_files - 1),
         (long)volume_label->maximum_directory_entries()
     );
     unsigned tblks = volume_label->get_eov_block();
-    printf
+    fprintf
     (
+        fp,
         "%d of %d blocks, %3.1f%% free\n",
-        num_blocks,
+        used_blocks,
         tblks,
-        100. * (tblks - num_blocks) / (double)tblks
+        100. * (tblks - used_blocks) / (double)tblks
     );
-    volume_label->print_listing(verbose);
+    if (verbose)
+    {
+        // This is the largest file the p-System itself could write.
+        fprintf(fp, "largest free extent: %d blocks\n",
+            largest_free_extent());
+    }
+    volume_label->print_listing(fp, verbose);
 }
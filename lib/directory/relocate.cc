@@ -0,0 +1,206 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cassert>
+#include <cstring>
+#include <libexplain/output.h>
+
+#include <lib/debug.h>
+#include <lib/directory.h>
+#include <lib/statistics.h>
+
+
+directory_journal::pointer
+directory::get_journal(void)
+{
+    if (!journal)
+    {
+        assert(volume_label);
+        bool twin = (volume_label->get_last_block() == 10);
+        journal = directory_journal::factory(deeper, twin);
+    }
+    return journal;
+}
+
+
+int
+directory::relocate_extent(const rcstring &name, unsigned from_block,
+    unsigned to_block, unsigned num_blocks)
+{
+    DEBUG(1, "%s", __PRETTY_FUNCTION__);
+    DEBUG(2, "name = %s, from = %u, to = %u, num_blocks = %u",
+        name.quote_c().c_str(), from_block, to_block, num_blocks);
+    if (from_block == to_block || num_blocks == 0)
+        return 0;
+    statistics::add(statistics::relocations);
+    statistics::add(statistics::relocation_bytes, (size_t)num_blocks << 9);
+    directory_journal::pointer jp = get_journal();
+    int err = jp->begin(name, from_block, to_block, num_blocks);
+    if (err < 0)
+    {
+        //
+        // Not being able to write the journal (for example, the
+        // directory containing the disk image is not writable) is not
+        // a good enough reason to refuse to move the file.  Say so
+        // once, and carry on without the safety net.
+        //
+        if (!journal_warned)
+        {
+            explain_output_warning
+            (
+                "%s: unable to write relocation journal, continuing "
+                    "without it (%s)",
+                jp->get_location().c_str(),
+                strerror(-err)
+            );
+            journal_warned = true;
+        }
+        return
+            deeper->relocate_bytes
+            (
+                (off_t)to_block << 9,
+                (off_t)from_block << 9,
+                (size_t)num_blocks << 9
+            );
+    }
+    return jp->resume(deeper);
+}
+
+
+int
+directory::journal_recover(concern_t concern_level)
+{
+    DEBUG(1, "%s", __PRETTY_FUNCTION__);
+    directory_journal::pointer jp = get_journal();
+    directory_journal::record rec;
+    int err = jp->pending(rec);
+    if (err < 0)
+    {
+        DEBUG(1, "journal: %s", strerror(-err));
+        return 0;
+    }
+    if (err == 0)
+        return 0;
+
+    //
+    // Work out what state the interrupted relocation was left in.
+    //
+    const char *action = "discarded";
+    bool roll_forward = false;
+    directory_entry::pointer dep = files.find(rec.name);
+    if
+    (
+        dep
+    &&
+        dep->size_in_blocks() == (int)rec.num_blocks
+    &&
+        dep->get_first_block() == (int)rec.from_block
+    )
+    {
+        if (rec.source_intact())
+        {
+            // The original data is untouched, forget the move.
+            action = "rolled back";
+        }
+        else
+        {
+            // The original data has been partially overwritten, the
+            // only way out is forward.
+            action = "rolled forward";
+            roll_forward = true;
+        }
+    }
+    else if
+    (
+        dep
+    &&
+        dep->size_in_blocks() == (int)rec.num_blocks
+    &&
+        dep->get_first_block() == (int)rec.to_block
+    )
+    {
+        // The directory was written, but the journal was not erased.
+        action = "already complete";
+    }
+
+    //
+    // Checking (as opposed to repairing) leaves the volume alone, as
+    // does a read-only open.  Otherwise, the recovery happens as soon
+    // as the volume is opened, before anything else can go wrong.
+    //
+    bool recover =
+        (!deeper->is_read_only() && concern_level != concern_check);
+    if (!recover)
+        action = "not recovered";
+
+    if (concern_level >= concern_check)
+    {
+        explain_output_error
+        (
+            "%s: relocation of %s from block %u to block %u was "
+                "interrupted after %u of %u blocks: %s",
+            jp->get_location().c_str(),
+            rec.name.quote_c().c_str(),
+            rec.from_block,
+            rec.to_block,
+            rec.progress,
+            rec.num_blocks,
+            action
+        );
+    }
+    int number_of_errors = (concern_level >= concern_check);
+    if (!recover)
+        return number_of_errors;
+
+    if (roll_forward)
+    {
+        err = jp->resume(deeper);
+        if (err < 0)
+            return err;
+
+        //
+        // Set the new location.  The order matters, so that the file's
+        // first block never passes its last block, which would lose
+        // the number of bytes in use in the last block.
+        //
+        int first = rec.to_block;
+        int last = first + rec.num_blocks;
+        if (rec.to_block > rec.from_block)
+        {
+            dep->fsck_last_block(last);
+            dep->fsck_first_block(first);
+        }
+        else
+        {
+            dep->fsck_first_block(first);
+            dep->fsck_last_block(last);
+        }
+    }
+
+    //
+    // Write the directory, and only then discard the journal.
+    //
+    err = meta_sync_now();
+    if (err < 0)
+        return err;
+    err = jp->commit();
+    if (err < 0)
+        return err;
+    return number_of_errors;
+}
@@ -0,0 +1,83 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <lib/debug.h>
+#include <lib/directory.h>
+
+
+directory *
+directory::try_factory(const rcstring &filename, bool read_only,
+    rcstring &interleave, concern_t concern)
+{
+    //
+    // The sector_io factory treats a file it can not open as a fatal
+    // error, so make sure it will be able to open this one.
+    //
+    struct stat st;
+    if (stat(filename.c_str(), &st) < 0)
+        return 0;
+    if (!S_ISREG(st.st_mode) && !S_ISBLK(st.st_mode))
+        return 0;
+    if (access(filename.c_str(), read_only ? R_OK : R_OK | W_OK) < 0)
+        return 0;
+    sector_io::pointer raw = sector_io::factory(filename, read_only);
+
+    //
+    // Sniff the file for interleaving, unless the caller already knows.
+    //
+    sector_io::pointer disk;
+    if (interleave.empty())
+    {
+        disk = sector_io::guess_interleaving(raw, &interleave);
+        if (!disk)
+        {
+            DEBUG(1, "%s: no volume label", filename.c_str());
+            return 0;
+        }
+    }
+    else
+        disk = sector_io::interleave_factory(interleave.c_str(), raw);
+
+    //
+    // A fatal error inside meta_read may throw (see lib/batch.cc), so
+    // don't leak the directory on the way out.
+    //
+    directory *dir = new directory(disk);
+    int err;
+    try
+    {
+        err = dir->meta_read(concern);
+    }
+    catch (...)
+    {
+        delete dir;
+        throw;
+    }
+    if (err < 0)
+    {
+        DEBUG(1, "read %s: %s", filename.c_str(), strerror(-err));
+        delete dir;
+        return 0;
+    }
+    return dir;
+}
@@ -0,0 +1,399 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <libexplain/close.h>
+#include <libexplain/flock.h>
+#include <libexplain/fopen.h>
+#include <libexplain/fstat.h>
+#include <libexplain/fsync.h>
+#include <libexplain/ftruncate.h>
+#include <libexplain/getc.h>
+#include <libexplain/mkdir.h>
+#include <libexplain/mmap.h>
+#include <libexplain/munmap.h>
+#include <libexplain/open.h>
+#include <libexplain/opendir.h>
+#include <libexplain/output.h>
+#include <libexplain/pread.h>
+#include <libexplain/pwrite.h>
+#include <libexplain/read.h>
+#include <libexplain/readdir.h>
+#include <libexplain/stat.h>
+#include <libexplain/utimes.h>
+#include <libexplain/write.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <lib/explain_mt.h>
+#include <lib/mutex.h>
+
+
+//
+// The explain_lock variable is used to serialize the formatting of
+// error messages.  It is held until the message has been reported; if
+// the thread then dies by exception (see lib/batch.cc) the lock is
+// released as the exception passes.
+//
+static mutex explain_lock;
+
+
+void
+explain_mt_close_or_die(int fildes)
+{
+    if (close(fildes) < 0)
+    {
+        int err = errno;
+        mutex::locker hold(explain_lock);
+        explain_output_error_and_die("%s", explain_errno_close(err, fildes));
+    }
+}
+
+
+void
+explain_mt_closedir_or_die(DIR *dir)
+{
+    // As for fclose, below, the directory stream is gone once closedir
+    // returns.
+    int fildes = dirfd(dir);
+    if (closedir(dir) < 0)
+    {
+        int err = errno;
+        mutex::locker hold(explain_lock);
+        explain_output_error_and_die("%s", explain_errno_close(err, fildes));
+    }
+}
+
+
+void
+explain_mt_fclose_or_die(FILE *fp)
+{
+    // The stream is gone once fclose returns, even when it fails, so
+    // the error is explained in terms of its file descriptor.
+    int fildes = fileno(fp);
+    if (fclose(fp))
+    {
+        int err = errno;
+        mutex::locker hold(explain_lock);
+        explain_output_error_and_die("%s", explain_errno_close(err, fildes));
+    }
+}
+
+
+FILE *
+explain_mt_fopen_or_die(const char *pathname, const char *flags)
+{
+    FILE *fp = fopen(pathname, flags);
+    if (!fp)
+    {
+        int err = errno;
+        mutex::locker hold(explain_lock);
+        explain_output_error_and_die
+        (
+            "%s",
+            explain_errno_fopen(err, pathname, flags)
+        );
+    }
+    return fp;
+}
+
+
+void
+explain_mt_flock_or_die(int fildes, int command)
+{
+    if (flock(fildes, command) < 0)
+    {
+        int err = errno;
+        mutex::locker hold(explain_lock);
+        explain_output_error_and_die
+        (
+            "%s",
+            explain_errno_flock(err, fildes, command)
+        );
+    }
+}
+
+
+void
+explain_mt_fstat_or_die(int fildes, struct stat *data)
+{
+    if (fstat(fildes, data) < 0)
+    {
+        int err = errno;
+        mutex::locker hold(explain_lock);
+        explain_output_error_and_die
+        (
+            "%s",
+            explain_errno_fstat(err, fildes, data)
+        );
+    }
+}
+
+
+void
+explain_mt_fsync_or_die(int fildes)
+{
+    if (fsync(fildes) < 0)
+    {
+        int err = errno;
+        mutex::locker hold(explain_lock);
+        explain_output_error_and_die("%s", explain_errno_fsync(err, fildes));
+    }
+}
+
+
+void
+explain_mt_ftruncate_or_die(int fildes, off_t length)
+{
+    if (ftruncate(fildes, length) < 0)
+    {
+        int err = errno;
+        mutex::locker hold(explain_lock);
+        explain_output_error_and_die
+        (
+            "%s",
+            explain_errno_ftruncate(err, fildes, length)
+        );
+    }
+}
+
+
+int
+explain_mt_getc_or_die(FILE *fp)
+{
+    int c = getc(fp);
+    if (c == EOF && ferror(fp))
+    {
+        int err = errno;
+        mutex::locker hold(explain_lock);
+        explain_output_error_and_die("%s", explain_errno_getc(err, fp));
+    }
+    return c;
+}
+
+
+void
+explain_mt_mkdir_or_die(const char *pathname, int mode)
+{
+    if (mkdir(pathname, mode) < 0)
+    {
+        int err = errno;
+        mutex::locker hold(explain_lock);
+        explain_output_error_and_die
+        (
+            "%s",
+            explain_errno_mkdir(err, pathname, mode)
+        );
+    }
+}
+
+
+void *
+explain_mt_mmap_or_die(void *data, size_t data_size, int prot, int flags,
+    int fildes, off_t offset)
+{
+    void *result = mmap(data, data_size, prot, flags, fildes, offset);
+    if (result == MAP_FAILED)
+    {
+        int err = errno;
+        mutex::locker hold(explain_lock);
+        explain_output_error_and_die
+        (
+            "%s",
+            explain_errno_mmap(err, data, data_size, prot, flags, fildes,
+                offset)
+        );
+    }
+    return result;
+}
+
+
+void
+explain_mt_munmap_or_die(void *data, size_t data_size)
+{
+    if (munmap(data, data_size) < 0)
+    {
+        int err = errno;
+        mutex::locker hold(explain_lock);
+        explain_output_error_and_die
+        (
+            "%s",
+            explain_errno_munmap(err, data, data_size)
+        );
+    }
+}
+
+
+int
+explain_mt_open_or_die(const char *pathname, int flags, int mode)
+{
+    int fd = open(pathname, flags, mode);
+    if (fd < 0)
+    {
+        int err = errno;
+        mutex::locker hold(explain_lock);
+        explain_output_error_and_die
+        (
+            "%s",
+            explain_errno_open(err, pathname, flags, mode)
+        );
+    }
+    return fd;
+}
+
+
+DIR *
+explain_mt_opendir_or_die(const char *pathname)
+{
+    DIR *dir = opendir(pathname);
+    if (!dir)
+    {
+        int err = errno;
+        mutex::locker hold(explain_lock);
+        explain_output_error_and_die
+        (
+            "%s",
+            explain_errno_opendir(err, pathname)
+        );
+    }
+    return dir;
+}
+
+
+ssize_t
+explain_mt_pread_or_die(int fildes, void *data, size_t data_size,
+    off_t offset)
+{
+    ssize_t n = pread(fildes, data, data_size, offset);
+    if (n < 0)
+    {
+        int err = errno;
+        mutex::locker hold(explain_lock);
+        explain_output_error_and_die
+        (
+            "%s",
+            explain_errno_pread(err, fildes, data, data_size, offset)
+        );
+    }
+    return n;
+}
+
+
+ssize_t
+explain_mt_pwrite_or_die(int fildes, const void *data, size_t data_size,
+    off_t offset)
+{
+    ssize_t n = pwrite(fildes, data, data_size, offset);
+    if (n < 0)
+    {
+        int err = errno;
+        mutex::locker hold(explain_lock);
+        explain_output_error_and_die
+        (
+            "%s",
+            explain_errno_pwrite(err, fildes, data, data_size, offset)
+        );
+    }
+    return n;
+}
+
+
+ssize_t
+explain_mt_read_or_die(int fildes, void *data, size_t data_size)
+{
+    ssize_t n = read(fildes, data, data_size);
+    if (n < 0)
+    {
+        int err = errno;
+        mutex::locker hold(explain_lock);
+        explain_output_error_and_die
+        (
+            "%s",
+            explain_errno_read(err, fildes, data, data_size)
+        );
+    }
+    return n;
+}
+
+
+struct dirent *
+explain_mt_readdir_or_die(DIR *dir)
+{
+    errno = 0;
+    struct dirent *dep = readdir(dir);
+    if (!dep && errno)
+    {
+        int err = errno;
+        mutex::locker hold(explain_lock);
+        explain_output_error_and_die("%s", explain_errno_readdir(err, dir));
+    }
+    return dep;
+}
+
+
+void
+explain_mt_stat_or_die(const char *pathname, struct stat *data)
+{
+    if (stat(pathname, data) < 0)
+    {
+        int err = errno;
+        mutex::locker hold(explain_lock);
+        explain_output_error_and_die
+        (
+            "%s",
+            explain_errno_stat(err, pathname, data)
+        );
+    }
+}
+
+
+void
+explain_mt_utimes_or_die(const char *pathname, const struct timeval *data)
+{
+    if (utimes(pathname, data) < 0)
+    {
+        int err = errno;
+        mutex::locker hold(explain_lock);
+        explain_output_error_and_die
+        (
+            "%s",
+            explain_errno_utimes(err, pathname, data)
+        );
+    }
+}
+
+
+ssize_t
+explain_mt_write_or_die(int fildes, const void *data, size_t data_size)
+{
+    ssize_t n = write(fildes, data, data_size);
+    if (n < 0)
+    {
+        int err = errno;
+        mutex::locker hold(explain_lock);
+        explain_output_error_and_die
+        (
+            "%s",
+            explain_errno_write(err, fildes, data, data_size)
+        );
+    }
+    return n;
+}
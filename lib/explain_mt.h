@@ -0,0 +1,68 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#ifndef LIB_EXPLAIN_MT_H
+#define LIB_EXPLAIN_MT_H
+
+#include <cstdio>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+
+//
+// The libexplain *_or_die functions format their error messages into a
+// buffer shared by all threads.  The functions below do the same job,
+// with the same arguments and results, but make the system call
+// themselves, and only call into libexplain (to format and report the
+// error) while holding a lock, so that two threads failing at once can
+// not garble each other's messages.
+//
+// They are to be used instead of the libexplain functions of the same
+// name by any code which may run in a worker thread: the batch actions,
+// fsck_deep, and ucsdpsys_mount when multi-threaded.
+//
+
+void explain_mt_close_or_die(int fildes);
+void explain_mt_closedir_or_die(DIR *dir);
+void explain_mt_fclose_or_die(FILE *fp);
+FILE *explain_mt_fopen_or_die(const char *pathname, const char *flags);
+void explain_mt_flock_or_die(int fildes, int command);
+void explain_mt_fstat_or_die(int fildes, struct stat *data);
+void explain_mt_fsync_or_die(int fildes);
+void explain_mt_ftruncate_or_die(int fildes, off_t length);
+int explain_mt_getc_or_die(FILE *fp);
+void explain_mt_mkdir_or_die(const char *pathname, int mode);
+void *explain_mt_mmap_or_die(void *data, size_t data_size, int prot,
+    int flags, int fildes, off_t offset);
+void explain_mt_munmap_or_die(void *data, size_t data_size);
+int explain_mt_open_or_die(const char *pathname, int flags, int mode);
+DIR *explain_mt_opendir_or_die(const char *pathname);
+ssize_t explain_mt_pread_or_die(int fildes, void *data, size_t data_size,
+    off_t offset);
+ssize_t explain_mt_pwrite_or_die(int fildes, const void *data,
+    size_t data_size, off_t offset);
+ssize_t explain_mt_read_or_die(int fildes, void *data, size_t data_size);
+struct dirent *explain_mt_readdir_or_die(DIR *dir);
+void explain_mt_stat_or_die(const char *pathname, struct stat *data);
+void explain_mt_utimes_or_die(const char *pathname,
+    const struct timeval *data);
+ssize_t explain_mt_write_or_die(int fildes, const void *data,
+    size_t data_size);
+
+#endif // LIB_EXPLAIN_MT_H
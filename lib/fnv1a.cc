@@ -0,0 +1,35 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+
+#include <lib/fnv1a.h>
+
+
+unsigned long long
+fnv1a_64(const void *data, size_t size, unsigned long long hash)
+{
+    const unsigned char *cp = (const unsigned char *)data;
+    const unsigned char *end = cp + size;
+    while (cp < end)
+    {
+        hash ^= *cp++;
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
@@ -0,0 +1,43 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#ifndef LIB_FNV1A_H
+#define LIB_FNV1A_H
+
+#include <cstddef>
+
+/**
+  * The fnv1a_64 function is used to calculate the 64-bit FNV-1a hash of
+  * some data.  It is fast, and good enough to tell blocks of data apart,
+  * but it is not cryptographic; callers which must not be fooled should
+  * compare the data as well.
+  *
+  * @param data
+  *     The data to be hashed.
+  * @param size
+  *     The size of the data, in bytes.
+  * @param hash
+  *     The hash so far, when hashing data in pieces.  Defaults to the
+  *     FNV-1a offset basis, for the first piece.
+  * @returns
+  *     the hash of the data.
+  */
+unsigned long long fnv1a_64(const void *data, size_t size,
+    unsigned long long hash = 0xCBF29CE484222325ULL);
+
+#endif // LIB_FNV1A_H
@@ -24,10 +24,10 @@
 
 //
 // IMPORTANT: you should define FUSE_USE_VERSION before including [the
-// fuse.h] header.  See the comment near the top of fuse.h for more
-// information.
+// fuse_lowlevel.h] header.  See the comment near the top of fuse_common.h
+// for more information.
 //
 #define FUSE_USE_VERSION 26
-#include <fuse.h>
+#include <fuse_lowlevel.h>
 
 #endif // LIB_FUSE_H
@@ -30,8 +30,7 @@ hexdump(const void *base, size_t len)
     if (len == 0)
         return "/* empty */";
     const unsigned char *cp = (const unsigned char *)base;
-    static rcstring_accumulator acc;
-    acc.clear();
+    rcstring_accumulator acc;
     for (size_t j = 0; j < len; j += 16)
     {
         if (j)
@@ -0,0 +1,322 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <libexplain/output.h>
+
+#include <lib/debug.h>
+#include <lib/input/tar.h>
+
+
+input_tar::~input_tar()
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+}
+
+
+input_tar::input_tar(const input::pointer &a_deeper) :
+    deeper(a_deeper)
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+}
+
+
+input_tar::pointer
+input_tar::create(const input::pointer &a_deeper)
+{
+    return pointer(new input_tar(a_deeper));
+}
+
+
+void
+input_tar::fatal_error(const char *message)
+{
+    explain_output_error_and_die("%s: %s", deeper->name().c_str(), message);
+}
+
+
+void
+input_tar::read_fully(void *data, size_t size)
+{
+    size_t nbytes = 0;
+    while (nbytes < size)
+    {
+        long n = deeper->read((char *)data + nbytes, size - nbytes);
+        if (n <= 0)
+            fatal_error("tar archive truncated");
+        nbytes += n;
+    }
+}
+
+
+bool
+input_tar::read_block(unsigned char *block)
+{
+    size_t nbytes = 0;
+    while (nbytes < 512)
+    {
+        long n = deeper->read(block + nbytes, 512 - nbytes);
+        if (n <= 0)
+            break;
+        nbytes += n;
+    }
+    if (nbytes == 0)
+        return false;
+    if (nbytes < 512)
+        fatal_error("tar archive truncated");
+    return true;
+}
+
+
+void
+input_tar::read_data(size_t size, std::vector<unsigned char> &data)
+{
+    data.resize(size);
+    read_fully(data.empty() ? 0 : &data[0], size);
+
+    //
+    // The data is padded to a whole number of blocks.
+    //
+    size_t partial = size & 511;
+    if (partial)
+    {
+        unsigned char padding[512];
+        read_fully(padding, 512 - partial);
+    }
+}
+
+
+static rcstring
+field(const char *data, size_t size)
+{
+    const char *end = (const char *)memchr(data, 0, size);
+    return rcstring(data, (end ? end - data : size));
+}
+
+
+static bool
+number(const char *data, size_t size, unsigned long &result)
+{
+    result = 0;
+    if ((unsigned char)data[0] & 0x80)
+    {
+        //
+        // The GNU base-256 form, for values too large for octal.
+        //
+        result = (unsigned char)data[0] & 0x3F;
+        for (size_t j = 1; j < size; ++j)
+            result = (result << 8) | (unsigned char)data[j];
+        return true;
+    }
+    size_t j = 0;
+    while (j < size && data[j] == ' ')
+        ++j;
+    for (; j < size && data[j] != '\0' && data[j] != ' '; ++j)
+    {
+        if (data[j] < '0' || data[j] > '7')
+            return false;
+        result = (result << 3) + (data[j] - '0');
+    }
+    return true;
+}
+
+
+bool
+input_tar::read_member(rcstring &name, time_t &mtime,
+    std::vector<unsigned char> &data)
+{
+    rcstring long_name;
+    bool have_mtime = false;
+    for (;;)
+    {
+        union
+        {
+            struct
+            {
+                char name[100];
+                char mode[8];
+                char uid[8];
+                char gid[8];
+                char size[12];
+                char mtime[12];
+                char chksum[8];
+                char typeflag;
+                char linkname[100];
+                char magic[6];
+                char version[2];
+                char uname[32];
+                char gname[32];
+                char devmajor[8];
+                char devminor[8];
+                char prefix[155];
+                char pad[12];
+            } h;
+            unsigned char raw[512];
+        } u;
+        if (!read_block(u.raw))
+            return false;
+
+        //
+        // The end of the archive is marked by blocks of zeros.
+        //
+        bool all_zero = true;
+        for (size_t j = 0; j < sizeof(u.raw); ++j)
+        {
+            if (u.raw[j])
+            {
+                all_zero = false;
+                break;
+            }
+        }
+        if (all_zero)
+            return false;
+
+        //
+        // The checksum is calculated with the checksum field set to
+        // blanks.
+        //
+        unsigned long chksum = 0;
+        if (!number(u.h.chksum, sizeof(u.h.chksum), chksum))
+            fatal_error("tar archive header checksum malformed");
+        memset(u.h.chksum, ' ', sizeof(u.h.chksum));
+        unsigned long sum = 0;
+        for (size_t j = 0; j < sizeof(u.raw); ++j)
+            sum += u.raw[j];
+        if (sum != chksum)
+            fatal_error("tar archive header checksum incorrect");
+
+        unsigned long size = 0;
+        if (!number(u.h.size, sizeof(u.h.size), size))
+            fatal_error("tar archive member size malformed");
+
+        switch (u.h.typeflag)
+        {
+        case 'L':
+            //
+            // GNU long name: the data is the name of the next member.
+            //
+            read_data(size, data);
+            if (!data.empty())
+                long_name = field((const char *)&data[0], data.size());
+            continue;
+
+        case 'x':
+            {
+                //
+                // POSIX pax extended header: "length key=value\n"
+                // records, which apply to the next member.
+                //
+                read_data(size, data);
+                if (data.empty())
+                    continue;
+                const char *cp = (const char *)&data[0];
+                const char *end = cp + data.size();
+                while (cp < end)
+                {
+                    //
+                    // The data is not NUL terminated, so the length is
+                    // parsed here, rather than with strtol.  The record
+                    // must have room for the space after the length and
+                    // the newline at the end.
+                    //
+                    const char *ep = cp;
+                    size_t len = 0;
+                    while (ep < end && isdigit((unsigned char)*ep))
+                    {
+                        len = len * 10 + (*ep - '0');
+                        if (len > (size_t)(end - cp))
+                            break;
+                        ++ep;
+                    }
+                    if
+                    (
+                        ep == cp
+                    ||
+                        len == 0
+                    ||
+                        ep >= end
+                    ||
+                        *ep != ' '
+                    ||
+                        len > (size_t)(end - cp)
+                    ||
+                        ep >= cp + len - 1
+                    )
+                    {
+                        fatal_error("tar archive pax header malformed");
+                    }
+                    rcstring record(ep + 1, cp + len - ep - 2);
+                    if (record.starts_with("path="))
+                        long_name = record.substring(5, record.size());
+                    else if (record.starts_with("mtime="))
+                    {
+                        mtime = atol(record.c_str() + 6);
+                        have_mtime = true;
+                    }
+                    cp += len;
+                }
+            }
+            continue;
+
+        case '0':
+        case '\0':
+        case '7':
+            break;
+
+        default:
+            //
+            // Directories, links, devices and the like have no place
+            // in a UCSD p-System volume.
+            //
+            read_data(size, data);
+            long_name = rcstring();
+            have_mtime = false;
+            continue;
+        }
+
+        if (!long_name.empty())
+            name = long_name;
+        else
+        {
+            name = field(u.h.name, sizeof(u.h.name));
+
+            //
+            // Only POSIX archives have the prefix field; old GNU
+            // archives use the space for other things.
+            //
+            if (!memcmp(u.h.magic, "ustar", 6))
+            {
+                rcstring prefix = field(u.h.prefix, sizeof(u.h.prefix));
+                if (!prefix.empty())
+                    name = prefix + "/" + name;
+            }
+        }
+        if (!have_mtime)
+        {
+            unsigned long when = 0;
+            if (!number(u.h.mtime, sizeof(u.h.mtime), when))
+                fatal_error("tar archive member mtime malformed");
+            mtime = when;
+        }
+        read_data(size, data);
+        return true;
+    }
+}
@@ -0,0 +1,145 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#ifndef LIB_INPUT_TAR_H
+#define LIB_INPUT_TAR_H
+
+#include <ctime>
+#include <vector>
+
+#include <lib/input.h>
+#include <lib/rcstring.h>
+
+/**
+  * The input_tar class is used to read the regular files from a tar
+  * archive (POSIX ustar, with the GNU long name and pax extensions),
+  * one member at a time, as a stream.
+  */
+class input_tar
+{
+public:
+    typedef boost::shared_ptr<input_tar> pointer;
+
+    /**
+      * The destructor.
+      */
+    virtual ~input_tar();
+
+private:
+    /**
+      * The constructor.  It is private on purpose, use the #create
+      * class method instead.
+      *
+      * @param deeper
+      *     Where to read the archive from.
+      */
+    input_tar(const input::pointer &deeper);
+
+public:
+    /**
+      * The create class method is used to create new dynamically
+      * allocated instances of this class.
+      *
+      * @param deeper
+      *     Where to read the archive from.
+      */
+    static pointer create(const input::pointer &deeper);
+
+    /**
+      * The read_member method is used to read the next regular file
+      * from the archive.  Directories, links and other kinds of member
+      * are skipped.  Format errors are fatal.
+      *
+      * @param name
+      *     Where to put the path of the file within the archive.
+      * @param mtime
+      *     Where to put the time the file was last modified.
+      * @param data
+      *     Where to put the contents of the file.
+      * @returns
+      *     true if a file was read, false at the end of the archive.
+      */
+    bool read_member(rcstring &name, time_t &mtime,
+        std::vector<unsigned char> &data);
+
+private:
+    /**
+      * The deeper instance variable is used to remember where to read
+      * the archive from.
+      */
+    input::pointer deeper;
+
+    /**
+      * The fatal_error method is used to report a fatal error in the
+      * format of the archive.  It does not return.
+      *
+      * @param message
+      *     What is wrong with the archive.
+      */
+    void fatal_error(const char *message);
+
+    /**
+      * The read_block method is used to read the next 512-byte block
+      * of the archive.
+      *
+      * @param block
+      *     Where to put the data.
+      * @returns
+      *     true if a block was read, false at end of file.
+      */
+    bool read_block(unsigned char *block);
+
+    /**
+      * The read_fully method is used to read exactly the given amount of
+      * data from the archive.  A short read is a fatal error.
+      *
+      * @param data
+      *     Where to put the data.
+      * @param size
+      *     The number of bytes to read.
+      */
+    void read_fully(void *data, size_t size);
+
+    /**
+      * The read_data method is used to read the data of a member, and
+      * the padding after it.
+      *
+      * @param size
+      *     The size of the member's data, in bytes.
+      * @param data
+      *     Where to put the data.
+      */
+    void read_data(size_t size, std::vector<unsigned char> &data);
+
+    /**
+      * The default constructor.  Do not use.
+      */
+    input_tar();
+
+    /**
+      * The copy constructor.  Do not use.
+      */
+    input_tar(const input_tar &);
+
+    /**
+      * The assignment operator.  Do not use.
+      */
+    input_tar &operator=(const input_tar &);
+};
+
+#endif // LIB_INPUT_TAR_H
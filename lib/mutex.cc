@@ -0,0 +1,59 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cstring>
+#include <libexplain/output.h>
+
+#include <lib/mutex.h>
+
+
+mutex::~mutex()
+{
+    pthread_mutex_destroy(&mtx);
+}
+
+
+mutex::mutex()
+{
+    int err = pthread_mutex_init(&mtx, 0);
+    if (err)
+        explain_output_error_and_die("pthread_mutex_init: %s", strerror(err));
+}
+
+
+void
+mutex::lock(void)
+{
+    int err = pthread_mutex_lock(&mtx);
+    if (err)
+        explain_output_error_and_die("pthread_mutex_lock: %s", strerror(err));
+}
+
+
+void
+mutex::unlock(void)
+{
+    int err = pthread_mutex_unlock(&mtx);
+    if (err)
+        explain_output_error_and_die
+        (
+            "pthread_mutex_unlock: %s",
+            strerror(err)
+        );
+}
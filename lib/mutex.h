@@ -0,0 +1,86 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#ifndef LIB_MUTEX_H
+#define LIB_MUTEX_H
+
+#include <pthread.h>
+
+/**
+  * The mutex class is used to represent a mutual exclusion lock, which
+  * at most one thread may hold at a time.
+  */
+class mutex
+{
+public:
+    /**
+      * The destructor.
+      */
+    virtual ~mutex();
+
+    /**
+      * The default constructor.
+      */
+    mutex();
+
+    /**
+      * The lock method is used to wait until no other thread holds the
+      * mutex, and then take it.
+      */
+    void lock(void);
+
+    /**
+      * The unlock method is used to release the mutex.
+      */
+    void unlock(void);
+
+    /**
+      * The locker class is used to hold a mutex for the lifetime of the
+      * locker object.
+      */
+    class locker
+    {
+    public:
+        locker(mutex &a_mtx) : mtx(a_mtx) { mtx.lock(); }
+        ~locker() { mtx.unlock(); }
+
+    private:
+        mutex &mtx;
+        locker(const locker &);
+        locker &operator=(const locker &);
+    };
+
+private:
+    /**
+      * The mtx instance variable is used to remember the underlying
+      * POSIX threads mutex.
+      */
+    pthread_mutex_t mtx;
+
+    /**
+      * The copy constructor.  Do not use.
+      */
+    mutex(const mutex &);
+
+    /**
+      * The assignment operator.  Do not use.
+      */
+    mutex &operator=(const mutex &);
+};
+
+#endif // LIB_MUTEX_H
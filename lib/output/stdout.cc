@@ -19,8 +19,8 @@
 #include <lib/config.h>
 #include <cstdio>
 #include <unistd.h>
-#include <libexplain/write.h>
 
+#include <lib/explain_mt.h>
 #include <lib/output/stdout.h>
 #include <lib/rcstring.h>
 
@@ -59,7 +59,7 @@ output_stdout::filename()
 void
 output_stdout::write_inner(const void *data, size_t len)
 {
-    explain_write_or_die(fileno(stdout), data, len);
+    explain_mt_write_or_die(fileno(stdout), data, len);
     if (len > 0)
         bol = (((const char *)data)[len - 1] == '\n');
     pos += len;
@@ -0,0 +1,217 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <libexplain/output.h>
+
+#include <lib/debug.h>
+#include <lib/output/memory.h>
+#include <lib/output/tar.h>
+
+
+output_tar::~output_tar()
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    close();
+}
+
+
+output_tar::output_tar(const output::pointer &a_deeper) :
+    deeper(a_deeper),
+    closed(false),
+    mode(0666)
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+
+    //
+    // The files are given the same permissions output_file would give
+    // them, had they been written to a directory.
+    //
+    mode_t um = umask(0);
+    umask(um);
+    mode &= ~um;
+}
+
+
+output_tar::pointer
+output_tar::create(const output::pointer &a_deeper)
+{
+    return pointer(new output_tar(a_deeper));
+}
+
+
+static void
+octal(char *field, size_t field_size, unsigned long value)
+{
+    // The value is zero filled, and NUL terminated.
+    field[--field_size] = '\0';
+    while (field_size > 0)
+    {
+        field[--field_size] = '0' + (value & 7);
+        value >>= 3;
+    }
+}
+
+
+void
+output_tar::write_header(const rcstring &name, size_t size, time_t mtime)
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    struct ustar_header
+    {
+        char name[100];
+        char mode[8];
+        char uid[8];
+        char gid[8];
+        char size[12];
+        char mtime[12];
+        char chksum[8];
+        char typeflag;
+        char linkname[100];
+        char magic[6];
+        char version[2];
+        char uname[32];
+        char gname[32];
+        char devmajor[8];
+        char devminor[8];
+        char prefix[155];
+        char pad[12];
+    };
+    union
+    {
+        ustar_header h;
+        unsigned char raw[block_size];
+    } u;
+    memset(&u, 0, sizeof(u));
+
+    if (name.size() > sizeof(u.h.name))
+    {
+        explain_output_error_and_die
+        (
+            "%s: %s: file name too long for a tar archive",
+            deeper->filename().c_str(),
+            name.c_str()
+        );
+    }
+    memcpy(u.h.name, name.c_str(), name.size());
+
+    octal(u.h.mode, sizeof(u.h.mode), mode);
+    octal(u.h.uid, sizeof(u.h.uid), getuid());
+    octal(u.h.gid, sizeof(u.h.gid), getgid());
+    octal(u.h.size, sizeof(u.h.size), size);
+    octal(u.h.mtime, sizeof(u.h.mtime), (mtime < 0 ? 0 : mtime));
+    u.h.typeflag = '0';
+    memcpy(u.h.magic, "ustar", 6);
+    memcpy(u.h.version, "00", 2);
+
+    //
+    // The checksum is calculated with the checksum field set to blanks.
+    //
+    memset(u.h.chksum, ' ', sizeof(u.h.chksum));
+    unsigned long sum = 0;
+    for (size_t j = 0; j < sizeof(u.raw); ++j)
+        sum += u.raw[j];
+    snprintf(u.h.chksum, sizeof(u.h.chksum), "%06lo", sum);
+
+    deeper->write(u.raw, sizeof(u.raw));
+}
+
+
+void
+output_tar::write_padding(size_t size)
+{
+    static const char zero[block_size] = { 0 };
+    size_t partial = size % block_size;
+    if (partial)
+        deeper->write(zero, block_size - partial);
+}
+
+
+void
+output_tar::add(const rcstring &name, const void *data, size_t size,
+    time_t mtime)
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    write_header(name, size, mtime);
+    deeper->write(data, size);
+    write_padding(size);
+}
+
+
+void
+output_tar::add(const rcstring &name, const input::pointer &ip,
+    time_t mtime)
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    long length = ip->length();
+    if (length < 0)
+    {
+        //
+        // The header needs the size, so an input of unknown length has
+        // to be read into memory first.
+        //
+        output_memory::mpointer mem = output_memory::create();
+        mem->write(ip);
+        mem->flush();
+        add(name, mem->get_data(), mem->size(), mtime);
+        return;
+    }
+
+    write_header(name, length, mtime);
+    size_t remaining = length;
+    while (remaining > 0)
+    {
+        char buffer[1 << 14];
+        size_t nbytes = remaining;
+        if (nbytes > sizeof(buffer))
+            nbytes = sizeof(buffer);
+        long n = ip->read(buffer, nbytes);
+        if (n <= 0)
+        {
+            explain_output_error_and_die
+            (
+                "%s: short read, %ld bytes expected",
+                ip->name().c_str(),
+                length
+            );
+        }
+        deeper->write(buffer, n);
+        remaining -= n;
+    }
+    write_padding(length);
+}
+
+
+void
+output_tar::close(void)
+{
+    if (closed)
+        return;
+    closed = true;
+
+    //
+    // The end of the archive is marked by two blocks of zeros.
+    //
+    static const char zero[2 * block_size] = { 0 };
+    deeper->write(zero, sizeof(zero));
+    deeper->flush();
+}
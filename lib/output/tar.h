@@ -0,0 +1,159 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#ifndef LIB_OUTPUT_TAR_H
+#define LIB_OUTPUT_TAR_H
+
+#include <ctime>
+
+#include <lib/output.h>
+#include <lib/rcstring.h>
+
+/**
+  * The output_tar class is used to write a POSIX ustar archive to an
+  * output stream, one member at a time, without using any temporary
+  * files.
+  */
+class output_tar
+{
+public:
+    typedef boost::shared_ptr<output_tar> pointer;
+
+    /**
+      * The destructor.
+      * It finishes the archive, if #close has not already done so.
+      */
+    virtual ~output_tar();
+
+private:
+    /**
+      * The constructor.  It is private on purpose, use the #create
+      * class method instead.
+      *
+      * @param deeper
+      *     Where to write the archive.
+      */
+    output_tar(const output::pointer &deeper);
+
+public:
+    /**
+      * The create class method is used to create new dynamically
+      * allocated instances of this class.
+      *
+      * @param deeper
+      *     Where to write the archive.
+      */
+    static pointer create(const output::pointer &deeper);
+
+    /**
+      * The add method is used to add a file to the archive, copying its
+      * contents directly from the given input.  The length of the input
+      * must be known in advance, because it is written into the member's
+      * header, before the data.
+      *
+      * @param name
+      *     The name of the file within the archive.
+      * @param ip
+      *     The contents of the file.
+      * @param mtime
+      *     The time the file was last modified.
+      */
+    void add(const rcstring &name, const input::pointer &ip, time_t mtime);
+
+    /**
+      * The add method is used to add a file to the archive, from data
+      * in memory.
+      *
+      * @param name
+      *     The name of the file within the archive.
+      * @param data
+      *     The contents of the file.
+      * @param size
+      *     The size of the file, in bytes.
+      * @param mtime
+      *     The time the file was last modified.
+      */
+    void add(const rcstring &name, const void *data, size_t size,
+        time_t mtime);
+
+    /**
+      * The close method is used to finish the archive, by writing the
+      * end-of-archive marker, and flushing the output.
+      */
+    void close(void);
+
+    enum { block_size = 512 };
+
+private:
+    /**
+      * The deeper instance variable is used to remember where to write
+      * the archive.
+      */
+    output::pointer deeper;
+
+    /**
+      * The closed instance variable is used to remember whether or not
+      * the end-of-archive marker has been written.
+      */
+    bool closed;
+
+    /**
+      * The mode instance variable is used to remember the permissions
+      * to give the files in the archive.
+      */
+    unsigned mode;
+
+    /**
+      * The write_header method is used to write the ustar header of
+      * a member of the archive.
+      *
+      * @param name
+      *     The name of the file within the archive.
+      * @param size
+      *     The size of the file, in bytes.
+      * @param mtime
+      *     The time the file was last modified.
+      */
+    void write_header(const rcstring &name, size_t size, time_t mtime);
+
+    /**
+      * The write_padding method is used to pad the data of a member
+      * out to a whole number of blocks.
+      *
+      * @param size
+      *     The size of the file, in bytes.
+      */
+    void write_padding(size_t size);
+
+    /**
+      * The default constructor.  Do not use.
+      */
+    output_tar();
+
+    /**
+      * The copy constructor.  Do not use.
+      */
+    output_tar(const output_tar &);
+
+    /**
+      * The assignment operator.  Do not use.
+      */
+    output_tar &operator=(const output_tar &);
+};
+
+#endif // LIB_OUTPUT_TAR_H
@@ -20,6 +20,7 @@
 
 #include <lib/rcstring.h>
 #include <lib/output/text_decode.h>
+#include <lib/text_scan.h>
 
 
 output_text_decode::~output_text_decode()
@@ -33,11 +34,11 @@ output_text_decode::~output_text_decode()
 
 
 output_text_decode::output_text_decode(const output::pointer &a_deeper,
-        bool a_use_tabs) :
+        bool a_use_tabs, bool a_header) :
     deeper(a_deeper),
     column(0),
     non_white(false),
-    start_of_file(1024),
+    start_of_file(a_header ? 1024 : 0),
     dle_seen(false),
     use_tabs(a_use_tabs)
 {
@@ -45,9 +46,10 @@ output_text_decode::output_text_decode(const output::pointer &a_deeper,
 
 
 output::pointer
-output_text_decode::create(const output::pointer &a_deeper, bool a_use_tabs)
+output_text_decode::create(const output::pointer &a_deeper, bool a_use_tabs,
+    bool a_header)
 {
-    return pointer(new output_text_decode(a_deeper, a_use_tabs));
+    return pointer(new output_text_decode(a_deeper, a_use_tabs, a_header));
 }
 
 
@@ -106,6 +108,23 @@ output_text_decode::write_inner(const void *vdata, size_t size)
     //
     while (size > 0)
     {
+        //
+        // In the middle of a line, everything except NUL, CR, NL and
+        // DLE is copied through unchanged, so copy the whole run at once.
+        //
+        if (non_white && !dle_seen)
+        {
+            size_t n = text_scan_decode(data, size);
+            if (n > 0)
+            {
+                deeper->write(data, n);
+                column += n;
+                data += n;
+                size -= n;
+                continue;
+            }
+        }
+
         unsigned char c = *data++;
         --size;
         if (dle_seen)
@@ -179,6 +198,107 @@ output_text_decode::write_inner(const void *vdata, size_t size)
 }
 
 
+output_text_decode::counter::counter(bool a_use_tabs, bool a_header) :
+    column(0),
+    non_white(false),
+    start_of_file(a_header ? 1024 : 0),
+    dle_seen(false),
+    use_tabs(a_use_tabs)
+{
+}
+
+
+size_t
+output_text_decode::counter::count(const void *vdata, size_t size)
+{
+    const unsigned char *data = (const unsigned char *)vdata;
+    if (start_of_file == 1024 && is_text_buffer(data, size))
+        start_of_file = 0;
+    while (size > 0 && start_of_file > 0)
+    {
+        ++data;
+        --size;
+        --start_of_file;
+    }
+
+    //
+    // This must follow exactly the same rules as write_inner, above,
+    // but counts the output rather than producing it.
+    //
+    size_t result = 0;
+    while (size > 0)
+    {
+        unsigned char c = *data++;
+        --size;
+        if (dle_seen)
+        {
+            dle_seen = false;
+            if (c < 32)
+            {
+                --data;
+                ++size;
+                goto normal;
+            }
+            c -= 32;
+            if (non_white)
+                result += c;
+            column += c;
+            continue;
+        }
+        switch (c)
+        {
+        case '\0':
+            break;
+
+        case '\r':
+        case '\n':
+            ++result;
+            column = 0;
+            non_white = false;
+            break;
+
+        case 16:
+            dle_seen = true;
+            break;
+
+        default:
+            normal:
+            if (!non_white)
+            {
+                int ocol = 0;
+                if (use_tabs)
+                {
+                    for (;;)
+                    {
+                        if (ocol + 1 == column)
+                            break;
+                        int ocol2 = (ocol + 8) & ~7;
+                        if (ocol2 > column)
+                            break;
+                        ++result;
+                        ocol = ocol2;
+                    }
+                }
+                result += column - ocol;
+                non_white = true;
+            }
+            ++result;
+            ++column;
+            break;
+        }
+    }
+    return result;
+}
+
+
+bool
+output_text_decode::counter::at_start_of_line(void)
+    const
+{
+    return (column == 0 && !non_white && !dle_seen);
+}
+
+
 void
 output_text_decode::flush_inner()
 {
@@ -45,9 +45,13 @@ private:
       * @param use_tabs
       *     true if 8-character tabs should be used, or false if spaces
       *     should be used
+      * @param header
+      *     true if the data could start with the 1KB header used by
+      *     the text editor, or false if decoding is starting part way
+      *     through a file, after the header.
       */
     output_text_decode(const output::pointer &deeper,
-        bool use_tabs = true);
+        bool use_tabs = true, bool header = true);
 
 public:
     /**
@@ -60,8 +64,89 @@ public:
       * @param use_tabs
       *     true if 8-character tabs should be used, or false if spaces
       *     should be used
+      * @param header
+      *     true if the data could start with the 1KB header used by
+      *     the text editor, or false if decoding is starting part way
+      *     through a file, after the header.
       */
-    static pointer create(const output::pointer &deeper, bool use_tabs = true);
+    static pointer create(const output::pointer &deeper, bool use_tabs = true,
+        bool header = true);
+
+    /**
+      * The decode_parallel class method is used to decode a whole UCSD
+      * p-System text file, held in memory, using several threads.
+      *
+      * Pages written by the text editor hold whole lines, so runs of
+      * pages can be decoded independently.  Each thread decodes a run
+      * of pages into a private buffer, and the buffers are then written
+      * to the deeper output in order.  Runs only ever start on a page
+      * which starts a line; the output is exactly the same as the
+      * output of the sequential decoder.
+      *
+      * @param data
+      *     The UCSD p-System text to be decoded.
+      * @param size
+      *     The number of bytes of text.
+      * @param deeper
+      *     Where to write the decoded text.
+      * @param use_tabs
+      *     true if 8-character tabs should be used, or false if spaces
+      *     should be used
+      * @param jobs
+      *     The maximum number of threads to use, or zero for one per
+      *     online processor.
+      */
+    static void decode_parallel(const void *data, size_t size,
+        const output::pointer &deeper, bool use_tabs = true,
+        unsigned jobs = 0);
+
+    /**
+      * The counter class is used to calculate the size of the Unix text
+      * which UCSD p-System text would decode to, without producing the
+      * text.  It follows exactly the same rules as the decoder.
+      */
+    class counter
+    {
+    public:
+        /**
+          * The constructor.
+          *
+          * @param use_tabs
+          *     true if 8-character tabs would be used, or false if
+          *     spaces would be used
+          * @param header
+          *     true if the data could start with the 1KB header used by
+          *     the text editor, or false if counting is starting part
+          *     way through a file, after the header.
+          */
+        counter(bool use_tabs = true, bool header = true);
+
+        /**
+          * The count method is used to count the decoded size of the
+          * next piece of the text.
+          *
+          * @param data
+          *     The UCSD p-System text to be counted.
+          * @param size
+          *     The number of bytes of text.
+          * @returns
+          *     the number of bytes of Unix text this would decode to
+          */
+        size_t count(const void *data, size_t size);
+
+        /**
+          * The at_start_of_line method is used to determine whether or
+          * not the text counted so far ends at the end of a line.
+          */
+        bool at_start_of_line(void) const;
+
+    private:
+        int column;
+        bool non_white;
+        int start_of_file;
+        bool dle_seen;
+        bool use_tabs;
+    };
 
 protected:
     // See base class for documentation.
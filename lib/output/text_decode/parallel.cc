@@ -0,0 +1,190 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <vector>
+
+#include <lib/output/memory.h>
+#include <lib/output/text_decode.h>
+
+
+//
+// Small files are not worth the cost of starting threads.
+//
+#define MINIMUM_PAGES_PER_JOB 64
+
+
+static bool
+page_starts_line(const unsigned char *data, size_t page)
+{
+    //
+    // Look backwards for the last non-NUL character before the start
+    // of the page.  The page starts a line if it is a line terminator,
+    // or there is no such character.
+    //
+    size_t j = page << 10;
+    while (j > 0)
+    {
+        --j;
+        unsigned char c = data[j];
+        if (c == '\0')
+            continue;
+        return (c == '\r' || c == '\n');
+    }
+    return true;
+}
+
+
+struct decode_job
+{
+    const unsigned char *data;
+    size_t size;
+    bool header;
+    output_memory::mpointer result;
+};
+
+
+struct decode_pool
+{
+    pthread_mutex_t lock;
+    std::vector<decode_job> jobs;
+    size_t next;
+    bool use_tabs;
+};
+
+
+static void
+decode_one(decode_job &job, bool use_tabs)
+{
+    job.result = output_memory::create();
+    output::pointer op =
+        output_text_decode::create(job.result, use_tabs, job.header);
+
+    //
+    // Give the decoder one page at a time, so that the decision about
+    // whether or not the file has a header is made exactly as it is by
+    // the sequential decoder.
+    //
+    for (size_t j = 0; j < job.size; j += 1024)
+    {
+        size_t len = job.size - j;
+        if (len > 1024)
+            len = 1024;
+        op->write(job.data + j, len);
+    }
+    op.reset();
+    job.result->flush();
+}
+
+
+static void *
+decode_worker(void *arg)
+{
+    decode_pool *pool = (decode_pool *)arg;
+    for (;;)
+    {
+        pthread_mutex_lock(&pool->lock);
+        size_t n = pool->next;
+        if (n < pool->jobs.size())
+            ++pool->next;
+        pthread_mutex_unlock(&pool->lock);
+        if (n >= pool->jobs.size())
+            return 0;
+        decode_one(pool->jobs[n], pool->use_tabs);
+    }
+}
+
+
+void
+output_text_decode::decode_parallel(const void *vdata, size_t size,
+    const output::pointer &deeper, bool use_tabs, unsigned max_jobs)
+{
+    const unsigned char *data = (const unsigned char *)vdata;
+    size_t npages = (size + 1023) >> 10;
+    if (max_jobs == 0)
+    {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+        max_jobs = (ncpu > 0 ? ncpu : 1);
+    }
+    if (max_jobs > npages / MINIMUM_PAGES_PER_JOB)
+        max_jobs = npages / MINIMUM_PAGES_PER_JOB;
+    if (max_jobs <= 1)
+    {
+        output::pointer op = output_text_decode::create(deeper, use_tabs);
+        for (size_t j = 0; j < size; j += 1024)
+            op->write(data + j, (size - j < 1024 ? size - j : 1024));
+        op->flush();
+        return;
+    }
+
+    //
+    // Split the pages into runs, several per thread so that the threads
+    // stay busy even when some runs decode faster than others.  Move
+    // each split forward, if necessary, to a page which starts a line.
+    //
+    decode_pool pool;
+    pool.next = 0;
+    pool.use_tabs = use_tabs;
+    size_t pages_per_job = (npages + 4 * max_jobs - 1) / (4 * max_jobs);
+    size_t first = 0;
+    while (first < npages)
+    {
+        size_t last = first + pages_per_job;
+        while (last < npages && !page_starts_line(data, last))
+            ++last;
+        if (last > npages)
+            last = npages;
+        decode_job job;
+        job.data = data + (first << 10);
+        job.size = (last - first) << 10;
+        if (last == npages)
+            job.size = size - (first << 10);
+        job.header = (first == 0);
+        pool.jobs.push_back(job);
+        first = last;
+    }
+
+    //
+    // Start the threads.  This thread works too, so if a thread can't
+    // be started, the work still gets done.
+    //
+    pthread_mutex_init(&pool.lock, 0);
+    std::vector<pthread_t> threads;
+    for (unsigned j = 1; j < max_jobs; ++j)
+    {
+        pthread_t tid;
+        if (pthread_create(&tid, 0, decode_worker, &pool) != 0)
+            break;
+        threads.push_back(tid);
+    }
+    decode_worker(&pool);
+    for (size_t j = 0; j < threads.size(); ++j)
+        pthread_join(threads[j], 0);
+    pthread_mutex_destroy(&pool.lock);
+
+    //
+    // Join the results, in order.
+    //
+    for (size_t j = 0; j < pool.jobs.size(); ++j)
+    {
+        const decode_job &job = pool.jobs[j];
+        deeper->write(job.result->get_data(), job.result->size());
+    }
+}
@@ -19,10 +19,12 @@
 #include <lib/config.h>
 #include <cassert>
 #include <cctype>
+#include <cstring>
 #include <libexplain/output.h>
 
 #include <lib/rcstring/accumulator.h>
 #include <lib/output/text_encode.h>
+#include <lib/text_scan.h>
 
 
 output_text_encode::~output_text_encode()
@@ -41,11 +43,8 @@ output_text_encode::~output_text_encode()
     //
     // Make sure the last block is NUL padded.
     //
-    while (address & 1023)
-    {
-        deeper->fputc(0);
-        ++address;
-    }
+    if (address)
+        end_page();
     deeper->flush();
 }
 
@@ -60,8 +59,10 @@ output_text_encode::output_text_encode(const output::pointer &a_deeper,
     use_dle(a_use_dle),
     nul_guarantee(a_nul_guarantee)
 {
-    for (int j = 0; j < 1024; ++j)
-        deeper->fputc(0);
+    //
+    // The first block is the header used by the text editor.
+    //
+    end_page();
 }
 
 
@@ -169,6 +170,15 @@ output_text_encode::line_character(unsigned char c)
 }
 
 
+void
+output_text_encode::end_page(void)
+{
+    memset(page + address, 0, sizeof(page) - address);
+    deeper->write(page, sizeof(page));
+    address = 0;
+}
+
+
 void
 output_text_encode::write_one_line()
 {
@@ -178,58 +188,50 @@ output_text_encode::write_one_line()
     unsigned characters_per_block = (nul_guarantee ? 1023 : 1024);
     assert(address < 1024);
     line_accumulator.push_back('\r');
-    rcstring line = line_accumulator.mkstr();
-    line_accumulator.clear();
+    const char *line = line_accumulator.get_data();
+    size_t line_size = line_accumulator.size();
 
     //
     // If the line does not fit in the current block,
     // pad the block with NUL charactres.
     //
-    if (address + line.size() > characters_per_block)
-    {
-        for (;;)
-        {
-            deeper->fputc(0);
-            ++address;
-            if ((address & 1023) == 0)
-            {
-                address = 0;
-                break;
-            }
-        }
-    }
+    if (address + line_size > characters_per_block)
+        end_page();
 
     //
     // Cope with exceptionally very long lines.
     //
     if (address == 0)
     {
-        while (line.size() > characters_per_block)
+        while (line_size > characters_per_block)
         {
             explain_output_error
             (
                 "%s: %d: warning: line too long (%ld) split at column %d",
                 deeper->filename().c_str(),
                 line_number,
-                (long)line.size(),
+                (long)line_size,
                 characters_per_block - 1
             );
-            deeper->write(line.c_str(), characters_per_block - 1);
-            deeper->fputc('\r');
-            if (nul_guarantee)
-                deeper->fputc(0);
-            line = line.substring(characters_per_block - 1, line.size());
+            memcpy(page, line, characters_per_block - 1);
+            page[characters_per_block - 1] = '\r';
+            address = characters_per_block;
+            end_page();
+            line += characters_per_block - 1;
+            line_size -= characters_per_block - 1;
         }
     }
 
     //
     // Add the line to the current block.
     //
-    deeper->write(line.c_str(), line.size());
-    address += line.size();
+    memcpy(page + address, line, line_size);
+    address += line_size;
     assert(address > 0);
     assert(address <= characters_per_block);
-    address &= 1023;
+    if (address == sizeof(page))
+        end_page();
+    line_accumulator.clear();
     ++line_number;
 
     column = 0;
@@ -243,6 +245,23 @@ output_text_encode::write_inner(const void *vdata, size_t size)
     const unsigned char *data = (const unsigned char *)vdata;
     while (size > 0)
     {
+        //
+        // Once past the indent, printable characters (including spaces)
+        // are added to the line unchanged, so add the whole run at once.
+        //
+        if (non_white)
+        {
+            size_t n = text_scan_encode(data, size);
+            if (n > 0)
+            {
+                line_accumulator.push_back(data, n);
+                column += n;
+                data += n;
+                size -= n;
+                continue;
+            }
+        }
+
         unsigned char c = *data++;
         --size;
         if (c == '\n' || c == '\r')
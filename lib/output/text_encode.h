@@ -116,10 +116,22 @@ private:
       */
     rcstring_accumulator line_accumulator;
 
+    /**
+      * The page instance variable is used to remember the 1KB text
+      * block under construction.  The first #address bytes are in use.
+      */
+    unsigned char page[1024];
+
     void line_character(unsigned char);
 
     void write_one_line();
 
+    /**
+      * The end_page method is used to pad the current text block with
+      * NUL characters, and write it to the deeper output.
+      */
+    void end_page(void);
+
     /**
       * The default constructor.  Do not use.
       */
@@ -313,6 +313,17 @@ public:
       */
     rcstring quote_c() const;
 
+    /**
+      * \brief
+      * quote JSON meta-characters
+      *
+      * The quote_json method is used to create a new string which
+      * quotes the input string as a JSON string, including the double
+      * quotes.  Bytes which are not printable ASCII are escaped as if
+      * they were ISO 8859-1, so that the result is always valid.
+      */
+    rcstring quote_json() const;
+
     /**
       * \brief
       * remove excess white space
@@ -25,10 +25,9 @@ rcstring
 rcstring::capitalize()
     const
 {
-    static rcstring_accumulator sa;
+    rcstring_accumulator sa;
     bool prev_was_alpha = false;
     const char *cp = c_str();
-    sa.clear();
     for (;;)
     {
         unsigned char c = (unsigned char)*cp++;
@@ -24,8 +24,7 @@ rcstring
 rcstring::catenate(const rcstring &rhs)
     const
 {
-    static rcstring_accumulator tmp;
-    tmp.clear();
+    rcstring_accumulator tmp;
     tmp.push_back(*this);
     tmp.push_back(rhs);
     return tmp.mkstr();
@@ -21,6 +21,7 @@
 
 #include <cassert>
 #include <cstring>
+#include <pthread.h>
 #include <lib/rcstring/gizzards.h>
 
 //
@@ -35,6 +36,26 @@ static rcstring_gizzards::hash_t hash_load;
 
 #define MAX_HASH_LEN 20
 
+//
+// The string table and the reference counts are shared by all threads.
+// This is a plain POSIX mutex, statically initialized, because strings
+// are created by static constructors in other files, before any
+// constructor of ours could be guaranteed to have run.
+//
+static pthread_mutex_t table_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+//
+// The table_locker class is used to hold the table_lock for its
+// lifetime.
+//
+class table_locker
+{
+public:
+    table_locker() { pthread_mutex_lock(&table_lock); }
+    ~table_locker() { pthread_mutex_unlock(&table_lock); }
+};
+
 
 //
 // NAME
@@ -156,6 +177,7 @@ rcstring_gizzards_from_c(const char *s)
 rcstring_gizzards *
 rcstring_gizzards_n_from_c(const char *s, size_t length)
 {
+    table_locker locked;
     if (!hash_table)
         rcstring_gizzards_initialize();
     if (!s)
@@ -216,6 +238,7 @@ rcstring_gizzards_n_from_c(const char *s, size_t length)
 rcstring_gizzards *
 rcstring_gizzards_copy(rcstring_gizzards *s)
 {
+    table_locker locked;
     s->rcstring_gizzards_references++;
     return s;
 }
@@ -226,6 +249,7 @@ rcstring_gizzards_free(rcstring_gizzards *s)
 {
     if (!s)
         return;
+    table_locker locked;
     if (s->rcstring_gizzards_references > 1)
     {
         s->rcstring_gizzards_references--;
@@ -266,6 +290,7 @@ bool
 rcstring_gizzards::validate()
     const
 {
+    table_locker locked;
     if (rcstring_gizzards_references == 0)
         return 0;
     rcstring_gizzards::hash_t idx = rcstring_gizzards_hash & hash_mask;
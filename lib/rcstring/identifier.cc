@@ -25,8 +25,7 @@ rcstring
 rcstring::identifier()
     const
 {
-    static rcstring_accumulator tmp;
-    tmp.clear();
+    rcstring_accumulator tmp;
     const char *cp = c_str();
     for (;;)
     {
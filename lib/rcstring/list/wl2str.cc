@@ -38,8 +38,7 @@ rcstring_list::unsplit(size_t start, size_t stop, const char *sep)
         sep = " ";
     size_t seplen = strlen(sep);
 
-    static rcstring_accumulator tmp;
-    tmp.clear();
+    rcstring_accumulator tmp;
     for (size_t j = start; j <= stop && j < nstrings; j++)
     {
         const rcstring &s = string[j];
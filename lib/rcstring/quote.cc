@@ -96,8 +96,7 @@ rcstring::quote_shell()
     // Also, the rules change depending on which style of quoting
     // is in force at the time.
     //
-    static rcstring_accumulator buffer;
-    buffer.clear();
+    rcstring_accumulator buffer;
     buffer.push_back(mode);
     for (const char *cp = c_str(); *cp; ++cp)
     {
@@ -27,8 +27,7 @@ rcstring
 rcstring::quote_c()
     const
 {
-    static rcstring_accumulator ac;
-    ac.clear();
+    rcstring_accumulator ac;
     const char *cp = c_str();
     ac.push_back('"');
     for (;;)
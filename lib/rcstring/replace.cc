@@ -42,8 +42,7 @@ rcstring::replace(const rcstring &lhs, const rcstring &rhs, int how_many_times)
     //
     const char *ip = c_str();
     const char *ip_end = ip + size();
-    static rcstring_accumulator sa;
-    sa.clear();
+    rcstring_accumulator sa;
     while (ip < ip_end && (size_t)(ip_end - ip) >= lhs.size())
     {
         if (0 == memcmp(ip, lhs.c_str(), lhs.size()))
@@ -26,8 +26,7 @@ rcstring::trim()
     const
 {
     bool whitespace = false;
-    static rcstring_accumulator buffer;
-    buffer.clear();
+    rcstring_accumulator buffer;
     const char *cp = c_str();
     for (;;)
     {
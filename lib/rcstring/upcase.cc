@@ -25,8 +25,7 @@ rcstring
 rcstring::upcase()
     const
 {
-    static rcstring_accumulator tmp;
-    tmp.clear();
+    rcstring_accumulator tmp;
     const char *s = c_str();
     for (;;)
     {
@@ -0,0 +1,93 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cerrno>
+#include <cstring>
+#include <libexplain/output.h>
+
+#include <lib/rwlock.h>
+
+
+rwlock::~rwlock()
+{
+    pthread_rwlock_destroy(&lock);
+}
+
+
+rwlock::rwlock()
+{
+    int err = pthread_rwlock_init(&lock, 0);
+    if (err)
+        explain_output_error_and_die("pthread_rwlock_init: %s", strerror(err));
+}
+
+
+void
+rwlock::read_lock(void)
+{
+    int err = pthread_rwlock_rdlock(&lock);
+    if (err)
+        explain_output_error_and_die
+        (
+            "pthread_rwlock_rdlock: %s",
+            strerror(err)
+        );
+}
+
+
+void
+rwlock::write_lock(void)
+{
+    int err = pthread_rwlock_wrlock(&lock);
+    if (err)
+        explain_output_error_and_die
+        (
+            "pthread_rwlock_wrlock: %s",
+            strerror(err)
+        );
+}
+
+
+bool
+rwlock::try_write_lock(void)
+{
+    int err = pthread_rwlock_trywrlock(&lock);
+    if (err == EBUSY)
+        return false;
+    if (err)
+        explain_output_error_and_die
+        (
+            "pthread_rwlock_trywrlock: %s",
+            strerror(err)
+        );
+    return true;
+}
+
+
+void
+rwlock::unlock(void)
+{
+    int err = pthread_rwlock_unlock(&lock);
+    if (err)
+        explain_output_error_and_die
+        (
+            "pthread_rwlock_unlock: %s",
+            strerror(err)
+        );
+}
@@ -0,0 +1,120 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#ifndef LIB_RWLOCK_H
+#define LIB_RWLOCK_H
+
+#include <pthread.h>
+
+/**
+  * The rwlock class is used to represent a reader/writer lock.  Any
+  * number of threads may hold the lock for reading at once, but a
+  * thread holding the lock for writing excludes all others.
+  */
+class rwlock
+{
+public:
+    /**
+      * The destructor.
+      */
+    virtual ~rwlock();
+
+    /**
+      * The default constructor.
+      */
+    rwlock();
+
+    /**
+      * The read_lock method is used to wait until the lock may be held
+      * for reading, and then take it.
+      */
+    void read_lock(void);
+
+    /**
+      * The write_lock method is used to wait until the lock may be held
+      * for writing, and then take it.
+      */
+    void write_lock(void);
+
+    /**
+      * The try_write_lock method is used to take the lock for writing,
+      * if that is possible without waiting.
+      *
+      * @returns
+      *     true if the lock was taken, false if some other thread holds
+      *     it (in which case do not call the #unlock method).
+      */
+    bool try_write_lock(void);
+
+    /**
+      * The unlock method is used to release the lock, after either of
+      * the #read_lock or #write_lock methods.
+      */
+    void unlock(void);
+
+    /**
+      * The reader class is used to hold a lock for reading for the
+      * lifetime of the reader object.
+      */
+    class reader
+    {
+    public:
+        reader(rwlock &a_lock) : lock(a_lock) { lock.read_lock(); }
+        ~reader() { lock.unlock(); }
+
+    private:
+        rwlock &lock;
+        reader(const reader &);
+        reader &operator=(const reader &);
+    };
+
+    /**
+      * The writer class is used to hold a lock for writing for the
+      * lifetime of the writer object.
+      */
+    class writer
+    {
+    public:
+        writer(rwlock &a_lock) : lock(a_lock) { lock.write_lock(); }
+        ~writer() { lock.unlock(); }
+
+    private:
+        rwlock &lock;
+        writer(const writer &);
+        writer &operator=(const writer &);
+    };
+
+private:
+    /**
+      * The lock instance variable is used to remember the underlying
+      * POSIX threads lock.
+      */
+    pthread_rwlock_t lock;
+
+    /**
+      * The copy constructor.  Do not use.
+      */
+    rwlock(const rwlock &);
+
+    /**
+      * The assignment operator.  Do not use.
+      */
+    rwlock &operator=(const rwlock &);
+};
+
+#endif // LIB_RWLOCK_H
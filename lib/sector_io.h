@@ -64,11 +64,16 @@ public:
       *
       * @param deeper
       *     The raw data to be sniffed
+      * @param how
+      *     If not NULL, where to put the name of the interleaving found,
+      *     in a form acceptable to the interleave_factory class method,
+      *     so that the same image may later be reopened without
+      *     sniffing it all over again.
       * @returns
       *     NULL on failure, or a suitable sector_io pointer for access
       *     to the data on success
       */
-    static pointer guess_interleaving(pointer deeper);
+    static pointer guess_interleaving(pointer deeper, rcstring *how = 0);
 
     /**
       * The interleave_factory class method is used to add some disk
@@ -77,6 +82,9 @@ public:
       *
       * @param name
       *     The name of the interleave pattern, e.g. "apple", "pdp", "none".
+      *     An "offset=N" pattern skips the first N bytes of the image.
+      *     Several patterns may be separated by commas, the rightmost
+      *     being applied to the disk image first.
       * @param deeper
       *     The disk image to be filtered.
       */
@@ -271,12 +279,49 @@ public:
       */
     int relocate_bytes(off_t to, off_t from, size_t nbytes);
 
+    /**
+      * The copy_bytes method is used to copy a range of bytes from one
+      * place in the medium to another, like #relocate_bytes, except
+      * that the positions need not be sector aligned.  The ranges may
+      * overlap.
+      *
+      * @param to
+      *     The byte offset of the destination.
+      * @param from
+      *     The byte offset of the source.
+      * @param nbytes
+      *     The number of bytes to copy.
+      * @returns
+      *     zero on success, or -errno on error.
+      */
+    int copy_bytes(off_t to, off_t from, size_t nbytes);
+
     /**
       * The is_read_only method may be used to determine whether
       * the file system is read-only (true) or read-write (false).
       */
     virtual bool is_read_only(void) const = 0;
 
+    /**
+      * The get_backing_fd method is used to discover whether a range
+      * of bytes is stored, as is and contiguously, in a plain file.  If
+      * it is, the bytes may be read and written through that file
+      * directly (for example, by splice(2)) rather than being copied
+      * by the #read and #write methods.
+      *
+      * @param byte_offset
+      *     The position of the first byte of interest.
+      * @param nbytes
+      *     The number of bytes of interest.
+      * @param pos
+      *     Where to put the position of the first byte within the file.
+      * @returns
+      *     the file descriptor, or -1 if the bytes are not stored that
+      *     way (the default).
+      */
+    virtual int get_backing_fd(off_t byte_offset, size_t nbytes, off_t &pos)
+        const;
+
 private:
     /**
       * The copy constructor.  Do not use.
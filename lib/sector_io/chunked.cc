@@ -0,0 +1,653 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <libexplain/output.h>
+
+#include <lib/debug.h>
+#include <lib/explain_mt.h>
+#include <lib/sector_io/chunked.h>
+#include <lib/statistics.h>
+
+
+static const char magic[8] = { 'U', 'C', 'S', 'D', 'C', 'H', 'N', 'K' };
+
+enum { header_size = 32 };
+
+
+static unsigned long
+get_u32(const unsigned char *data)
+{
+    return
+        (
+            data[0]
+        |
+            ((unsigned long)data[1] << 8)
+        |
+            ((unsigned long)data[2] << 16)
+        |
+            ((unsigned long)data[3] << 24)
+        );
+}
+
+
+static unsigned long long
+get_u64(const unsigned char *data)
+{
+    return (get_u32(data) | ((unsigned long long)get_u32(data + 4) << 32));
+}
+
+
+static void
+put_u32(unsigned char *data, unsigned long value)
+{
+    data[0] = value;
+    data[1] = value >> 8;
+    data[2] = value >> 16;
+    data[3] = value >> 24;
+}
+
+
+static void
+put_u64(unsigned char *data, unsigned long long value)
+{
+    for (int j = 0; j < 8; ++j)
+    {
+        data[j] = value;
+        value >>= 8;
+    }
+}
+
+
+/**
+  * The write_all function is used to write all of the given data to a
+  * file, at the given position.
+  *
+  * @returns
+  *     zero on success, or -errno on error.  A short write (the file
+  *     system is full) is reported as -ENOSPC.
+  */
+static int
+write_all(int fildes, const void *data, size_t nbytes, off_t offset)
+{
+    ssize_t n = ::pwrite(fildes, data, nbytes, offset);
+    if (n < 0)
+        return -errno;
+    if ((size_t)n != nbytes)
+        return -ENOSPC;
+    return 0;
+}
+
+
+sector_io_chunked::~sector_io_chunked()
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    if (need_sync && !read_only)
+    {
+        int err = sync();
+        if (err < 0)
+        {
+            explain_output_error
+            (
+                "write %s: %s",
+                filename.c_str(),
+                strerror(-err)
+            );
+        }
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+}
+
+
+sector_io_chunked::sector_io_chunked(const rcstring &a_filename,
+        bool a_read_only) :
+    filename(a_filename),
+    fd(-1),
+    read_only(a_read_only),
+    chunk_size(default_chunk_size),
+    image_size(0),
+    file_image_size(0),
+    need_sync(false),
+    fake_bytes_per_sector(512)
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+
+    //
+    // A new container starts out empty, and is written by the first
+    // sync.  An existing container is only ever read.
+    //
+    if (!read_only)
+    {
+        need_sync = true;
+        return;
+    }
+    fd = explain_mt_open_or_die(filename.c_str(), O_RDONLY, 0);
+    load_index();
+}
+
+
+sector_io::pointer
+sector_io_chunked::create(const rcstring &a_filename, bool)
+{
+    return pointer(new sector_io_chunked(a_filename, true));
+}
+
+
+sector_io::pointer
+sector_io_chunked::create_new(const rcstring &a_filename)
+{
+    return pointer(new sector_io_chunked(a_filename, false));
+}
+
+
+bool
+sector_io_chunked::candidate(const rcstring &a_filename)
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    int cfd = open(a_filename.c_str(), O_RDONLY);
+    if (cfd < 0)
+        return false;
+    char buffer[sizeof(magic)];
+    ssize_t n = ::read(cfd, buffer, sizeof(buffer));
+    close(cfd);
+    return (n == sizeof(buffer) && 0 == memcmp(buffer, magic, sizeof(magic)));
+}
+
+
+static void
+corrupted(const rcstring &filename)
+{
+    explain_output_error_and_die
+    (
+        "%s: chunked disk image corrupted",
+        filename.c_str()
+    );
+}
+
+
+void
+sector_io_chunked::load_index(void)
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    struct stat st;
+    if (fstat(fd, &st) < 0)
+    {
+        explain_output_error_and_die
+        (
+            "stat %s: %s",
+            filename.c_str(),
+            strerror(errno)
+        );
+    }
+    unsigned char header[header_size];
+    if
+    (
+        ::pread(fd, header, sizeof(header), 0) != (ssize_t)sizeof(header)
+    ||
+        memcmp(header, magic, sizeof(magic))
+    )
+    {
+        explain_output_error_and_die
+        (
+            "%s: not a chunked disk image",
+            filename.c_str()
+        );
+    }
+    unsigned long version = get_u32(header + 8);
+    if (version != 1)
+    {
+        explain_output_error_and_die
+        (
+            "%s: chunked disk image version %lu not supported",
+            filename.c_str(),
+            version
+        );
+    }
+    chunk_size = get_u32(header + 12);
+    unsigned long long size64 = get_u64(header + 16);
+    unsigned long long index_offset = get_u64(header + 24);
+    size_t nchunks = (size64 + chunk_size - 1) / chunk_size;
+    if
+    (
+        chunk_size < 512
+    ||
+        chunk_size > (1 << 24)
+    ||
+        (chunk_size & (chunk_size - 1))
+    ||
+        index_offset + 8 * (nchunks + 1) != (unsigned long long)st.st_size
+    )
+        corrupted(filename);
+    image_size = size64;
+    file_image_size = size64;
+
+    std::vector<unsigned char> index(8 * (nchunks + 1));
+    if
+    (
+        ::pread(fd, &index[0], index.size(), index_offset)
+    !=
+        (ssize_t)index.size()
+    )
+        corrupted(filename);
+    positions.clear();
+    positions.reserve(nchunks + 1);
+    off_t previous = header_size;
+    for (size_t j = 0; j <= nchunks; ++j)
+    {
+        unsigned long long pos = get_u64(&index[8 * j]);
+        if (pos < (unsigned long long)previous || pos > index_offset)
+            corrupted(filename);
+        positions.push_back(pos);
+        previous = pos;
+    }
+    DEBUG(1, "%s: %ld chunks of %ld bytes", filename.c_str(), (long)nchunks,
+        (long)chunk_size);
+}
+
+
+size_t
+sector_io_chunked::file_chunk_length(size_t chunk_number)
+    const
+{
+    off_t start = (off_t)chunk_number * chunk_size;
+    if (start + (off_t)chunk_size > file_image_size)
+        return file_image_size - start;
+    return chunk_size;
+}
+
+
+int
+sector_io_chunked::read_compressed(size_t chunk_number, chunk_t &data)
+    const
+{
+    assert(chunk_number + 1 < positions.size());
+    off_t pos = positions[chunk_number];
+    size_t nbytes = positions[chunk_number + 1] - pos;
+    data.resize(nbytes);
+    if (nbytes == 0)
+        return 0;
+    statistics::add(statistics::image_reads);
+    ssize_t n = ::pread(fd, &data[0], nbytes, pos);
+    if (n < 0)
+        return -errno;
+    if ((size_t)n != nbytes)
+        return -EIO;
+    statistics::add(statistics::image_read_bytes, nbytes);
+    return 0;
+}
+
+
+sector_io_chunked::chunk_t *
+sector_io_chunked::get_chunk(size_t chunk_number, int &err)
+{
+    cache_t::iterator it = cache.find(chunk_number);
+    if (it != cache.end())
+    {
+        if (!dirty.count(chunk_number))
+        {
+            lru.remove(chunk_number);
+            lru.push_front(chunk_number);
+        }
+        return &it->second;
+    }
+
+    //
+    // Chunks past the end of the file have not been written yet, and
+    // read as zero.  So does the tail of a short last chunk.
+    //
+    chunk_t data(chunk_size, 0);
+    if (chunk_number + 1 < positions.size())
+    {
+        chunk_t packed;
+        err = read_compressed(chunk_number, packed);
+        if (err < 0)
+            return 0;
+        size_t length = file_chunk_length(chunk_number);
+        if (packed.size() == length)
+        {
+            // Stored as is, it would not compress.
+            if (length)
+                memcpy(&data[0], &packed[0], length);
+        }
+        else
+        {
+            uLongf unpacked = length;
+            int rc =
+                uncompress(&data[0], &unpacked, &packed[0], packed.size());
+            if (rc != Z_OK || unpacked != length)
+            {
+                DEBUG(1, "chunk %ld: %s", (long)chunk_number, zError(rc));
+                err = -EIO;
+                return 0;
+            }
+        }
+    }
+
+    chunk_t &result = cache[chunk_number];
+    result.swap(data);
+    lru.push_front(chunk_number);
+    while (lru.size() > lru_max)
+    {
+        cache.erase(lru.back());
+        lru.pop_back();
+    }
+    return &result;
+}
+
+
+int
+sector_io_chunked::read_sector(unsigned sector_number, void *data)
+{
+    off_t offset = (off_t)sector_number * fake_bytes_per_sector;
+    return read(offset, data, fake_bytes_per_sector);
+}
+
+
+int
+sector_io_chunked::read(off_t offset, void *data, size_t size)
+{
+    DEBUG(2, "sector_io_chunked::read(this = %p, offset = 0x%lX, "
+        "data = %p, size = 0x%lX)", this, (long)offset, data, (long)size);
+    if (offset < 0)
+        return -EINVAL;
+    mutex::locker hold(lock);
+    if (offset + (off_t)size > image_size)
+        return -ENOSPC;
+    unsigned char *dp = (unsigned char *)data;
+    size_t remaining = size;
+    while (remaining > 0)
+    {
+        size_t chunk_number = offset / chunk_size;
+        size_t chunk_offset = offset % chunk_size;
+        size_t nbytes = chunk_size - chunk_offset;
+        if (nbytes > remaining)
+            nbytes = remaining;
+        int err = 0;
+        chunk_t *cp = get_chunk(chunk_number, err);
+        if (!cp)
+            return err;
+        memcpy(dp, &(*cp)[chunk_offset], nbytes);
+        dp += nbytes;
+        offset += nbytes;
+        remaining -= nbytes;
+    }
+    return size;
+}
+
+
+int
+sector_io_chunked::write_sector(unsigned sector_number, const void *data)
+{
+    off_t offset = (off_t)sector_number * fake_bytes_per_sector;
+    return write(offset, data, fake_bytes_per_sector);
+}
+
+
+int
+sector_io_chunked::write(off_t offset, const void *data, size_t size)
+{
+    DEBUG(2, "sector_io_chunked::write(this = %p, offset = 0x%lX, "
+        "data = %p, size = 0x%lX)", this, (long)offset, data, (long)size);
+    if (read_only)
+        return -EROFS;
+    if (offset < 0)
+        return -EINVAL;
+    mutex::locker hold(lock);
+    statistics::add(statistics::image_writes);
+    const unsigned char *dp = (const unsigned char *)data;
+    size_t remaining = size;
+    while (remaining > 0)
+    {
+        size_t chunk_number = offset / chunk_size;
+        size_t chunk_offset = offset % chunk_size;
+        size_t nbytes = chunk_size - chunk_offset;
+        if (nbytes > remaining)
+            nbytes = remaining;
+        int err = 0;
+        chunk_t *cp = get_chunk(chunk_number, err);
+        if (!cp)
+            return err;
+        memcpy(&(*cp)[chunk_offset], dp, nbytes);
+
+        //
+        // Changed chunks stay in the cache until they are written.
+        //
+        if (dirty.insert(chunk_number).second)
+            lru.remove(chunk_number);
+        dp += nbytes;
+        offset += nbytes;
+        remaining -= nbytes;
+    }
+    if (offset > image_size)
+        image_size = offset;
+    need_sync = true;
+    statistics::add(statistics::image_write_bytes, size);
+    return size;
+}
+
+
+int
+sector_io_chunked::sync(void)
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    mutex::locker hold(lock);
+    if (read_only || !need_sync)
+        return 0;
+    statistics::add(statistics::image_syncs);
+
+    rcstring tmp = filename + ".tmp";
+    int tfd = open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (tfd < 0)
+        return -errno;
+
+    //
+    // Write the new container.  Chunks which have not changed (and have
+    // not changed length, because the image grew) are copied as they
+    // are, without being decompressed.
+    //
+    size_t file_nchunks = (positions.empty() ? 0 : positions.size() - 1);
+    size_t nchunks = (image_size + chunk_size - 1) / chunk_size;
+    std::vector<off_t> new_positions;
+    new_positions.reserve(nchunks + 1);
+    off_t pos = header_size;
+    chunk_t packed;
+    chunk_t zero;
+    int err = 0;
+    for (size_t j = 0; j < nchunks; ++j)
+    {
+        size_t length = chunk_size;
+        if ((off_t)(j * chunk_size + length) > image_size)
+            length = image_size - (off_t)j * chunk_size;
+        if
+        (
+            !dirty.count(j)
+        &&
+            j < file_nchunks
+        &&
+            file_chunk_length(j) == length
+        )
+        {
+            err = read_compressed(j, packed);
+            if (err < 0)
+                goto failed;
+        }
+        else
+        {
+            const chunk_t *cp = 0;
+            if (cache.count(j) || j < file_nchunks)
+            {
+                cp = get_chunk(j, err);
+                if (!cp)
+                    goto failed;
+            }
+            else
+            {
+                zero.resize(chunk_size);
+                cp = &zero;
+            }
+            uLongf packed_size = compressBound(length);
+            packed.resize(packed_size);
+            int rc =
+                compress2
+                (
+                    &packed[0],
+                    &packed_size,
+                    &(*cp)[0],
+                    length,
+                    Z_DEFAULT_COMPRESSION
+                );
+            if (rc == Z_OK && packed_size < length)
+                packed.resize(packed_size);
+            else
+                packed.assign(cp->begin(), cp->begin() + length);
+        }
+        if (!packed.empty())
+        {
+            err = write_all(tfd, &packed[0], packed.size(), pos);
+            if (err < 0)
+                goto failed;
+        }
+        new_positions.push_back(pos);
+        pos += packed.size();
+    }
+    new_positions.push_back(pos);
+
+    {
+        std::vector<unsigned char> index(8 * new_positions.size());
+        for (size_t j = 0; j < new_positions.size(); ++j)
+            put_u64(&index[8 * j], new_positions[j]);
+        unsigned char header[header_size];
+        memcpy(header, magic, sizeof(magic));
+        put_u32(header + 8, 1);
+        put_u32(header + 12, chunk_size);
+        put_u64(header + 16, image_size);
+        put_u64(header + 24, pos);
+        err = write_all(tfd, &index[0], index.size(), pos);
+        if (err < 0)
+            goto failed;
+        err = write_all(tfd, header, sizeof(header), 0);
+        if (err < 0)
+            goto failed;
+
+        //
+        // If the new file is about to replace an old one (by the same
+        // name, written by someone else), keep the old one's mode.
+        //
+        struct stat st;
+        if (stat(filename.c_str(), &st) == 0)
+            fchmod(tfd, st.st_mode & 07777);
+        if
+        (
+            fsync(tfd) < 0
+        ||
+            rename(tmp.c_str(), filename.c_str()) < 0
+        )
+        {
+            err = -errno;
+            goto failed;
+        }
+    }
+    statistics::add(statistics::image_write_bytes, pos);
+
+    //
+    // The new file replaces the old one, and the chunks written are now
+    // unchanged chunks like any other.
+    //
+    if (fd >= 0)
+        close(fd);
+    fd = tfd;
+    positions.swap(new_positions);
+    file_image_size = image_size;
+    for (std::set<size_t>::const_iterator it = dirty.begin();
+        it != dirty.end(); ++it)
+        lru.push_front(*it);
+    dirty.clear();
+    while (lru.size() > lru_max)
+    {
+        cache.erase(lru.back());
+        lru.pop_back();
+    }
+    need_sync = false;
+    return 0;
+
+    failed:
+    close(tfd);
+    unlink(tmp.c_str());
+    return err;
+}
+
+
+int
+sector_io_chunked::size_in_sectors(void)
+{
+    mutex::locker hold(lock);
+    return (image_size / fake_bytes_per_sector);
+}
+
+
+unsigned
+sector_io_chunked::bytes_per_sector(void)
+    const
+{
+    return fake_bytes_per_sector;
+}
+
+
+unsigned
+sector_io_chunked::size_multiple_in_bytes(void)
+    const
+{
+    return fake_bytes_per_sector;
+}
+
+
+bool
+sector_io_chunked::is_read_only(void)
+    const
+{
+    return read_only;
+}
+
+
+void
+sector_io_chunked::bytes_per_sector_hint(unsigned n)
+{
+    // Must always be a power of two.
+    assert(n != 0 && n == (n & -n));
+    if (n < fake_bytes_per_sector)
+        fake_bytes_per_sector = n;
+}
+
+
+rcstring
+sector_io_chunked::get_filename(void)
+    const
+{
+    return filename;
+}
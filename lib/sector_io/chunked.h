@@ -0,0 +1,296 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#ifndef LIB_SECTOR_IO_CHUNKED_H
+#define LIB_SECTOR_IO_CHUNKED_H
+
+#include <list>
+#include <map>
+#include <set>
+#include <vector>
+
+#include <lib/mutex.h>
+#include <lib/rcstring.h>
+#include <lib/sector_io.h>
+
+/**
+  * The sector_io_chunked class is used to represent access to a disk
+  * image in a compressed container which may be read at random.  The image is split into fixed size chunks, each compressed
+  * separately, so only the chunks actually touched need be
+  * decompressed.  A few recently used chunks are kept decompressed.
+  *
+  * The container format (all numbers little-endian) is
+  *     8 bytes     the magic number "UCSDCHNK"
+  *     4 bytes     the format version, 1
+  *     4 bytes     the chunk size, a power of two
+  *     8 bytes     the size of the image, in bytes
+  *     8 bytes     the position of the chunk index
+  *     ...         the compressed chunks, end to end
+  *     8 bytes     the position of each chunk, one per chunk, and
+  *                 one more for the end of the last chunk
+  *
+  * Each chunk is compressed with zlib, unless that would not make it
+  * any smaller, in which case it is stored as is.  The last chunk is
+  * only as long as the image needs.
+  *
+  * Existing containers are read-only, like the IMD and dedup formats:
+  * the format can only be written as a whole, so each change would cost
+  * time in proportion to the size of the image, not the size of the
+  * change.  New containers (see #create_new) are kept in memory, and
+  * written by the #sync method, which writes the container beside the
+  * file and renames it into place.
+  *
+  * Reads change the cache, so all access is serialized by a mutex;
+  * the threads of ucsdpsys_fsck --deep (for example) share one
+  * instance.
+  */
+class sector_io_chunked:
+    public sector_io
+{
+public:
+    /**
+      * The destructor.
+      * It writes any changes not yet written by #sync.
+      */
+    virtual ~sector_io_chunked();
+
+private:
+    /**
+      * The constructor.  It is private on purpose, use the #create
+      * class method instead.
+      *
+      * @param filename
+      *     The name of the file containing the container.
+      * @param read_only
+      *     true to read an existing container, false to write a new
+      *     one.
+      */
+    sector_io_chunked(const rcstring &filename, bool read_only);
+
+public:
+    /**
+      * The create class method is used to create new dynamically
+      * allocated instances of this class, to read an existing
+      * container.  Errors are fatal.
+      *
+      * @param filename
+      *     The name of the file containing the container.
+      * @param read_only
+      *     Ignored, the image is always read-only.
+      */
+    static pointer create(const rcstring &filename, bool read_only = true);
+
+    /**
+      * The create_new class method is used to create new dynamically
+      * allocated instances of this class, to write a new container,
+      * holding an empty image to start with.  The file is written (and
+      * any existing file by that name replaced) by the first #sync.
+      *
+      * @param filename
+      *     The name of the file to contain the container.
+      */
+    static pointer create_new(const rcstring &filename);
+
+    /**
+      * The candidate class method is used to determine if the given file
+      * is a candidate for being in the chunked format.
+      */
+    static bool candidate(const rcstring &filename);
+
+    enum { default_chunk_size = 32 << 10 };
+
+protected:
+    // See base class for documentation.
+    int read_sector(unsigned sector_number, void *data);
+
+    // See base class for documentation.
+    int read(off_t offset, void *data, size_t size);
+
+    // See base class for documentation.
+    int write_sector(unsigned sector_number, const void *data);
+
+    // See base class for documentation.
+    int write(off_t offset, const void *data, size_t size);
+
+    // See base class for documentation.
+    int size_in_sectors(void);
+
+    // See base class for documentation.
+    unsigned bytes_per_sector(void) const;
+
+    // See base class for documentation.
+    unsigned size_multiple_in_bytes(void) const;
+
+    // See base class for documentation.
+    int sync(void);
+
+    // See base class for documentation.
+    bool is_read_only(void) const;
+
+    // See base class for documentation.
+    void bytes_per_sector_hint(unsigned nbytes);
+
+    // See base class for documentation.
+    rcstring get_filename(void) const;
+
+private:
+    /**
+      * The filename instance variable is used to remember the name of
+      * the file containing the container.
+      */
+    rcstring filename;
+
+    /**
+      * The fd instance variable is used to remember the file descriptor
+      * of the container, or -1 if it has not yet been written.
+      */
+    int fd;
+
+    /**
+      * The read_only instance variable is used to remember whether
+      * this is an existing container (which may not be changed) or a
+      * new one.
+      */
+    bool read_only;
+
+    /**
+      * The chunk_size instance variable is used to remember the size
+      * of the (uncompressed) chunks, in bytes.
+      */
+    size_t chunk_size;
+
+    /**
+      * The image_size instance variable is used to remember the size of
+      * the image, in bytes, including any changes not yet written.
+      */
+    off_t image_size;
+
+    /**
+      * The file_image_size instance variable is used to remember the
+      * size of the image, in bytes, as it is in the file.
+      */
+    off_t file_image_size;
+
+    /**
+      * The positions instance variable is used to remember the position
+      * of each chunk in the file, and of the end of the last chunk.
+      */
+    std::vector<off_t> positions;
+
+    /**
+      * The lock instance variable is used to serialize access to the
+      * #cache, #lru and #dirty instance variables (and the rest of the
+      * container state) by the #read, #write and #sync methods, which
+      * may be called by more than one thread at once.
+      */
+    mutex lock;
+
+    typedef std::vector<unsigned char> chunk_t;
+    typedef std::map<size_t, chunk_t> cache_t;
+
+    /**
+      * The cache instance variable is used to remember the decompressed
+      * chunks, indexed by chunk number.
+      */
+    cache_t cache;
+
+    /**
+      * The lru instance variable is used to remember the unchanged
+      * chunks in the cache, the most recently used first.  Changed
+      * chunks are never dropped from the cache, so they are not on
+      * this list.
+      */
+    std::list<size_t> lru;
+
+    enum { lru_max = 8 };
+
+    /**
+      * The dirty instance variable is used to remember the chunks which
+      * have been changed since the last #sync.
+      */
+    std::set<size_t> dirty;
+
+    /**
+      * The need_sync instance variable is used to remember whether or
+      * not there are changes (including the creation of the file) not
+      * yet written.
+      */
+    bool need_sync;
+
+    /**
+      * The fake_bytes_per_sector instance variable is used to remember
+      * the current bytes per sector hint.
+      */
+    unsigned fake_bytes_per_sector;
+
+    /**
+      * The file_chunk_length method is used to obtain the number of
+      * bytes in the given chunk, as the file has it.
+      */
+    size_t file_chunk_length(size_t chunk_number) const;
+
+    /**
+      * The load_index method is used to read the header and the chunk
+      * index of the container.  Format errors are fatal.
+      */
+    void load_index(void);
+
+    /**
+      * The get_chunk method is used to obtain a chunk's data,
+      * decompressing it if it is not already in the cache.  Chunks past
+      * the end of the file read as zero.
+      *
+      * @param chunk_number
+      *     The number of the chunk of interest.
+      * @param err
+      *     Where to put -errno, on error.
+      * @returns
+      *     the chunk's data (#chunk_size bytes), or NULL on error.
+      */
+    chunk_t *get_chunk(size_t chunk_number, int &err);
+
+    /**
+      * The read_compressed method is used to read a chunk from the
+      * file, as it is stored there.
+      *
+      * @param chunk_number
+      *     The number of the chunk of interest.
+      * @param data
+      *     Where to put the data.
+      * @returns
+      *     zero on success, or -errno on error.
+      */
+    int read_compressed(size_t chunk_number, chunk_t &data) const;
+
+    /**
+      * The default constructor.  Do not use.
+      */
+    sector_io_chunked();
+
+    /**
+      * The copy constructor.  Do not use.
+      */
+    sector_io_chunked(const sector_io_chunked &);
+
+    /**
+      * The assignment operator.  Do not use.
+      */
+    sector_io_chunked &operator=(const sector_io_chunked &);
+};
+
+#endif // LIB_SECTOR_IO_CHUNKED_H
@@ -0,0 +1,334 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <libexplain/output.h>
+
+#include <lib/debug.h>
+#include <lib/explain_mt.h>
+#include <lib/sector_io/dedup.h>
+
+
+static const char magic[8] = { 'U', 'C', 'S', 'D', 'D', 'D', 'U', 'P' };
+
+enum { header_size = 32 };
+
+
+sector_io_dedup::~sector_io_dedup()
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+}
+
+
+static unsigned long
+get_u32(const unsigned char *data)
+{
+    return
+        (
+            data[0]
+        |
+            ((unsigned long)data[1] << 8)
+        |
+            ((unsigned long)data[2] << 16)
+        |
+            ((unsigned long)data[3] << 24)
+        );
+}
+
+
+static void
+put_u32(unsigned char *data, unsigned long value)
+{
+    data[0] = value;
+    data[1] = value >> 8;
+    data[2] = value >> 16;
+    data[3] = value >> 24;
+}
+
+
+sector_io_dedup::sector_io_dedup(const rcstring &a_filename) :
+    filename(a_filename),
+    image_size(0),
+    fake_bytes_per_sector(512)
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    int fd = explain_mt_open_or_die(filename.c_str(), O_RDONLY, 0);
+    struct stat st;
+    explain_mt_fstat_or_die(fd, &st);
+    std::vector<unsigned char> data(st.st_size);
+    size_t nbytes = 0;
+    while (nbytes < data.size())
+    {
+        ssize_t n =
+            explain_mt_read_or_die(fd, &data[nbytes], data.size() - nbytes);
+        if (n == 0)
+            break;
+        nbytes += n;
+    }
+    explain_mt_close_or_die(fd);
+
+    if (nbytes < header_size || memcmp(&data[0], magic, sizeof(magic)))
+    {
+        explain_output_error_and_die
+        (
+            "%s: not a deduplicated disk image",
+            filename.c_str()
+        );
+    }
+    unsigned long version = get_u32(&data[8]);
+    if (version != 1)
+    {
+        explain_output_error_and_die
+        (
+            "%s: deduplicated disk image version %lu not supported",
+            filename.c_str(),
+            version
+        );
+    }
+    if (get_u32(&data[12]) != dedup_store::chunk_size)
+    {
+        explain_output_error_and_die
+        (
+            "%s: deduplicated disk image chunk size not supported",
+            filename.c_str()
+        );
+    }
+    unsigned long long size64 =
+        get_u32(&data[16]) | ((unsigned long long)get_u32(&data[20]) << 32);
+    image_size = size64;
+    size_t nchunks = get_u32(&data[24]);
+    size_t path_len = get_u32(&data[28]);
+    if
+    (
+        nchunks != (size64 + dedup_store::chunk_size - 1)
+            / dedup_store::chunk_size
+    ||
+        path_len == 0
+    ||
+        nbytes != header_size + path_len + 4 * nchunks
+    )
+    {
+        explain_output_error_and_die
+        (
+            "%s: deduplicated disk image manifest corrupted",
+            filename.c_str()
+        );
+    }
+    rcstring store_path((const char *)&data[header_size], path_len);
+    if (store_path[0] != '/')
+        store_path = filename.dirname() + "/" + store_path;
+    const unsigned char *cp = &data[header_size + path_len];
+    chunks.reserve(nchunks);
+    for (size_t j = 0; j < nchunks; ++j, cp += 4)
+        chunks.push_back(get_u32(cp));
+    store = dedup_store::create(store_path, false);
+}
+
+
+sector_io::pointer
+sector_io_dedup::create(const rcstring &a_filename, bool)
+{
+    return pointer(new sector_io_dedup(a_filename));
+}
+
+
+bool
+sector_io_dedup::candidate(const rcstring &a_filename)
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    int fd = open(a_filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    char buffer[sizeof(magic)];
+    ssize_t n = ::read(fd, buffer, sizeof(buffer));
+    close(fd);
+    return (n == sizeof(buffer) && 0 == memcmp(buffer, magic, sizeof(magic)));
+}
+
+
+void
+sector_io_dedup::write_manifest(const rcstring &a_filename,
+    const rcstring &store_path, off_t a_image_size,
+    const std::vector<unsigned> &a_chunks)
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    std::vector<unsigned char> data
+    (
+        header_size + store_path.size() + 4 * a_chunks.size()
+    );
+    memcpy(&data[0], magic, sizeof(magic));
+    put_u32(&data[8], 1);
+    put_u32(&data[12], dedup_store::chunk_size);
+    put_u32(&data[16], (unsigned long long)a_image_size);
+    put_u32(&data[20], (unsigned long long)a_image_size >> 32);
+    put_u32(&data[24], a_chunks.size());
+    put_u32(&data[28], store_path.size());
+    memcpy(&data[header_size], store_path.c_str(), store_path.size());
+    unsigned char *cp = &data[header_size + store_path.size()];
+    for (size_t j = 0; j < a_chunks.size(); ++j, cp += 4)
+        put_u32(cp, a_chunks[j]);
+
+    int fd =
+        explain_mt_open_or_die
+        (
+            a_filename.c_str(),
+            O_WRONLY | O_CREAT | O_TRUNC,
+            0666
+        );
+    explain_mt_write_or_die(fd, &data[0], data.size());
+    explain_mt_close_or_die(fd);
+}
+
+
+int
+sector_io_dedup::read_sector(unsigned sector_number, void *data)
+{
+    off_t offset = (off_t)sector_number * fake_bytes_per_sector;
+    return read(offset, data, fake_bytes_per_sector);
+}
+
+
+int
+sector_io_dedup::read(off_t offset, void *data, size_t size)
+{
+    DEBUG(2, "sector_io_dedup::read(this = %p, offset = 0x%lX, data = %p, "
+        "size = 0x%lX)", this, (long)offset, data, (long)size);
+    if (offset < 0)
+        return -EINVAL;
+    if (offset + (off_t)size > image_size)
+        return -ENOSPC;
+
+    //
+    // The read may span any number of chunks, and need not start or
+    // finish on a chunk boundary.
+    //
+    unsigned char *dp = (unsigned char *)data;
+    size_t remaining = size;
+    while (remaining > 0)
+    {
+        size_t chunk_index = offset / dedup_store::chunk_size;
+        unsigned chunk_offset = offset % dedup_store::chunk_size;
+        size_t nbytes = dedup_store::chunk_size - chunk_offset;
+        if (nbytes > remaining)
+            nbytes = remaining;
+        int err = store->read(chunks[chunk_index], chunk_offset, dp, nbytes);
+        if (err < 0)
+            return err;
+        dp += nbytes;
+        offset += nbytes;
+        remaining -= nbytes;
+    }
+    return size;
+}
+
+
+int
+sector_io_dedup::write_sector(unsigned, const void *)
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    return -EROFS;
+}
+
+
+int
+sector_io_dedup::write(off_t, const void *, size_t)
+{
+    DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    return -EROFS;
+}
+
+
+int
+sector_io_dedup::size_in_sectors(void)
+{
+    return (image_size / fake_bytes_per_sector);
+}
+
+
+unsigned
+sector_io_dedup::bytes_per_sector(void)
+    const
+{
+    return fake_bytes_per_sector;
+}
+
+
+unsigned
+sector_io_dedup::size_multiple_in_bytes(void)
+    const
+{
+    return fake_bytes_per_sector;
+}
+
+
+int
+sector_io_dedup::sync(void)
+{
+    return 0;
+}
+
+
+bool
+sector_io_dedup::is_read_only(void)
+    const
+{
+    return true;
+}
+
+
+void
+sector_io_dedup::bytes_per_sector_hint(unsigned n)
+{
+    // Must always be a power of two.
+    assert(n != 0 && n == (n & -n));
+    if (n < fake_bytes_per_sector)
+        fake_bytes_per_sector = n;
+}
+
+
+rcstring
+sector_io_dedup::get_filename(void)
+    const
+{
+    return filename;
+}
+
+
+int
+sector_io_dedup::get_backing_fd(off_t offset, size_t size, off_t &pos)
+    const
+{
+    //
+    // Only ranges within a single chunk are stored contiguously.  All
+    // of the images in the store share the chunks file, and so they
+    // also share its pages in the kernel's cache.
+    //
+    if (offset < 0 || size == 0 || offset + (off_t)size > image_size)
+        return -1;
+    size_t chunk_index = offset / dedup_store::chunk_size;
+    unsigned chunk_offset = offset % dedup_store::chunk_size;
+    if (chunk_offset + size > dedup_store::chunk_size)
+        return -1;
+    return store->get_backing_fd(chunks[chunk_index], chunk_offset, pos);
+}
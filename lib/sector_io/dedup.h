@@ -0,0 +1,188 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#ifndef LIB_SECTOR_IO_DEDUP_H
+#define LIB_SECTOR_IO_DEDUP_H
+
+#include <vector>
+
+#include <lib/dedup_store.h>
+#include <lib/rcstring.h>
+#include <lib/sector_io.h>
+
+/**
+  * The sector_io_dedup class is used to represent access to a disk
+  * image kept in a deduplicated store (see dedup_store).  The image
+  * itself is a small manifest file, which names the store, and lists
+  * the store's chunks which make up the image, in order.  The bytes
+  * read are exactly those of the image which was imported.
+  *
+  * The manifest format (all numbers little-endian) is
+  *     8 bytes     the magic number "UCSDDDUP"
+  *     4 bytes     the format version, 1
+  *     4 bytes     the chunk size, 512
+  *     8 bytes     the size of the image, in bytes
+  *     4 bytes     the number of chunks
+  *     4 bytes     the length of the store's path
+  *     n bytes     the store's path, relative to the manifest's
+  *                 directory unless it starts with a slash
+  *     4 bytes     each chunk number, one per chunk
+  *
+  * Images in this format are read-only.
+  */
+class sector_io_dedup:
+    public sector_io
+{
+public:
+    /**
+      * The destructor.
+      */
+    virtual ~sector_io_dedup();
+
+private:
+    /**
+      * The constructor.  It is private on purpose, use the #create
+      * class method instead.
+      *
+      * @param filename
+      *     The name of the manifest file.
+      */
+    sector_io_dedup(const rcstring &filename);
+
+public:
+    /**
+      * The create class method is used to create new dynamically
+      * allocated instances of this class.  Errors are fatal.
+      *
+      * @param filename
+      *     The name of the manifest file.
+      * @param read_only
+      *     Ignored, images in this format are always read-only.
+      */
+    static pointer create(const rcstring &filename, bool read_only);
+
+    /**
+      * The candidate class method is used to determine if the given file
+      * is a candidate for being a deduplicated image manifest.
+      */
+    static bool candidate(const rcstring &filename);
+
+    /**
+      * The write_manifest class method is used to write a manifest
+      * file.  Errors are fatal.
+      *
+      * @param filename
+      *     The name of the manifest file to write.
+      * @param store_path
+      *     The path of the store, exactly as it is to appear in the
+      *     manifest.
+      * @param image_size
+      *     The size of the image, in bytes.
+      * @param chunks
+      *     The store's chunk numbers, one for each #dedup_store::chunk_size
+      *     bytes of the image (the last one may be partly used).
+      */
+    static void write_manifest(const rcstring &filename,
+        const rcstring &store_path, off_t image_size,
+        const std::vector<unsigned> &chunks);
+
+protected:
+    // See base class for documentation.
+    int read_sector(unsigned sector_number, void *data);
+
+    // See base class for documentation.
+    int read(off_t offset, void *data, size_t size);
+
+    // See base class for documentation.
+    int write_sector(unsigned sector_number, const void *data);
+
+    // See base class for documentation.
+    int write(off_t offset, const void *data, size_t size);
+
+    // See base class for documentation.
+    int size_in_sectors(void);
+
+    // See base class for documentation.
+    unsigned bytes_per_sector(void) const;
+
+    // See base class for documentation.
+    unsigned size_multiple_in_bytes(void) const;
+
+    // See base class for documentation.
+    int sync(void);
+
+    // See base class for documentation.
+    bool is_read_only(void) const;
+
+    // See base class for documentation.
+    void bytes_per_sector_hint(unsigned nbytes);
+
+    // See base class for documentation.
+    rcstring get_filename(void) const;
+
+    // See base class for documentation.
+    int get_backing_fd(off_t byte_offset, size_t nbytes, off_t &pos) const;
+
+private:
+    /**
+      * The filename instance variable is used to remember the name of
+      * the manifest file.
+      */
+    rcstring filename;
+
+    /**
+      * The store instance variable is used to remember the store
+      * holding the image's chunks.
+      */
+    dedup_store::pointer store;
+
+    /**
+      * The image_size instance variable is used to remember the size of
+      * the image, in bytes.
+      */
+    off_t image_size;
+
+    /**
+      * The chunks instance variable is used to remember the store's
+      * chunk numbers which make up the image, in order.
+      */
+    std::vector<unsigned> chunks;
+
+    /**
+      * The fake_bytes_per_sector instance variable is used to remember
+      * the current bytes per sector hint.
+      */
+    unsigned fake_bytes_per_sector;
+
+    /**
+      * The default constructor.  Do not use.
+      */
+    sector_io_dedup();
+
+    /**
+      * The copy constructor.  Do not use.
+      */
+    sector_io_dedup(const sector_io_dedup &);
+
+    /**
+      * The assignment operator.  Do not use.
+      */
+    sector_io_dedup &operator=(const sector_io_dedup &);
+};
+
+#endif // LIB_SECTOR_IO_DEDUP_H
@@ -16,6 +16,8 @@
 // with this program. If not, see <http://www.gnu.org/licenses/>
 //
 
+#include <lib/sector_io/chunked.h>
+#include <lib/sector_io/dedup.h>
 #include <lib/sector_io/imd.h>
 #include <lib/sector_io/mmap.h>
 #include <lib/sector_io/raw.h>
@@ -29,6 +31,10 @@ sector_io::factory(const rcstring &filename, bool read_only)
         return sector_io_imd::create(filename, read_only);
     if (sector_io_td0::candidate(filename))
         return sector_io_td0::create(filename, read_only);
+    if (sector_io_chunked::candidate(filename))
+        return sector_io_chunked::create(filename, read_only);
+    if (sector_io_dedup::candidate(filename))
+        return sector_io_dedup::create(filename, read_only);
     if (sector_io_mmap::available(filename, read_only))
         return sector_io_mmap::create(filename, read_only);
     return sector_io_raw::create(filename, read_only);
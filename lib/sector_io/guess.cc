@@ -19,6 +19,7 @@
 #include <lib/config.h>
 #include <lib/debug.h>
 #include <lib/hexdump.h>
+#include <lib/rcstring.h>
 #include <lib/sector_io/apple.h>
 #include <lib/sector_io/offset.h>
 #include <lib/sector_io/pdp.h>
@@ -55,8 +56,12 @@ has_valid_signature(const sector_io::pointer &sio)
 
 
 sector_io::pointer
-sector_io::guess_interleaving(pointer raw)
+sector_io::guess_interleaving(pointer raw, rcstring *how)
 {
+    rcstring dummy;
+    if (!how)
+        how = &dummy;
+
     //
     // See if the raw disk image has a valid signature.
     // This is the ideal case.
@@ -65,6 +70,7 @@ sector_io::guess_interleaving(pointer raw)
     if (has_valid_signature(raw))
     {
         DEBUG(2, "Interleaving: None");
+        *how = "none";
         return raw;
     }
 
@@ -76,6 +82,7 @@ sector_io::guess_interleaving(pointer raw)
     if (has_valid_signature(trial))
     {
         DEBUG(2, "Interleaving: Apple ][ Pascal");
+        *how = "apple";
         return trial;
     }
 
@@ -92,6 +99,7 @@ sector_io::guess_interleaving(pointer raw)
     if (has_valid_signature(trial))
     {
         DEBUG(2, "Interleaving: PDP11 offset");
+        *how = "offset=3328";
         return trial;
     }
 
@@ -100,6 +108,7 @@ sector_io::guess_interleaving(pointer raw)
     if (has_valid_signature(trial2))
     {
         DEBUG(2, "Interleaving: PDP11 map, PDP11 offset");
+        *how = "pdp,offset=3328";
         return trial2;
     }
 
@@ -108,6 +117,7 @@ sector_io::guess_interleaving(pointer raw)
     if (has_valid_signature(trial))
     {
         DEBUG(2, "Interleaving: PDP11 map");
+        *how = "pdp";
         return trial;
     }
 
@@ -121,6 +131,7 @@ sector_io::guess_interleaving(pointer raw)
         if (has_valid_signature(trial))
         {
             DEBUG(2, "Interleaving: offset 0x%04X", nbytes);
+            *how = rcstring::printf("offset=%d", nbytes);
             return trial;
         }
     }
@@ -18,12 +18,14 @@
 
 #include <lib/config.h>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <libexplain/output.h>
 
 #include <lib/endof.h>
 #include <lib/rcstring.h>
 #include <lib/sector_io/apple.h>
+#include <lib/sector_io/offset.h>
 #include <lib/sector_io/pdp.h>
 
 
@@ -67,6 +69,26 @@ help(const sector_io::pointer &iop)
 sector_io::pointer
 sector_io::interleave_factory(const char *name, const sector_io::pointer &iop)
 {
+    //
+    // A comma separated list is applied from right to left, so that
+    // the leftmost pattern is outermost, the way guess_interleaving
+    // describes what it found.
+    //
+    const char *comma = strchr(name, ',');
+    if (comma)
+    {
+        sector_io::pointer deeper = interleave_factory(comma + 1, iop);
+        return interleave_factory(rcstring(name, comma - name).c_str(), deeper);
+    }
+
+    if (0 == strncasecmp(name, "offset=", 7))
+    {
+        char *end = 0;
+        long nbytes = strtol(name + 7, &end, 0);
+        if (end != name + 7 && !*end && nbytes >= 0)
+            return sector_io_offset::create(iop, nbytes);
+    }
+
     for (const table_t *tp = table; tp < ENDOF(table); ++tp)
     {
         if (0 == strcasecmp(name, tp->name))
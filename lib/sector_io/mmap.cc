@@ -21,18 +21,15 @@
 #include <cerrno>
 #include <cstring>
 #include <fcntl.h>
-#include <libexplain/close.h>
-#include <libexplain/fstat.h>
-#include <libexplain/mmap.h>
-#include <libexplain/munmap.h>
-#include <libexplain/open.h>
 #include <libexplain/output.h>
 #include <unistd.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
 
 #include <lib/debug.h>
+#include <lib/explain_mt.h>
 #include <lib/sector_io/mmap.h>
+#include <lib/statistics.h>
 
 
 bool
@@ -89,11 +86,16 @@ sector_io_mmap::~sector_io_mmap()
 #ifdef HAVE_MMAP
     if (base)
     {
-        explain_munmap_or_die(base, length);
+        explain_mt_munmap_or_die(base, length);
     }
 #endif
     base = 0;
     length = 0;
+    if (fd >= 0)
+    {
+        explain_mt_close_or_die(fd);
+        fd = -1;
+    }
 }
 
 
@@ -102,6 +104,7 @@ sector_io_mmap::sector_io_mmap(const rcstring &a_filename, bool a_read_only) :
     read_only(a_read_only),
     base(0),
     length(0),
+    fd(-1),
     fake_bytes_per_sector(512)
 {
     DEBUG(1, "%s", __PRETTY_FUNCTION__);
@@ -109,10 +112,10 @@ sector_io_mmap::sector_io_mmap(const rcstring &a_filename, bool a_read_only) :
     int mode = O_RDWR;
     if (read_only)
         mode = O_RDONLY;
-    int fd = explain_open_or_die(filename.c_str(), mode, 0666);
+    fd = explain_mt_open_or_die(filename.c_str(), mode, 0666);
     DEBUG(2, "fd = %d", fd);
     struct stat st;
-    explain_fstat_or_die(fd, &st);
+    explain_mt_fstat_or_die(fd, &st);
 
     // Don't use memory mapped I/O for absurdly large disk images.
     // Sensable disk images are all less than 32K of 512 byte blocks.
@@ -133,9 +136,8 @@ sector_io_mmap::sector_io_mmap(const rcstring &a_filename, bool a_read_only) :
     off_t offset = 0;
     base =
         (unsigned char *)
-        explain_mmap_or_die(0, length, prot, flags, fd, offset);
+        explain_mt_mmap_or_die(0, length, prot, flags, fd, offset);
     DEBUG(2, "base = %p", base);
-    explain_close_or_die(fd);
 #endif
 }
 
@@ -155,6 +157,8 @@ sector_io_mmap::read_sector(unsigned sector_number, void *data)
         return -EINVAL;
 #ifdef HAVE_MMAP
     memcpy(data, base + offset, fake_bytes_per_sector);
+    statistics::add(statistics::image_reads);
+    statistics::add(statistics::image_read_bytes, fake_bytes_per_sector);
     return 0;
 #else
     return -ENOSYS;
@@ -171,6 +175,8 @@ sector_io_mmap::read(off_t offset, void *data, size_t size)
         return -EINVAL;
 #ifdef HAVE_MMAP
     memcpy(data, base + (size_t)offset, size);
+    statistics::add(statistics::image_reads);
+    statistics::add(statistics::image_read_bytes, size);
     return size;
 #else
     return -ENOSYS;
@@ -188,6 +194,8 @@ sector_io_mmap::write_sector(unsigned sector_number, const void *data)
         return -EINVAL;
 #ifdef HAVE_MMAP
     memcpy(base + offset, data, fake_bytes_per_sector);
+    statistics::add(statistics::image_writes);
+    statistics::add(statistics::image_write_bytes, fake_bytes_per_sector);
     return 0;
 #else
     return -ENOSYS;
@@ -206,6 +214,28 @@ sector_io_mmap::write(off_t offset, const void *data, size_t size)
         return -EINVAL;
 #ifdef HAVE_MMAP
     memcpy(base + (size_t)offset, data, size);
+    statistics::add(statistics::image_writes);
+    statistics::add(statistics::image_write_bytes, size);
+    return 0;
+#else
+    return -ENOSYS;
+#endif
+}
+
+
+int
+sector_io_mmap::write_zero(off_t offset, size_t size)
+{
+    if (read_only)
+        return -EACCES;
+    if (offset < 0 || offset >= (off_t)length)
+        return -EINVAL;
+    if (offset + size > length)
+        return -EINVAL;
+#ifdef HAVE_MMAP
+    memset(base + (size_t)offset, 0, size);
+    statistics::add(statistics::image_writes);
+    statistics::add(statistics::image_write_bytes, size);
     return 0;
 #else
     return -ENOSYS;
@@ -227,6 +257,7 @@ int
 sector_io_mmap::sync()
 {
 #ifdef HAVE_MMAP
+    statistics::add(statistics::image_syncs);
     int flags = MS_SYNC;
     if (msync(base, length, flags) < 0)
         return -errno;
@@ -276,3 +307,14 @@ sector_io_mmap::get_filename(void)
 {
     return filename;
 }
+
+
+int
+sector_io_mmap::get_backing_fd(off_t offset, size_t size, off_t &pos)
+    const
+{
+    if (fd < 0 || offset < 0 || offset + size > length)
+        return -1;
+    pos = offset;
+    return fd;
+}
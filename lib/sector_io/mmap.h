@@ -94,6 +94,9 @@ protected:
     // See base class for documentation.
     int write(off_t offset, const void *data, size_t size);
 
+    // See base class for documentation.
+    int write_zero(off_t offset, size_t size);
+
     // See base class for documentation.
     int size_in_sectors();
 
@@ -115,6 +118,9 @@ protected:
     // See base class for documentation.
     rcstring get_filename(void) const;
 
+    // See base class for documentation.
+    int get_backing_fd(off_t byte_offset, size_t nbytes, off_t &pos) const;
+
 private:
     /**
       * The filename instance variable is used to remember the name of
@@ -142,6 +148,12 @@ private:
       */
     size_t length;
 
+    /**
+      * The fd instance variable is used to remember the file descriptor
+      * of the mapped file.  It is kept open for #get_backing_fd.
+      */
+    int fd;
+
     /**
       * The fake_bytes_per_sector instance variable is used to remember
       * the current bytes per sector hint.  It has no effect on our I/O
@@ -71,6 +71,13 @@ sector_io_offset::write(off_t pos, const void *data, size_t nbytes)
 }
 
 
+int
+sector_io_offset::write_zero(off_t pos, size_t nbytes)
+{
+    return deeper->write_zero(pos + byte_offset, nbytes);
+}
+
+
 int
 sector_io_offset::size_in_sectors()
 {
@@ -128,3 +135,11 @@ sector_io_offset::get_filename(void)
 {
     return deeper->get_filename();
 }
+
+
+int
+sector_io_offset::get_backing_fd(off_t pos, size_t nbytes, off_t &fd_pos)
+    const
+{
+    return deeper->get_backing_fd(pos + byte_offset, nbytes, fd_pos);
+}
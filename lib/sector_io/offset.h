@@ -71,6 +71,9 @@ protected:
     // See base class for documentation.
     int write(off_t byte_offset, const void *data, size_t nbytes);
 
+    // See base class for documentation.
+    int write_zero(off_t byte_offset, size_t nbytes);
+
     // See base class for documentation.
     int size_in_sectors();
 
@@ -92,6 +95,9 @@ protected:
     // See base class for documentation.
     rcstring get_filename(void) const;
 
+    // See base class for documentation.
+    int get_backing_fd(off_t byte_offset, size_t nbytes, off_t &pos) const;
+
 private:
     /**
       * The offset instance variable is used to remember the sector I/O
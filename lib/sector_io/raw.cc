@@ -21,13 +21,14 @@
 #include <cerrno>
 #include <cstring>
 #include <fcntl.h>
-#include <libexplain/open.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
 #include <lib/debug.h>
+#include <lib/explain_mt.h>
 #include <lib/sector_io/raw.h>
+#include <lib/statistics.h>
 
 
 sector_io_raw::~sector_io_raw()
@@ -50,7 +51,7 @@ sector_io_raw::sector_io_raw(const rcstring &a_filename, bool a_read_only) :
     DEBUG(2, "sector_io_raw::sector_io_raw(this = %p, filename = %s, "
         "read_only = %d)", this, filename.quote_c().c_str(), read_only);
     int mode = (read_only ? O_RDONLY : (O_RDWR | O_CREAT));
-    fd = explain_open_or_die(filename.c_str(), mode, 0666);
+    fd = explain_mt_open_or_die(filename.c_str(), mode, 0666);
     DEBUG(3, "fd = %d", fd);
 }
 
@@ -83,6 +84,7 @@ sector_io_raw::read(off_t offset, void *data, size_t size)
         return -EINVAL;
     DEBUG(3, "pread(fd = %d, data = %p, size = 0x%lX, offset = 0x%lX)", fd,
         data, (long)size, (long)offset);
+    statistics::add(statistics::image_reads);
     ssize_t n = ::pread(fd, data, size, offset);
     if (n < 0)
     {
@@ -94,6 +96,7 @@ sector_io_raw::read(off_t offset, void *data, size_t size)
         DEBUG(3, "read %ld, expected %ld", (long)n, (long)size);
         return -ENOSPC;
     }
+    statistics::add(statistics::image_read_bytes, size);
     return size;
 }
 
@@ -121,6 +124,7 @@ sector_io_raw::write(off_t offset, const void *data, size_t size)
         return -EINVAL;
     DEBUG(3, "pwrite(fd = %d, data = %p, size = 0x%lX, offset = 0x%lX)", fd,
         data, (long)size, (long)offset);
+    statistics::add(statistics::image_writes);
     ssize_t n = ::pwrite(fd, data, size, offset);
     if (n < 0)
     {
@@ -132,10 +136,81 @@ sector_io_raw::write(off_t offset, const void *data, size_t size)
         DEBUG(3, "wrote %ld, expected %ld", (long)n, (long)size);
         return -ENOSPC;
     }
+    statistics::add(statistics::image_write_bytes, size);
     return size;
 }
 
 
+int
+sector_io_raw::write_zero(off_t offset, size_t size)
+{
+    DEBUG(2, "sector_io_raw::write_zero(this = %p, offset = 0x%lX, "
+        "size = 0x%lX)", this, (long)offset, (long)size);
+    if (fd < 0)
+        return -err;
+    if (read_only)
+        return -EACCES;
+    if (offset < 0)
+        return -EINVAL;
+    if (size == 0)
+        return 0;
+
+    //
+    // Punch a hole for the part of the range within the file, the file
+    // system will read back zeros, and the disk image becomes sparse.
+    // Any part of the range beyond the end of the file still has to be
+    // written, so that the file grows.
+    //
+#ifdef HAVE_FALLOCATE_PUNCH_HOLE
+    struct stat st;
+    if (fstat(fd, &st) == 0 && offset < st.st_size)
+    {
+        off_t end = offset + size;
+        if (end > st.st_size)
+            end = st.st_size;
+        int mode = FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE;
+        if (fallocate(fd, mode, offset, end - offset) == 0)
+        {
+            size -= end - offset;
+            offset = end;
+            if (size == 0)
+                return 0;
+        }
+        else
+        {
+            // Not supported by this file system, write zeros instead.
+            DEBUG(3, "fallocate: %s", strerror(errno));
+        }
+    }
+#endif
+
+    //
+    // Write the zeros in large chunks.  Unlike sector_io::write_zero,
+    // there is no interleave to worry about.
+    //
+    static char zero[1 << 16];
+    while (size > 0)
+    {
+        size_t chunk = size;
+        if (chunk > sizeof(zero))
+            chunk = sizeof(zero);
+        statistics::add(statistics::image_writes);
+        ssize_t n = ::pwrite(fd, zero, chunk, offset);
+        if (n < 0)
+        {
+            err = errno;
+            return -err;
+        }
+        if ((size_t)n != chunk)
+            return -ENOSPC;
+        statistics::add(statistics::image_write_bytes, chunk);
+        offset += chunk;
+        size -= chunk;
+    }
+    return 0;
+}
+
+
 int
 sector_io_raw::size_in_sectors()
 {
@@ -174,6 +249,7 @@ sector_io_raw::sync()
         return 0;
     if (fd < 0)
         return -err;
+    statistics::add(statistics::image_syncs);
     int rslt = fsync(fd);
     if (rslt < 0)
         return -errno;
@@ -205,3 +281,22 @@ sector_io_raw::get_filename(void)
 {
     return filename;
 }
+
+
+int
+sector_io_raw::get_backing_fd(off_t offset, size_t size, off_t &pos)
+    const
+{
+    if (fd < 0 || offset < 0)
+        return -1;
+
+    //
+    // The read method fails for bytes past the end of the file, so
+    // they must not be read by other means, either.
+    //
+    struct stat st;
+    if (fstat(fd, &st) < 0 || offset + (off_t)size > st.st_size)
+        return -1;
+    pos = offset;
+    return fd;
+}
@@ -61,6 +61,9 @@ protected:
     // See base class for documentation.
     int write(off_t offset, const void *data, size_t size);
 
+    // See base class for documentation.
+    int write_zero(off_t offset, size_t size);
+
     // See base class for documentation.
     int size_in_sectors(void);
 
@@ -82,6 +85,9 @@ protected:
     // See base class for documentation.
     rcstring get_filename(void) const;
 
+    // See base class for documentation.
+    int get_backing_fd(off_t byte_offset, size_t nbytes, off_t &pos) const;
+
 private:
     /**
       * The filename instance variable is used to remember the name of
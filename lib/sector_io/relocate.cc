@@ -18,6 +18,7 @@
 
 #include <lib/config.h>
 #include <cassert>
+#include <vector>
 
 #include <lib/sector_io.h>
 
@@ -85,3 +86,45 @@ sector_io::relocate_sectors(unsigned to_sector_num, unsigned from_sector_num,
     }
     return 0;
 }
+
+
+int
+sector_io::copy_bytes(off_t to, off_t from, size_t nbytes)
+{
+    if (to == from || nbytes == 0)
+        return 0;
+    unsigned sizeof_sector = bytes_per_sector();
+    if
+    (
+        to % sizeof_sector == 0
+    &&
+        from % sizeof_sector == 0
+    &&
+        nbytes % sizeof_sector == 0
+    )
+        return relocate_bytes(to, from, nbytes);
+
+    //
+    // Copy in large pieces.  If the destination overlaps the end of the
+    // source, work from the end backwards, the way relocate_sectors
+    // does, so that nothing is overwritten before it has been copied.
+    //
+    std::vector<char> buffer(nbytes < (1 << 16) ? nbytes : (1 << 16));
+    bool backwards = (to > from && to < from + (off_t)nbytes);
+    size_t done = 0;
+    while (done < nbytes)
+    {
+        size_t chunk = nbytes - done;
+        if (chunk > buffer.size())
+            chunk = buffer.size();
+        off_t offset = (backwards ? nbytes - done - chunk : done);
+        int err = read(from + offset, &buffer[0], chunk);
+        if (err < 0)
+            return err;
+        err = write(to + offset, &buffer[0], chunk);
+        if (err < 0)
+            return err;
+        done += chunk;
+    }
+    return 0;
+}
@@ -20,12 +20,12 @@
 #include <cerrno>
 #include <cstdio>
 #include <cstring>
-#include <libexplain/fopen.h>
-#include <libexplain/getc.h>
 #include <libexplain/output.h>
 
 #include <lib/debug.h>
 #include <lib/endof.h>
+#include <lib/explain_mt.h>
+#include <lib/mutex.h>
 #include <lib/rcstring.h>
 #include <lib/rcstring/accumulator.h>
 #include <lib/sector_io/td0.h>
@@ -52,6 +52,13 @@ compute_crc(const unsigned char *p, size_t len, unsigned short crc)
     return crc;
 }
 
+//
+// The decoder below keeps its state in static variables, so only one
+// .TD0 file may be read at a time.  The decode_lock variable is used to
+// make sure of that, when several threads are opening disk images.
+//
+static mutex decode_lock;
+
 static rcstring fn;
 static FILE *fp;
 
@@ -277,7 +284,7 @@ static unsigned char
 get_char_raw(void)
 {
     DEBUG(3, "%s", __PRETTY_FUNCTION__);
-    int c = explain_getc_or_die(fp);
+    int c = explain_mt_getc_or_die(fp);
     if (c == EOF)
     {
         explain_output_error_and_die("%s: premature end-of-file", fn.c_str());
@@ -470,12 +477,13 @@ sector_io_td0::sector_io_td0(const rcstring &a_filename) :
     data(0)
 {
     DEBUG(2, "%s", __PRETTY_FUNCTION__);
+    mutex::locker hold(decode_lock);
 
     //
     // Open the file
     //
     fn = filename;
-    fp = explain_fopen_or_die(filename.c_str(), "rb");
+    fp = explain_mt_fopen_or_die(filename.c_str(), "rb");
 
     Advcomp = false;
     unsigned comp_crc = 0;
@@ -657,14 +665,13 @@ bool
 sector_io_td0::candidate(const rcstring &filnam)
 {
     DEBUG(2, "%s", __PRETTY_FUNCTION__);
-    fp = fopen(filnam.c_str(), "rb");
-    if (!fp)
+    FILE *cfp = fopen(filnam.c_str(), "rb");
+    if (!cfp)
         return false;
-    int c1 = getc(fp);
-    int c2 = getc(fp);
-    int c3 = getc(fp);
-    fclose(fp);
-    fp = 0;
+    int c1 = getc(cfp);
+    int c2 = getc(cfp);
+    int c3 = getc(cfp);
+    fclose(cfp);
     return (((c1 == 'T' && c2 == 'D') || (c1 == 't' && c2 == 'd')) && c3 == 0);
 }
 
@@ -0,0 +1,94 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cassert>
+
+#include <lib/statistics.h>
+
+
+unsigned long statistics::counters[statistics::counter_max];
+
+
+void
+statistics::add(counter_t which, unsigned long amount)
+{
+    assert(which >= 0 && which < counter_max);
+    __sync_fetch_and_add(&counters[which], amount);
+}
+
+
+unsigned long
+statistics::get(counter_t which)
+{
+    assert(which >= 0 && which < counter_max);
+    return __sync_fetch_and_add(&counters[which], 0);
+}
+
+
+const char *
+statistics::name(counter_t which)
+{
+    switch (which)
+    {
+    case image_reads:
+        return "image.reads";
+
+    case image_read_bytes:
+        return "image.read_bytes";
+
+    case image_writes:
+        return "image.writes";
+
+    case image_write_bytes:
+        return "image.write_bytes";
+
+    case image_syncs:
+        return "image.syncs";
+
+    case meta_syncs:
+        return "meta.syncs";
+
+    case meta_syncs_avoided:
+        return "meta.syncs_avoided";
+
+    case relocations:
+        return "relocate.extents";
+
+    case relocation_bytes:
+        return "relocate.bytes";
+
+    case text_index_hits:
+        return "text_index.hits";
+
+    case text_index_misses:
+        return "text_index.misses";
+
+    case counter_max:
+        break;
+    }
+    return "unknown";
+}
+
+
+void
+statistics::reset(void)
+{
+    for (int j = 0; j < counter_max; ++j)
+        __sync_lock_test_and_set(&counters[j], 0);
+}
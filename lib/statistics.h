@@ -0,0 +1,102 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#ifndef LIB_STATISTICS_H
+#define LIB_STATISTICS_H
+
+#include <lib/config.h>
+
+/**
+  * The statistics class is used to count interesting events deep in
+  * the library, such as disk image I/O and file relocations, so that a
+  * long running program (ucsdpsys_mount) can report where its time is
+  * going.  The counters are shared by all threads, and all disk images
+  * a program has open.
+  */
+class statistics
+{
+public:
+    enum counter_t
+    {
+        image_reads,
+        image_read_bytes,
+        image_writes,
+        image_write_bytes,
+        image_syncs,
+        meta_syncs,
+        meta_syncs_avoided,
+        relocations,
+        relocation_bytes,
+        text_index_hits,
+        text_index_misses,
+        counter_max
+    };
+
+    /**
+      * The add class method is used to add to a counter.
+      * It is safe to call from any thread.
+      *
+      * @param which
+      *     The counter to add to.
+      * @param amount
+      *     The amount to add.
+      */
+    static void add(counter_t which, unsigned long amount = 1);
+
+    /**
+      * The get class method is used to obtain the current value of a
+      * counter.
+      */
+    static unsigned long get(counter_t which);
+
+    /**
+      * The name class method is used to obtain the name of a counter,
+      * for use in reports.
+      */
+    static const char *name(counter_t which);
+
+    /**
+      * The reset class method is used to set all of the counters back
+      * to zero.
+      */
+    static void reset(void);
+
+private:
+    /**
+      * The counters class variable is used to remember the value of
+      * each counter.
+      */
+    static unsigned long counters[counter_max];
+
+    /**
+      * The default constructor.  Do not use.
+      */
+    statistics();
+
+    /**
+      * The copy constructor.  Do not use.
+      */
+    statistics(const statistics &);
+
+    /**
+      * The assignment operator.  Do not use.
+      */
+    statistics &operator=(const statistics &);
+};
+
+#endif // LIB_STATISTICS_H
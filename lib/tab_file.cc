@@ -0,0 +1,119 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <libexplain/close.h>
+#include <libexplain/fclose.h>
+#include <libexplain/fopen.h>
+#include <libexplain/fstat.h>
+#include <libexplain/open.h>
+#include <libexplain/read.h>
+#include <libexplain/rename.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include <lib/tab_file.h>
+
+
+void
+tab_file_read(const rcstring &filename, rcstring_list &lines)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        if (errno == ENOENT)
+            return;
+        explain_open_or_die(filename.c_str(), O_RDONLY, 0);
+    }
+
+    //
+    // The file is read in one piece; it is read far more often than it
+    // is written, and reading it should be quick.
+    //
+    struct stat st;
+    explain_fstat_or_die(fd, &st);
+    std::vector<char> data(st.st_size);
+    size_t nbytes = 0;
+    while (nbytes < data.size())
+    {
+        ssize_t n =
+            explain_read_or_die(fd, &data[nbytes], data.size() - nbytes);
+        if (n == 0)
+            break;
+        nbytes += n;
+    }
+    explain_close_or_die(fd);
+
+    const char *cp = (nbytes ? &data[0] : "");
+    const char *end = cp + nbytes;
+    while (cp < end)
+    {
+        const char *eol = (const char *)memchr(cp, '\n', end - cp);
+        if (!eol)
+            eol = end;
+        if (eol > cp && *cp != '#')
+            lines.push_back(rcstring(cp, eol - cp));
+        cp = eol + 1;
+    }
+}
+
+
+bool
+tab_file_split(const rcstring &line, rcstring *fields, size_t nfields)
+{
+    const char *cp = line.c_str();
+    const char *end = cp + line.size();
+    for (size_t j = 0; j + 1 < nfields; ++j)
+    {
+        const char *tab = (const char *)memchr(cp, '\t', end - cp);
+        if (!tab)
+            return false;
+        fields[j] = rcstring(cp, tab - cp);
+        cp = tab + 1;
+    }
+    fields[nfields - 1] = rcstring(cp, end - cp);
+    return true;
+}
+
+
+FILE *
+tab_file_create(const rcstring &filename, const char *title)
+{
+    //
+    // Write a new file, and then rename it into place (see
+    // tab_file_commit), so that an interrupted run never leaves half a
+    // file behind.
+    //
+    rcstring tmp = filename + ".tmp";
+    FILE *fp = explain_fopen_or_die(tmp.c_str(), "w");
+    fprintf(fp, "# %s\n", title);
+    return fp;
+}
+
+
+void
+tab_file_commit(FILE *fp, const rcstring &filename)
+{
+    rcstring tmp = filename + ".tmp";
+    explain_fclose_or_die(fp);
+    explain_rename_or_die(tmp.c_str(), filename.c_str());
+}
@@ -0,0 +1,88 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#ifndef LIB_TAB_FILE_H
+#define LIB_TAB_FILE_H
+
+#include <cstdio>
+
+#include <lib/rcstring/list.h>
+
+//
+// Tab files are the text files in which indexes (ucsdpsys_fsck's cache,
+// ucsdpsys_catalog's index) are kept from one run to the next: one
+// record per line, tab separated fields, lines starting with '#' are
+// comments.  They are only ever a record of work done before, so lines
+// which can't be understood are quietly dropped; the worst that can
+// happen is that the work is done again.
+//
+
+/**
+  * The tab_file_read function is used to read a tab file.  It is not
+  * an error for the file not to exist (there is none the first time).
+  *
+  * @param filename
+  *     The name of the file to read.
+  * @param lines
+  *     Where to put the lines of the file, less blank lines and
+  *     comments.
+  */
+void tab_file_read(const rcstring &filename, rcstring_list &lines);
+
+/**
+  * The tab_file_split function is used to break a line of a tab file
+  * into its fields.  The last field is the rest of the line, so that it
+  * (and only it) may contain tabs; it is usually a file name.
+  *
+  * @param line
+  *     The line to break up.
+  * @param fields
+  *     Where to put the fields.
+  * @param nfields
+  *     The number of fields expected.
+  * @returns
+  *     true if the line has enough fields, false if not.
+  */
+bool tab_file_split(const rcstring &line, rcstring *fields, size_t nfields);
+
+/**
+  * The tab_file_create function is used to start writing a new tab
+  * file.  It is written beside the old one, and only replaces it when
+  * passed to #tab_file_commit.
+  *
+  * @param filename
+  *     The name of the file to write.
+  * @param title
+  *     The comment to put on the first line.
+  * @returns
+  *     the stream to write the lines to.
+  */
+FILE *tab_file_create(const rcstring &filename, const char *title);
+
+/**
+  * The tab_file_commit function is used to finish writing a tab file,
+  * replacing the old one.
+  *
+  * @param fp
+  *     The stream returned by #tab_file_create.
+  * @param filename
+  *     The name of the file, as given to #tab_file_create.
+  */
+void tab_file_commit(FILE *fp, const rcstring &filename);
+
+#endif // LIB_TAB_FILE_H
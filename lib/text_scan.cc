@@ -0,0 +1,153 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+
+#include <lib/text_scan.h>
+
+//
+// The vector versions examine 16 (SSE2) or 32 (AVX2) bytes at a time,
+// building a bit mask of the special bytes, so that the position of the
+// first one can be found with a single count-trailing-zeros.  Any
+// remainder is handled by the scalar loop.
+//
+#if defined(__GNUC__) && defined(__AVX2__)
+#include <immintrin.h>
+#define TEXT_SCAN_AVX2 1
+#elif defined(__GNUC__) && defined(__SSE2__)
+#include <emmintrin.h>
+#define TEXT_SCAN_SSE2 1
+#endif
+
+
+static inline bool
+decode_special(unsigned char c)
+{
+    return (c == '\0' || c == '\r' || c == '\n' || c == 16);
+}
+
+
+static inline bool
+encode_special(unsigned char c)
+{
+    return (c < ' ' || c > '~');
+}
+
+
+size_t
+text_scan_decode(const unsigned char *data, size_t size)
+{
+    size_t j = 0;
+#if TEXT_SCAN_AVX2
+    const __m256i nul = _mm256_setzero_si256();
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i nl = _mm256_set1_epi8('\n');
+    const __m256i dle = _mm256_set1_epi8(16);
+    for (; j + 32 <= size; j += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(data + j));
+        __m256i m =
+            _mm256_or_si256
+            (
+                _mm256_or_si256
+                (
+                    _mm256_cmpeq_epi8(v, nul),
+                    _mm256_cmpeq_epi8(v, cr)
+                ),
+                _mm256_or_si256
+                (
+                    _mm256_cmpeq_epi8(v, nl),
+                    _mm256_cmpeq_epi8(v, dle)
+                )
+            );
+        unsigned mask = _mm256_movemask_epi8(m);
+        if (mask)
+            return j + __builtin_ctz(mask);
+    }
+#elif TEXT_SCAN_SSE2
+    const __m128i nul = _mm_setzero_si128();
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i nl = _mm_set1_epi8('\n');
+    const __m128i dle = _mm_set1_epi8(16);
+    for (; j + 16 <= size; j += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(data + j));
+        __m128i m =
+            _mm_or_si128
+            (
+                _mm_or_si128(_mm_cmpeq_epi8(v, nul), _mm_cmpeq_epi8(v, cr)),
+                _mm_or_si128(_mm_cmpeq_epi8(v, nl), _mm_cmpeq_epi8(v, dle))
+            );
+        unsigned mask = _mm_movemask_epi8(m);
+        if (mask)
+            return j + __builtin_ctz(mask);
+    }
+#endif
+    for (; j < size; ++j)
+        if (decode_special(data[j]))
+            return j;
+    return size;
+}
+
+
+size_t
+text_scan_encode(const unsigned char *data, size_t size)
+{
+    size_t j = 0;
+#if TEXT_SCAN_AVX2
+    //
+    // The comparisons are signed, so bytes 0x80..0xFF look negative,
+    // and are caught by the less-than-space comparison.
+    //
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i del = _mm256_set1_epi8(0x7F);
+    for (; j + 32 <= size; j += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(data + j));
+        __m256i m =
+            _mm256_or_si256
+            (
+                _mm256_cmpgt_epi8(space, v),
+                _mm256_cmpeq_epi8(v, del)
+            );
+        unsigned mask = _mm256_movemask_epi8(m);
+        if (mask)
+            return j + __builtin_ctz(mask);
+    }
+#elif TEXT_SCAN_SSE2
+    //
+    // The comparisons are signed, so bytes 0x80..0xFF look negative,
+    // and are caught by the less-than-space comparison.
+    //
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i del = _mm_set1_epi8(0x7F);
+    for (; j + 16 <= size; j += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(data + j));
+        __m128i m =
+            _mm_or_si128(_mm_cmplt_epi8(v, space), _mm_cmpeq_epi8(v, del));
+        unsigned mask = _mm_movemask_epi8(m);
+        if (mask)
+            return j + __builtin_ctz(mask);
+    }
+#endif
+    for (; j < size; ++j)
+        if (encode_special(data[j]))
+            return j;
+    return size;
+}
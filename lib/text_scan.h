@@ -0,0 +1,53 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#ifndef LIB_TEXT_SCAN_H
+#define LIB_TEXT_SCAN_H
+
+#include <cstddef>
+
+/**
+  * The text_scan_decode function is used to find the next byte of UCSD
+  * p-System text which the text decoder must treat specially: NUL, CR,
+  * NL or DLE.  All other bytes are copied through unchanged, when in
+  * the middle of a line.
+  *
+  * @param data
+  *     The text to be scanned.
+  * @param size
+  *     The number of bytes of text.
+  * @returns
+  *     the offset of the first special byte, or size if there is none.
+  */
+size_t text_scan_decode(const unsigned char *data, size_t size);
+
+/**
+  * The text_scan_encode function is used to find the next byte of Unix
+  * text which the text encoder must treat specially, that is, anything
+  * other than a printable ASCII character (space to tilde).
+  *
+  * @param data
+  *     The text to be scanned.
+  * @param size
+  *     The number of bytes of text.
+  * @returns
+  *     the offset of the first special byte, or size if there is none.
+  */
+size_t text_scan_encode(const unsigned char *data, size_t size);
+
+#endif // LIB_TEXT_SCAN_H
@@ -27,6 +27,7 @@ FRED:
 EXAMPLE.TEXT       6  10   2048 $dt textfile
 1 of 77 files
 10 of 280 blocks, 96.4% free
+largest free extent: 270 blocks
 Last mounted $dt2
 fubar
 test $? -eq 0 || no_result
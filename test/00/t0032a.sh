@@ -0,0 +1,146 @@
+#!/bin/sh
+#
+# UCSD p-System filesystem in user space
+# Copyright (C) 2026 Peter Miller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or (at
+# you option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program. If not, see <http://www.gnu.org/licenses/>
+#
+
+TEST_SUBJECT="journaled crunch"
+. test_prelude
+
+#
+# Once a relocation is over, the second copy of the directory (where the
+# twin journal lives) must be the same as the first again.
+#
+check_twin()
+{
+    test -z "$twin" && return 0
+    dd if=fred.vol of=dir1 bs=512 skip=2 count=4 2> /dev/null
+    test $? -eq 0 || no_result
+    dd if=fred.vol of=dir2 bs=512 skip=6 count=4 2> /dev/null
+    test $? -eq 0 || no_result
+    cmp dir1 dir2
+    test $? -eq 0 || fail
+}
+
+for n in 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20
+do
+    echo "The quick brown fox jumps over the lazy dog, line $n."
+done > a.text
+test $? -eq 0 || no_result
+cat a.text a.text a.text a.text > b.text
+test $? -eq 0 || no_result
+cat b.text b.text b.text b.text b.text b.text > c.text
+test $? -eq 0 || no_result
+
+for twin in "" "-t"
+do
+    rm -f fred.vol fred.vol.journal
+    ucsdpsys_mkfs $twin -L fred fred.vol
+    test $? -eq 0 || no_result
+
+    ucsdpsys_disk -f fred.vol -p a.text b.text c.text
+    test $? -eq 0 || fail
+
+    ucsdpsys_disk -f fred.vol -r a.text
+    test $? -eq 0 || fail
+
+    # the files overlap their old locations, so they move in chunks
+    ucsdpsys_disk -f fred.vol -k
+    test $? -eq 0 || fail
+
+    test -f fred.vol.journal && fail
+    check_twin
+
+    ucsdpsys_fsck fred.vol
+    test $? -eq 0 || fail
+
+    mkdir out
+    test $? -eq 0 || no_result
+    ( cd out && ucsdpsys_disk -f ../fred.vol -g b.text c.text )
+    test $? -eq 0 || fail
+
+    cmp b.text out/b.text
+    test $? -eq 0 || fail
+    cmp c.text out/c.text
+    test $? -eq 0 || fail
+    rm -rf out
+done
+
+#
+# Plant the journal of a relocation which was interrupted before any
+# data was copied (which must be rolled back), and one interrupted after
+# the first chunk over-wrote part of the original (which must be rolled
+# forward), in both the sidecar form and the twin directory form.
+#
+for twin in "" "-t"
+do
+    for copied in 0 6
+    do
+        rm -f fred.vol fred.vol.journal
+        ucsdpsys_mkfs $twin -L fred fred.vol
+        test $? -eq 0 || no_result
+        ucsdpsys_disk -f fred.vol -p a.text b.text c.text
+        test $? -eq 0 || no_result
+        ucsdpsys_disk -f fred.vol -r a.text
+        test $? -eq 0 || no_result
+
+        test_journal $twin -p $copied fred.vol b.text > test.out
+        test $? -eq 0 || no_result
+        if test -z "$twin"
+        then
+            test -f fred.vol.journal || fail
+        fi
+
+        # checking reports the interrupted move, but leaves it alone
+        ucsdpsys_fsck fred.vol > test.out 2> test.err
+        grep 'not recovered' test.err > /dev/null
+        test $? -eq 0 || fail
+
+        if test "$copied" -eq 0
+        then
+            # the move is undone by the next read-write open
+            ucsdpsys_disk -f fred.vol -p a.text
+            test $? -eq 0 || fail
+        else
+            ucsdpsys_fsck -f fred.vol > test.out 2> test.err
+            grep 'rolled forward' test.err > /dev/null
+            test $? -eq 0 || fail
+        fi
+        test -f fred.vol.journal && fail
+        check_twin
+
+        ucsdpsys_fsck fred.vol
+        test $? -eq 0 || fail
+
+        mkdir out
+        test $? -eq 0 || no_result
+        ( cd out && ucsdpsys_disk -f ../fred.vol -g b.text c.text )
+        test $? -eq 0 || fail
+
+        cmp b.text out/b.text
+        test $? -eq 0 || fail
+        cmp c.text out/c.text
+        test $? -eq 0 || fail
+        rm -rf out
+    done
+done
+
+#
+# The functionality exercised by this test worked.
+# No other assertions are made.
+#
+pass
+# vim: set ts=8 sw=4 et :
@@ -0,0 +1,87 @@
+#!/bin/sh
+#
+# UCSD p-System filesystem in user space
+# Copyright (C) 2026 Peter Miller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or (at
+# you option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program. If not, see <http://www.gnu.org/licenses/>
+#
+
+
+TEST_SUBJECT="ucsdpsys_disk --wipe-unused"
+. test_prelude
+
+#
+# Build a tiny code file: a segment dictionary with one version II
+# segment of 100 bytes in block 1, and the rest of block 1 full of
+# rubbish.
+#
+printf '\001\000\144\000' > dict
+test $? -eq 0 || no_result
+dd if=/dev/zero bs=252 count=1 >> dict 2> /dev/null
+test $? -eq 0 || no_result
+printf '\000\100' >> dict
+test $? -eq 0 || no_result
+dd if=/dev/zero bs=254 count=1 >> dict 2> /dev/null
+test $? -eq 0 || no_result
+dd if=/dev/zero bs=512 count=1 2> /dev/null | tr '\000' X > seg
+test $? -eq 0 || no_result
+cat dict seg > junk.code
+test $? -eq 0 || no_result
+
+date > junk.text
+test $? -eq 0 || no_result
+
+ucsdpsys_mkfs -L fred fred.vol
+test $? -eq 0 || no_result
+
+ucsdpsys_disk -f fred.vol -p junk.text junk.code
+test $? -eq 0 || fail
+
+ucsdpsys_disk -f fred.vol -r junk.text
+test $? -eq 0 || fail
+
+ucsdpsys_disk -f fred.vol --wipe-unused
+test $? -eq 0 || fail
+
+# the removed text file (block 6) should be gone
+dd if=fred.vol bs=512 skip=6 count=4 2> /dev/null | tr -d '\000' > test.out
+test $? -eq 0 || no_result
+test -s test.out && fail
+
+# everything after the code file should be zero, too
+dd if=fred.vol bs=512 skip=12 2> /dev/null | tr -d '\000' > test.out
+test $? -eq 0 || no_result
+test -s test.out && fail
+
+mkdir out
+test $? -eq 0 || no_result
+( cd out && ucsdpsys_disk -f ../fred.vol -g junk.code )
+test $? -eq 0 || fail
+
+# the segment's code is intact
+dd if=out/junk.code bs=1 skip=512 count=100 2> /dev/null | tr -d X > test.out
+test $? -eq 0 || no_result
+test -s test.out && fail
+
+# the segment's tail has been wiped
+dd if=out/junk.code bs=1 skip=612 2> /dev/null | tr -d '\000' > test.out
+test $? -eq 0 || no_result
+test -s test.out && fail
+
+#
+# The functionality exercised by this test worked.
+# No other assertions are made.
+#
+pass
+# vim: set ts=8 sw=4 et :
@@ -0,0 +1,73 @@
+#!/bin/sh
+#
+# UCSD p-System filesystem in user space
+# Copyright (C) 2026 Peter Miller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or (at
+# you option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program. If not, see <http://www.gnu.org/licenses/>
+#
+
+TEST_SUBJECT="incremental text encoding"
+. test_prelude
+
+#
+# Create a disk image
+#
+ucsdpsys_mkfs disk.image
+test $? -eq 0 || fail
+
+#
+# Build a text file large enough to be written in many pieces, with
+# lines of varying length and indent, so that page boundaries fall in
+# many different places.
+#
+i=0
+: > big.text
+while [ $i -lt 1500 ]
+do
+    echo "line $i" >> big.text
+    echo "        indented $i $i $i $i" >> big.text
+    i=`expr $i + 1`
+done
+test $? -eq 0 || no_result
+
+ucsdpsys_disk -t -f disk.image -p big.text
+test $? -eq 0 || fail
+
+#
+# The on-disk form must be exactly what encoding the whole file at
+# once would have produced.
+#
+ucsdpsys_text -e < big.text > expected.raw
+test $? -eq 0 || no_result
+
+ucsdpsys_disk -B -f disk.image -g test.out.raw=big.text
+test $? -eq 0 || fail
+
+cmp expected.raw test.out.raw
+test $? -eq 0 || fail
+
+#
+# and it must survive the round trip
+#
+ucsdpsys_text -d -t < test.out.raw > test.out
+test $? -eq 0 || no_result
+
+diff big.text test.out
+test $? -eq 0 || fail
+
+#
+# The functionality exercised by this test worked.
+# No other assertions are made.
+#
+pass
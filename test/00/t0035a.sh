@@ -0,0 +1,67 @@
+#!/bin/sh
+#
+# UCSD p-System filesystem in user space
+# Copyright (C) 2026 Peter Miller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or (at
+# you option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program. If not, see <http://www.gnu.org/licenses/>
+#
+
+
+TEST_SUBJECT="text file reads via page index"
+. test_prelude
+
+#
+# Create a disk image
+#
+ucsdpsys_mkfs disk.image
+test $? -eq 0 || fail
+
+#
+# Build a text file with many pages, and put its encoded form onto the
+# volume without any translation.
+#
+i=0
+: > test.in
+while [ $i -lt 1000 ]
+do
+    echo "line $i" >> test.in
+    echo "                          indented $i" >> test.in
+    echo "a	b" >> test.in
+    i=`expr $i + 1`
+done
+test $? -eq 0 || no_result
+
+ucsdpsys_text -e < test.in > big.text
+test $? -eq 0 || no_result
+
+ucsdpsys_disk -B -f disk.image -p big.text
+test $? -eq 0 || fail
+
+ucsdpsys_text -d < big.text > expected
+test $? -eq 0 || no_result
+
+#
+# Files already on the volume are translated, too.
+#
+ucsdpsys_disk -t -f disk.image -g test.out=big.text
+test $? -eq 0 || fail
+
+cmp expected test.out
+test $? -eq 0 || fail
+
+#
+# The functionality exercised by this test worked.
+# No other assertions are made.
+#
+pass
@@ -0,0 +1,60 @@
+#!/bin/sh
+#
+# UCSD p-System filesystem in user space
+# Copyright (C) 2026 Peter Miller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or (at
+# you option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program. If not, see <http://www.gnu.org/licenses/>
+#
+
+
+TEST_SUBJECT="ucsdpsys_text --jobs"
+. test_prelude
+
+#
+# Build a text file large enough to be split between several threads.
+#
+i=0
+: > test.in
+while [ $i -lt 3000 ]
+do
+    echo "line $i" >> test.in
+    echo "                          indented $i" >> test.in
+    echo "        a	b" >> test.in
+    i=`expr $i + 1`
+done
+test $? -eq 0 || no_result
+
+ucsdpsys_text -e < test.in > test.ucsd
+test $? -eq 0 || no_result
+
+ucsdpsys_text -d < test.ucsd > expected
+test $? -eq 0 || fail
+
+#
+# The output must not depend on the number of threads.
+#
+for jobs in 0 2 3 8
+do
+    ucsdpsys_text -d -j $jobs < test.ucsd > test.out
+    test $? -eq 0 || fail
+
+    cmp expected test.out
+    test $? -eq 0 || fail
+done
+
+#
+# The functionality exercised by this test worked.
+# No other assertions are made.
+#
+pass
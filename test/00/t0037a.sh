@@ -0,0 +1,95 @@
+#!/bin/sh
+#
+# UCSD p-System filesystem in user space
+# Copyright (C) 2026 Peter Miller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or (at
+# you option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program. If not, see <http://www.gnu.org/licenses/>
+#
+
+
+TEST_SUBJECT="ucsdpsys_disk --batch"
+. test_prelude
+
+#
+# Build several disk images, each with one file, and one file which is
+# not a disk image at all.
+#
+: > test.list
+for n in 1 2 3 4 5 6
+do
+    ucsdpsys_mkfs -B 200 --label=vol$n test$n.vol
+    test $? -eq 0 || no_result
+    echo "hello $n" > file$n.text
+    test $? -eq 0 || no_result
+    ucsdpsys_disk -f test$n.vol -p file$n.text
+    test $? -eq 0 || no_result
+    echo test$n.vol >> test.list
+    if [ $n -eq 3 ]
+    then
+        echo "not a disk image" > junk.vol
+        echo junk.vol >> test.list
+    fi
+done
+
+#
+# The listings must come out in order, whatever the number of threads,
+# and the bad disk image must not stop the others.
+#
+: > expected
+for n in 1 2 3 4 5 6
+do
+    ucsdpsys_disk -f test$n.vol -l >> expected
+    test $? -eq 0 || no_result
+done
+
+for jobs in 1 3 8
+do
+    ucsdpsys_disk --batch=test.list -j $jobs -l --summary=test.sum > test.out
+    test $? -eq 1 || fail
+
+    cmp expected test.out
+    test $? -eq 0 || fail
+
+    grep -c '"status": "ok"' test.sum > test.count
+    test $? -eq 0 || fail
+    echo 6 | cmp - test.count
+    test $? -eq 0 || fail
+
+    grep '"image": "junk.vol", "status": "failed"' test.sum > /dev/null
+    test $? -eq 0 || fail
+done
+
+#
+# Get all of the files of the good disk images.
+#
+grep -v junk test.list > test.good
+test $? -eq 0 || no_result
+
+mkdir out
+test $? -eq 0 || no_result
+
+ucsdpsys_disk --batch=test.good -j 4 -g out --summary=test.sum
+test $? -eq 0 || fail
+
+for n in 1 2 3 4 5 6
+do
+    cmp file$n.text out/test$n.vol/file$n.text
+    test $? -eq 0 || fail
+done
+
+#
+# The functionality exercised by this test worked.
+# No other assertions are made.
+#
+pass
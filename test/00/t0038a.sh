@@ -0,0 +1,110 @@
+#!/bin/sh
+#
+# UCSD p-System filesystem in user space
+# Copyright (C) 2026 Peter Miller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or (at
+# you option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program. If not, see <http://www.gnu.org/licenses/>
+#
+
+
+TEST_SUBJECT="ucsdpsys_disk --tar"
+. test_prelude
+
+tar --version > /dev/null 2>&1 || no_result
+
+#
+# Build a disk image with some text files and a binary file.
+#
+ucsdpsys_mkfs -B 200 --label=tar test.vol
+test $? -eq 0 || no_result
+
+mkdir in
+test $? -eq 0 || no_result
+cat > in/hello.text << 'fubar'
+program hello;
+begin
+  writeln('Hello, World!')
+end.
+fubar
+test $? -eq 0 || no_result
+awk 'BEGIN { for (j = 0; j < 400; ++j) print "line", j }' /dev/null \
+    > in/long.text
+test $? -eq 0 || no_result
+awk 'BEGIN { for (j = 0; j < 1300; ++j) printf("%c", j % 256) }' /dev/null \
+    > in/data.code
+test $? -eq 0 || no_result
+
+ucsdpsys_disk -f test.vol -p in
+test $? -eq 0 || no_result
+
+#
+# The archive must hold exactly what --get would have written to a
+# directory, files, times and all.
+#
+mkdir dir
+test $? -eq 0 || no_result
+ucsdpsys_disk -f test.vol -g dir
+test $? -eq 0 || no_result
+
+ucsdpsys_disk -f test.vol --tar=test.tar
+test $? -eq 0 || fail
+
+mkdir x
+test $? -eq 0 || no_result
+tar -x -f test.tar -C x
+test $? -eq 0 || fail
+
+diff -r dir x
+test $? -eq 0 || fail
+
+ls -l dir | awk '{ print $6, $7, $8, $9 }' > test.dir
+test $? -eq 0 || no_result
+ls -l x | awk '{ print $6, $7, $8, $9 }' > test.x
+test $? -eq 0 || no_result
+diff test.dir test.x
+test $? -eq 0 || fail
+
+#
+# The files are in the order they appear on the disk.
+#
+cat > test.ok << 'fubar'
+data.code
+hello.text
+long.text
+fubar
+test $? -eq 0 || no_result
+tar -t -f test.tar > test.out
+test $? -eq 0 || fail
+diff test.ok test.out
+test $? -eq 0 || fail
+
+#
+# The archive may also be written to the standard output.
+#
+ucsdpsys_disk -f test.vol --tar=- > test2.tar
+test $? -eq 0 || fail
+cmp test.tar test2.tar
+test $? -eq 0 || fail
+
+#
+# Nothing else may be done at the same time.
+#
+ucsdpsys_disk -f test.vol --tar=test3.tar -p in/hello.text > /dev/null 2>&1
+test $? -ne 0 || fail
+
+#
+# The functionality exercised by this test worked.
+# No other assertions are made.
+#
+pass
@@ -0,0 +1,137 @@
+#!/bin/sh
+#
+# UCSD p-System filesystem in user space
+# Copyright (C) 2026 Peter Miller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or (at
+# you option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program. If not, see <http://www.gnu.org/licenses/>
+#
+
+
+TEST_SUBJECT="ucsdpsys_disk --put-tar"
+. test_prelude
+
+tar --version > /dev/null 2>&1 || no_result
+
+#
+# Some text files, and some binary files.
+#
+mkdir in
+test $? -eq 0 || no_result
+for n in 1 2 3 4 5
+do
+    awk "BEGIN { for (j = 0; j < $n * 97; ++j) print \"line\", j }" \
+        /dev/null > in/file$n.text
+    test $? -eq 0 || no_result
+    awk "BEGIN { for (j = 0; j < $n * 611; ++j) printf(\"%c\", j % 256) }" \
+        /dev/null > in/file$n.code
+    test $? -eq 0 || no_result
+done
+
+(cd in && tar -c -f ../test.tar .)
+test $? -eq 0 || no_result
+
+#
+# Put a whole directory; everything must come back out the same.
+#
+ucsdpsys_mkfs -B 200 --label=dir dir.vol
+test $? -eq 0 || no_result
+ucsdpsys_disk -f dir.vol -p in
+test $? -eq 0 || fail
+ucsdpsys_fsck dir.vol
+test $? -eq 0 || fail
+mkdir out1
+test $? -eq 0 || no_result
+ucsdpsys_disk -f dir.vol -g out1
+test $? -eq 0 || fail
+diff -r in out1
+test $? -eq 0 || fail
+
+#
+# Put a tar archive; the same again, from a file and from a pipe.
+#
+ucsdpsys_mkfs -B 200 --label=tar tar.vol
+test $? -eq 0 || no_result
+ucsdpsys_disk -f tar.vol --put-tar=test.tar
+test $? -eq 0 || fail
+ucsdpsys_fsck tar.vol
+test $? -eq 0 || fail
+mkdir out2
+test $? -eq 0 || no_result
+ucsdpsys_disk -f tar.vol -g out2
+test $? -eq 0 || fail
+diff -r in out2
+test $? -eq 0 || fail
+
+ucsdpsys_mkfs -B 200 --label=tar pipe.vol
+test $? -eq 0 || no_result
+ucsdpsys_disk -f pipe.vol -p --tar=- < test.tar
+test $? -eq 0 || fail
+ucsdpsys_disk -f pipe.vol -l > pipe.list
+test $? -eq 0 || fail
+ucsdpsys_disk -f tar.vol -l > tar.list
+test $? -eq 0 || fail
+diff tar.list pipe.list
+test $? -eq 0 || fail
+
+#
+# Putting the files again replaces them, rather than adding to them.
+#
+ucsdpsys_disk -f tar.vol --put-tar=test.tar
+test $? -eq 0 || fail
+ucsdpsys_fsck tar.vol
+test $? -eq 0 || fail
+ucsdpsys_disk -f tar.vol -l > tar.list2
+test $? -eq 0 || fail
+diff tar.list tar.list2
+test $? -eq 0 || fail
+
+#
+# Free space in the middle of the volume is used, too.
+#
+ucsdpsys_disk -f tar.vol -r FILE1.TEXT
+test $? -eq 0 || fail
+ucsdpsys_disk -f tar.vol -r FILE3.CODE
+test $? -eq 0 || fail
+ucsdpsys_disk -f tar.vol -p in/file1.text in/file3.code
+test $? -eq 0 || fail
+ucsdpsys_fsck tar.vol
+test $? -eq 0 || fail
+mkdir out3
+test $? -eq 0 || no_result
+ucsdpsys_disk -f tar.vol -g out3
+test $? -eq 0 || fail
+diff -r in out3
+test $? -eq 0 || fail
+
+#
+# A pax extended header record too short to hold its own length, a
+# space and a newline, is an error, not a crash.
+#
+(cd in && tar -c -f ../pax.tar --format=pax --pax-option='comment:=hello' \
+    file1.text)
+test $? -eq 0 || no_result
+printf '1  ' | dd of=pax.tar bs=1 seek=512 conv=notrunc 2> /dev/null
+test $? -eq 0 || no_result
+ucsdpsys_mkfs -B 200 --label=pax pax.vol
+test $? -eq 0 || no_result
+ucsdpsys_disk -f pax.vol --put-tar=pax.tar 2> test.err
+test $? -eq 1 || fail
+grep 'pax header malformed' test.err > /dev/null
+test $? -eq 0 || fail
+
+#
+# The functionality exercised by this test worked.
+# No other assertions are made.
+#
+pass
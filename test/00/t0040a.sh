@@ -0,0 +1,81 @@
+#!/bin/sh
+#
+# UCSD p-System filesystem in user space
+# Copyright (C) 2026 Peter Miller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or (at
+# you option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program. If not, see <http://www.gnu.org/licenses/>
+#
+
+
+
+TEST_SUBJECT="ucsdpsys_disk batched directory writes"
+. test_prelude
+
+mkdir in
+test $? -eq 0 || no_result
+for n in 1 2 3 4 5 6 7 8
+do
+    awk "BEGIN { for (j = 0; j < $n * 300; ++j) printf(\"%c\", j % 256) }" \
+        /dev/null > in/file$n.code
+    test $? -eq 0 || no_result
+done
+
+ucsdpsys_mkfs -B 200 --label=batch test.vol
+test $? -eq 0 || no_result
+ucsdpsys_disk -f test.vol -p in
+test $? -eq 0 || no_result
+cp test.vol before.vol
+test $? -eq 0 || no_result
+
+#
+# If any of the files can't be removed, none of them are.
+#
+ucsdpsys_disk -f test.vol -r FILE2.CODE FILE4.CODE NOSUCH.CODE > log 2>&1
+test $? -ne 0 || fail
+cmp before.vol test.vol
+test $? -eq 0 || fail
+
+#
+# Otherwise, they are all removed, and the volume can be crunched at
+# the same time.
+#
+ucsdpsys_disk -f test.vol -r FILE2.CODE FILE4.CODE FILE6.CODE
+test $? -eq 0 || fail
+ucsdpsys_fsck test.vol
+test $? -eq 0 || fail
+ucsdpsys_disk -f test.vol -l | grep FILE > test.out
+test $? -eq 0 || fail
+for n in 2 4 6
+do
+    grep -q FILE$n test.out && fail
+done
+
+ucsdpsys_disk -f before.vol -r FILE2.CODE FILE4.CODE FILE6.CODE --crunch
+test $? -eq 0 || fail
+ucsdpsys_fsck before.vol
+test $? -eq 0 || fail
+mkdir out
+test $? -eq 0 || no_result
+ucsdpsys_disk -f before.vol -g out
+test $? -eq 0 || fail
+rm in/file2.code in/file4.code in/file6.code
+test $? -eq 0 || no_result
+diff -r in out
+test $? -eq 0 || fail
+
+#
+# The functionality exercised by this test worked.
+# No other assertions are made.
+#
+pass
@@ -0,0 +1,100 @@
+#!/bin/sh
+#
+# UCSD p-System filesystem in user space
+# Copyright (C) 2026 Peter Miller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or (at
+# you option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program. If not, see <http://www.gnu.org/licenses/>
+#
+
+
+
+TEST_SUBJECT="ucsdpsys_fsck --corpus"
+. test_prelude
+
+mkdir -p corpus/sub
+test $? -eq 0 || no_result
+ucsdpsys_mkfs -B 200 --label=one corpus/one.vol
+test $? -eq 0 || no_result
+ucsdpsys_mkfs -B 100 --label=two corpus/sub/two.vol
+test $? -eq 0 || no_result
+ucsdpsys_mkfs -B 100 --label=bad corpus/sub/bad.vol
+test $? -eq 0 || no_result
+echo hello > hello.text
+test $? -eq 0 || no_result
+ucsdpsys_disk -f corpus/sub/bad.vol -p hello.text
+test $? -eq 0 || no_result
+
+#
+# Set reserved bits in the first file's last byte field.
+#
+printf '\202' | dd of=corpus/sub/bad.vol bs=1 seek=1073 conv=notrunc \
+    2> /dev/null
+test $? -eq 0 || no_result
+
+#
+# Every image gets a line, in order, whether or not it is clean.
+#
+ucsdpsys_fsck --corpus -j 2 --cache=test.cache corpus > test.out
+test $? -eq 1 || fail
+grep -c '"image"' test.out > count
+test $? -eq 0 || fail
+echo 3 | diff - count
+test $? -eq 0 || fail
+sed -n 1p test.out | grep '"image": "corpus/one.vol", "status": "ok"' \
+    > /dev/null
+test $? -eq 0 || fail
+sed -n 1p test.out | grep '"volume": "ONE", "interleave": "none"' > /dev/null
+test $? -eq 0 || fail
+sed -n 2p test.out | grep '"image": "corpus/sub/bad.vol", "status": "failed"' \
+    > /dev/null
+test $? -eq 0 || fail
+sed -n 2p test.out | grep '"entry": 1,' > /dev/null
+test $? -eq 0 || fail
+grep -c '"cached": false' test.out > count
+test $? -eq 0 || fail
+echo 3 | diff - count
+test $? -eq 0 || fail
+
+#
+# The second time, the clean images come from the cache, and the bad
+# one is checked again.
+#
+ucsdpsys_fsck --corpus --cache=test.cache corpus > test.out
+test $? -eq 1 || fail
+grep -c '"cached": true' test.out > count
+test $? -eq 0 || fail
+echo 2 | diff - count
+test $? -eq 0 || fail
+sed -n 2p test.out | grep '"cached": false' > /dev/null
+test $? -eq 0 || fail
+
+#
+# A changed image is checked again.
+#
+rm corpus/sub/bad.vol
+test $? -eq 0 || no_result
+ucsdpsys_disk -f corpus/one.vol -p hello.text
+test $? -eq 0 || no_result
+ucsdpsys_fsck --corpus --cache=test.cache corpus > test.out
+test $? -eq 0 || fail
+sed -n 1p test.out | grep '"cached": false' > /dev/null
+test $? -eq 0 || fail
+sed -n 2p test.out | grep '"cached": true' > /dev/null
+test $? -eq 0 || fail
+
+#
+# The functionality exercised by this test worked.
+# No other assertions are made.
+#
+pass
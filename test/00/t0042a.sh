@@ -0,0 +1,105 @@
+#!/bin/sh
+#
+# UCSD p-System filesystem in user space
+# Copyright (C) 2026 Peter Miller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or (at
+# you option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program. If not, see <http://www.gnu.org/licenses/>
+#
+
+
+
+TEST_SUBJECT="ucsdpsys_fsck --deep"
+. test_prelude
+
+awk 'BEGIN { for (j = 0; j < 500; ++j) printf("%*sline %d\n", j % 9, "", j) }' \
+    /dev/null > a.text
+test $? -eq 0 || no_result
+
+#
+# A code file whose only segment is longer than the file.
+#
+printf '\001\000\320\007' > bad.code
+test $? -eq 0 || no_result
+dd if=/dev/zero bs=1 count=60 >> bad.code 2> /dev/null
+test $? -eq 0 || no_result
+printf 'MAIN    ' >> bad.code
+test $? -eq 0 || no_result
+dd if=/dev/zero bs=1 count=952 >> bad.code 2> /dev/null
+test $? -eq 0 || no_result
+
+ucsdpsys_mkfs -B 200 --label=deep test.vol
+test $? -eq 0 || no_result
+ucsdpsys_disk -f test.vol -p a.text
+test $? -eq 0 || no_result
+
+ucsdpsys_fsck --deep test.vol > test.out 2>&1
+test $? -eq 0 || fail
+diff /dev/null test.out
+test $? -eq 0 || fail
+
+#
+# The text file starts at block 6, after its 1KB header come the pages.
+# Break the first page with a DLE that has no indent, and the second
+# page with a NUL in the middle of a line.
+#
+printf '\020\001' | dd of=test.vol bs=1 seek=4096 conv=notrunc 2> /dev/null
+test $? -eq 0 || no_result
+printf '\000' | dd of=test.vol bs=1 seek=5220 conv=notrunc 2> /dev/null
+test $? -eq 0 || no_result
+ucsdpsys_disk -f test.vol -p bad.code
+test $? -eq 0 || no_result
+
+ucsdpsys_fsck --deep -j 2 test.vol > test.out 2>&1
+test $? -eq 0 || fail
+grep '"A.TEXT": page 1, offset 1: DLE without indent' test.out > /dev/null
+test $? -eq 0 || fail
+grep '"A.TEXT": page 2, offset 100: last line not terminated' test.out \
+    > /dev/null
+test $? -eq 0 || fail
+grep '"BAD.CODE": segment 0 "MAIN": code' test.out > /dev/null
+test $? -eq 0 || fail
+grep 'found 3 format errors' test.out > /dev/null
+test $? -eq 0 || fail
+
+#
+# Without --deep, the contents are not looked at.
+#
+ucsdpsys_fsck test.vol
+test $? -eq 0 || fail
+
+ucsdpsys_fsck --corpus --deep test.vol > test.out
+test $? -eq 1 || fail
+grep '"code": 1, "text": 2}' test.out > /dev/null
+test $? -eq 0 || fail
+
+#
+# A text file of two blocks, whose last block is short, holds less
+# than a text header.  The check must not read past the end of it.
+#
+dd if=/dev/zero bs=1 count=600 2> /dev/null | tr '\000' 'x' > short.text
+test $? -eq 0 || no_result
+ucsdpsys_mkfs -B 200 --label=short short.vol
+test $? -eq 0 || no_result
+ucsdpsys_disk -f short.vol -B -p short.text
+test $? -eq 0 || no_result
+ucsdpsys_fsck --deep short.vol > test.out 2>&1
+test $? -eq 0 || fail
+grep '"SHORT.TEXT": too short for a text header' test.out > /dev/null
+test $? -eq 0 || fail
+
+#
+# The functionality exercised by this test worked.
+# No other assertions are made.
+#
+pass
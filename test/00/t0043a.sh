@@ -0,0 +1,101 @@
+#!/bin/sh
+#
+# UCSD p-System filesystem in user space
+# Copyright (C) 2026 Peter Miller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or (at
+# you option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program. If not, see <http://www.gnu.org/licenses/>
+#
+
+
+
+TEST_SUBJECT="ucsdpsys_dedup"
+. test_prelude
+
+ucsdpsys_mkfs -B 200 --label=one one.vol
+test $? -eq 0 || no_result
+echo hello > hello.text
+test $? -eq 0 || no_result
+ucsdpsys_disk -f one.vol -p hello.text
+test $? -eq 0 || no_result
+cp one.vol two.vol
+test $? -eq 0 || no_result
+echo goodbye > goodbye.text
+test $? -eq 0 || no_result
+ucsdpsys_disk -f two.vol -p goodbye.text
+test $? -eq 0 || no_result
+
+# A plain file whose size is not a whole number of chunks.
+printf 'odd' >> two.vol
+test $? -eq 0 || no_result
+
+mkdir images
+test $? -eq 0 || no_result
+ucsdpsys_dedup --store=store --import one.vol images/one.ddp
+test $? -eq 0 || fail
+ucsdpsys_dedup --store=store --import two.vol images/two.ddp
+test $? -eq 0 || fail
+
+#
+# The two images have almost all of their chunks in common, and the
+# unused blocks are all the same chunk.
+#
+size=`wc -c < store/chunks`
+test $size -le 4096 || fail
+
+#
+# The images read back exactly as they were imported.
+#
+ucsdpsys_dedup --export images/one.ddp one.out
+test $? -eq 0 || fail
+cmp one.vol one.out
+test $? -eq 0 || fail
+ucsdpsys_dedup --export images/two.ddp two.out
+test $? -eq 0 || fail
+cmp two.vol two.out
+test $? -eq 0 || fail
+
+#
+# The manifest refers to the store relative to itself, so they may be
+# moved together.
+#
+mkdir moved && mv images store moved
+test $? -eq 0 || no_result
+ucsdpsys_dedup --export moved/images/one.ddp one.out
+test $? -eq 0 || fail
+cmp one.vol one.out
+test $? -eq 0 || fail
+
+#
+# The other tools read the manifest as if it were the image.
+#
+ucsdpsys_disk -f moved/images/two.ddp -l > test.out
+test $? -eq 0 || fail
+grep GOODBYE.TEXT test.out > /dev/null
+test $? -eq 0 || fail
+ucsdpsys_fsck moved/images/two.ddp
+test $? -eq 0 || fail
+ucsdpsys_disk -f moved/images/two.ddp -g hello.out=HELLO.TEXT
+test $? -eq 0 || fail
+cmp hello.text hello.out
+test $? -eq 0 || fail
+
+# ...but they can't change it.
+ucsdpsys_disk -f moved/images/two.ddp -r HELLO.TEXT > /dev/null 2>&1
+test $? -ne 0 || fail
+
+#
+# The functionality exercised by this test worked.
+# No other assertions are made.
+#
+pass
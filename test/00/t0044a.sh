@@ -0,0 +1,94 @@
+#!/bin/sh
+#
+# UCSD p-System filesystem in user space
+# Copyright (C) 2026 Peter Miller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or (at
+# you option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program. If not, see <http://www.gnu.org/licenses/>
+#
+
+
+
+TEST_SUBJECT="ucsdpsys_interleave --chunked"
+. test_prelude
+
+ucsdpsys_mkfs -B 400 --label=chunky test.vol
+test $? -eq 0 || no_result
+echo hello > hello.text
+test $? -eq 0 || no_result
+ucsdpsys_disk -f test.vol -p hello.text
+test $? -eq 0 || no_result
+
+#
+# Convert to the chunked format, and back again.
+#
+ucsdpsys_interleave --chunked -d -T none test.vol test.chk
+test $? -eq 0 || fail
+size=`wc -c < test.chk`
+test $size -lt 4096 || fail
+ucsdpsys_interleave -d -T none test.chk test.out
+test $? -eq 0 || fail
+cmp test.vol test.out
+test $? -eq 0 || fail
+
+#
+# The other tools read the chunked image directly...
+#
+ucsdpsys_fsck test.chk
+test $? -eq 0 || fail
+ucsdpsys_disk -f test.chk -l > test.out
+test $? -eq 0 || fail
+grep HELLO.TEXT test.out > /dev/null
+test $? -eq 0 || fail
+
+#
+# ...but they can't change it.
+#
+echo goodbye > goodbye.text
+test $? -eq 0 || no_result
+cp test.chk test.chk.orig
+test $? -eq 0 || no_result
+ucsdpsys_disk -f test.chk -p goodbye.text > test.out 2>&1
+test $? -eq 1 || fail
+grep 'read-only' test.out > /dev/null
+test $? -eq 0 || fail
+cmp test.chk test.chk.orig
+test $? -eq 0 || fail
+
+#
+# Writing a new chunked image over an old one keeps the old one's mode.
+#
+chmod 600 test.chk
+test $? -eq 0 || no_result
+ucsdpsys_interleave --chunked -d -T none test.vol test.chk
+test $? -eq 0 || fail
+ls -l test.chk | grep '^-rw-------' > /dev/null
+test $? -eq 0 || fail
+
+#
+# Encoding with an interleave works, too.
+#
+ucsdpsys_interleave --chunked -e -T apple test.vol apple.chk
+test $? -eq 0 || fail
+ucsdpsys_interleave -e -T apple test.vol apple.vol
+test $? -eq 0 || no_result
+ucsdpsys_interleave -d -T none apple.chk test.out
+test $? -eq 0 || fail
+cmp apple.vol test.out
+test $? -eq 0 || fail
+
+#
+# The functionality exercised by this test worked.
+# No other assertions are made.
+#
+pass
@@ -0,0 +1,115 @@
+#!/bin/sh
+#
+# UCSD p-System filesystem in user space
+# Copyright (C) 2026 Peter Miller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or (at
+# you option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program. If not, see <http://www.gnu.org/licenses/>
+#
+
+
+
+TEST_SUBJECT="ucsdpsys_catalog"
+. test_prelude
+
+mkdir -p corpus/sub
+test $? -eq 0 || no_result
+ucsdpsys_mkfs -B 200 --label=one corpus/one.vol
+test $? -eq 0 || no_result
+ucsdpsys_mkfs -B 100 --label=two corpus/sub/two.vol
+test $? -eq 0 || no_result
+echo hello > hello.text
+test $? -eq 0 || no_result
+echo fake > compiler.code
+test $? -eq 0 || no_result
+ucsdpsys_disk -f corpus/one.vol -p hello.text -p compiler.code
+test $? -eq 0 || no_result
+ucsdpsys_disk -f corpus/sub/two.vol -p hello.text
+test $? -eq 0 || no_result
+echo not an image > corpus/junk
+test $? -eq 0 || no_result
+
+ucsdpsys_catalog --index=test.idx --update -j 2 corpus 2> test.err
+test $? -eq 0 || fail
+grep 'corpus/junk: warning' test.err > /dev/null
+test $? -eq 0 || fail
+
+#
+# Queries are answered from the index alone.
+#
+mv corpus hidden
+test $? -eq 0 || no_result
+ucsdpsys_catalog --index=test.idx --name='hello.*' > test.out
+test $? -eq 0 || fail
+grep -c HELLO.TEXT test.out > count
+test $? -eq 0 || fail
+echo 2 | diff - count
+test $? -eq 0 || fail
+hash1=`sed -n 1p test.out | cut -f 8`
+hash2=`sed -n 2p test.out | cut -f 8`
+test "$hash1" = "$hash2" || fail
+
+ucsdpsys_catalog --index=test.idx --kind=code > test.out
+test $? -eq 0 || fail
+cut -f 1-4 test.out > test.got
+printf 'corpus/one.vol\tONE:COMPILER.CODE\tcodefile\t5\n' > test.ok
+diff test.ok test.got
+test $? -eq 0 || fail
+
+year=`date +%Y`
+ucsdpsys_catalog --index=test.idx --since=$year --until=$year \
+    --kind=text > test.out
+test $? -eq 0 || fail
+grep -c HELLO.TEXT test.out > count
+test $? -eq 0 || fail
+echo 2 | diff - count
+test $? -eq 0 || fail
+ucsdpsys_catalog --index=test.idx --until=1979 > test.out
+test $? -eq 1 || fail
+
+#
+# Only the images which have changed are scanned again.
+#
+mv hidden corpus
+test $? -eq 0 || no_result
+echo goodbye > goodbye.text
+test $? -eq 0 || no_result
+ucsdpsys_disk -f corpus/sub/two.vol -p goodbye.text
+test $? -eq 0 || no_result
+ucsdpsys_catalog -D --index=test.idx --update corpus > test.out 2>&1
+test $? -eq 0 || fail
+grep 'scan corpus/sub/two.vol' test.out > /dev/null
+test $? -eq 0 || fail
+grep 'scan corpus/one.vol' test.out > /dev/null
+test $? -ne 0 || fail
+ucsdpsys_catalog --index=test.idx --name=GOODBYE.TEXT > test.out
+test $? -eq 0 || fail
+cut -f 1 test.out > test.got
+echo corpus/sub/two.vol | diff - test.got
+test $? -eq 0 || fail
+
+#
+# Images which have gone are dropped from the index.
+#
+rm corpus/sub/two.vol
+test $? -eq 0 || no_result
+ucsdpsys_catalog --index=test.idx --update corpus 2> /dev/null
+test $? -eq 0 || fail
+ucsdpsys_catalog --index=test.idx --name=GOODBYE.TEXT > test.out
+test $? -eq 1 || fail
+
+#
+# The functionality exercised by this test worked.
+# No other assertions are made.
+#
+pass
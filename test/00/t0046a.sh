@@ -0,0 +1,100 @@
+#!/bin/sh
+#
+# UCSD p-System filesystem in user space
+# Copyright (C) 2026 Peter Miller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or (at
+# you option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program. If not, see <http://www.gnu.org/licenses/>
+#
+
+TEST_SUBJECT="free space counters"
+. test_prelude
+
+for n in 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20
+do
+    echo "The quick brown fox jumps over the lazy dog, line $n."
+done > a.text
+test $? -eq 0 || no_result
+cat a.text a.text a.text a.text > b.text
+test $? -eq 0 || no_result
+cat b.text b.text b.text b.text b.text b.text > c.text
+test $? -eq 0 || no_result
+
+ucsdpsys_mkfs -L fred fred.vol
+test $? -eq 0 || no_result
+
+#
+# The counters are updated incrementally as each action is performed,
+# so the footer printed in the same process as the change must agree
+# both with the expected values, and with the footer printed by a fresh
+# process, which counts the blocks from scratch.
+#
+check()
+{
+    grep blocks test.out > test.inc
+    test $? -eq 0 || fail
+    diff ok test.inc
+    test $? -eq 0 || fail
+    ucsdpsys_disk -f fred.vol -ll > test.out
+    test $? -eq 0 || fail
+    grep blocks test.out > test.fresh
+    test $? -eq 0 || fail
+    diff ok test.fresh
+    test $? -eq 0 || fail
+}
+
+cat > ok << 'fubar'
+78 of 280 blocks, 72.1% free
+largest free extent: 202 blocks
+fubar
+test $? -eq 0 || no_result
+ucsdpsys_disk -f fred.vol -p a.text b.text c.text -ll > test.out
+test $? -eq 0 || fail
+check
+
+# removing a file leaves a hole smaller than the space at the end
+cat > ok << 'fubar'
+66 of 280 blocks, 76.4% free
+largest free extent: 202 blocks
+fubar
+test $? -eq 0 || no_result
+ucsdpsys_disk -f fred.vol -r b.text -ll > test.out
+test $? -eq 0 || fail
+check
+
+# crunching moves the hole to the end
+cat > ok << 'fubar'
+66 of 280 blocks, 76.4% free
+largest free extent: 214 blocks
+fubar
+test $? -eq 0 || no_result
+ucsdpsys_disk -f fred.vol -k -ll > test.out
+test $? -eq 0 || fail
+check
+
+# putting a file takes from the free space at the end
+cat > ok << 'fubar'
+78 of 280 blocks, 72.1% free
+largest free extent: 202 blocks
+fubar
+test $? -eq 0 || no_result
+ucsdpsys_disk -f fred.vol -p b.text -ll > test.out
+test $? -eq 0 || fail
+check
+
+#
+# The functionality exercised by this test worked.
+# No other assertions are made.
+#
+pass
+# vim: set ts=8 sw=4 et :
@@ -0,0 +1,76 @@
+#!/bin/sh
+#
+# UCSD p-System filesystem in user space
+# Copyright (C) 2026 Peter Miller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or (at
+# you option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program. If not, see <http://www.gnu.org/licenses/>
+#
+
+TEST_SUBJECT="ucsdpsys_disk --copy"
+. test_prelude
+
+for n in 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20
+do
+    echo "The quick brown fox jumps over the lazy dog, line $n."
+done > a.text
+test $? -eq 0 || no_result
+cat a.text a.text a.text a.text > b.text
+test $? -eq 0 || no_result
+cat b.text b.text b.text > c.data
+test $? -eq 0 || no_result
+
+ucsdpsys_mkfs -L fred fred.vol
+test $? -eq 0 || no_result
+ucsdpsys_disk -f fred.vol -p a.text b.text c.data
+test $? -eq 0 || no_result
+
+# copy to a new file, and over the top of an existing file
+ucsdpsys_disk -f fred.vol --copy d.data=c.data a.text=b.text
+test $? -eq 0 || fail
+ucsdpsys_fsck fred.vol
+test $? -eq 0 || fail
+
+mkdir out
+test $? -eq 0 || no_result
+ucsdpsys_disk -f fred.vol -g out/a.text=a.text out/d.data=d.data
+test $? -eq 0 || fail
+cmp b.text out/a.text
+test $? -eq 0 || fail
+cmp c.data out/d.data
+test $? -eq 0 || fail
+
+# the same, with text files translated on the fly
+ucsdpsys_disk -f fred.vol -t --copy e.text=b.text
+test $? -eq 0 || fail
+ucsdpsys_disk -f fred.vol -g out/e.text=e.text
+test $? -eq 0 || fail
+cmp b.text out/e.text
+test $? -eq 0 || fail
+
+# copying a file which does not exist changes nothing
+ucsdpsys_disk -f fred.vol -l > before.out
+test $? -eq 0 || no_result
+ucsdpsys_disk -f fred.vol -C f.data=nosuch.data 2> test.err
+test $? -ne 0 || fail
+ucsdpsys_disk -f fred.vol -l > after.out
+test $? -eq 0 || no_result
+diff before.out after.out
+test $? -eq 0 || fail
+
+#
+# The functionality exercised by this test worked.
+# No other assertions are made.
+#
+pass
+# vim: set ts=8 sw=4 et :
@@ -0,0 +1,73 @@
+#!/bin/sh
+#
+# UCSD p-System filesystem in user space
+# Copyright (C) 2026 Peter Miller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or (at
+# you option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program. If not, see <http://www.gnu.org/licenses/>
+#
+
+TEST_SUBJECT="chunked image, deep check, many threads"
+. test_prelude
+
+ucsdpsys_mkfs -B 2000 --label=chunky test.vol
+test $? -eq 0 || no_result
+
+#
+# Many files, spread over more chunks than are kept decompressed, so
+# that the threads of the deep check all want chunks of the image at
+# the same time, and push each other's chunks out of the cache.
+#
+for n in 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20
+do
+    echo "The quick brown fox jumps over the lazy dog, line $n."
+done > a.text
+test $? -eq 0 || no_result
+names=
+for n in 01 02 03 04 05 06 07 08 09 10 11 12 13 14 15 16 17 18 19 20 \
+    21 22 23 24
+do
+    cat a.text a.text a.text a.text a.text a.text a.text a.text \
+        a.text a.text a.text a.text a.text a.text a.text a.text \
+        a.text a.text a.text a.text a.text a.text a.text a.text \
+        > f$n.text
+    test $? -eq 0 || no_result
+    echo "file $n" >> f$n.text
+    test $? -eq 0 || no_result
+    names="$names f$n.text"
+done
+ucsdpsys_disk -f test.vol -p $names
+test $? -eq 0 || no_result
+
+ucsdpsys_fsck --deep -j 8 test.vol > expected.out 2>&1
+test $? -eq 0 || no_result
+
+ucsdpsys_interleave --chunked -d -T none test.vol test.chk
+test $? -eq 0 || fail
+
+for n in 1 2 3 4 5
+do
+    ucsdpsys_fsck --deep -j 8 test.chk > test.out 2>&1
+    test $? -eq 0 || fail
+    sed 's|test.chk|test.vol|g' test.out > test.out2
+    test $? -eq 0 || no_result
+    diff expected.out test.out2
+    test $? -eq 0 || fail
+done
+
+#
+# The functionality exercised by this test worked.
+# No other assertions are made.
+#
+pass
+# vim: set ts=8 sw=4 et :
@@ -0,0 +1,98 @@
+#!/bin/sh
+#
+# UCSD p-System filesystem in user space
+# Copyright (C) 2026 Peter Miller
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or (at
+# you option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+# General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program. If not, see <http://www.gnu.org/licenses/>
+#
+
+
+
+TEST_SUBJECT="batch mode vs damaged images"
+. test_prelude
+
+#
+# Build a good disk image, and then a lot of copies of it damaged in
+# ways which make reading the directory a fatal error.  Half have a
+# nonsense file count in the volume label, half are cut short in the
+# middle of the directory.
+#
+mkdir corpus
+test $? -eq 0 || no_result
+ucsdpsys_mkfs -B 200 --label=good corpus/good.vol
+test $? -eq 0 || no_result
+echo hello > hello.text
+test $? -eq 0 || no_result
+ucsdpsys_disk -f corpus/good.vol -p hello.text
+test $? -eq 0 || no_result
+
+: > test.list
+n=10
+while [ $n -lt 50 ]
+do
+    cp corpus/good.vol corpus/bad$n.vol
+    test $? -eq 0 || no_result
+    if [ `expr $n % 2` -eq 0 ]
+    then
+        printf '\377\177' |
+        dd of=corpus/bad$n.vol bs=1 seek=1040 conv=notrunc 2> /dev/null
+        test $? -eq 0 || no_result
+    else
+        dd if=corpus/good.vol of=corpus/bad$n.vol bs=1 count=2600 \
+            2> /dev/null
+        test $? -eq 0 || no_result
+    fi
+    echo corpus/bad$n.vol >> test.list
+    n=`expr $n + 1`
+done
+echo corpus/good.vol >> test.list
+
+#
+# Every damaged image fails on its own, and the good one is still
+# listed, however many threads there are.
+#
+ucsdpsys_disk -f corpus/good.vol -l > expected
+test $? -eq 0 || no_result
+
+for jobs in 1 8
+do
+    ucsdpsys_disk --batch=test.list -j $jobs -l --summary=test.sum > test.out
+    test $? -eq 1 || fail
+
+    cmp expected test.out
+    test $? -eq 0 || fail
+
+    grep -c '"status": "failed"' test.sum > count
+    test $? -eq 0 || fail
+    echo 40 | cmp - count
+    test $? -eq 0 || fail
+
+    grep '"image": "corpus/good.vol", "status": "ok"' test.sum > /dev/null
+    test $? -eq 0 || fail
+done
+
+ucsdpsys_fsck --corpus -j 8 corpus > test.out
+test $? -eq 1 || fail
+grep -c '"status": "failed"' test.out > count
+test $? -eq 0 || fail
+echo 40 | cmp - count
+test $? -eq 0 || fail
+grep '"image": "corpus/good.vol", "status": "ok"' test.out > /dev/null
+test $? -eq 0 || fail
+
+#
+# The functionality exercised by this test worked.
+# No other assertions are made.
+#
+pass
@@ -0,0 +1,180 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <boost/scoped_ptr.hpp>
+#include <libexplain/output.h>
+#include <libexplain/program_name.h>
+
+#include <lib/directory.h>
+#include <lib/directory/journal.h>
+#include <lib/version.h>
+
+
+static void
+usage(void)
+{
+    const char *prog = explain_program_name_get();
+    fprintf(stderr, "Usage: %s [ <option>... ] <filename> <ucsd-name>\n",
+        prog);
+    fprintf(stderr, "       %s -V\n", prog);
+    exit(1);
+}
+
+
+static void
+check(int err, const char *filename, const char *what)
+{
+    if (err < 0)
+    {
+        explain_output_error_and_die
+        (
+            "%s: %s: %s",
+            filename,
+            what,
+            strerror(-err)
+        );
+    }
+}
+
+
+//
+// This program plants the journal record of an interrupted relocation,
+// as if a crunch had been killed part way through moving the named
+// file down to the end of the file before it.  The directory itself is
+// left untouched, so that the next read-write open (or fsck -f) has to
+// finish the move, or undo it.
+//
+int
+main(int argc, char **argv)
+{
+    explain_program_name_set(argv[0]);
+    explain_option_hanging_indent_set(4);
+    bool twin = false;
+    unsigned copy_blocks = 0;
+    for (;;)
+    {
+        int c = getopt(argc, argv, "p:tV");
+        if (c == EOF)
+            break;
+        switch (c)
+        {
+        case 'p':
+            copy_blocks = atoi(optarg);
+            break;
+
+        case 't':
+            twin = true;
+            break;
+
+        case 'V':
+            version_print();
+            return 0;
+
+        default:
+            usage();
+        }
+    }
+    if (optind + 2 != argc)
+        usage();
+    const char *filename = argv[optind];
+    rcstring name(argv[optind + 1]);
+
+    //
+    // Work out where the file is, and where a crunch would move it to.
+    //
+    unsigned from_block = 0;
+    unsigned to_block = (twin ? 10 : 6);
+    unsigned num_blocks = 0;
+    {
+        boost::scoped_ptr<directory> volume(directory::factory(filename));
+        directory_entry::pointer dep = volume->find(name);
+        if (!dep)
+        {
+            explain_output_error_and_die
+            (
+                "%s: file %s not found",
+                filename,
+                name.quote_c().c_str()
+            );
+        }
+        from_block = dep->get_first_block();
+        num_blocks = dep->size_in_blocks();
+        int n = 0;
+        for (;;)
+        {
+            directory_entry::pointer other = volume->nth(n);
+            if (!other)
+                break;
+            unsigned last = other->get_last_block();
+            if (last <= from_block && last > to_block)
+                to_block = last;
+        }
+    }
+    if (to_block == from_block)
+    {
+        explain_output_error_and_die
+        (
+            "%s: file %s has nowhere to move to",
+            filename,
+            name.quote_c().c_str()
+        );
+    }
+    if (copy_blocks > num_blocks)
+        copy_blocks = num_blocks;
+
+    //
+    // Record the intent, and copy the first few chunks, exactly as
+    // directory_journal::resume would, then stop without updating the
+    // directory.
+    //
+    sector_io::pointer deeper = sector_io::factory(filename, false);
+    directory_journal::pointer jp = directory_journal::factory(deeper, twin);
+    check(jp->begin(name, from_block, to_block, num_blocks), filename,
+        "journal begin");
+    unsigned chunk = from_block - to_block;
+    if (chunk > num_blocks)
+        chunk = num_blocks;
+    unsigned done = 0;
+    while (done < copy_blocks)
+    {
+        unsigned len = num_blocks - done;
+        if (len > chunk)
+            len = chunk;
+        check
+        (
+            deeper->relocate_bytes
+            (
+                (off_t)(to_block + done) << 9,
+                (off_t)(from_block + done) << 9,
+                (size_t)len << 9
+            ),
+            filename,
+            "relocate"
+        );
+        check(deeper->sync(), filename, "sync");
+        done += len;
+        check(jp->progress(done), filename, "journal progress");
+    }
+    printf("%u %u %u %u\n", from_block, to_block, num_blocks, done);
+    return 0;
+}
@@ -0,0 +1,257 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+#include <libexplain/output.h>
+#include <libexplain/program_name.h>
+
+#include <lib/text_scan.h>
+#include <lib/version.h>
+
+
+static void
+usage(void)
+{
+    const char *prog = explain_program_name_get();
+    fprintf(stderr, "Usage: %s [ -n <iterations> ]\n", prog);
+    fprintf(stderr, "       %s -b [ <megabytes> ]\n", prog);
+    fprintf(stderr, "       %s -V\n", prog);
+    exit(1);
+}
+
+
+//
+// The reference versions are the obvious byte-at-a-time loops, which
+// the vector kernels must agree with exactly.
+//
+static size_t
+reference_decode(const unsigned char *data, size_t size)
+{
+    for (size_t j = 0; j < size; ++j)
+    {
+        unsigned char c = data[j];
+        if (c == '\0' || c == '\r' || c == '\n' || c == 16)
+            return j;
+    }
+    return size;
+}
+
+
+static size_t
+reference_encode(const unsigned char *data, size_t size)
+{
+    for (size_t j = 0; j < size; ++j)
+    {
+        unsigned char c = data[j];
+        if (c < ' ' || c > '~')
+            return j;
+    }
+    return size;
+}
+
+
+typedef size_t (*scan_t)(const unsigned char *data, size_t size);
+
+
+static void
+compare(const unsigned char *data, size_t size)
+{
+    size_t expected = reference_decode(data, size);
+    size_t actual = text_scan_decode(data, size);
+    if (actual != expected)
+    {
+        explain_output_error_and_die
+        (
+            "text_scan_decode: size %ld: expected %ld, got %ld",
+            (long)size,
+            (long)expected,
+            (long)actual
+        );
+    }
+    expected = reference_encode(data, size);
+    actual = text_scan_encode(data, size);
+    if (actual != expected)
+    {
+        explain_output_error_and_die
+        (
+            "text_scan_encode: size %ld: expected %ld, got %ld",
+            (long)size,
+            (long)expected,
+            (long)actual
+        );
+    }
+}
+
+
+static void
+check_equivalence(long iterations)
+{
+    enum { maxlen = 200, slop = 64 };
+    unsigned char buffer[maxlen + slop];
+
+    //
+    // Every byte value, in every lane, at every alignment.
+    //
+    for (int c = 0; c < 256; ++c)
+    {
+        for (size_t align = 0; align < slop; ++align)
+        {
+            for (size_t pos = 0; pos < 70; ++pos)
+            {
+                memset(buffer, 'a', sizeof(buffer));
+                buffer[align + pos] = c;
+                compare(buffer + align, 70);
+                compare(buffer + align, pos);
+            }
+        }
+    }
+
+    //
+    // Random text, with special bytes anywhere from common to rare, and
+    // random lengths and alignments.
+    //
+    srand(1);
+    for (long n = 0; n < iterations; ++n)
+    {
+        int rarity = 1 + rand() % 300;
+        for (size_t j = 0; j < sizeof(buffer); ++j)
+        {
+            if (rand() % rarity == 0)
+                buffer[j] = rand() >> 7;
+            else
+                buffer[j] = ' ' + rand() % 95;
+        }
+        size_t align = rand() % slop;
+        size_t size = rand() % (maxlen + 1);
+        compare(buffer + align, size);
+    }
+}
+
+
+static double
+now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+
+//
+// Scan the whole buffer, as the text translators do, one run at a time.
+// The result is the best rate of three, in megabytes per second.
+//
+static double
+measure(scan_t scan, const unsigned char *data, size_t size)
+{
+    double best = 0;
+    for (int pass = 0; pass < 3; ++pass)
+    {
+        double start = now();
+        size_t runs = 0;
+        for (size_t pos = 0; pos < size; ++runs)
+            pos += scan(data + pos, size - pos) + 1;
+        double elapsed = now() - start;
+        if (runs && elapsed > 0 && size / elapsed / 1e6 > best)
+            best = size / elapsed / 1e6;
+    }
+    return best;
+}
+
+
+static void
+benchmark(long megabytes)
+{
+    //
+    // Synthetic source text: lines of 20 to 80 printable characters,
+    // like a Pascal program.
+    //
+    size_t size = (size_t)megabytes << 20;
+    unsigned char *data = new unsigned char [size];
+    srand(1);
+    size_t eol = 20 + rand() % 60;
+    for (size_t j = 0; j < size; ++j)
+    {
+        if (j == eol)
+        {
+            data[j] = '\n';
+            eol += 20 + rand() % 60;
+        }
+        else
+            data[j] = ' ' + rand() % 95;
+    }
+    printf("decode: kernel %8.1f MB/s, reference %8.1f MB/s\n",
+        measure(text_scan_decode, data, size),
+        measure(reference_decode, data, size));
+    printf("encode: kernel %8.1f MB/s, reference %8.1f MB/s\n",
+        measure(text_scan_encode, data, size),
+        measure(reference_encode, data, size));
+    delete [] data;
+}
+
+
+int
+main(int argc, char **argv)
+{
+    explain_program_name_set(argv[0]);
+    explain_option_hanging_indent_set(4);
+    bool bench_flag = false;
+    long iterations = 100000;
+    for (;;)
+    {
+        int c = getopt(argc, argv, "bn:V");
+        if (c == EOF)
+            break;
+        switch (c)
+        {
+        case 'b':
+            bench_flag = true;
+            break;
+
+        case 'n':
+            iterations = atol(optarg);
+            break;
+
+        case 'V':
+            version_print();
+            return 0;
+
+        default:
+            usage();
+        }
+    }
+    if (bench_flag)
+    {
+        long megabytes = 64;
+        if (optind < argc)
+            megabytes = atol(argv[optind++]);
+        if (optind != argc || megabytes < 1)
+            usage();
+        benchmark(megabytes);
+        return 0;
+    }
+    if (optind != argc)
+        usage();
+    check_equivalence(iterations);
+    return 0;
+}
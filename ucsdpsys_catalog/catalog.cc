@@ -0,0 +1,257 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cstdlib>
+#include <cstring>
+#include <fnmatch.h>
+#include <set>
+
+#include <lib/tab_file.h>
+
+#include <ucsdpsys_catalog/catalog.h>
+
+
+catalog::~catalog()
+{
+}
+
+
+catalog::catalog(const rcstring &a_filename) :
+    filename(a_filename)
+{
+}
+
+
+void
+catalog::read(void)
+{
+    rcstring_list lines;
+    tab_file_read(filename, lines);
+
+    mutex::locker locked(lock);
+    image_entry *current = 0;
+    for (size_t j = 0; j < lines.size(); ++j)
+    {
+        rcstring line = lines[j];
+        if (line.size() < 2 || line[1] != '\t')
+            continue;
+        rcstring f[6];
+        if (line[0] == 'I')
+        {
+            current = 0;
+            if (!tab_file_split(line.substring(2, line.size() - 2), f, 6))
+                continue;
+            if (f[5].empty())
+                continue;
+            image_entry &e = entries[f[5]];
+            e.size = strtoll(f[0].c_str(), 0, 10);
+            e.mtime = strtol(f[1].c_str(), 0, 10);
+            e.mtime_nsec = strtol(f[2].c_str(), 0, 10);
+            e.interleave = f[3];
+            e.volume = f[4];
+            e.files.clear();
+            current = &e;
+        }
+        else if (line[0] == 'F' && current)
+        {
+            if (!tab_file_split(line.substring(2, line.size() - 2), f, 6))
+                continue;
+            file_entry fe;
+            fe.size = strtoul(f[0].c_str(), 0, 10);
+            fe.first_block = atoi(f[1].c_str());
+            fe.date = f[2];
+            fe.kind = f[3];
+            fe.hash = f[4];
+            fe.name = f[5];
+            current->files.push_back(fe);
+        }
+    }
+}
+
+
+void
+catalog::write(void) const
+{
+    FILE *fp = tab_file_create(filename, "ucsdpsys_catalog index");
+    {
+        mutex::locker locked(lock);
+        for
+        (
+            entries_t::const_iterator it = entries.begin();
+            it != entries.end();
+            ++it
+        )
+        {
+            const image_entry &e = it->second;
+            fprintf
+            (
+                fp,
+                "I\t%lld\t%ld\t%ld\t%s\t%s\t%s\n",
+                (long long)e.size,
+                (long)e.mtime,
+                e.mtime_nsec,
+                e.interleave.c_str(),
+                e.volume.c_str(),
+                it->first.c_str()
+            );
+            for (size_t j = 0; j < e.files.size(); ++j)
+            {
+                const file_entry &fe = e.files[j];
+                fprintf
+                (
+                    fp,
+                    "F\t%lu\t%d\t%s\t%s\t%s\t%s\n",
+                    fe.size,
+                    fe.first_block,
+                    fe.date.c_str(),
+                    fe.kind.c_str(),
+                    fe.hash.c_str(),
+                    fe.name.c_str()
+                );
+            }
+        }
+    }
+    tab_file_commit(fp, filename);
+}
+
+
+bool
+catalog::unchanged(const rcstring &image, const struct stat &st)
+    const
+{
+    mutex::locker locked(lock);
+    entries_t::const_iterator it = entries.find(image);
+    if (it == entries.end())
+        return false;
+    const image_entry &e = it->second;
+    return
+        (
+            e.size == st.st_size
+        &&
+            e.mtime == st.st_mtim.tv_sec
+        &&
+            e.mtime_nsec == st.st_mtim.tv_nsec
+        );
+}
+
+
+void
+catalog::remember(const rcstring &image, const image_entry &value)
+{
+    mutex::locker locked(lock);
+    entries[image] = value;
+}
+
+
+void
+catalog::retain(const rcstring_list &images)
+{
+    std::set<rcstring> keep;
+    for (size_t j = 0; j < images.size(); ++j)
+        keep.insert(images[j]);
+    mutex::locker locked(lock);
+    entries_t::iterator it = entries.begin();
+    while (it != entries.end())
+    {
+        if (keep.count(it->first))
+            ++it;
+        else
+            entries.erase(it++);
+    }
+}
+
+
+static bool
+kind_matches(const rcstring &kind, const rcstring &wanted)
+{
+    if (wanted.empty())
+        return true;
+    rcstring w = wanted.downcase();
+    return (kind == w || kind == w + "file");
+}
+
+
+static bool
+date_matches(const rcstring &date, const rcstring &since,
+    const rcstring &until)
+{
+    //
+    // The dates are all YYYY-MM-DD, so they compare as strings.  A
+    // shorter limit is a prefix, and covers the whole year or month.
+    //
+    if (!since.empty() && strcmp(date.c_str(), since.c_str()) < 0)
+        return false;
+    if
+    (
+        !until.empty()
+    &&
+        strcmp(date.substring(0, until.size()).c_str(), until.c_str()) > 0
+    )
+        return false;
+    return true;
+}
+
+
+size_t
+catalog::search(const query &q, FILE *fp)
+    const
+{
+    rcstring pattern = q.name.upcase();
+    size_t count = 0;
+    mutex::locker locked(lock);
+    for
+    (
+        entries_t::const_iterator it = entries.begin();
+        it != entries.end();
+        ++it
+    )
+    {
+        const image_entry &e = it->second;
+        for (size_t j = 0; j < e.files.size(); ++j)
+        {
+            const file_entry &fe = e.files[j];
+            if (!kind_matches(fe.kind, q.kind))
+                continue;
+            if (!date_matches(fe.date, q.since, q.until))
+                continue;
+            if
+            (
+                !pattern.empty()
+            &&
+                fnmatch(pattern.c_str(), fe.name.upcase().c_str(), 0) != 0
+            )
+                continue;
+            fprintf
+            (
+                fp,
+                "%s\t%s:%s\t%s\t%lu\t%s\t%d\t%s\n",
+                it->first.c_str(),
+                e.volume.c_str(),
+                fe.name.c_str(),
+                fe.kind.c_str(),
+                fe.size,
+                fe.date.c_str(),
+                fe.first_block,
+                fe.hash.c_str()
+            );
+            ++count;
+        }
+    }
+    return count;
+}
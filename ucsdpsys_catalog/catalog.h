@@ -0,0 +1,214 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#ifndef UCSDPSYS_CATALOG_CATALOG_H
+#define UCSDPSYS_CATALOG_CATALOG_H
+
+#include <cstdio>
+#include <map>
+#include <sys/stat.h>
+#include <vector>
+
+#include <lib/mutex.h>
+#include <lib/rcstring.h>
+#include <lib/rcstring/list.h>
+
+/**
+  * The catalog class is used to represent an index of the files on
+  * each of a collection of disk images, kept on disk from one run to
+  * the next, so that questions about the files can be answered without
+  * opening the disk images.
+  *
+  * All of the methods may be called from several threads at once.
+  */
+class catalog
+{
+public:
+    /**
+      * The destructor.
+      */
+    virtual ~catalog();
+
+    /**
+      * The constructor.
+      *
+      * @param filename
+      *     The file in which the index is kept between runs.
+      */
+    catalog(const rcstring &filename);
+
+    /**
+      * The file_entry class is used to remember what is known about a
+      * file on a disk image.
+      */
+    struct file_entry
+    {
+        file_entry() : size(0), first_block(0) { }
+
+        rcstring name;
+        rcstring kind;
+        unsigned long size;
+        rcstring date;
+        int first_block;
+        rcstring hash;
+    };
+
+    typedef std::vector<file_entry> file_entries_t;
+
+    /**
+      * The image_entry class is used to remember what is known about a
+      * disk image.  Files which are not UCSD p-System volumes are
+      * remembered too (with an empty volume name), so that they are not
+      * looked at again until they change.
+      */
+    struct image_entry
+    {
+        image_entry() : size(0), mtime(0), mtime_nsec(0) { }
+
+        off_t size;
+        time_t mtime;
+        long mtime_nsec;
+        rcstring interleave;
+        rcstring volume;
+        file_entries_t files;
+    };
+
+    /**
+      * The read method is used to read the index file, if it exists.
+      */
+    void read(void);
+
+    /**
+      * The write method is used to replace the index file with the
+      * present contents of the index.
+      */
+    void write(void) const;
+
+    /**
+      * The unchanged method is used to determine whether a disk image
+      * is in the index, and has the same size and modification time as
+      * when it was scanned.
+      *
+      * @param image
+      *     The file name of the disk image.
+      * @param st
+      *     The file's present status, from stat(2).
+      */
+    bool unchanged(const rcstring &image, const struct stat &st) const;
+
+    /**
+      * The remember method is used to add a disk image to the index, or
+      * to replace one already there.
+      *
+      * @param image
+      *     The file name of the disk image.
+      * @param value
+      *     What is known about the disk image.
+      */
+    void remember(const rcstring &image, const image_entry &value);
+
+    /**
+      * The retain method is used to remove from the index every disk
+      * image not in the given list (typically because it no longer
+      * exists).
+      *
+      * @param images
+      *     The file names of the disk images to keep.
+      */
+    void retain(const rcstring_list &images);
+
+    /**
+      * The query class is used to represent what to look for in the
+      * index.  Empty fields match everything.
+      */
+    struct query
+    {
+        /**
+          * A file name pattern, as for fnmatch(3), case insensitive.
+          */
+        rcstring name;
+
+        /**
+          * A file kind, as for directory_entry::dfkind_name (the "file"
+          * suffix is optional).
+          */
+        rcstring kind;
+
+        /**
+          * The earliest date, as YYYY, YYYY-MM or YYYY-MM-DD.
+          */
+        rcstring since;
+
+        /**
+          * The latest date, as YYYY, YYYY-MM or YYYY-MM-DD (inclusive,
+          * so a year means the end of that year).
+          */
+        rcstring until;
+    };
+
+    /**
+      * The search method is used to print the files which match a
+      * query, one per line, in the order of the disk images' names.
+      *
+      * @param q
+      *     What to look for.
+      * @param fp
+      *     Where to print the results.
+      * @returns
+      *     the number of files which matched.
+      */
+    size_t search(const query &q, FILE *fp) const;
+
+private:
+    /**
+      * The filename instance variable is used to remember the file in
+      * which the index is kept between runs.
+      */
+    rcstring filename;
+
+    typedef std::map<rcstring, image_entry> entries_t;
+
+    /**
+      * The entries instance variable is used to remember the disk
+      * images, indexed by file name.
+      */
+    entries_t entries;
+
+    /**
+      * The lock instance variable is used to serialize access to the
+      * #entries instance variable.
+      */
+    mutable mutex lock;
+
+    /**
+      * The default constructor.  Do not use.
+      */
+    catalog();
+
+    /**
+      * The copy constructor.  Do not use.
+      */
+    catalog(const catalog &);
+
+    /**
+      * The assignment operator.  Do not use.
+      */
+    catalog &operator=(const catalog &);
+};
+
+#endif // UCSDPSYS_CATALOG_CATALOG_H
@@ -0,0 +1,263 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <getopt.h>
+#include <libexplain/output.h>
+#include <libexplain/program_name.h>
+#include <sys/stat.h>
+#include <boost/scoped_ptr.hpp>
+#include <vector>
+
+#include <lib/batch.h>
+#include <lib/debug.h>
+#include <lib/directory.h>
+#include <lib/directory/entry.h>
+#include <lib/explain_mt.h>
+#include <lib/fnv1a.h>
+#include <lib/version.h>
+
+#include <ucsdpsys_catalog/catalog.h>
+
+
+static void
+usage(void)
+{
+    const char *prog = explain_program_name_get();
+    fprintf(stderr, "Usage: %s --index=<file> --update [ -j <n> ] <path>...\n",
+        prog);
+    fprintf(stderr, "       %s --index=<file> [ --name=<pattern> ]"
+        "[ --kind=<kind> ]\n", prog);
+    fprintf(stderr, "           [ --since=<date> ][ --until=<date> ]\n");
+    fprintf(stderr, "       %s --version\n", prog);
+    exit(1);
+}
+
+
+/**
+  * The index variable is used to remember the index being updated.
+  */
+static catalog *index_ptr;
+
+
+/**
+  * The scan_one function is used to add one disk image of a corpus to
+  * the index, unless it has not changed since it was last scanned.
+  *
+  * @param image
+  *     The file name of the disk image.
+  */
+static void
+scan_one(const rcstring &image, FILE *)
+{
+    struct stat st;
+    explain_mt_stat_or_die(image.c_str(), &st);
+    if (index_ptr->unchanged(image, st))
+        return;
+    DEBUG(1, "scan %s", image.c_str());
+
+    catalog::image_entry e;
+    e.size = st.st_size;
+    e.mtime = st.st_mtim.tv_sec;
+    e.mtime_nsec = st.st_mtim.tv_nsec;
+    boost::scoped_ptr<directory> volume
+    (
+        directory::try_factory(image, true, e.interleave)
+    );
+    if (!volume)
+    {
+        //
+        // It is remembered anyway, so that it isn't looked at again
+        // until it changes.
+        //
+        e.interleave = rcstring();
+        index_ptr->remember(image, e);
+        explain_output_error
+        (
+            "%s: warning: unable to find a UCSD p-System volume",
+            image.c_str()
+        );
+        return;
+    }
+    e.volume = volume->get_volume_name();
+
+    std::vector<unsigned char> data;
+    int n = 0;
+    for (;;)
+    {
+        directory_entry::pointer dep = volume->nth(n);
+        if (!dep)
+            break;
+        catalog::file_entry fe;
+        fe.name = dep->get_name();
+        fe.kind = directory_entry::dfkind_name(dep->get_file_kind());
+        fe.size = dep->get_size_in_bytes();
+        fe.first_block = dep->get_first_block();
+
+        time_t when = dep->get_mtime();
+        struct tm tm;
+        localtime_r(&when, &tm);
+        char buf[20];
+        strftime(buf, sizeof(buf), "%Y-%m-%d", &tm);
+        fe.date = buf;
+
+        //
+        // The hash is of the file's contents as they are on the medium,
+        // so that copies of the same file on different disk images
+        // have the same hash.
+        //
+        data.resize(fe.size);
+        unsigned long long hash = fnv1a_64(0, 0);
+        if (!data.empty())
+        {
+            int err = dep->read(0, &data[0], data.size());
+            if (err < 0)
+            {
+                explain_output_error_and_die
+                (
+                    "%s: read %s: %s",
+                    image.c_str(),
+                    fe.name.c_str(),
+                    strerror(-err)
+                );
+            }
+            hash = fnv1a_64(&data[0], data.size(), hash);
+        }
+        fe.hash = rcstring::printf("%016llx", hash);
+        e.files.push_back(fe);
+    }
+    index_ptr->remember(image, e);
+}
+
+
+int
+main(int argc, char **argv)
+{
+    explain_program_name_set(argv[0]);
+    explain_option_hanging_indent_set(4);
+    const char *index_filename = 0;
+    bool update_flag = false;
+    unsigned jobs = 0;
+    catalog::query q;
+    for (;;)
+    {
+        static const struct option options[] =
+        {
+            { "debug", 0, 0, 'D' },
+            { "index", 1, 0, 'i' },
+            { "jobs", 1, 0, 'j' },
+            { "kind", 1, 0, 'k' },
+            { "name", 1, 0, 'n' },
+            { "since", 1, 0, 's' },
+            { "until", 1, 0, 'u' },
+            { "update", 0, 0, 'U' },
+            { "version", 0, 0, 'V' },
+            { 0, 0, 0, 0 }
+        };
+        int c = getopt_long(argc, argv, "Di:j:k:n:s:u:UV", options, 0);
+        if (c < 0)
+            break;
+        switch (c)
+        {
+        case 'D':
+            ++debug_level;
+            break;
+
+        case 'i':
+            index_filename = optarg;
+            break;
+
+        case 'j':
+            jobs = atoi(optarg);
+            if (jobs < 1)
+            {
+                explain_output_error_and_die
+                (
+                    "the --jobs option needs a positive number"
+                );
+            }
+            break;
+
+        case 'k':
+            q.kind = optarg;
+            break;
+
+        case 'n':
+            q.name = optarg;
+            break;
+
+        case 's':
+            q.since = optarg;
+            break;
+
+        case 'u':
+            q.until = optarg;
+            break;
+
+        case 'U':
+            update_flag = true;
+            break;
+
+        case 'V':
+            version_print();
+            return 0;
+
+        default:
+            usage();
+        }
+    }
+    if (!index_filename)
+        explain_output_error_and_die("no index (--index=file) specified");
+    catalog idx(index_filename);
+    idx.read();
+
+    if (update_flag)
+    {
+        if (optind >= argc)
+            usage();
+        rcstring_list images;
+        for (int j = optind; j < argc; ++j)
+            batch_walk(argv[j], images);
+
+        //
+        // The index describes the disk images found this time, and no
+        // others.  Only new and changed images are scanned.
+        //
+        idx.retain(images);
+        index_ptr = &idx;
+        size_t failures = batch_run(images, scan_one, jobs, 0);
+        index_ptr = 0;
+        idx.write();
+        return (failures ? 1 : 0);
+    }
+
+    if (optind != argc)
+        usage();
+    if (jobs)
+    {
+        explain_output_error_and_die
+        (
+            "the --jobs option needs the --update option"
+        );
+    }
+    return (idx.search(q, stdout) ? 0 : 1);
+}
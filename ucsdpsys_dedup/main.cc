@@ -0,0 +1,334 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <getopt.h>
+#include <libexplain/close.h>
+#include <libexplain/open.h>
+#include <libexplain/output.h>
+#include <libexplain/program_name.h>
+#include <libexplain/read.h>
+#include <libexplain/realpath.h>
+#include <libexplain/write.h>
+#include <unistd.h>
+#include <vector>
+
+#include <lib/debug.h>
+#include <lib/dedup_store.h>
+#include <lib/sector_io/dedup.h>
+#include <lib/sector_io/imd.h>
+#include <lib/sector_io/td0.h>
+#include <lib/version.h>
+
+
+static void
+usage(void)
+{
+    const char *prog = explain_program_name_get();
+    fprintf(stderr, "Usage: %s --store=<dir> --import <image> <manifest>\n",
+        prog);
+    fprintf(stderr, "       %s --export <manifest> <image>\n", prog);
+    fprintf(stderr, "       %s -V\n", prog);
+    exit(1);
+}
+
+
+/**
+  * The split_path function is used to break an absolute path into its
+  * components.
+  */
+static std::vector<rcstring>
+split_path(const char *path)
+{
+    std::vector<rcstring> result;
+    for (;;)
+    {
+        while (*path == '/')
+            ++path;
+        if (!*path)
+            return result;
+        const char *end = strchr(path, '/');
+        if (!end)
+            end = path + strlen(path);
+        result.push_back(rcstring(path, end - path));
+        path = end;
+    }
+}
+
+
+/**
+  * The relative_path function is used to express the path of one
+  * directory relative to another, so that a manifest and its store
+  * may be moved together.
+  *
+  * @param from
+  *     The directory the path is to be relative to.
+  * @param to
+  *     The directory the path is to lead to.
+  */
+static rcstring
+relative_path(const rcstring &from, const rcstring &to)
+{
+    char buf[PATH_MAX];
+    explain_realpath_or_die(from.c_str(), buf);
+    std::vector<rcstring> from_parts = split_path(buf);
+    explain_realpath_or_die(to.c_str(), buf);
+    std::vector<rcstring> to_parts = split_path(buf);
+
+    size_t common = 0;
+    while
+    (
+        common < from_parts.size()
+    &&
+        common < to_parts.size()
+    &&
+        from_parts[common] == to_parts[common]
+    )
+        ++common;
+
+    rcstring result;
+    for (size_t j = common; j < from_parts.size(); ++j)
+        result += "../";
+    for (size_t j = common; j < to_parts.size(); ++j)
+        result += to_parts[j] + "/";
+    if (result.empty())
+        return ".";
+    return result.substring(0, result.size() - 1);
+}
+
+
+/**
+  * The read_image function is used to read the whole of a disk image
+  * into memory.  Plain files are read exactly as they are, byte for
+  * byte; the other disk image formats are read by way of the sector
+  * I/O class which understands them.
+  *
+  * @param filename
+  *     The name of the disk image to read.
+  * @param data
+  *     Where to put the contents.
+  */
+static void
+read_image(const rcstring &filename, std::vector<unsigned char> &data)
+{
+    data.clear();
+    if
+    (
+        sector_io_imd::candidate(filename)
+    ||
+        sector_io_td0::candidate(filename)
+    ||
+        sector_io_dedup::candidate(filename)
+    )
+    {
+        sector_io::pointer io = sector_io::factory(filename, true);
+
+        //
+        // A deduplicated image need not be a whole number of sectors.
+        // With one byte sectors, its size is exact, not rounded down.
+        //
+        io->bytes_per_sector_hint(1);
+        int rc = io->size_in_bytes();
+        if (rc < 0)
+        {
+            explain_output_error_and_die
+            (
+                "stat %s: %s",
+                filename.c_str(),
+                strerror(-rc)
+            );
+        }
+        data.resize(rc);
+        if (data.empty())
+            return;
+        rc = io->read(0, &data[0], data.size());
+        if (rc < 0)
+        {
+            explain_output_error_and_die
+            (
+                "read %s: %s",
+                filename.c_str(),
+                strerror(-rc)
+            );
+        }
+        return;
+    }
+
+    int fd = explain_open_or_die(filename.c_str(), O_RDONLY, 0);
+    unsigned char buffer[1 << 16];
+    for (;;)
+    {
+        ssize_t n = explain_read_or_die(fd, buffer, sizeof(buffer));
+        if (n == 0)
+            break;
+        data.insert(data.end(), buffer, buffer + n);
+    }
+    explain_close_or_die(fd);
+}
+
+
+static void
+import(const rcstring &store_dir, const rcstring &image,
+    const rcstring &manifest)
+{
+    std::vector<unsigned char> data;
+    read_image(image, data);
+
+    //
+    // The last chunk is padded with zeros; the image size in the
+    // manifest says how much of it is real.
+    //
+    dedup_store::pointer store = dedup_store::create(store_dir, true);
+    unsigned before = store->size();
+    std::vector<unsigned> chunks;
+    size_t size = data.size();
+    chunks.reserve((size + dedup_store::chunk_size - 1)
+        / dedup_store::chunk_size);
+    for (size_t pos = 0; pos < size; pos += dedup_store::chunk_size)
+    {
+        unsigned char chunk[dedup_store::chunk_size];
+        size_t nbytes = size - pos;
+        if (nbytes > dedup_store::chunk_size)
+            nbytes = dedup_store::chunk_size;
+        memcpy(chunk, &data[pos], nbytes);
+        memset(chunk + nbytes, 0, dedup_store::chunk_size - nbytes);
+        chunks.push_back(store->insert(chunk));
+    }
+
+    //
+    // The chunks must be safely in the store before the manifest
+    // refers to them.
+    //
+    store->sync();
+    rcstring store_path =
+        (
+            store_dir[0] == '/'
+        ?
+            store_dir
+        :
+            relative_path(manifest.dirname(), store_dir)
+        );
+    sector_io_dedup::write_manifest(manifest, store_path, size, chunks);
+    DEBUG(1, "%s: %ld chunks, %u new", image.c_str(), (long)chunks.size(),
+        store->size() - before);
+}
+
+
+static void
+export_image(const rcstring &manifest, const rcstring &image)
+{
+    if (!sector_io_dedup::candidate(manifest))
+    {
+        explain_output_error_and_die
+        (
+            "%s: not a deduplicated disk image",
+            manifest.c_str()
+        );
+    }
+    std::vector<unsigned char> data;
+    read_image(manifest, data);
+    int fd =
+        explain_open_or_die
+        (
+            image.c_str(),
+            O_WRONLY | O_CREAT | O_TRUNC,
+            0666
+        );
+    if (!data.empty())
+        explain_write_or_die(fd, &data[0], data.size());
+    explain_close_or_die(fd);
+}
+
+
+int
+main(int argc, char **argv)
+{
+    explain_program_name_set(argv[0]);
+    explain_option_hanging_indent_set(4);
+    bool import_flag = false;
+    bool export_flag = false;
+    const char *store_dir = 0;
+    for (;;)
+    {
+        static const struct option options[] =
+        {
+            { "debug", 0, 0, 'D' },
+            { "export", 0, 0, 'x' },
+            { "import", 0, 0, 'i' },
+            { "store", 1, 0, 's' },
+            { "version", 0, 0, 'V' },
+            { 0, 0, 0, 0 }
+        };
+        int c = getopt_long(argc, argv, "Dis:Vx", options, 0);
+        if (c == EOF)
+            break;
+        switch (c)
+        {
+        case 'D':
+            ++debug_level;
+            break;
+
+        case 'i':
+            import_flag = true;
+            break;
+
+        case 's':
+            store_dir = optarg;
+            break;
+
+        case 'V':
+            version_print();
+            return 0;
+
+        case 'x':
+            export_flag = true;
+            break;
+
+        default:
+            usage();
+        }
+    }
+    if (import_flag + export_flag != 1)
+    {
+        explain_output_error_and_die
+        (
+            "you must specify exactly one of the --import or "
+                "--export options"
+        );
+    }
+    if (argc - optind != 2)
+        explain_output_error_and_die("two file names must be given");
+    rcstring infile(argv[optind]);
+    rcstring outfile(argv[optind + 1]);
+
+    if (import_flag)
+    {
+        if (!store_dir)
+            explain_output_error_and_die("no store (--store=dir) specified");
+        import(store_dir, infile, outfile);
+    }
+    else
+        export_image(infile, outfile);
+    return 0;
+}
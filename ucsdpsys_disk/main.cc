@@ -17,30 +17,39 @@
 //
 
 #include <lib/config.h>
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <fcntl.h>
 #include <getopt.h>
-#include <libexplain/stat.h>
-#include <libexplain/closedir.h>
-#include <libexplain/opendir.h>
-#include <libexplain/readdir.h>
+#include <libexplain/fclose.h>
+#include <libexplain/fopen.h>
 #include <libexplain/output.h>
 #include <libexplain/program_name.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <dirent.h>
+#include <boost/scoped_ptr.hpp>
+#include <vector>
 
+#include <lib/batch.h>
 #include <lib/debug.h>
 #include <lib/directory.h>
 #include <lib/directory/entry.h>
+#include <lib/explain_mt.h>
 #include <lib/input/file.h>
 #include <lib/input/psystem.h>
+#include <lib/input/stdin.h>
+#include <lib/input/tar.h>
 #include <lib/output/file.h>
+#include <lib/output/memory.h>
 #include <lib/output/psystem.h>
+#include <lib/output/stdout.h>
+#include <lib/output/tar.h>
 #include <lib/output/text_decode.h>
 #include <lib/output/text_encode.h>
 #include <lib/rcstring/list.h>
@@ -54,24 +63,22 @@ usage(void)
     fprintf(stderr, "Usage: %s -f <disk.image> -l\n", prog);
     fprintf(stderr, "       %s -f <disk.image> -g <file.to.get>...\n", prog);
     fprintf(stderr, "       %s -f <disk.image> -p <file.to.put>...\n", prog);
+    fprintf(stderr, "       %s -f <disk.image> --tar=<archive>\n", prog);
+    fprintf(stderr, "       %s -f <disk.image> --put-tar=<archive>\n", prog);
     fprintf(stderr, "       %s -f <disk.image> -r <file.to.remove>...\n", prog);
+    fprintf(stderr, "       %s -f <disk.image> --copy <to>=<from>...\n",
+        prog);
     fprintf(stderr, "       %s -f <disk.image> --crunch\n", prog);
     fprintf(stderr, "       %s -f <disk.image> --system-volume\n", prog);
+    fprintf(stderr, "       %s --batch=<list> [ -j <n> ] <action> "
+        "[ <file>... ]\n", prog);
     fprintf(stderr, "       %s -V\n", prog);
     exit(1);
 }
 
 
-static mode_t
-get_umask(void)
-{
-    mode_t um = umask(0);
-    umask(um);
-    return (um & 0777);
-}
-
-
 static bool all_binary;
+static bool text_on_the_fly;
 
 
 static void
@@ -149,8 +156,62 @@ get_dir(directory *volume, const rcstring &dir)
 }
 
 
+/**
+  * The add_file function is used to add a file to the list of files to
+  * be put into the disk image, encoding it first if it is a text file.
+  *
+  * @param list
+  *     The files to be put into the disk image.
+  * @param ucsd_filename
+  *     The name of the file in the disk image.
+  * @param data
+  *     The contents of the file, as read from the host.
+  * @param size
+  *     The size of the file, in bytes.
+  * @param mtime
+  *     The time the file was last modified.
+  */
+static void
+add_file(directory::new_file_list &list, const rcstring &ucsd_filename,
+    const void *data, size_t size, time_t mtime)
+{
+    list.push_back(directory::new_file());
+    directory::new_file &nf = list.back();
+    nf.name = ucsd_filename;
+    nf.mtime = mtime;
+
+    //
+    // The files are written straight to the medium, not through their
+    // directory entries, so text files have to be encoded here even if
+    // the file system is translating text files on-the-fly.
+    //
+    bool text =
+        (
+            directory_entry::dfkind_from_extension(ucsd_filename)
+        ==
+            directory_entry::textfile
+        );
+    if (text && (!all_binary || text_on_the_fly))
+    {
+        output_memory::mpointer mem = output_memory::create();
+        {
+            // The last page is only padded when the encoder is destroyed.
+            output::pointer out = output_text_encode::create(mem);
+            out->write(data, size);
+        }
+        const unsigned char *cp = (const unsigned char *)mem->get_data();
+        nf.data.assign(cp, cp + mem->size());
+    }
+    else
+    {
+        const unsigned char *cp = (const unsigned char *)data;
+        nf.data.assign(cp, cp + size);
+    }
+}
+
+
 static void
-put(directory *volume, const rcstring &fspec)
+put(directory::new_file_list &list, const rcstring &fspec)
 {
     rcstring unix_filename(fspec);
     rcstring ucsd_filename(unix_filename.basename());
@@ -164,66 +225,81 @@ put(directory *volume, const rcstring &fspec)
     input::pointer in = input_file::create(unix_filename);
     struct stat st;
     in->fstat(st);
-
-    directory_entry::pointer dep = volume->find(ucsd_filename);
-    if (!dep)
-    {
-        dep = volume->find("/");
-        assert(dep);
-        mode_t mode = S_IFREG + (0666 & ~get_umask());
-        int err = dep->mknod(ucsd_filename, mode, 0);
-        if (err < 0)
-        {
-            explain_output_error_and_die
-            (
-                "create %s:%s: %s",
-                volume->get_volume_name().c_str(),
-                ucsd_filename.c_str(),
-                strerror(-err)
-            );
-        }
-        dep = volume->find(ucsd_filename);
-        assert(dep);
-    }
-
-    output::pointer out = output_psystem::create(dep);
-    if (!all_binary && dep->is_text_kind())
-        out = output_text_encode::create(out);
-
-    out->write(in);
-    out->flush();
-
-    //
-    // Preserve the utimes (as far as possible, anyway).
-    //
-    struct timespec tv[2];
-    tv[0].tv_sec = st.st_atime;
-    tv[0].tv_nsec = 0;
-    tv[1].tv_sec = st.st_mtime;
-    tv[1].tv_nsec = 0;
-    out->utime_ns(tv);
+    output_memory::mpointer mem = output_memory::create();
+    mem->write(in);
+    mem->flush();
+    add_file(list, ucsd_filename, mem->get_data(), mem->size(), st.st_mtime);
 }
 
 
 static void
-put_dir(directory *volume, const rcstring &dir, bool skip_dot)
+put_dir(directory::new_file_list &list, const rcstring &dir, bool skip_dot)
 {
-    DIR *dp = explain_opendir_or_die(dir.c_str());
+    DIR *dp = explain_mt_opendir_or_die(dir.c_str());
     for (;;)
     {
-        dirent *dep = explain_readdir_or_die(dp);
+        dirent *dep = explain_mt_readdir_or_die(dp);
         if (!dep)
             break;
         rcstring name(dep->d_name);
         rcstring path = dir + "/" + name;
         struct stat st;
-        explain_stat_or_die(path.c_str(), &st);
+        explain_mt_stat_or_die(path.c_str(), &st);
         if (skip_dot && name[0] == '.')
             continue;
         if (S_ISREG(st.st_mode))
-            put(volume, name.upcase() + "=" + path);
+            put(list, name.upcase() + "=" + path);
+    }
+    explain_mt_closedir_or_die(dp);
+}
+
+
+/**
+  * The put_tar function is used to read all of the files in a tar
+  * archive, to be put into the disk image.  The directories of the
+  * files within the archive are ignored, as the p-System has none.
+  *
+  * @param list
+  *     The files to be put into the disk image.
+  * @param tar_file
+  *     The name of the archive, or "-" for the standard input.
+  * @param skip_dot
+  *     Whether or not to ignore files with names starting with a dot.
+  */
+static void
+put_tar(directory::new_file_list &list, const rcstring &tar_file,
+    bool skip_dot)
+{
+    input_tar::pointer archive =
+        input_tar::create
+        (
+            (
+                tar_file == "-"
+            ?
+                input_stdin::create()
+            :
+                input_file::create(tar_file)
+            )
+        );
+    for (;;)
+    {
+        rcstring path;
+        time_t mtime = 0;
+        std::vector<unsigned char> data;
+        if (!archive->read_member(path, mtime, data))
+            break;
+        rcstring name = path.basename();
+        if (name.empty() || (skip_dot && name[0] == '.'))
+            continue;
+        add_file
+        (
+            list,
+            name.upcase(),
+            (data.empty() ? 0 : &data[0]),
+            data.size(),
+            mtime
+        );
     }
-    explain_closedir_or_die(dp);
 }
 
 
@@ -255,6 +331,116 @@ remove(directory *volume, const rcstring &filename)
 }
 
 
+/**
+  * The copy function is used to copy a file to another file in the
+  * same disk image.  The data is copied within the disk image, rather
+  * than being read into memory and written out again, unless the text
+  * files are being translated on-the-fly.
+  *
+  * @param volume
+  *     The volume to work on.
+  * @param fspec
+  *     The files to copy, in the form <to>=<from>.
+  */
+static void
+copy(directory *volume, const rcstring &fspec)
+{
+    const char *cp = strchr(fspec.c_str(), '=');
+    if (!cp)
+    {
+        explain_output_error_and_die
+        (
+            "copy %s: the file names must be given as <to>=<from>",
+            fspec.c_str()
+        );
+    }
+    rcstring to_filename(fspec.c_str(), cp - fspec.c_str());
+    rcstring from_filename(cp + 1);
+
+    directory_entry::pointer src = volume->find(from_filename);
+    if (!src)
+    {
+        explain_output_error_and_die
+        (
+            "open %s:%s: %s",
+            volume->get_volume_name().c_str(),
+            from_filename.c_str(),
+            strerror(ENOENT)
+        );
+    }
+    struct stat st;
+    int err = src->getattr(&st);
+    if (err >= 0 && !S_ISREG(st.st_mode))
+        err = -EISDIR;
+    if (err < 0)
+    {
+        explain_output_error_and_die
+        (
+            "copy %s:%s: %s",
+            volume->get_volume_name().c_str(),
+            from_filename.c_str(),
+            strerror(-err)
+        );
+    }
+
+    directory_entry::pointer dst = volume->find(to_filename);
+    if (!dst)
+    {
+        err = volume->find("/")->mknod(to_filename, S_IFREG | 0666, 0);
+        if (err >= 0)
+            dst = volume->find(to_filename);
+    }
+    else if (dst == src)
+        return;
+    else
+        err = dst->truncate(0);
+    if (err < 0 || !dst)
+    {
+        explain_output_error_and_die
+        (
+            "create %s:%s: %s",
+            volume->get_volume_name().c_str(),
+            to_filename.c_str(),
+            strerror(err < 0 ? -err : ENOENT)
+        );
+    }
+
+    err = dst->copy_range(0, *src, 0, st.st_size);
+    if (err == -EOPNOTSUPP)
+    {
+        //
+        // The contents are translated on the way in and out, so they
+        // have to be copied the long way.
+        //
+        input::pointer in = input_psystem::create(src);
+        output::pointer out = output_psystem::create(dst);
+        out->write(in);
+        out->flush();
+        err = 0;
+    }
+    if (err < 0)
+    {
+        explain_output_error_and_die
+        (
+            "copy %s:%s: %s",
+            volume->get_volume_name().c_str(),
+            to_filename.c_str(),
+            strerror(-err)
+        );
+    }
+
+    //
+    // Keep the modification time, as the get and put actions do.
+    //
+    struct timespec tv[2];
+    tv[0].tv_sec = st.st_atime;
+    tv[0].tv_nsec = 0;
+    tv[1].tv_sec = st.st_mtime;
+    tv[1].tv_nsec = 0;
+    dst->utime_ns(tv);
+}
+
+
 static bool
 is_a_directory(const rcstring &filename)
 {
@@ -288,23 +474,301 @@ decode_sort_name(const rcstring &name)
 }
 
 
+static bool
+by_first_block(const directory_entry::pointer &lhs,
+    const directory_entry::pointer &rhs)
+{
+    return (lhs->get_first_block() < rhs->get_first_block());
+}
+
+
+/**
+  * The get_tar function is used to get all of the files of a disk
+  * image, and write them to a tar archive, in the same form as if the
+  * --get option had been used to get them all into a directory.
+  *
+  * @param volume
+  *     The disk image to get the files from.
+  * @param tar_file
+  *     The name of the archive to write, or "-" for the standard output.
+  */
+static void
+get_tar(directory *volume, const rcstring &tar_file)
+{
+    //
+    // Read the files in the order they appear on the disk, so that the
+    // whole disk image is read sequentially.
+    //
+    std::vector<directory_entry::pointer> files;
+    int n = 0;
+    for (;;)
+    {
+        directory_entry::pointer dep = volume->nth(n);
+        if (!dep)
+            break;
+        files.push_back(dep);
+    }
+    std::stable_sort(files.begin(), files.end(), by_first_block);
+
+    output_tar::pointer archive =
+        output_tar::create
+        (
+            (
+                tar_file == "-"
+            ?
+                output_stdout::create()
+            :
+                output_file::create(tar_file, true)
+            )
+        );
+    for (size_t j = 0; j < files.size(); ++j)
+    {
+        directory_entry::pointer dep = files[j];
+        rcstring name = dep->get_name().downcase();
+        input::pointer in = input_psystem::create(dep);
+        struct stat stbuf;
+        in->fstat(stbuf);
+        bool binary = all_binary || !dep->is_text_kind();
+        if (binary)
+        {
+            archive->add(name, in, stbuf.st_mtime);
+            continue;
+        }
+
+        //
+        // The size of a text file isn't known until it has been
+        // decoded, and the archive needs the size before the data.
+        // The files are small enough to decode in memory.
+        //
+        output_memory::mpointer mem = output_memory::create();
+        {
+            output::pointer out = output_text_decode::create(mem);
+            out->write(in);
+            out->flush();
+        }
+        archive->add(name, mem->get_data(), mem->size(), stbuf.st_mtime);
+    }
+    archive->close();
+}
+
+
+//
+// The options which say what to do to each disk image.
+//
+static int listing_flag;
+static bool get_flag;
+static bool put_flag;
+static bool crunch_flag;
+static bool remove_flag;
+static bool copy_flag;
+static bool check_flag;
+static bool skip_dot = true;
+static bool wipe_flag;
+static directory::sort_by_t sort_by = directory::sort_by_block;
+static const char *boot_blocks;
+static rcstring_list file_args;
+static bool batch_mode;
+static const char *tar_filename;
+
+
+/**
+  * The get_all function is used to get all of the files of a disk image,
+  * in batch mode, into a directory of their own (named after the disk
+  * image) below the given directory.
+  */
+static void
+get_all(directory *volume, const rcstring &image, const rcstring &dir)
+{
+    rcstring path = dir + "/" + image.basename();
+    if (!is_a_directory(path))
+        explain_mt_mkdir_or_die(path.c_str(), 0777);
+    get_dir(volume, path);
+}
+
+
+/**
+  * The process function is used to do what the command line options
+  * ask, to the given disk image.
+  *
+  * @param disk_image_filename
+  *     The disk image to work on.
+  * @param fp
+  *     Where to print the listing, if any.
+  */
+static void
+process(const rcstring &disk_image_filename, FILE *fp)
+{
+    //
+    // Open the volume, and make sure it has the right format.
+    //
+    bool read_only_flag =
+        (
+            !put_flag
+        &&
+            !remove_flag
+        &&
+            !copy_flag
+        &&
+            !crunch_flag
+        &&
+            !wipe_flag
+        );
+    boost::scoped_ptr<directory> volume
+    (
+        directory::factory
+        (
+            disk_image_filename,
+            read_only_flag,
+            (check_flag ? concern_check : concern_blithe)
+        )
+    );
+    if (text_on_the_fly)
+        volume->convert_text_on_the_fly();
+
+    //
+    // Changes to the directory are written once, at the end, rather
+    // than once for each file.  The exception is moving files about
+    // (crunching, or making room for a file): each move writes the
+    // directory as soon as the data is in its new place, so that the
+    // directory always says where the data is.  If anything goes wrong,
+    // the directory on the medium is left as it was after the last
+    // move, not necessarily as it was to start with.
+    //
+    boost::scoped_ptr<directory::batch> txn;
+    if (!read_only_flag)
+        txn.reset(new directory::batch(*volume));
+
+    //
+    // Chew on the volume, as requested.
+    //
+    directory::new_file_list new_files;
+    for (size_t j = 0; j < file_args.size(); ++j)
+    {
+        rcstring filename = file_args[j];
+        if (put_flag)
+        {
+            if (is_a_directory(filename))
+                put_dir(new_files, filename, skip_dot);
+            else
+                put(new_files, filename);
+        }
+        if (get_flag)
+        {
+            if (batch_mode)
+                get_all(volume.get(), disk_image_filename, filename);
+            else if (is_a_directory(filename))
+                get_dir(volume.get(), filename);
+            else
+                get(volume.get(), filename);
+        }
+        if (remove_flag)
+            remove(volume.get(), filename);
+        if (copy_flag)
+            copy(volume.get(), filename);
+    }
+    if (tar_filename)
+    {
+        if (put_flag)
+            put_tar(new_files, tar_filename, skip_dot);
+        else
+            get_tar(volume.get(), tar_filename);
+    }
+
+    //
+    // All of the files being put are added at once, so that they can
+    // be laid out end to end, and written in a single pass, with the
+    // directory written only once.
+    //
+    if (!new_files.empty())
+    {
+        int err = volume->add_new_files(new_files);
+        if (err < 0)
+        {
+            explain_output_error_and_die
+            (
+                "%s: put: %s",
+                disk_image_filename.c_str(),
+                strerror(-err)
+            );
+        }
+    }
+
+    //
+    // "Crunch" means to move all of the files as far forward in the
+    // volume as possible.
+    //
+    if (crunch_flag)
+        volume->crunch();
+
+    if (txn)
+    {
+        int err = txn->commit();
+        if (err < 0)
+        {
+            explain_output_error_and_die
+            (
+                "%s: write directory: %s",
+                disk_image_filename.c_str(),
+                strerror(-err)
+            );
+        }
+    }
+
+    //
+    // The wipe-unused flags menas to make sure that all blocks not
+    // accounted for in the directory are reset to zero, wiping any
+    // "left over" content.  Not only is this more secure (things you
+    // didn't intent to stay on this disk don't) but this disk images
+    // compress better, too.
+    //
+    if (wipe_flag)
+    {
+        int err = volume->wipe_unused();
+        if (err < 0)
+        {
+            explain_output_error_and_die
+            (
+                "%s: wipe unused: %s",
+                disk_image_filename.c_str(),
+                strerror(-err)
+            );
+        }
+    }
+
+    //
+    // Show the contents of the volume.
+    //
+    if (listing_flag)
+        volume->print_listing(listing_flag >= 2, sort_by, fp);
+
+    //
+    // Set the boot sectors (flat binary file).
+    //
+    if (boot_blocks)
+    {
+        if (put_flag)
+            volume->set_boot_blocks(boot_blocks);
+        else
+            volume->get_boot_blocks(boot_blocks);
+    }
+
+    //
+    // Close down the volume (when volume goes out of scope).
+    // This may do essential flush operations.
+    //
+}
+
+
 int
 main(int argc, char **argv)
 {
     explain_program_name_set(argv[0]);
     explain_option_hanging_indent_set(4);
-    int listing_flag = 0;
-    bool get_flag = false;
-    bool put_flag = false;
-    bool crunch_flag = false;
-    bool remove_flag = false;
     const char *disk_image_filename = 0;
-    bool text_on_the_fly = false;
-    bool skip_dot = true;
-    bool wipe_flag = false;
-    directory::sort_by_t sort_by = directory::sort_by_block;
-    const char *boot_blocks = 0;
     bool check_for_system_volume = false;
+    const char *batch_list = 0;
+    unsigned jobs = 0;
+    const char *summary_filename = 0;
     for (;;)
     {
         static struct option options[] =
@@ -312,25 +776,33 @@ main(int argc, char **argv)
             { "all", 0, 0, 'A' }, // similar to ls(1)
             { "all-binary", 0, 0, 'B' },
             { "almost-all", 0, 0, 'A' }, // like ls(1)
+            { "batch", 1, 0, 'F' },
             { "boot", 1, 0, 'b' },
+            { "check", 0, 0, 'c' },
+            { "copy", 0, 0, 'C' },
             { "crunch", 0, 0, 'k' },
             { "debug", 0, 0, 'D' },
             { "defragment", 0, 0, 'k' },
             { "file", 1, 0, 'f' },
             { "get", 0, 0, 'g' },
+            { "jobs", 1, 0, 'j' },
             { "list", 0, 0, 'l' },
             { "no-skip-dot", 0, 0, 'A' },
             { "put", 0, 0, 'p' },
+            { "put-tar", 1, 0, 'P' },
             { "remove", 0, 0, 'r' },
             { "sort", 1, 0, 's' },
             { "squeeze", 0, 0, 'k' },
+            { "summary", 1, 0, 'Z' },
             { "system-volume", 0, 0, 'S' },
+            { "tar", 1, 0, 'T' },
             { "text", 0, 0, 't' },
             { "version", 0, 0, 'V' },
             { "wipe-unused", 0, 0, 'w' },
             { 0, 0, 0, 0 }
         };
-        int c = getopt_long(argc, argv, "ABb:Df:gklprSs:tVw", options, 0);
+        int c =
+            getopt_long(argc, argv, "ABb:CcDF:f:gj:klPprSs:T:tVw", options, 0);
         if (c == EOF)
             break;
         switch (c)
@@ -347,10 +819,22 @@ main(int argc, char **argv)
             boot_blocks = optarg;
             break;
 
+        case 'C':
+            copy_flag = true;
+            break;
+
+        case 'c':
+            check_flag = true;
+            break;
+
         case 'D':
             ++debug_level;
             break;
 
+        case 'F':
+            batch_list = optarg;
+            break;
+
         case 'f':
             disk_image_filename = optarg;
             break;
@@ -359,6 +843,12 @@ main(int argc, char **argv)
             get_flag = true;
             break;
 
+        case 'j':
+            jobs = atoi(optarg);
+            if (jobs < 1)
+                usage();
+            break;
+
         case 'k':
             crunch_flag = true;
             break;
@@ -367,6 +857,11 @@ main(int argc, char **argv)
             ++listing_flag;
             break;
 
+        case 'P':
+            put_flag = true;
+            tar_filename = optarg;
+            break;
+
         case 'p':
             put_flag = true;
             break;
@@ -383,6 +878,10 @@ main(int argc, char **argv)
             sort_by = decode_sort_name(optarg);
             break;
 
+        case 'T':
+            tar_filename = optarg;
+            break;
+
         case 't':
             // Have the file system implementation transparently translate
             // text files as they are read and written.
@@ -401,17 +900,70 @@ main(int argc, char **argv)
             wipe_flag = true;
             break;
 
+        case 'Z':
+            summary_filename = optarg;
+            break;
+
         default:
             usage();
         }
     }
-    if (!disk_image_filename)
+    if (batch_list)
+    {
+        if (disk_image_filename)
+        {
+            explain_output_error_and_die
+            (
+                "the --batch option may not be used with the --file option"
+            );
+        }
+        if (boot_blocks || check_for_system_volume || tar_filename)
+        {
+            explain_output_error_and_die
+            (
+                "the --batch option may not be used with the --boot, "
+                "--system-volume or --tar options"
+            );
+        }
+        if (get_flag && optind + 1 != argc)
+        {
+            explain_output_error_and_die
+            (
+                "the --batch option, with the --get option, needs exactly "
+                "one directory to get the files into"
+            );
+        }
+    }
+    else if (!disk_image_filename)
     {
         if (optind >= argc)
             explain_output_error_and_die("no disk image file name specified");
         // Ugly, but probably what the user meant.
         disk_image_filename = argv[optind++];
     }
+    if (tar_filename)
+    {
+        if (remove_flag || boot_blocks)
+        {
+            explain_output_error_and_die
+            (
+                "the --tar option may not be used with the --remove or --boot "
+                "options"
+            );
+        }
+        if (!put_flag)
+        {
+            if (optind < argc)
+            {
+                explain_output_error_and_die
+                (
+                    "the --tar option gets all of the files, it may not be "
+                    "used with file names"
+                );
+            }
+            get_flag = true;
+        }
+    }
     if (boot_blocks && put_flag + get_flag != 1)
     {
         explain_output_error_and_die
@@ -431,13 +983,17 @@ main(int argc, char **argv)
         !put_flag
     &&
         !remove_flag
+    &&
+        !copy_flag
     &&
         !crunch_flag
     &&
         !wipe_flag
+    &&
+        !check_flag
     )
         listing_flag = 1;
-    if (get_flag + put_flag + remove_flag > 1)
+    if (get_flag + put_flag + remove_flag + copy_flag > 1)
         usage();
     if
     (
@@ -450,88 +1006,44 @@ main(int argc, char **argv)
         !put_flag
     &&
         !remove_flag
+    &&
+        !copy_flag
     )
         usage();
+    while (optind < argc)
+        file_args.push_back(argv[optind++]);
 
     //
-    // Open the volume, and make sure it has the right format.
+    // Do the same thing to many disk images at once.
     //
-    bool read_only_flag =
-        !put_flag && !remove_flag && !crunch_flag && !wipe_flag;
-    directory *volume = directory::factory(disk_image_filename, read_only_flag);
+    if (batch_list)
+    {
+        rcstring_list images;
+        batch_read_list(batch_list, images);
+        FILE *summary =
+            (
+                summary_filename
+            ?
+                explain_fopen_or_die(summary_filename, "w")
+            :
+                stderr
+            );
+        batch_mode = true;
+        size_t failures = batch_run(images, process, jobs, summary);
+        if (summary != stderr)
+            explain_fclose_or_die(summary);
+        return (failures ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
+
     if (check_for_system_volume)
     {
+        directory *volume = directory::factory(disk_image_filename, true);
         if (!volume->check_for_system_files())
             return EXIT_FAILURE;
         return EXIT_SUCCESS;
     }
-    if (text_on_the_fly)
-        volume->convert_text_on_the_fly();
-
-    //
-    // Chew on the volume, as requested.
-    //
-    while (optind < argc)
-    {
-        rcstring filename = argv[optind++];
-        if (put_flag)
-        {
-            if (is_a_directory(filename))
-                put_dir(volume, filename, skip_dot);
-            else
-                put(volume, filename);
-        }
-        if (get_flag)
-        {
-            if (is_a_directory(filename))
-                get_dir(volume, filename);
-            else
-                get(volume, filename);
-        }
-        if (remove_flag)
-            remove(volume, filename);
-    }
-
-    //
-    // "Crunch" means to move all of the files as far forward in the
-    // volume as possible.
-    //
-    if (crunch_flag)
-        volume->crunch();
-
-    //
-    // The wipe-unused flags menas to make sure that all blocks not
-    // accounted for in the directory are reset to zero, wiping any
-    // "left over" content.  Not only is this more secure (things you
-    // didn't intent to stay on this disk don't) but this disk images
-    // compress better, too.
-    //
-    if (wipe_flag)
-        volume->wipe_unused();
-
-    //
-    // Show the contents of the volume.
-    //
-    if (listing_flag)
-        volume->print_listing(listing_flag >= 2, sort_by);
-
-    //
-    // Set the boot sectors (flat binary file).
-    //
-    if (boot_blocks)
-    {
-        if (put_flag)
-            volume->set_boot_blocks(boot_blocks);
-        else
-            volume->get_boot_blocks(boot_blocks);
-    }
 
-    //
-    // Close down the volume.
-    // This may do essential flush operations.
-    //
-    delete volume;
-    volume = 0;
+    process(disk_image_filename, stdout);
 
     //
     // Report success
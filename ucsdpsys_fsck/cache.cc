@@ -0,0 +1,182 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cstdlib>
+#include <fcntl.h>
+#include <vector>
+
+#include <lib/explain_mt.h>
+#include <lib/fnv1a.h>
+#include <lib/tab_file.h>
+
+#include <ucsdpsys_fsck/cache.h>
+
+
+fsck_cache::~fsck_cache()
+{
+}
+
+
+fsck_cache::fsck_cache(const rcstring &a_filename) :
+    filename(a_filename)
+{
+}
+
+
+static bool
+parse_line(const rcstring &line, rcstring &image, fsck_cache::entry &e)
+{
+    rcstring f[8];
+    if (!tab_file_split(line, f, 8) || f[7].empty())
+        return false;
+
+    char *ep = 0;
+    e.size = strtoll(f[0].c_str(), &ep, 10);
+    if (f[0].empty() || *ep)
+        return false;
+    e.mtime = strtol(f[1].c_str(), &ep, 10);
+    if (f[1].empty() || *ep)
+        return false;
+    e.mtime_nsec = strtol(f[2].c_str(), &ep, 10);
+    if (f[2].empty() || *ep)
+        return false;
+    e.deep = (f[3] == "deep");
+    e.hash = f[4];
+    e.interleave = f[5];
+    e.volume = f[6];
+    image = f[7];
+    return true;
+}
+
+
+void
+fsck_cache::read(void)
+{
+    rcstring_list lines;
+    tab_file_read(filename, lines);
+
+    mutex::locker locked(lock);
+    for (size_t j = 0; j < lines.size(); ++j)
+    {
+        rcstring image;
+        entry e;
+        if (parse_line(lines[j], image, e))
+            entries[image] = e;
+    }
+}
+
+
+void
+fsck_cache::write(void) const
+{
+    FILE *fp = tab_file_create(filename, "ucsdpsys_fsck cache");
+    {
+        mutex::locker locked(lock);
+        for
+        (
+            entries_t::const_iterator it = entries.begin();
+            it != entries.end();
+            ++it
+        )
+        {
+            const entry &e = it->second;
+            fprintf
+            (
+                fp,
+                "%lld\t%ld\t%ld\t%s\t%s\t%s\t%s\t%s\n",
+                (long long)e.size,
+                (long)e.mtime,
+                e.mtime_nsec,
+                (e.deep ? "deep" : "check"),
+                e.hash.c_str(),
+                e.interleave.c_str(),
+                e.volume.c_str(),
+                it->first.c_str()
+            );
+        }
+    }
+    tab_file_commit(fp, filename);
+}
+
+
+bool
+fsck_cache::lookup(const rcstring &image, const struct stat &st,
+    entry &result, rcstring &hash, bool deep) const
+{
+    {
+        mutex::locker locked(lock);
+        entries_t::const_iterator it = entries.find(image);
+        if (it == entries.end())
+            return false;
+        result = it->second;
+    }
+    if
+    (
+        (deep && !result.deep)
+    ||
+        result.size != st.st_size
+    ||
+        result.mtime != st.st_mtim.tv_sec
+    ||
+        result.mtime_nsec != st.st_mtim.tv_nsec
+    )
+        return false;
+
+    //
+    // The size and time look right, but that can be arranged (touch -r,
+    // copies which preserve the time, clocks with coarse resolution), so
+    // check the contents, too.
+    //
+    hash = hash_file(image);
+    return (hash == result.hash);
+}
+
+
+void
+fsck_cache::remember(const rcstring &image, const entry &value)
+{
+    mutex::locker locked(lock);
+    entries[image] = value;
+}
+
+
+void
+fsck_cache::forget(const rcstring &image)
+{
+    mutex::locker locked(lock);
+    entries.erase(image);
+}
+
+
+rcstring
+fsck_cache::hash_file(const rcstring &a_filename)
+{
+    int fd = explain_mt_open_or_die(a_filename.c_str(), O_RDONLY, 0);
+    unsigned long long hash = fnv1a_64(0, 0);
+    std::vector<unsigned char> buffer(1 << 16);
+    for (;;)
+    {
+        ssize_t n = explain_mt_read_or_die(fd, &buffer[0], buffer.size());
+        if (n <= 0)
+            break;
+        hash = fnv1a_64(&buffer[0], n, hash);
+    }
+    explain_mt_close_or_die(fd);
+    return rcstring::printf("%016llx", hash);
+}
@@ -0,0 +1,172 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#ifndef UCSDPSYS_FSCK_CACHE_H
+#define UCSDPSYS_FSCK_CACHE_H
+
+#include <map>
+#include <sys/stat.h>
+
+#include <lib/mutex.h>
+#include <lib/rcstring.h>
+
+/**
+  * The fsck_cache class is used to remember which disk images were
+  * found to be clean, from one run to the next, so that images which
+  * have not changed need not be checked again.
+  *
+  * An image is taken to be unchanged if its size and modification time
+  * are the same as before, and so is a hash of its contents.
+  *
+  * All of the methods may be called from several threads at once.
+  */
+class fsck_cache
+{
+public:
+    /**
+      * The destructor.
+      */
+    virtual ~fsck_cache();
+
+    /**
+      * The constructor.
+      *
+      * @param filename
+      *     The file in which the cache is kept between runs.
+      */
+    fsck_cache(const rcstring &filename);
+
+    /**
+      * The entry class is used to remember what is known about a clean
+      * disk image.
+      */
+    struct entry
+    {
+        entry() : size(0), mtime(0), mtime_nsec(0), deep(false) { }
+
+        off_t size;
+        time_t mtime;
+        long mtime_nsec;
+        bool deep;
+        rcstring hash;
+        rcstring interleave;
+        rcstring volume;
+    };
+
+    /**
+      * The read method is used to read the cache file, if it exists.
+      */
+    void read(void);
+
+    /**
+      * The write method is used to replace the cache file with the
+      * present contents of the cache.
+      */
+    void write(void) const;
+
+    /**
+      * The lookup method is used to find a disk image in the cache.
+      * The contents of the image are only hashed when its size and
+      * modification time match.
+      *
+      * @param image
+      *     The file name of the disk image.
+      * @param st
+      *     The file's present status, from stat(2).
+      * @param result
+      *     Where to put what was known about the disk image.
+      * @param hash
+      *     Where to put the hash of the file's contents, if it was
+      *     calculated; otherwise it is left alone.
+      * @param deep
+      *     Whether the disk image must have been found clean by a deep
+      *     check (see directory::fsck_deep).
+      * @returns
+      *     true if the disk image was clean, and has not changed since,
+      *     false if it must be checked.
+      */
+    bool lookup(const rcstring &image, const struct stat &st, entry &result,
+        rcstring &hash, bool deep) const;
+
+    /**
+      * The remember method is used to add a clean disk image to the
+      * cache, or to update one already there.
+      *
+      * @param image
+      *     The file name of the disk image.
+      * @param value
+      *     What is known about the disk image.
+      */
+    void remember(const rcstring &image, const entry &value);
+
+    /**
+      * The forget method is used to remove a disk image from the cache,
+      * typically because it is no longer clean.
+      *
+      * @param image
+      *     The file name of the disk image.
+      */
+    void forget(const rcstring &image);
+
+    /**
+      * The hash_file class method is used to calculate a hash (64-bit
+      * FNV-1a, in hexadecimal) of the contents of a file.
+      *
+      * @param filename
+      *     The file to be hashed.
+      */
+    static rcstring hash_file(const rcstring &filename);
+
+private:
+    /**
+      * The filename instance variable is used to remember the file in
+      * which the cache is kept between runs.
+      */
+    rcstring filename;
+
+    typedef std::map<rcstring, entry> entries_t;
+
+    /**
+      * The entries instance variable is used to remember the clean disk
+      * images, indexed by file name.
+      */
+    entries_t entries;
+
+    /**
+      * The lock instance variable is used to serialize access to the
+      * #entries instance variable.
+      */
+    mutable mutex lock;
+
+    /**
+      * The default constructor.  Do not use.
+      */
+    fsck_cache();
+
+    /**
+      * The copy constructor.  Do not use.
+      */
+    fsck_cache(const fsck_cache &);
+
+    /**
+      * The assignment operator.  Do not use.
+      */
+    fsck_cache &operator=(const fsck_cache &);
+};
+
+#endif // UCSDPSYS_FSCK_CACHE_H
@@ -1,6 +1,6 @@
 //
 // UCSD p-System filesystem in user space
-// Copyright (C) 2006, 2007, 2010 Peter Miller
+// Copyright (C) 2006, 2007, 2010, 2026 Peter Miller
 //
 // This program is free software; you can redistribute it and/or modify
 // it under the terms of the GNU General Public License as published by
@@ -18,26 +18,152 @@
 
 #include <lib/config.h>
 #include <cstdio>
+#include <cstdlib>
 #include <getopt.h>
 #include <libexplain/output.h>
 #include <libexplain/program_name.h>
+#include <sys/stat.h>
 #include <unistd.h>
+#include <boost/scoped_ptr.hpp>
+#include <vector>
 
+#include <lib/batch.h>
 #include <lib/debug.h>
 #include <lib/directory.h>
+#include <lib/explain_mt.h>
+#include <lib/rcstring/accumulator.h>
 #include <lib/version.h>
 
+#include <ucsdpsys_fsck/cache.h>
+
 
 static void
 usage(void)
 {
     const char *prog = explain_program_name_get();
     fprintf(stderr, "Usage: %s [ <option>... ] <volume>\n", prog);
+    fprintf(stderr, "       %s --corpus [ --deep ][ -j <n> ]"
+        "[ --cache=<file> ] <path>...\n", prog);
     fprintf(stderr, "       %s --version\n", prog);
     exit(1);
 }
 
 
+/**
+  * The cache variable is used to remember the results of previous runs,
+  * or NULL if there is no cache.
+  */
+static fsck_cache *cache;
+
+/**
+  * The deep_flag variable is used to remember whether or not the
+  * contents of the files are to be checked, too.
+  */
+static bool deep_flag;
+
+
+static rcstring
+errors_json(const directory *volume)
+{
+    rcstring_accumulator ac;
+    ac.push_back('{');
+    for (int j = 0; j < directory::fsck_class_max; ++j)
+    {
+        directory::fsck_class_t which = (directory::fsck_class_t)j;
+        if (j)
+            ac.push_back(", ");
+        ac.printf
+        (
+            "\"%s\": %d",
+            directory::fsck_class_name(which),
+            (volume ? volume->get_fsck_errors(which) : 0)
+        );
+    }
+    ac.push_back('}');
+    return ac.mkstr();
+}
+
+
+/**
+  * The check_one function is used to check one disk image of a corpus.
+  * What was found is added to the image's summary line.  Images with
+  * format errors are reported as failed.
+  *
+  * @param image
+  *     The file name of the disk image.
+  */
+static void
+check_one(const rcstring &image, FILE *)
+{
+    struct stat st;
+    explain_mt_stat_or_die(image.c_str(), &st);
+
+    rcstring hash;
+    if (cache)
+    {
+        fsck_cache::entry prev;
+        if (cache->lookup(image, st, prev, hash, deep_flag))
+        {
+            batch_note("volume", prev.volume.quote_json());
+            batch_note("interleave", prev.interleave.quote_json());
+            batch_note("deep", (deep_flag ? "true" : "false"));
+            batch_note("errors", errors_json(0));
+            batch_note("cached", "true");
+            return;
+        }
+        cache->forget(image);
+    }
+
+    rcstring interleave;
+    boost::scoped_ptr<directory> volume
+    (
+        directory::try_factory(image, true, interleave, concern_check)
+    );
+    if (!volume)
+    {
+        explain_output_error_and_die
+        (
+            "%s: unable to find a UCSD p-System volume",
+            image.c_str()
+        );
+    }
+    if (deep_flag)
+        volume->fsck_deep(1);
+    batch_note("volume", volume->get_volume_name().quote_json());
+    batch_note("interleave", interleave.quote_json());
+    batch_note("deep", (deep_flag ? "true" : "false"));
+    batch_note("errors", errors_json(volume.get()));
+    batch_note("cached", "false");
+
+    int err = 0;
+    for (int j = 0; j < directory::fsck_class_max; ++j)
+        err += volume->get_fsck_errors((directory::fsck_class_t)j);
+    if (err > 0)
+    {
+        explain_output_error_and_die
+        (
+            "%s: found %d format error%s",
+            image.c_str(),
+            err,
+            (err == 1 ? "" : "s")
+        );
+    }
+
+    if (cache)
+    {
+        fsck_cache::entry e;
+        e.size = st.st_size;
+        e.mtime = st.st_mtim.tv_sec;
+        e.mtime_nsec = st.st_mtim.tv_nsec;
+        e.deep = deep_flag;
+        e.hash = (hash.empty() ? fsck_cache::hash_file(image) : hash);
+        e.interleave = interleave;
+        e.volume = volume->get_volume_name();
+        cache->remember(image, e);
+    }
+}
+
+
 int
 main(int argc, char **argv)
 {
@@ -49,21 +175,40 @@ main(int argc, char **argv)
     //
     concern_t concern_level = concern_check;
     bool read_only_flag = false;
+    bool corpus_flag = false;
+    unsigned jobs = 0;
+    const char *cache_filename = 0;
     for (;;)
     {
         static const struct option options[] =
         {
+            { "cache", 1, 0, 'c' },
+            { "corpus", 0, 0, 'C' },
             { "debug", 0, 0, 'D' },
+            { "deep", 0, 0, 'd' },
             { "fix", 0, 0, 'f' },
+            { "jobs", 1, 0, 'j' },
             { "read-only", 0, 0, 'r' },
             { "version", 0, 0, 'V' },
             { 0, 0, 0, 0 }
         };
-        int c = getopt_long(argc, argv, "DfrV", options, 0);
+        int c = getopt_long(argc, argv, "c:CdDfj:rV", options, 0);
         if (c < 0)
             break;
         switch (c)
         {
+        case 'c':
+            cache_filename = optarg;
+            break;
+
+        case 'C':
+            corpus_flag = true;
+            break;
+
+        case 'd':
+            deep_flag = true;
+            break;
+
         case 'D':
             ++debug_level;
             break;
@@ -72,6 +217,17 @@ main(int argc, char **argv)
             concern_level = concern_repair;
             break;
 
+        case 'j':
+            jobs = atoi(optarg);
+            if (jobs < 1)
+            {
+                explain_output_error_and_die
+                (
+                    "the --jobs option needs a positive number"
+                );
+            }
+            break;
+
         case 'r':
             // read only
             read_only_flag = true;
@@ -85,6 +241,53 @@ main(int argc, char **argv)
             usage();
         }
     }
+    if (corpus_flag)
+    {
+        if (optind >= argc)
+            usage();
+        if (concern_level == concern_repair)
+        {
+            explain_output_error_and_die
+            (
+                "unable to fix problems (--fix) with the --corpus option"
+            );
+        }
+
+        rcstring_list images;
+        for (int j = optind; j < argc; ++j)
+            batch_walk(argv[j], images);
+
+        boost::scoped_ptr<fsck_cache> cache_ptr;
+        if (cache_filename)
+        {
+            cache_ptr.reset(new fsck_cache(cache_filename));
+            cache_ptr->read();
+            cache = cache_ptr.get();
+        }
+
+        size_t failures = batch_run(images, check_one, jobs, stdout);
+
+        if (cache)
+        {
+            cache->write();
+            cache = 0;
+        }
+        return (failures ? 1 : 0);
+    }
+    if (cache_filename)
+    {
+        explain_output_error_and_die
+        (
+            "the --cache option needs the --corpus option"
+        );
+    }
+    if (jobs && !deep_flag)
+    {
+        explain_output_error_and_die
+        (
+            "the --jobs option needs the --corpus or --deep option"
+        );
+    }
     if (optind + 1 != argc)
         usage();
     const char *filename = argv[optind];
@@ -107,6 +310,24 @@ main(int argc, char **argv)
         directory::factory(filename, read_only_flag, concern_level);
     assert(volume);
 
+    //
+    // Check the contents of the files, too, if asked.
+    //
+    if (deep_flag)
+    {
+        int err = volume->fsck_deep(jobs);
+        if (err > 0)
+        {
+            explain_output_error
+            (
+                "%s: warning: found %d format error%s in file contents",
+                filename,
+                err,
+                (err == 1 ? "" : "s")
+            );
+        }
+    }
+
     //
     // Close down the volume.
     // This may do essential flush operations.
@@ -27,6 +27,7 @@
 
 #include <lib/debug.h>
 #include <lib/sector_io/apple.h>
+#include <lib/sector_io/chunked.h>
 #include <lib/sector_io/imd.h>
 #include <lib/sector_io/offset.h>
 #include <lib/sector_io/pdp.h>
@@ -39,8 +40,10 @@ static void
 usage(void)
 {
     const char *prog = explain_program_name_get();
-    fprintf(stderr, "Usage: %s -T<name> -d <infile> <outfile>\n", prog);
-    fprintf(stderr, "       %s -T<name> -e <infile> <outfile>\n", prog);
+    fprintf(stderr, "Usage: %s [ -c ] -T<name> -d <infile> <outfile>\n",
+        prog);
+    fprintf(stderr, "       %s [ -c ] -T<name> -e <infile> <outfile>\n",
+        prog);
     fprintf(stderr, "       %s -V\n", prog);
     exit(1);
 }
@@ -86,10 +89,12 @@ main(int argc, char **argv)
     const char *interleave_type_name = 0;
     bool encode_flag = false;
     bool decode_flag = false;
+    bool chunked_flag = false;
     for (;;)
     {
         static const struct option options[] =
         {
+            { "chunked", 0, 0, 'c' },
             { "debug", 0, 0, 'D' },
             { "decode", 0, 0, 'd' },
             { "encode", 0, 0, 'e' },
@@ -97,11 +102,15 @@ main(int argc, char **argv)
             { "version", 0, 0, 'V' },
             { 0, 0, 0, 0 }
         };
-        int c = getopt_long(argc, argv, "DdeT:V", options, 0);
+        int c = getopt_long(argc, argv, "cDdeT:V", options, 0);
         if (c == EOF)
             break;
         switch (c)
         {
+        case 'c':
+            chunked_flag = true;
+            break;
+
         case 'D':
             ++debug_level;
             break;
@@ -157,7 +166,14 @@ main(int argc, char **argv)
         inp = filter_factory(inp, interleave_type_name);
 
     DEBUG(1, "open output (%s)", outfile);
-    sector_io::pointer outp = sector_io_raw::create(outfile, false);
+    sector_io::pointer outp =
+        (
+            chunked_flag
+        ?
+            sector_io_chunked::create_new(outfile)
+        :
+            sector_io_raw::create(outfile, false)
+        );
     if (encode_flag)
         outp = filter_factory(outp, interleave_type_name);
 
@@ -0,0 +1,813 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <map>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <vector>
+
+#include <lib/debug.h>
+#include <lib/mutex.h>
+
+#include <ucsdpsys_mount/collection.h>
+#include <ucsdpsys_mount/image.h>
+#include <ucsdpsys_mount/op_stats.h>
+
+
+//
+// Each node ID refers to a host directory, a disk image (which looks
+// like a directory), or a file within a disk image.
+//
+enum node_kind_t
+{
+    node_host_directory,
+    node_volume,
+    node_file
+};
+
+struct node_t
+{
+    node_t() : kind(node_host_directory), nlookup(0) { }
+
+    node_kind_t kind;
+
+    // The path of the host directory or host file.
+    rcstring path;
+
+    // The name of the file within the disk image.
+    rcstring name;
+
+    // The disk image, for node_volume and node_file.
+    image::pointer img;
+
+    // The number of times the kernel has been handed this node ID and
+    // not yet forgotten it.
+    unsigned long nlookup;
+};
+
+
+//
+// Node IDs are handed out by lookup requests, the first time a name is
+// seen, and withdrawn when the kernel has forgotten them as many times
+// as they were handed out.  They are never reused (the next node ID
+// only ever increases) so the generation number is always zero, and
+// the node ID can also be the inode number.
+//
+// A disk image is shared by the nodes of the volume and of its files.
+// It is also kept when only readdir has seen it, so that a directory
+// of disk images is sniffed once, not every time it is listed.  It is
+// discarded, if nothing else is using it, when the last of its nodes
+// is forgotten, or when a readdir of its host directory finds that the
+// host file has gone.
+//
+typedef std::map<fuse_ino_t, node_t> nodes_t;
+static nodes_t nodes;
+static fuse_ino_t next_node_id = FUSE_ROOT_ID;
+static std::map<rcstring, fuse_ino_t> node_ids;
+typedef std::map<rcstring, image::pointer> images_t;
+static images_t images;
+static mutex table_lock;
+
+static double attr_timeout;
+static double entry_timeout;
+
+//
+// The inode number given to readdir for a name which has not been
+// looked up, and so has no node ID yet.  The same value is used by the
+// libfuse high-level API for the same purpose.
+//
+enum { unknown_ino = 0xFFFFFFFF };
+
+
+/**
+  * The node_key function is used to obtain the key of a node in the
+  * node_ids table.
+  */
+static rcstring
+node_key(const node_t &n)
+{
+    //
+    // Host paths never contain "//", and file names never contain "/",
+    // so the key is unambiguous.
+    //
+    return (n.kind == node_file ? n.path + "//" + n.name : n.path);
+}
+
+
+/**
+  * The get_image function is used to obtain the disk image object for
+  * a host file, creating it if it has not been seen before.
+  */
+static image::pointer
+get_image(const rcstring &path)
+{
+    mutex::locker hold_table(table_lock);
+    image::pointer &ip = images[path];
+    if (!ip)
+        ip = image::create(path);
+    return ip;
+}
+
+
+/**
+  * The drop_image function is used to discard a disk image object if
+  * nothing else is using it.  The caller must hold the table_lock.
+  */
+static void
+drop_image(images_t::iterator it)
+{
+    if (it->second.use_count() == 1)
+    {
+        DEBUG(2, "%s: discard", it->first.c_str());
+        images.erase(it);
+    }
+}
+
+
+/**
+  * The remember function is used to obtain the node ID for a host
+  * directory, disk image or file, handing out a new one if it has not
+  * been seen before, and to count one more lookup of it by the kernel.
+  */
+static fuse_ino_t
+remember(const node_t &n)
+{
+    rcstring key = node_key(n);
+    mutex::locker hold_table(table_lock);
+    std::map<rcstring, fuse_ino_t>::const_iterator it = node_ids.find(key);
+    if (it != node_ids.end())
+    {
+        ++nodes[it->second].nlookup;
+        return it->second;
+    }
+
+    fuse_ino_t ino = next_node_id++;
+    node_t &nn = nodes[ino];
+    nn = n;
+    nn.nlookup = 1;
+    node_ids[key] = ino;
+    return ino;
+}
+
+
+/**
+  * The known_node_id function is used to obtain the node ID of a host
+  * directory, disk image or file, without handing out a new one.
+  *
+  * @returns
+  *     the node ID, or unknown_ino if it has none.
+  */
+static fuse_ino_t
+known_node_id(const node_t &n)
+{
+    rcstring key = node_key(n);
+    mutex::locker hold_table(table_lock);
+    std::map<rcstring, fuse_ino_t>::const_iterator it = node_ids.find(key);
+    return (it == node_ids.end() ? (fuse_ino_t)unknown_ino : it->second);
+}
+
+
+/**
+  * The forget_node function is used to count down the kernel's lookups
+  * of a node ID, discarding the node (and, if nothing else is using it,
+  * its disk image) when the count reaches zero.
+  */
+static void
+forget_node(fuse_ino_t ino, unsigned long nlookup)
+{
+    if (ino == FUSE_ROOT_ID)
+        return;
+    mutex::locker hold_table(table_lock);
+    nodes_t::iterator it = nodes.find(ino);
+    if (it == nodes.end())
+        return;
+    node_t &n = it->second;
+    if (n.nlookup > nlookup)
+    {
+        n.nlookup -= nlookup;
+        return;
+    }
+    DEBUG(2, "forget %lu", (unsigned long)ino);
+    rcstring path = n.path;
+    bool has_image = !!n.img;
+    node_ids.erase(node_key(n));
+    nodes.erase(it);
+    if (has_image)
+    {
+        images_t::iterator ip = images.find(path);
+        if (ip != images.end())
+            drop_image(ip);
+    }
+}
+
+
+/**
+  * The drop_missing_images function is used to discard the disk image
+  * objects of host files which are no longer in the given host
+  * directory, unless something is still using them.
+  *
+  * @param dir
+  *     The path of the host directory.
+  * @param names
+  *     The names in the host directory, sorted.
+  */
+static void
+drop_missing_images(const rcstring &dir, const rcstring_list &names)
+{
+    rcstring prefix = (dir == "/" ? dir : dir + "/");
+    mutex::locker hold_table(table_lock);
+    images_t::iterator it = images.lower_bound(prefix);
+    while (it != images.end())
+    {
+        const rcstring &path = it->first;
+        if
+        (
+            path.size() <= prefix.size()
+        ||
+            0 != memcmp(path.c_str(), prefix.c_str(), prefix.size())
+        )
+            break;
+        images_t::iterator next = it;
+        ++next;
+        rcstring name = path.substring(prefix.size(), path.size() - prefix.size());
+        if (!strchr(name.c_str(), '/') && !names.member(name))
+            drop_image(it);
+        it = next;
+    }
+}
+
+
+/**
+  * The find_node function is used to obtain a copy of the node for the
+  * given node ID.
+  *
+  * @returns
+  *     zero on success, -ESTALE if the node ID is not known.
+  */
+static int
+find_node(fuse_ino_t ino, node_t &n)
+{
+    mutex::locker hold_table(table_lock);
+    nodes_t::const_iterator it = nodes.find(ino);
+    if (it == nodes.end())
+        return -ESTALE;
+    n = it->second;
+    return 0;
+}
+
+
+/**
+  * The get_attr function is used to obtain the attributes of a node.
+  *
+  * @param ino
+  *     The inode number to report.
+  * @param n
+  *     The node of interest.
+  * @param st
+  *     Where to put the attributes.
+  * @returns
+  *     zero on success, -errno on error.
+  */
+static int
+get_attr(fuse_ino_t ino, const node_t &n, struct stat *st)
+{
+    memset(st, 0, sizeof(*st));
+    int err = 0;
+    switch (n.kind)
+    {
+    case node_host_directory:
+        if (::stat(n.path.c_str(), st) < 0)
+            return -errno;
+        if (!S_ISDIR(st->st_mode))
+            return -ENOENT;
+        st->st_mode &= ~(S_IWUSR | S_IWGRP | S_IWOTH);
+        break;
+
+    case node_volume:
+        err = n.img->check();
+        if (err >= 0)
+            err = n.img->getattr("", st);
+        break;
+
+    case node_file:
+        err = n.img->getattr(n.name, st);
+        break;
+    }
+    if (err < 0)
+        return err;
+    st->st_ino = ino;
+    return 0;
+}
+
+
+/**
+  * The find_child function is used to locate a name within a host
+  * directory or a disk image.  No node ID is handed out.
+  *
+  * @param n
+  *     The node of the directory to search.
+  * @param name
+  *     The name to search for.
+  * @param child
+  *     Where to put the node of the child.
+  * @param st
+  *     Where to put the attributes of the child.  The inode number is
+  *     the child's node ID, if it has one, or unknown_ino if not.
+  * @returns
+  *     zero on success, -errno on error.
+  */
+static int
+find_child(const node_t &n, const rcstring &name, node_t &child,
+    struct stat *st)
+{
+    switch (n.kind)
+    {
+    case node_host_directory:
+        {
+            if (name == "." || name == "..")
+                return -ENOENT;
+            child.path = (n.path == "/" ? n.path : n.path + "/") + name;
+            struct stat host;
+            if (::stat(child.path.c_str(), &host) < 0)
+                return -errno;
+            if (S_ISDIR(host.st_mode))
+                child.kind = node_host_directory;
+            else if (S_ISREG(host.st_mode) || S_ISBLK(host.st_mode))
+            {
+                child.kind = node_volume;
+                child.img = get_image(child.path);
+            }
+            else
+                return -ENOENT;
+        }
+        break;
+
+    case node_volume:
+        {
+            struct stat dummy;
+            int err = n.img->getattr(name, &dummy);
+            if (err < 0)
+                return err;
+            child.kind = node_file;
+            child.path = n.path;
+            child.name = name.upcase();
+            child.img = n.img;
+        }
+        break;
+
+    case node_file:
+        return -ENOTDIR;
+    }
+    return get_attr(known_node_id(child), child, st);
+}
+
+
+static void
+lookup_callback(fuse_req_t req, fuse_ino_t parent, const char *name)
+{
+    op_stats::timer timing(op_stats::op_lookup);
+    DEBUG(1, "lookup(parent = %lu, name = \"%s\")", (unsigned long)parent,
+        name);
+    node_t n;
+    int err = find_node(parent, n);
+    fuse_entry_param e;
+    memset(&e, 0, sizeof(e));
+    node_t child;
+    if (err >= 0)
+        err = find_child(n, name, child, &e.attr);
+    if (err == -ENOENT)
+    {
+        //
+        // A node ID of zero tells the kernel to remember that the name
+        // does not exist, for as long as the entry timeout.
+        //
+        e.ino = 0;
+        e.entry_timeout = entry_timeout;
+        fuse_reply_entry(req, &e);
+        return;
+    }
+    if (err < 0)
+    {
+        fuse_reply_err(req, -err);
+        return;
+    }
+    e.ino = remember(child);
+    e.attr.st_ino = e.ino;
+    e.attr_timeout = attr_timeout;
+    e.entry_timeout = entry_timeout;
+    if (fuse_reply_entry(req, &e) != 0)
+        forget_node(e.ino, 1);
+}
+
+
+static void
+forget_callback(fuse_req_t req, fuse_ino_t ino, unsigned long nlookup)
+{
+    op_stats::timer timing(op_stats::op_forget);
+    DEBUG(1, "forget(ino = %lu, nlookup = %lu)", (unsigned long)ino,
+        nlookup);
+    forget_node(ino, nlookup);
+    fuse_reply_none(req);
+}
+
+
+static void
+getattr_callback(fuse_req_t req, fuse_ino_t ino, fuse_file_info *)
+{
+    op_stats::timer timing(op_stats::op_getattr);
+    DEBUG(1, "getattr(ino = %lu)", (unsigned long)ino);
+    node_t n;
+    struct stat st;
+    int err = find_node(ino, n);
+    if (err >= 0)
+        err = get_attr(ino, n, &st);
+    if (err < 0)
+    {
+        fuse_reply_err(req, -err);
+        return;
+    }
+    fuse_reply_attr(req, &st, attr_timeout);
+}
+
+
+static void
+open_callback(fuse_req_t req, fuse_ino_t ino, fuse_file_info *fi)
+{
+    op_stats::timer timing(op_stats::op_open);
+    DEBUG(1, "open(ino = %lu, fi = %p)", (unsigned long)ino, fi);
+    node_t n;
+    int err = find_node(ino, n);
+    if (err < 0)
+    {
+        fuse_reply_err(req, -err);
+        return;
+    }
+    if (n.kind != node_file)
+    {
+        fuse_reply_err(req, EISDIR);
+        return;
+    }
+    if ((fi->flags & O_ACCMODE) != O_RDONLY)
+    {
+        fuse_reply_err(req, EROFS);
+        return;
+    }
+
+    //
+    // Keep the disk image open until the file is released, so that the
+    // same directory entry is used for every read.
+    //
+    n.img->pin();
+    rwlock::reader hold_image(n.img->get_lock());
+    directory_entry::pointer dep = n.img->find(n.name);
+    err = (dep ? dep->open() : -ENOENT);
+    if (err < 0)
+    {
+        n.img->unpin();
+        fuse_reply_err(req, -err);
+        return;
+    }
+    fi->keep_cache = 1;
+    op_stats::page_cache(true);
+    fuse_reply_open(req, fi);
+}
+
+
+static void
+read_callback(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset,
+    fuse_file_info *fi)
+{
+    op_stats::timer timing(op_stats::op_read);
+    DEBUG(1, "read(ino = %lu, size = %ld, offset = %ld, fi = %p)",
+        (unsigned long)ino, (long)size, (long)offset, fi);
+    node_t n;
+    int err = find_node(ino, n);
+    if (err >= 0 && n.kind != node_file)
+        err = -EISDIR;
+    if (err < 0)
+    {
+        fuse_reply_err(req, -err);
+        return;
+    }
+    rwlock::reader hold_image(n.img->get_lock());
+    directory_entry::pointer dep = n.img->find(n.name);
+    if (!dep)
+    {
+        fuse_reply_err(req, ESTALE);
+        return;
+    }
+
+#if FUSE_VERSION >= 29
+    size_t nbytes = size;
+    off_t pos = 0;
+    int fd = dep->get_backing_fd(offset, nbytes, pos, false);
+    if (fd >= 0)
+    {
+        fuse_bufvec bufv = FUSE_BUFVEC_INIT(nbytes);
+        bufv.buf[0].flags = fuse_buf_flags(FUSE_BUF_IS_FD | FUSE_BUF_FD_SEEK);
+        bufv.buf[0].fd = fd;
+        bufv.buf[0].pos = pos;
+        fuse_reply_data(req, &bufv, FUSE_BUF_SPLICE_MOVE);
+        return;
+    }
+#endif
+
+    std::vector<char> buf(size ? size : 1);
+    int nread = dep->read(offset, &buf[0], size);
+    if (nread < 0)
+    {
+        fuse_reply_err(req, -nread);
+        return;
+    }
+    fuse_reply_buf(req, &buf[0], nread);
+}
+
+
+static void
+release_callback(fuse_req_t req, fuse_ino_t ino, fuse_file_info *fi)
+{
+    op_stats::timer timing(op_stats::op_release);
+    DEBUG(1, "release(ino = %lu, fi = %p)", (unsigned long)ino, fi);
+    node_t n;
+    if (find_node(ino, n) >= 0 && n.kind == node_file)
+    {
+        {
+            rwlock::reader hold_image(n.img->get_lock());
+            directory_entry::pointer dep = n.img->find(n.name);
+            if (dep)
+                dep->release();
+        }
+        n.img->unpin();
+    }
+    fuse_reply_err(req, 0);
+}
+
+
+static void
+opendir_callback(fuse_req_t req, fuse_ino_t ino, fuse_file_info *fi)
+{
+    op_stats::timer timing(op_stats::op_opendir);
+    DEBUG(1, "opendir(ino = %lu, fi = %p)", (unsigned long)ino, fi);
+    node_t n;
+    struct stat st;
+    int err = find_node(ino, n);
+    if (err >= 0)
+        err = get_attr(ino, n, &st);
+    if (err >= 0 && !S_ISDIR(st.st_mode))
+        err = -ENOTDIR;
+    if (err < 0)
+    {
+        fuse_reply_err(req, -err);
+        return;
+    }
+    fuse_reply_open(req, fi);
+}
+
+
+/**
+  * The read_host_directory function is used to obtain the names in a
+  * host directory, sorted so that offsets into the list are stable from
+  * one readdir request to the next.
+  */
+static int
+read_host_directory(const rcstring &path, rcstring_list &names)
+{
+    DIR *dp = opendir(path.c_str());
+    if (!dp)
+        return -errno;
+    for (;;)
+    {
+        dirent *dep = readdir(dp);
+        if (!dep)
+            break;
+        rcstring name(dep->d_name);
+        if (name != "." && name != "..")
+            names.push_back(name);
+    }
+    closedir(dp);
+    names.sort();
+    return 0;
+}
+
+
+/**
+  * Read directory
+  *
+  * As for a single volume, the offset of each entry is the index of
+  * the next entry.  Host files which are not disk images are left out,
+  * which means looking at each of them the first time the host
+  * directory is read.
+  */
+static void
+readdir_callback(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset,
+    fuse_file_info *fi)
+{
+    op_stats::timer timing(op_stats::op_readdir);
+    DEBUG(1, "readdir(ino = %lu, size = %ld, offset = %ld, fi = %p)",
+        (unsigned long)ino, (long)size, (long)offset, fi);
+    node_t n;
+    int err = find_node(ino, n);
+    rcstring_list names;
+    if (err >= 0)
+    {
+        if (n.kind == node_host_directory)
+        {
+            err = read_host_directory(n.path, names);
+            if (err >= 0 && offset == 0)
+                drop_missing_images(n.path, names);
+        }
+        else if (n.kind == node_volume)
+            err = n.img->get_names(names);
+        else
+            err = -ENOTDIR;
+    }
+    if (err < 0)
+    {
+        fuse_reply_err(req, -err);
+        return;
+    }
+
+    std::vector<char> buf(size ? size : 1);
+    size_t pos = 0;
+    for (size_t j = offset; j < names.size() + 2; ++j)
+    {
+        struct stat st;
+        memset(&st, 0, sizeof(st));
+        rcstring name;
+        if (j < 2)
+        {
+            name = (j ? ".." : ".");
+            st.st_ino = ino;
+            st.st_mode = S_IFDIR;
+        }
+        else
+        {
+            name = names[j - 2];
+            node_t child;
+            if (find_child(n, name, child, &st) < 0)
+                continue;
+        }
+        size_t len =
+            fuse_add_direntry
+            (
+                req,
+                &buf[pos],
+                size - pos,
+                name.c_str(),
+                &st,
+                j + 1
+            );
+        if (len > size - pos)
+            break;
+        pos += len;
+    }
+    fuse_reply_buf(req, &buf[0], pos);
+}
+
+
+static void
+statfs_callback(fuse_req_t req, fuse_ino_t ino)
+{
+    op_stats::timer timing(op_stats::op_statfs);
+    DEBUG(1, "statfs(ino = %lu)", (unsigned long)ino);
+    node_t n;
+    int err = find_node(ino, n);
+    struct statvfs buf;
+    memset(&buf, 0, sizeof(buf));
+    if (err >= 0)
+    {
+        if (n.kind == node_host_directory)
+            err = (::statvfs(n.path.c_str(), &buf) < 0 ? -errno : 0);
+        else
+            err = n.img->statfs(&buf);
+    }
+    if (err < 0)
+    {
+        fuse_reply_err(req, -err);
+        return;
+    }
+    fuse_reply_statfs(req, &buf);
+}
+
+
+/**
+  * The reply_xattr function is used to reply to the getxattr and
+  * listxattr requests.  If the size is zero, the size of the value is
+  * wanted, otherwise the value itself.
+  */
+static void
+reply_xattr(fuse_req_t req, int n, size_t size, const char *buf)
+{
+    if (n < 0)
+        fuse_reply_err(req, -n);
+    else if (size == 0)
+        fuse_reply_xattr(req, n);
+    else
+        fuse_reply_buf(req, buf, n);
+}
+
+
+/**
+  * Get an extended attribute.  The only one is the statistics of the
+  * root directory, see the ucsdpsys_stat(1) command.
+  */
+static void
+getxattr_callback(fuse_req_t req, fuse_ino_t ino, const char *name,
+    size_t size)
+{
+    op_stats::timer timing(op_stats::op_getxattr);
+    DEBUG(1, "getxattr(ino = %lu, name = \"%s\", size = %ld)",
+        (unsigned long)ino, name, (long)size);
+    if (ino != FUSE_ROOT_ID || strcmp(name, op_stats::xattr_name))
+    {
+        fuse_reply_err(req, ENODATA);
+        return;
+    }
+    std::vector<char> buf(size ? size : 1);
+    int n = op_stats::getxattr(size ? &buf[0] : 0, size);
+    reply_xattr(req, n, size, &buf[0]);
+}
+
+
+static void
+listxattr_callback(fuse_req_t req, fuse_ino_t ino, size_t size)
+{
+    op_stats::timer timing(op_stats::op_listxattr);
+    DEBUG(1, "listxattr(ino = %lu, size = %ld)", (unsigned long)ino,
+        (long)size);
+    int n = 0;
+    if (ino == FUSE_ROOT_ID)
+        n = strlen(op_stats::xattr_name) + 1;
+    if (size && (size_t)n > size)
+        n = -ERANGE;
+    reply_xattr(req, n, size, op_stats::xattr_name);
+}
+
+
+static void
+init_callback(void *, fuse_conn_info *conn)
+{
+    op_stats::timer timing(op_stats::op_init);
+    DEBUG(1, "init(capable = 0x%X)", conn->capable);
+#if FUSE_VERSION >= 29
+    unsigned splice = FUSE_CAP_SPLICE_WRITE | FUSE_CAP_SPLICE_MOVE;
+    conn->want |= (conn->capable & splice);
+#endif
+}
+
+
+void
+collection_init(const rcstring &host_root, double a_attr_timeout,
+    double a_entry_timeout)
+{
+    attr_timeout = a_attr_timeout;
+    entry_timeout = a_entry_timeout;
+    rcstring path = host_root;
+    while (path.size() > 1 && path.back() == '/')
+        path = path.substring(0, path.size() - 1);
+    node_t n;
+    n.kind = node_host_directory;
+    n.path = path;
+    fuse_ino_t ino = remember(n);
+    assert(ino == FUSE_ROOT_ID);
+    (void)ino;
+}
+
+
+void
+collection_init_ops(fuse_lowlevel_ops &ops)
+{
+    ops.init = init_callback;
+    ops.lookup = lookup_callback;
+    ops.forget = forget_callback;
+    ops.getattr = getattr_callback;
+    ops.open = open_callback;
+    ops.read = read_callback;
+    ops.release = release_callback;
+    ops.opendir = opendir_callback;
+    ops.readdir = readdir_callback;
+    ops.statfs = statfs_callback;
+    ops.getxattr = getxattr_callback;
+    ops.listxattr = listxattr_callback;
+}
@@ -0,0 +1,51 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#ifndef UCSDPSYS_MOUNT_COLLECTION_H
+#define UCSDPSYS_MOUNT_COLLECTION_H
+
+#include <lib/fuse.h>
+#include <lib/rcstring.h>
+
+/**
+  * The collection_init function is used to prepare to serve a whole
+  * directory tree of disk images, read-only.  Host directories appear
+  * as directories, host files which contain a UCSD p-System disk image
+  * appear as directories of the files in the disk image, and other
+  * host files do not appear at all.
+  *
+  * @param host_root
+  *     The path of the host directory to be served.
+  * @param attr_timeout
+  *     How long (in seconds) the kernel may cache attributes.
+  * @param entry_timeout
+  *     How long (in seconds) the kernel may cache names.
+  */
+void collection_init(const rcstring &host_root, double attr_timeout,
+    double entry_timeout);
+
+/**
+  * The collection_init_ops function is used to fill in the table of
+  * low-level operations to serve the directory tree.
+  *
+  * @param ops
+  *     The table to be filled in.
+  */
+void collection_init_ops(fuse_lowlevel_ops &ops);
+
+#endif // UCSDPSYS_MOUNT_COLLECTION_H
@@ -0,0 +1,409 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <libexplain/output.h>
+#include <libexplain/program_name.h>
+#include <syslog.h>
+
+#include <lib/debug.h>
+
+#include <ucsdpsys_mount/image.h>
+
+
+image::lru_t image::lru;
+mutex image::lru_lock;
+size_t image::max_open = 64;
+bool image::text;
+
+
+//
+// The image_open_failure exception is thrown (by image_exit, below)
+// when a fatal error is reported while a disk image is being opened,
+// so that only that disk image fails, rather than the whole daemon.
+//
+struct image_open_failure
+{
+};
+
+
+//
+// The opening variable is used to remember whether the calling thread
+// is opening a disk image.
+//
+static __thread bool opening;
+
+
+//
+// The use_syslog variable is used to remember whether error messages
+// are to be sent to syslog, rather than the standard error.
+//
+static bool use_syslog;
+
+
+static void
+image_message(explain_output_t *, const char *text)
+{
+    if (use_syslog)
+        syslog(LOG_ERR, "%s", text);
+    else
+        fprintf(stderr, "%s: %s\n", explain_program_name_get(), text);
+}
+
+
+static void
+image_exit(explain_output_t *, int status)
+{
+#ifdef HAVE_EXPLAIN_UNWIND
+    if (opening)
+        throw image_open_failure();
+#endif
+    exit(status);
+}
+
+
+static const explain_output_vtable_t image_vtable =
+{
+    0, // destructor
+    image_message,
+    image_exit,
+    sizeof(explain_output_t)
+};
+
+
+void
+image::register_output(bool to_syslog)
+{
+    use_syslog = to_syslog;
+    if (use_syslog)
+        openlog(explain_program_name_get(), LOG_PID, LOG_USER);
+    explain_output_register(explain_output_new(&image_vtable));
+}
+
+
+image::~image()
+{
+    delete volume;
+    volume = 0;
+}
+
+
+image::image(const rcstring &a_path) :
+    path(a_path),
+    volume(0),
+    known(false),
+    status(-ENOENT),
+    pins(0)
+{
+    memset(&host, 0, sizeof(host));
+    memset(&root, 0, sizeof(root));
+    memset(&fs, 0, sizeof(fs));
+}
+
+
+image::pointer
+image::create(const rcstring &a_path)
+{
+    return pointer(new image(a_path));
+}
+
+
+void
+image::set_max_open(size_t n)
+{
+    max_open = (n < 1 ? 1 : n);
+}
+
+
+void
+image::set_text(bool yesno)
+{
+    text = yesno;
+}
+
+
+static bool
+same_file(const struct stat &a, const struct stat &b)
+{
+    return
+        (
+            a.st_dev == b.st_dev
+        &&
+            a.st_ino == b.st_ino
+        &&
+            a.st_size == b.st_size
+        &&
+            a.st_mtime == b.st_mtime
+        );
+}
+
+
+int
+image::check(void)
+{
+    struct stat st;
+    if (::stat(path.c_str(), &st) < 0)
+        return -errno;
+    if (!S_ISREG(st.st_mode) && !S_ISBLK(st.st_mode))
+        return -ENOENT;
+
+    {
+        mutex::locker hold_state(state_lock);
+        if (known && (pins > 0 || same_file(st, host)))
+            return status;
+    }
+
+    //
+    // The host file is new to us, or it has changed.  Look (again) at
+    // what it contains, after everyone has finished with the disk
+    // image as it was.
+    //
+    {
+        rwlock::writer hold_use(use_lock);
+        mutex::locker hold_state(state_lock);
+        if (!known || (pins == 0 && !same_file(st, host)))
+        {
+            host = st;
+            reload();
+        }
+    }
+    close_idle();
+
+    mutex::locker hold_state(state_lock);
+    return status;
+}
+
+
+void
+image::reload(void)
+{
+    if (known)
+    {
+        DEBUG(1, "%s: changed", path.c_str());
+        close();
+        interleave.clear();
+    }
+    known = true;
+    status = -ENOENT;
+    names.clear();
+    attrs.clear();
+    int err = open();
+    if (err < 0)
+    {
+        status = err;
+        return;
+    }
+
+    directory_entry::pointer dep = volume->find("/");
+    if (!dep)
+        return;
+    memset(&root, 0, sizeof(root));
+    memset(&fs, 0, sizeof(fs));
+    if (dep->getattr(&root) < 0 || dep->statfs(&fs) < 0)
+        return;
+    rcstring_list all;
+    if (dep->get_directory_entry_names(all) < 0)
+        return;
+    for (size_t j = 0; j < all.size(); ++j)
+    {
+        directory_entry::pointer child = volume->find(all[j]);
+        struct stat st;
+        memset(&st, 0, sizeof(st));
+        if (!child || child->getattr(&st) < 0)
+            continue;
+        names.push_back(all[j]);
+        attrs[all[j].upcase()] = st;
+    }
+    status = 0;
+}
+
+
+int
+image::open(void)
+{
+    if (volume)
+        return 0;
+
+    //
+    // Most damage is reported by try_factory returning NULL, but some
+    // (a corrupted compressed image, for example) is fatal, and comes
+    // back as an exception instead; see image_exit, above.  The
+    // exception passes through libexplain's C stack frames, the same
+    // way batch failures do (see lib/batch.cc).
+    //
+    opening = true;
+    try
+    {
+        volume = directory::try_factory(path, true, interleave);
+    }
+    catch (image_open_failure)
+    {
+        opening = false;
+        DEBUG(1, "%s: unable to open", path.c_str());
+        interleave.clear();
+        volume = 0;
+        return -EIO;
+    }
+    opening = false;
+    if (!volume)
+        return -ENOENT;
+    if (text)
+        volume->convert_text_on_the_fly();
+    DEBUG(2, "%s: open (%s)", path.c_str(), interleave.c_str());
+
+    mutex::locker hold_lru(lru_lock);
+    lru.push_front(this);
+    lru_pos = lru.begin();
+    return 0;
+}
+
+
+void
+image::close(void)
+{
+    if (!volume)
+        return;
+    DEBUG(2, "%s: close", path.c_str());
+    delete volume;
+    volume = 0;
+
+    mutex::locker hold_lru(lru_lock);
+    lru.erase(lru_pos);
+}
+
+
+void
+image::close_idle(void)
+{
+    mutex::locker hold_lru(lru_lock);
+    lru_t::iterator it = lru.end();
+    while (lru.size() > max_open && it != lru.begin())
+    {
+        --it;
+        image *ip = *it;
+
+        //
+        // Skip disk images which are in use, rather than waiting for
+        // them.  The caller may be using one.  Any other thread which
+        // holds an image's state_lock while wanting the lru_lock also
+        // holds its use_lock, so this can not deadlock.
+        //
+        if (!ip->use_lock.try_write_lock())
+            continue;
+        {
+            mutex::locker hold_state(ip->state_lock);
+            if (ip->pins == 0 && ip->volume)
+            {
+                DEBUG(2, "%s: close", ip->path.c_str());
+                delete ip->volume;
+                ip->volume = 0;
+                it = lru.erase(it);
+            }
+        }
+        ip->use_lock.unlock();
+    }
+}
+
+
+int
+image::getattr(const rcstring &name, struct stat *st)
+{
+    mutex::locker hold_state(state_lock);
+    if (status < 0)
+        return status;
+    if (name.empty())
+    {
+        *st = root;
+        return 0;
+    }
+    attrs_t::const_iterator it = attrs.find(name.upcase());
+    if (it == attrs.end())
+        return -ENOENT;
+    *st = it->second;
+    return 0;
+}
+
+
+int
+image::get_names(rcstring_list &results)
+{
+    mutex::locker hold_state(state_lock);
+    if (status < 0)
+        return status;
+    results = names;
+    return 0;
+}
+
+
+int
+image::statfs(struct statvfs *st)
+{
+    mutex::locker hold_state(state_lock);
+    if (status < 0)
+        return status;
+    *st = fs;
+    return 0;
+}
+
+
+directory_entry::pointer
+image::find(const rcstring &name)
+{
+    bool opened = false;
+    directory_entry::pointer dep;
+    {
+        mutex::locker hold_state(state_lock);
+        if (status < 0)
+            return dep;
+        if (!volume)
+        {
+            if (open() < 0)
+                return dep;
+            opened = true;
+        }
+        else
+        {
+            mutex::locker hold_lru(lru_lock);
+            lru.splice(lru.begin(), lru, lru_pos);
+        }
+        dep = volume->find(name.empty() ? rcstring("/") : name);
+    }
+    if (opened)
+        close_idle();
+    return dep;
+}
+
+
+void
+image::pin(void)
+{
+    mutex::locker hold_state(state_lock);
+    ++pins;
+}
+
+
+void
+image::unpin(void)
+{
+    mutex::locker hold_state(state_lock);
+    --pins;
+}
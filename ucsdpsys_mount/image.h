@@ -0,0 +1,337 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#ifndef UCSDPSYS_MOUNT_IMAGE_H
+#define UCSDPSYS_MOUNT_IMAGE_H
+
+#include <list>
+#include <map>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <boost/shared_ptr.hpp>
+
+#include <lib/directory.h>
+#include <lib/directory/entry.h>
+#include <lib/mutex.h>
+#include <lib/rcstring/list.h>
+#include <lib/rwlock.h>
+
+/**
+  * The image class is used to represent a file in the host file system
+  * which (probably) contains a UCSD p-System disk image, when a whole
+  * directory tree of them is mounted.
+  *
+  * The disk image is opened the first time it is needed, and closed
+  * again when it has not been used for a while, so that the number of
+  * disk images open at once is bounded.  Its interleaving, and the
+  * names and attributes of its files, are remembered while it is
+  * closed, so that listing a directory full of disk images does not
+  * keep opening them all over again.
+  *
+  * Disk images are opened read-only.
+  */
+class image
+{
+public:
+    typedef boost::shared_ptr<image> pointer;
+
+    /**
+      * The destructor.
+      */
+    virtual ~image();
+
+    /**
+      * The create class method is used to create new dynamically
+      * allocated instances of this class.
+      *
+      * @param path
+      *     The path of the host file which may contain a disk image.
+      */
+    static pointer create(const rcstring &path);
+
+    /**
+      * The set_max_open class method is used to set how many disk
+      * images may be open at once.  Disk images with open files are
+      * never closed, so this may be exceeded.
+      */
+    static void set_max_open(size_t n);
+
+    /**
+      * The set_text class method is used to set whether text files are
+      * to be converted on the fly, see the -t option.
+      */
+    static void set_text(bool yesno);
+
+    /**
+      * The register_output class method is used to direct libexplain's
+      * error messages, so that a fatal error while opening a disk image
+      * makes only that disk image fail (its status is -EIO until the
+      * host file changes) rather than terminating the daemon.  Fatal
+      * errors anywhere else still exit, as do all fatal errors if
+      * libexplain was built without unwind tables.
+      *
+      * @param to_syslog
+      *     true if error messages are to go to syslog, false if they
+      *     are to go to the standard error.
+      */
+    static void register_output(bool to_syslog);
+
+    /**
+      * The check method is used to make sure the cached information
+      * about the disk image is up to date with the host file, opening
+      * the disk image to find out if necessary.
+      *
+      * @returns
+      *     zero if the host file contains a disk image, -ENOENT if it
+      *     does not, or some other -errno on error.
+      */
+    int check(void);
+
+    /**
+      * The getattr method is used to obtain the remembered attributes
+      * of a file within the disk image, without opening it.
+      *
+      * @param name
+      *     The name of the file, or the empty string for the volume
+      *     itself.
+      * @param st
+      *     Where to put the attributes.
+      * @returns
+      *     zero on success, -errno on error.
+      */
+    int getattr(const rcstring &name, struct stat *st);
+
+    /**
+      * The get_names method is used to obtain the remembered names of
+      * the files within the disk image.
+      */
+    int get_names(rcstring_list &names);
+
+    /**
+      * The statfs method is used to obtain the remembered file system
+      * statistics of the disk image.
+      */
+    int statfs(struct statvfs *st);
+
+    /**
+      * The get_lock method is used to obtain the lock which must be
+      * held for reading while using a directory entry obtained from the
+      * #find method.  The disk image is not closed while it is held.
+      */
+    rwlock &get_lock(void) { return use_lock; }
+
+    /**
+      * The find method is used to locate a file within the disk image,
+      * opening the disk image first if necessary.  The caller must
+      * hold the #get_lock lock for reading.
+      *
+      * @param name
+      *     The name of the file to look for.
+      * @returns
+      *     pointer to directory entry, or NULL if not found.
+      */
+    directory_entry::pointer find(const rcstring &name);
+
+    /**
+      * The pin method is used to keep the disk image open while one of
+      * its files is open.
+      */
+    void pin(void);
+
+    /**
+      * The unpin method is used to undo the effects of a #pin call.
+      */
+    void unpin(void);
+
+private:
+    /**
+      * The constructor.
+      * It is private on purpose, use the #create class method instead.
+      *
+      * @param path
+      *     The path of the host file which may contain a disk image.
+      */
+    image(const rcstring &path);
+
+    /**
+      * The path instance variable is used to remember the path of the
+      * host file.
+      */
+    rcstring path;
+
+    /**
+      * The use_lock instance variable is used to keep the disk image
+      * open while it is in use.  Users hold it for reading, closing
+      * the disk image needs it for writing.
+      */
+    rwlock use_lock;
+
+    /**
+      * The state_lock instance variable is used to protect the rest of
+      * the instance variables.  When both are needed, it is taken
+      * after the use_lock.
+      */
+    mutex state_lock;
+
+    /**
+      * The volume instance variable is used to remember the open disk
+      * image, or NULL when it is closed.
+      */
+    directory *volume;
+
+    /**
+      * The known instance variable is used to remember whether the
+      * host file has been looked at yet.
+      */
+    bool known;
+
+    /**
+      * The status instance variable is used to remember the result of
+      * the #check method: zero for a disk image, -ENOENT for some other
+      * kind of file, -EIO for a disk image which could not be opened.
+      */
+    int status;
+
+    /**
+      * The host instance variable is used to remember the attributes
+      * of the host file, when it was last looked at.  If they change,
+      * the host file has been changed or replaced.
+      */
+    struct stat host;
+
+    /**
+      * The interleave instance variable is used to remember the
+      * interleaving of the disk image (see sector_io::interleave_factory)
+      * so that it need not be sniffed again when the disk image is
+      * reopened.
+      */
+    rcstring interleave;
+
+    /**
+      * The root instance variable is used to remember the attributes
+      * of the volume.
+      */
+    struct stat root;
+
+    /**
+      * The fs instance variable is used to remember the file system
+      * statistics of the volume.
+      */
+    struct statvfs fs;
+
+    /**
+      * The names instance variable is used to remember the names of
+      * the files in the volume, in directory order.
+      */
+    rcstring_list names;
+
+    typedef std::map<rcstring, struct stat> attrs_t;
+
+    /**
+      * The attrs instance variable is used to remember the attributes
+      * of the files in the volume, by upper case name (file names are
+      * not case sensitive).
+      */
+    attrs_t attrs;
+
+    /**
+      * The pins instance variable is used to remember how many files
+      * of the disk image are open.
+      */
+    long pins;
+
+    typedef std::list<image *> lru_t;
+
+    /**
+      * The lru_pos instance variable is used to remember where this
+      * image is in the list of open disk images, when it is open.
+      */
+    lru_t::iterator lru_pos;
+
+    /**
+      * The lru class variable is used to remember the open disk images,
+      * most recently used first.
+      */
+    static lru_t lru;
+
+    /**
+      * The lru_lock class variable is used to protect the #lru list.
+      */
+    static mutex lru_lock;
+
+    /**
+      * The max_open class variable is used to remember how many disk
+      * images may be open at once.
+      */
+    static size_t max_open;
+
+    /**
+      * The text class variable is used to remember whether text files
+      * are converted on the fly.
+      */
+    static bool text;
+
+    /**
+      * The reload method is used to (re)open the disk image, and
+      * remember its interleaving, file names and attributes.  The
+      * caller must hold the use_lock for writing, and the state_lock.
+      */
+    void reload(void);
+
+    /**
+      * The open method is used to open the disk image, and add it to
+      * the front of the #lru list.  The caller must hold the
+      * state_lock.
+      *
+      * @returns
+      *     zero on success, -ENOENT if it is no longer a disk image, or
+      *     -EIO if opening it reported a fatal error.
+      */
+    int open(void);
+
+    /**
+      * The close method is used to close the disk image, and remove it
+      * from the #lru list.  The caller must hold the use_lock for
+      * writing, and the state_lock.
+      */
+    void close(void);
+
+    /**
+      * The close_idle class method is used to close the least recently
+      * used disk images, until no more than #max_open are open.  Disk
+      * images in use, or with open files, are skipped.
+      */
+    static void close_idle(void);
+
+    /**
+      * The default constructor.  Do not use.
+      */
+    image();
+
+    /**
+      * The copy constructor.  Do not use.
+      */
+    image(const image &);
+
+    /**
+      * The assignment operator.  Do not use.
+      */
+    image &operator=(const image &);
+};
+
+#endif // UCSDPSYS_MOUNT_IMAGE_H
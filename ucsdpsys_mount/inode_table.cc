@@ -0,0 +1,151 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+
+#include <lib/debug.h>
+#include <ucsdpsys_mount/inode_table.h>
+
+
+inode_table::~inode_table()
+{
+}
+
+
+inode_table::inode_table() :
+    generation(1),
+    spare(0x10000)
+{
+}
+
+
+void
+inode_table::set_root(const directory_entry::pointer &dep)
+{
+    mutex::locker hold(lock);
+    node &n = nodes[FUSE_ROOT_ID];
+    n.dep = dep;
+    n.nlookup = 1;
+    n.generation = 0;
+    n.contents_lock.reset(new mutex);
+    by_entry[dep.get()] = FUSE_ROOT_ID;
+}
+
+
+fuse_ino_t
+inode_table::remember(const directory_entry::pointer &dep, ino_t ino,
+    unsigned long &gen)
+{
+    mutex::locker hold(lock);
+    by_entry_t::iterator it = by_entry.find(dep.get());
+    if (it != by_entry.end())
+    {
+        node &n = nodes[it->second];
+        if (it->second != FUSE_ROOT_ID)
+            ++n.nlookup;
+        gen = n.generation;
+        return it->second;
+    }
+
+    fuse_ino_t nodeid = ino;
+    if (nodeid <= FUSE_ROOT_ID || nodes.find(nodeid) != nodes.end())
+    {
+        while (nodes.find(spare) != nodes.end())
+            ++spare;
+        nodeid = spare++;
+    }
+    DEBUG(2, "remember %s as %lu", dep->get_name().quote_c().c_str(),
+        (unsigned long)nodeid);
+    node &n = nodes[nodeid];
+    n.dep = dep;
+    n.nlookup = 1;
+    n.generation = generation;
+    n.contents_lock.reset(new mutex);
+    by_entry[dep.get()] = nodeid;
+    gen = n.generation;
+    return nodeid;
+}
+
+
+directory_entry::pointer
+inode_table::find(fuse_ino_t nodeid)
+    const
+{
+    mutex::locker hold(lock);
+    nodes_t::const_iterator it = nodes.find(nodeid);
+    if (it == nodes.end())
+        return directory_entry::pointer();
+    return it->second.dep;
+}
+
+
+boost::shared_ptr<mutex>
+inode_table::get_lock(fuse_ino_t nodeid)
+    const
+{
+    mutex::locker hold(lock);
+    nodes_t::const_iterator it = nodes.find(nodeid);
+    if (it == nodes.end())
+        return boost::shared_ptr<mutex>();
+    return it->second.contents_lock;
+}
+
+
+void
+inode_table::forget(fuse_ino_t nodeid, unsigned long nlookup)
+{
+    if (nodeid == FUSE_ROOT_ID)
+        return;
+    mutex::locker hold(lock);
+    nodes_t::iterator it = nodes.find(nodeid);
+    if (it == nodes.end())
+        return;
+    node &n = it->second;
+    if (n.nlookup > nlookup)
+    {
+        n.nlookup -= nlookup;
+        return;
+    }
+    DEBUG(2, "forget %lu", (unsigned long)nodeid);
+    by_entry.erase(n.dep.get());
+    nodes.erase(it);
+    ++generation;
+}
+
+
+void
+inode_table::set_changed(fuse_ino_t nodeid)
+{
+    mutex::locker hold(lock);
+    nodes_t::iterator it = nodes.find(nodeid);
+    if (it != nodes.end())
+        it->second.changed = true;
+}
+
+
+bool
+inode_table::clear_changed(fuse_ino_t nodeid)
+{
+    mutex::locker hold(lock);
+    nodes_t::iterator it = nodes.find(nodeid);
+    if (it == nodes.end())
+        return true;
+    bool result = it->second.changed;
+    it->second.changed = false;
+    return result;
+}
@@ -0,0 +1,226 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#ifndef UCSDPSYS_MOUNT_INODE_TABLE_H
+#define UCSDPSYS_MOUNT_INODE_TABLE_H
+
+#include <map>
+#include <boost/shared_ptr.hpp>
+
+#include <lib/directory/entry.h>
+#include <lib/fuse.h>
+#include <lib/mutex.h>
+
+/**
+  * The inode_table class is used to represent the mapping between the
+  * node IDs the kernel knows about, and the directory entries they
+  * refer to.  Node IDs are handed out by #remember (in reply to lookup,
+  * mknod and similar requests), and withdrawn by #forget once the
+  * kernel has forgotten them as many times as they were handed out.
+  *
+  * Where it is free, a directory entry's node ID is the same as its
+  * inode number (see directory::next_inode_number), and the node ID is
+  * what the kernel is told the inode number is.
+  */
+class inode_table
+{
+public:
+    /**
+      * The destructor.
+      */
+    virtual ~inode_table();
+
+    /**
+      * The default constructor.
+      */
+    inode_table();
+
+    /**
+      * The set_root method is used to set the directory entry for
+      * FUSE_ROOT_ID, which the kernel never looks up nor forgets.
+      *
+      * @param dep
+      *     The volume label directory entry.
+      */
+    void set_root(const directory_entry::pointer &dep);
+
+    /**
+      * The remember method is used to obtain a node ID for a directory
+      * entry, and to count one more lookup of it by the kernel.
+      *
+      * @param dep
+      *     The directory entry of interest.
+      * @param ino
+      *     The directory entry's inode number, used as the node ID if
+      *     it is not already in use by another directory entry.
+      * @param generation
+      *     Where to put the generation number of the node ID.  The
+      *     pair (node ID, generation) is never reused.
+      * @returns
+      *     the node ID
+      */
+    fuse_ino_t remember(const directory_entry::pointer &dep, ino_t ino,
+        unsigned long &generation);
+
+    /**
+      * The find method is used to obtain the directory entry for a
+      * node ID.
+      *
+      * @param nodeid
+      *     The node ID of interest.
+      * @returns
+      *     pointer to the directory entry, or NULL if the node ID is
+      *     not known.
+      */
+    directory_entry::pointer find(fuse_ino_t nodeid) const;
+
+    /**
+      * The get_lock method is used to obtain the lock which serializes
+      * changes to the contents of the file a node ID refers to.  It is
+      * always taken before the volume lock, never after.
+      *
+      * @param nodeid
+      *     The node ID of interest.
+      * @returns
+      *     pointer to the lock, or NULL if the node ID is not known.
+      */
+    boost::shared_ptr<mutex> get_lock(fuse_ino_t nodeid) const;
+
+    /**
+      * The forget method is used to count down the kernel's lookups of
+      * a node ID, discarding the node ID when the count reaches zero.
+      *
+      * @param nodeid
+      *     The node ID of interest.
+      * @param nlookup
+      *     The number of lookups to forget.
+      */
+    void forget(fuse_ino_t nodeid, unsigned long nlookup);
+
+    /**
+      * The set_changed method is used to record that the contents of a
+      * file have been changed by this file system.
+      *
+      * @param nodeid
+      *     The node ID of the file which was changed.
+      */
+    void set_changed(fuse_ino_t nodeid);
+
+    /**
+      * The clear_changed method is used to discover whether the
+      * contents of a file have changed since the last time this method
+      * was called (in practice, since the file was last opened), and
+      * to clear the record of changes.
+      *
+      * @param nodeid
+      *     The node ID of the file of interest.
+      * @returns
+      *     true if the file has changed, false if it has not.
+      */
+    bool clear_changed(fuse_ino_t nodeid);
+
+private:
+    /**
+      * The node class is used to represent what is known about a node
+      * ID handed out to the kernel.
+      */
+    struct node
+    {
+        node() : nlookup(0), generation(0), changed(false) { }
+
+        /**
+          * The directory entry the node ID refers to.
+          */
+        directory_entry::pointer dep;
+
+        /**
+          * The number of times the kernel has been handed this node ID
+          * and not yet forgotten it.
+          */
+        unsigned long nlookup;
+
+        /**
+          * The generation number of the node ID.
+          */
+        unsigned long generation;
+
+        /**
+          * Whether or not the file's contents have changed since it was
+          * last opened.
+          */
+        bool changed;
+
+        /**
+          * The lock which serializes changes to the file's contents.
+          * It is shared, so that it outlives the node if the kernel
+          * forgets the node ID while the lock is held.
+          */
+        boost::shared_ptr<mutex> contents_lock;
+    };
+
+    typedef std::map<fuse_ino_t, node> nodes_t;
+
+    /**
+      * The nodes instance variable is used to remember the node for
+      * each node ID.
+      */
+    nodes_t nodes;
+
+    typedef std::map<const directory_entry *, fuse_ino_t> by_entry_t;
+
+    /**
+      * The by_entry instance variable is used to remember the node ID
+      * of each directory entry in the #nodes table.
+      */
+    by_entry_t by_entry;
+
+    /**
+      * The generation instance variable is used to remember the
+      * generation number to be given to the next node ID.  It is
+      * advanced each time a node ID is discarded, so that a node ID
+      * which is reused always has a new generation number.
+      */
+    unsigned long generation;
+
+    /**
+      * The spare instance variable is used to remember the next node
+      * ID to try, when a directory entry's inode number is already in
+      * use.  It starts well above the inode numbers of the files on a
+      * freshly mounted volume.
+      */
+    fuse_ino_t spare;
+
+    /**
+      * The lock instance variable is used to serialize access to the
+      * table, because lookups run in parallel when the file system is
+      * mounted multi-threaded.
+      */
+    mutable mutex lock;
+
+    /**
+      * The copy constructor.  Do not use.
+      */
+    inode_table(const inode_table &);
+
+    /**
+      * The assignment operator.  Do not use.
+      */
+    inode_table &operator=(const inode_table &);
+};
+
+#endif // UCSDPSYS_MOUNT_INODE_TABLE_H
@@ -21,215 +21,528 @@
 #include <cerrno>
 #include <cstdio>
 #include <cstring>
+#include <cstdlib>
+#include <ctime>
+#include <climits>
 #include <getopt.h>
 #include <libexplain/output.h>
 #include <libexplain/program_name.h>
+#include <libexplain/realpath.h>
+#include <libexplain/stat.h>
 #include <unistd.h>
+#include <vector>
 
 #include <lib/debug.h>
 #include <lib/directory.h>
 #include <lib/directory/entry.h>
 #include <lib/fuse.h>
 #include <lib/hexdump.h>
+#include <lib/mutex.h>
 #include <lib/rcstring/list.h>
+#include <lib/rwlock.h>
 #include <lib/sector_io/raw.h>
 #include <lib/version.h>
 
+#include <ucsdpsys_mount/collection.h>
+#include <ucsdpsys_mount/image.h>
+#include <ucsdpsys_mount/inode_table.h>
+#include <ucsdpsys_mount/op_stats.h>
+
 
 static directory *volume;
 
 
+//
+// The volume_lock variable is used to serialize access to the volume
+// when it is mounted multi-threaded.  Operations which only look at
+// the volume hold it for reading, and any number of them may run at
+// once, including reads of the same file.  Operations which change
+// the volume hold it for writing, excluding everything else.  This
+// includes writes to file contents (which update the directory when
+// the file grows, and may relocate other files) and the writing back
+// of cached text file data by flush, release and fsync.
+//
+// Operations which change a file's contents also hold the file's own
+// lock (see inode_table::get_lock), taken before the volume lock.
+// This lets flush, release and fsync do the expensive encoding of
+// cached text while holding the volume only for reading, so that
+// several files may be encoded at once, and only take the volume for
+// writing to store the result.
+//
+static rwlock volume_lock;
+
+
+//
+// The inodes variable is used to remember the directory entry for each
+// node ID the kernel has been told about.  Every request (other than
+// lookups) names its file by node ID, so paths are never resolved
+// more than once.
+//
+static inode_table inodes;
+
+
+//
+// The read_only variable is used to remember whether or not the volume
+// is mounted read-only.  A read-only volume can not change while it is
+// mounted, so the kernel may cache everything for a long time.
+//
+static bool read_only;
+
+//
+// The attr_timeout variable is used to remember how long (in seconds)
+// the kernel may cache file attributes, before asking again.
+//
+static double attr_timeout = 1.0;
+
+//
+// The entry_timeout variable is used to remember how long (in seconds)
+// the kernel may cache file names (including names which do not
+// exist), before asking again.
+//
+static double entry_timeout = 1.0;
+
+
+/**
+  * The find_child function is used to locate a directory entry by name,
+  * within the given directory.
+  *
+  * @param parent
+  *     The node ID of the directory to search.
+  * @param name
+  *     The name of the directory entry to search for.
+  * @param dep
+  *     Where to put the directory entry, if found.
+  * @returns
+  *     zero on success, -errno on error.
+  */
 static int
-getattr_callback(const char *path, struct stat *stbuf)
+find_child(fuse_ino_t parent, const char *name, directory_entry::pointer &dep)
 {
-    DEBUG(1, "getattr(path = \"%s\", stbuf = %p)", path, stbuf);
     assert(volume);
-    directory_entry::pointer dep = volume->find(path);
+    directory_entry::pointer pdep = inodes.find(parent);
+    if (!pdep)
+        return -ESTALE;
+    if (parent != FUSE_ROOT_ID)
+        return -ENOTDIR;
+    dep = volume->find(name);
     if (!dep)
         return -ENOENT;
-    return dep->getattr(stbuf);
+    return 0;
 }
 
 
 /**
-  * Read the target of a symbolic link
+  * The reply_entry function is used to reply to a request (lookup,
+  * mknod, etc) which hands a new node ID to the kernel.
   *
-  * The buffer should be filled with a null terminated string.  The
-  * buffer size argument includes the space for the terminating
-  * null character.  If the linkname is too long to fit in the
-  * buffer, it should be truncated.  The return value should be 0
-  * for success.
+  * @param req
+  *     The request being replied to.
+  * @param dep
+  *     The directory entry to be described.
   */
-static int
-readlink_callback(const char *path, char *buf, size_t size)
+static void
+reply_entry(fuse_req_t req, const directory_entry::pointer &dep)
 {
-    DEBUG(1, "readlink(path = \"%s\", buf = %p, size = %d)", path, buf,
-        (int)size);
-    assert(volume);
-    directory_entry::pointer dep = volume->find(path);
-    if (!dep)
-        return -ENOENT;
-    return dep->readlink(buf, size);
+    fuse_entry_param e;
+    memset(&e, 0, sizeof(e));
+    int err = dep->getattr(&e.attr);
+    if (err < 0)
+    {
+        fuse_reply_err(req, -err);
+        return;
+    }
+    e.ino = inodes.remember(dep, e.attr.st_ino, e.generation);
+    e.attr.st_ino = e.ino;
+    e.attr_timeout = attr_timeout;
+    e.entry_timeout = entry_timeout;
+    if (fuse_reply_entry(req, &e))
+    {
+        // the kernel never saw it, so it will never forget it
+        inodes.forget(e.ino, 1);
+    }
 }
 
 
 /**
-  * Create a file node
+  * The reply_attr function is used to reply to a request (getattr,
+  * setattr) with the attributes of a directory entry.
   *
-  * This is called for creation of all non-directory, non-symlink
-  * nodes.  If the filesystem defines a create() method, then for
-  * regular files that will be called instead.
+  * @param req
+  *     The request being replied to.
+  * @param ino
+  *     The node ID of the directory entry.
+  * @param dep
+  *     The directory entry to be described.
   */
-static int
-mknod_callback(const char *s, mode_t mode, dev_t dev)
+static void
+reply_attr(fuse_req_t req, fuse_ino_t ino, const directory_entry::pointer &dep)
 {
-    DEBUG(1, "mknod(path = \"%s\", mode = 0%o, dev = %d)", s, (int)mode,
-        (int)dev);
-    rcstring path(s);
-    assert(volume);
-    directory_entry::pointer dep = volume->find(path);
-    if (dep)
-        return -EEXIST;
-    dep = volume->find(path.dirname());
-    if (!dep)
-        return -ENOENT;
-    return dep->mknod(path.basename(), mode, dev);
+    struct stat st;
+    memset(&st, 0, sizeof(st));
+    int err = dep->getattr(&st);
+    if (err < 0)
+    {
+        fuse_reply_err(req, -err);
+        return;
+    }
+    st.st_ino = ino;
+    fuse_reply_attr(req, &st, attr_timeout);
 }
 
 
-static int
-mkdir_callback(const char *s, mode_t mode)
+/**
+  * Look up a directory entry by name and get its attributes.
+  */
+static void
+lookup_callback(fuse_req_t req, fuse_ino_t parent, const char *name)
 {
-    DEBUG(1, "mkdir(s = \"%s\", mode = 0%o)", s, mode);
-    rcstring path(s);
-    assert(volume);
-    directory_entry::pointer dep = volume->find(path);
-    if (dep)
-        return -EEXIST;
-    dep = volume->find(path.dirname());
-    if (!dep)
-        return -ENOENT;
-    return dep->mkdir(path.basename(), mode);
+    op_stats::timer timing(op_stats::op_lookup);
+    DEBUG(1, "lookup(parent = %lu, name = \"%s\")", (unsigned long)parent,
+        name);
+    rwlock::reader hold_volume(volume_lock);
+    directory_entry::pointer dep;
+    int err = find_child(parent, name, dep);
+    if (err == -ENOENT && read_only)
+    {
+        //
+        // A node ID of zero tells the kernel to remember that the name
+        // does not exist, for as long as the entry timeout.
+        //
+        fuse_entry_param e;
+        memset(&e, 0, sizeof(e));
+        e.entry_timeout = entry_timeout;
+        fuse_reply_entry(req, &e);
+        return;
+    }
+    if (err < 0)
+    {
+        fuse_reply_err(req, -err);
+        return;
+    }
+    reply_entry(req, dep);
 }
 
 
-static int
-unlink_callback(const char *path)
+/**
+  * Forget about an inode
+  *
+  * The nlookup parameter indicates the number of lookups previously
+  * performed on this inode.  Each lookup, mknod, mkdir, symlink and
+  * link increments the lookup count by one.
+  */
+static void
+forget_callback(fuse_req_t req, fuse_ino_t ino, unsigned long nlookup)
 {
-    DEBUG(1, "unlink(path = \"%s\")", path);
-    assert(volume);
-    directory_entry::pointer dep = volume->find(path);
-    if (!dep)
-        return -ENOENT;
-    return dep->unlink();
+    op_stats::timer timing(op_stats::op_forget);
+    DEBUG(1, "forget(ino = %lu, nlookup = %lu)", (unsigned long)ino,
+        nlookup);
+    inodes.forget(ino, nlookup);
+    fuse_reply_none(req);
 }
 
 
-static int
-rmdir_callback(const char *path)
+static void
+getattr_callback(fuse_req_t req, fuse_ino_t ino, fuse_file_info *)
 {
-    DEBUG(1, "rmdir(path = \"%s\")", path);
-    assert(volume);
-    directory_entry::pointer dep = volume->find(path);
+    op_stats::timer timing(op_stats::op_getattr);
+    DEBUG(1, "getattr(ino = %lu)", (unsigned long)ino);
+    rwlock::reader hold_volume(volume_lock);
+    directory_entry::pointer dep = inodes.find(ino);
     if (!dep)
-        return -ENOENT;
-    return dep->rmdir();
+    {
+        fuse_reply_err(req, ESTALE);
+        return;
+    }
+    reply_attr(req, ino, dep);
 }
 
 
-static int
-symlink_callback(const char *lhs, const char *rhs)
+/**
+  * Set file attributes
+  *
+  * In the 'attr' argument only members indicated by the 'to_set'
+  * bitmask contain valid values.  Other members contain undefined
+  * values.  This takes the place of the chmod, chown, truncate and
+  * utimens operations.
+  */
+static void
+setattr_callback(fuse_req_t req, fuse_ino_t ino, struct stat *attr,
+    int to_set, fuse_file_info *)
 {
-    DEBUG(1, "symlink(lhs = \"%s\", rhs = \"%s\")", lhs, rhs);
-    rcstring path(lhs);
-    assert(volume);
-    directory_entry::pointer dep = volume->find(path);
-    if (dep)
-        return -EEXIST;
-    dep = volume->find(path.dirname());
+    op_stats::timer timing(op_stats::op_setattr);
+    DEBUG(1, "setattr(ino = %lu, to_set = 0x%X)", (unsigned long)ino,
+        to_set);
+    boost::shared_ptr<mutex> contents = inodes.get_lock(ino);
+    if (!contents)
+    {
+        fuse_reply_err(req, ESTALE);
+        return;
+    }
+    mutex::locker hold_contents(*contents);
+    rwlock::writer hold_volume(volume_lock);
+    directory_entry::pointer dep = inodes.find(ino);
     if (!dep)
-        return -ENOENT;
-    return dep->symlink(path.basename(), rhs);
+    {
+        fuse_reply_err(req, ESTALE);
+        return;
+    }
+    int err = 0;
+    if (to_set & FUSE_SET_ATTR_MODE)
+        err = dep->chmod(attr->st_mode);
+    if (err >= 0 && (to_set & (FUSE_SET_ATTR_UID | FUSE_SET_ATTR_GID)))
+    {
+        err =
+            dep->chown
+            (
+                (to_set & FUSE_SET_ATTR_UID) ? attr->st_uid : uid_t(-1),
+                (to_set & FUSE_SET_ATTR_GID) ? attr->st_gid : gid_t(-1)
+            );
+    }
+    if (err >= 0 && (to_set & FUSE_SET_ATTR_SIZE))
+    {
+        inodes.set_changed(ino);
+        err = dep->truncate(attr->st_size);
+    }
+    int times =
+        FUSE_SET_ATTR_ATIME | FUSE_SET_ATTR_MTIME |
+        FUSE_SET_ATTR_ATIME_NOW | FUSE_SET_ATTR_MTIME_NOW;
+    if (err >= 0 && (to_set & times))
+    {
+        struct stat st;
+        memset(&st, 0, sizeof(st));
+        err = dep->getattr(&st);
+        struct timespec tv[2];
+        memset(tv, 0, sizeof(tv));
+        tv[0].tv_sec = st.st_atime;
+        tv[1].tv_sec = st.st_mtime;
+        time_t now = time(0);
+        if (to_set & FUSE_SET_ATTR_ATIME)
+            tv[0].tv_sec = attr->st_atime;
+        if (to_set & FUSE_SET_ATTR_ATIME_NOW)
+            tv[0].tv_sec = now;
+        if (to_set & FUSE_SET_ATTR_MTIME)
+            tv[1].tv_sec = attr->st_mtime;
+        if (to_set & FUSE_SET_ATTR_MTIME_NOW)
+            tv[1].tv_sec = now;
+        if (err >= 0)
+            err = dep->utime_ns(tv);
+    }
+    if (err < 0)
+    {
+        fuse_reply_err(req, -err);
+        return;
+    }
+    reply_attr(req, ino, dep);
 }
 
 
-static int
-rename_callback(const char *lhs, const char *rhs)
+/**
+  * Read the target of a symbolic link
+  */
+static void
+readlink_callback(fuse_req_t req, fuse_ino_t ino)
 {
-    DEBUG(1, "rename(lhs = \"%s\", rhs = \"%s\")", lhs, rhs);
-    assert(volume);
-    directory_entry::pointer dep = volume->find(lhs);
+    op_stats::timer timing(op_stats::op_readlink);
+    DEBUG(1, "readlink(ino = %lu)", (unsigned long)ino);
+    rwlock::reader hold_volume(volume_lock);
+    directory_entry::pointer dep = inodes.find(ino);
     if (!dep)
-        return -ENOENT;
-    // FIXME: this isn't right, if moving between directories.
-    return dep->rename(rhs);
+    {
+        fuse_reply_err(req, ESTALE);
+        return;
+    }
+    char buf[1024];
+    int err = dep->readlink(buf, sizeof(buf));
+    if (err < 0)
+    {
+        fuse_reply_err(req, -err);
+        return;
+    }
+    fuse_reply_readlink(req, buf);
 }
 
 
+/**
+  * The new_entry function is used to look up the parent directory,
+  * for requests (mknod, mkdir, symlink, link) which create a new
+  * directory entry.
+  *
+  * @param parent
+  *     The node ID of the directory to contain the new name.
+  * @param name
+  *     The new name.
+  * @param pdep
+  *     Where to put the parent directory entry.
+  * @returns
+  *     zero on success, -errno on error.
+  */
 static int
-link_callback(const char *lhs, const char *rhs)
+new_entry(fuse_ino_t parent, const char *name, directory_entry::pointer &pdep)
 {
-    DEBUG(1, "link(lhs = \"%s\", rhs = \"%s\")", lhs, rhs);
-    rcstring path(lhs);
-    assert(volume);
-    directory_entry::pointer dep = volume->find(path);
-    if (dep)
+    directory_entry::pointer dep;
+    int err = find_child(parent, name, dep);
+    if (err == 0)
         return -EEXIST;
-    dep = volume->find(path.dirname());
-    if (!dep)
-        return -ENOENT;
-    directory_entry::pointer rhs_dep = volume->find(rhs);
-    if (!rhs)
-        return -ENOENT;
-    return dep->link(path.basename(), rhs_dep);
+    if (err != -ENOENT)
+        return err;
+    pdep = inodes.find(parent);
+    return 0;
 }
 
 
-static int
-chmod_callback(const char *path, mode_t mode)
+/**
+  * The reply_new_entry function is used to reply to requests (mknod,
+  * mkdir, symlink, link) which create a new directory entry.
+  *
+  * @param req
+  *     The request being replied to.
+  * @param err
+  *     The result of creating the directory entry.
+  * @param parent
+  *     The node ID of the directory containing the new name.
+  * @param name
+  *     The new name.
+  */
+static void
+reply_new_entry(fuse_req_t req, int err, fuse_ino_t parent, const char *name)
 {
-    DEBUG(1, "chmod(path = \"%s\", mode = 0%o)", path, mode);
-    assert(volume);
-    directory_entry::pointer dep = volume->find(path);
-    if (!dep)
-        return -ENOENT;
-    return dep->chmod(mode);
+    directory_entry::pointer dep;
+    if (err >= 0)
+        err = find_child(parent, name, dep);
+    if (err < 0)
+    {
+        fuse_reply_err(req, -err);
+        return;
+    }
+    reply_entry(req, dep);
 }
 
 
-static int
-chown_callback(const char *path, uid_t uid, gid_t gid)
+/**
+  * Create a file node
+  *
+  * This is called for creation of all non-directory, non-symlink
+  * nodes.
+  */
+static void
+mknod_callback(fuse_req_t req, fuse_ino_t parent, const char *name,
+    mode_t mode, dev_t dev)
 {
-    DEBUG(1, "chown(path = \"%s\", uid = %d, gid = %d)", path, uid, gid);
-    assert(volume);
-    directory_entry::pointer dep = volume->find(path);
-    if (!dep)
-        return -ENOENT;
-    return dep->chown(uid, gid);
+    op_stats::timer timing(op_stats::op_mknod);
+    DEBUG(1, "mknod(parent = %lu, name = \"%s\", mode = 0%o, dev = %d)",
+        (unsigned long)parent, name, (int)mode, (int)dev);
+    rwlock::writer hold_volume(volume_lock);
+    directory_entry::pointer pdep;
+    int err = new_entry(parent, name, pdep);
+    if (err >= 0)
+        err = pdep->mknod(name, mode, dev);
+    reply_new_entry(req, err, parent, name);
 }
 
 
-static int
-truncate_callback(const char *path, off_t size)
+static void
+mkdir_callback(fuse_req_t req, fuse_ino_t parent, const char *name,
+    mode_t mode)
 {
-    DEBUG(1, "truncate(path = \"%s\", size = %ld)", path, (long)size);
-    assert(volume);
-    directory_entry::pointer dep = volume->find(path);
-    if (!dep)
-        return -ENOENT;
-    return dep->truncate(size);
+    op_stats::timer timing(op_stats::op_mkdir);
+    DEBUG(1, "mkdir(parent = %lu, name = \"%s\", mode = 0%o)",
+        (unsigned long)parent, name, (int)mode);
+    rwlock::writer hold_volume(volume_lock);
+    directory_entry::pointer pdep;
+    int err = new_entry(parent, name, pdep);
+    if (err >= 0)
+        err = pdep->mkdir(name, mode);
+    reply_new_entry(req, err, parent, name);
 }
 
 
-static int
-utimens_callback(const char *path, const struct timespec *tv)
+static void
+unlink_callback(fuse_req_t req, fuse_ino_t parent, const char *name)
 {
-    DEBUG(1, "utimens(path = \"%s\", tv = %p)", path, tv);
-    assert(volume);
-    directory_entry::pointer dep = volume->find(path);
+    op_stats::timer timing(op_stats::op_unlink);
+    DEBUG(1, "unlink(parent = %lu, name = \"%s\")", (unsigned long)parent,
+        name);
+    rwlock::writer hold_volume(volume_lock);
+    directory_entry::pointer dep;
+    int err = find_child(parent, name, dep);
+    if (err >= 0)
+        err = dep->unlink();
+    fuse_reply_err(req, -err);
+}
+
+
+static void
+rmdir_callback(fuse_req_t req, fuse_ino_t parent, const char *name)
+{
+    op_stats::timer timing(op_stats::op_rmdir);
+    DEBUG(1, "rmdir(parent = %lu, name = \"%s\")", (unsigned long)parent,
+        name);
+    rwlock::writer hold_volume(volume_lock);
+    directory_entry::pointer dep;
+    int err = find_child(parent, name, dep);
+    if (err >= 0)
+        err = dep->rmdir();
+    fuse_reply_err(req, -err);
+}
+
+
+static void
+symlink_callback(fuse_req_t req, const char *link, fuse_ino_t parent,
+    const char *name)
+{
+    op_stats::timer timing(op_stats::op_symlink);
+    DEBUG(1, "symlink(link = \"%s\", parent = %lu, name = \"%s\")", link,
+        (unsigned long)parent, name);
+    rwlock::writer hold_volume(volume_lock);
+    directory_entry::pointer pdep;
+    int err = new_entry(parent, name, pdep);
+    if (err >= 0)
+        err = pdep->symlink(name, link);
+    reply_new_entry(req, err, parent, name);
+}
+
+
+static void
+rename_callback(fuse_req_t req, fuse_ino_t parent, const char *name,
+    fuse_ino_t newparent, const char *newname)
+{
+    op_stats::timer timing(op_stats::op_rename);
+    DEBUG(1, "rename(parent = %lu, name = \"%s\", newparent = %lu, "
+        "newname = \"%s\")", (unsigned long)parent, name,
+        (unsigned long)newparent, newname);
+    rwlock::writer hold_volume(volume_lock);
+    if (newparent != parent)
+    {
+        fuse_reply_err(req, EXDEV);
+        return;
+    }
+    directory_entry::pointer dep;
+    int err = find_child(parent, name, dep);
+    if (err >= 0)
+        err = dep->rename(newname);
+    fuse_reply_err(req, -err);
+}
+
+
+static void
+link_callback(fuse_req_t req, fuse_ino_t ino, fuse_ino_t newparent,
+    const char *newname)
+{
+    op_stats::timer timing(op_stats::op_link);
+    DEBUG(1, "link(ino = %lu, newparent = %lu, newname = \"%s\")",
+        (unsigned long)ino, (unsigned long)newparent, newname);
+    rwlock::writer hold_volume(volume_lock);
+    directory_entry::pointer dep = inodes.find(ino);
     if (!dep)
-        return -ENOENT;
-    return dep->utime_ns(tv);
+    {
+        fuse_reply_err(req, ESTALE);
+        return;
+    }
+    directory_entry::pointer pdep;
+    int err = new_entry(newparent, newname, pdep);
+    if (err >= 0)
+        err = pdep->link(newname, dep);
+    reply_new_entry(req, err, newparent, newname);
 }
 
 
@@ -238,57 +551,89 @@ utimens_callback(const char *path, const struct timespec *tv)
   *
   * No creation, or truncation flags (O_CREAT, O_EXCL, O_TRUNC) will be
   * passed to open().  Open should check if the operation is permitted
-  * for the given flags.  Optionally open may also return an arbitrary
-  * filehandle in the fuse_file_info structure, which will be passed to
-  * all file operations.
+  * for the given flags.
   */
-static int
-open_callback(const char *path, fuse_file_info *fi)
+static void
+open_callback(fuse_req_t req, fuse_ino_t ino, fuse_file_info *fi)
 {
-    DEBUG(1, "open(path = \"%s\", fi = %p)", path, fi);
-    assert(volume);
-    directory_entry::pointer dep = volume->find(path);
+    op_stats::timer timing(op_stats::op_open);
+    DEBUG(1, "open(ino = %lu, fi = %p)", (unsigned long)ino, fi);
+    rwlock::reader hold_volume(volume_lock);
+    directory_entry::pointer dep = inodes.find(ino);
     if (!dep)
-        return -ENOENT;
+    {
+        fuse_reply_err(req, ESTALE);
+        return;
+    }
     int err = dep->open();
     if (err < 0)
-        return err;
-    fi->fh = (unsigned long)new directory_entry::pointer(dep);
-    return 0;
+    {
+        fuse_reply_err(req, -err);
+        return;
+    }
+
+    //
+    // Let the kernel keep the file's cached pages from one open to the
+    // next, unless this file system has changed the file in the mean
+    // time.  Text files, in particular, may not read back exactly as
+    // they were written.
+    //
+    fi->keep_cache = (read_only || !inodes.clear_changed(ino));
+    op_stats::page_cache(fi->keep_cache);
+    fuse_reply_open(req, fi);
 }
 
 
 /**
   * Read data from an open file
   *
-  * Read should return exactly the number of bytes requested except
+  * Read should send exactly the number of bytes requested except
   * on EOF or error, otherwise the rest of the data will be
-  * substituted with zeroes.      An exception to this is when the
-  * 'direct_io' mount option is specified, in which case the return
-  * value of the read system call will reflect the return value of
-  * this operation.
+  * substituted with zeroes.
   */
-static int
-read_callback(const char *path, char *buf, size_t size, off_t offset,
+static void
+read_callback(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset,
     fuse_file_info *fi)
 {
-    DEBUG(1, "read(path = \"%s\", buf = %p, size = %ld, offset = %ld, fi = %p)",
-        path, buf, (long)size, (long)offset, fi);
-    directory_entry::pointer *depp = (directory_entry::pointer *)fi->fh;
-    directory_entry::pointer dep(depp ? *depp : directory_entry::pointer());
+    op_stats::timer timing(op_stats::op_read);
+    DEBUG(1, "read(ino = %lu, size = %ld, offset = %ld, fi = %p)",
+        (unsigned long)ino, (long)size, (long)offset, fi);
+    rwlock::reader hold_volume(volume_lock);
+    directory_entry::pointer dep = inodes.find(ino);
     if (!dep)
     {
-        assert(volume);
-        dep = volume->find(path);
-        if (dep)
-        {
-            delete depp;
-            fi->fh = (long)new directory_entry::pointer(dep);
-        }
+        fuse_reply_err(req, ESTALE);
+        return;
     }
-    if (!dep)
-        return -ENOENT;
-    return dep->read(offset, buf, size);
+
+#if FUSE_VERSION >= 29
+    //
+    // If the data is sitting in the disk image file, as is, tell libfuse
+    // where to find it, and it can splice it to the kernel without it
+    // ever being copied into our address space.
+    //
+    size_t nbytes = size;
+    off_t pos = 0;
+    int fd = dep->get_backing_fd(offset, nbytes, pos, false);
+    if (fd >= 0)
+    {
+        fuse_bufvec bufv = FUSE_BUFVEC_INIT(nbytes);
+        bufv.buf[0].flags = fuse_buf_flags(FUSE_BUF_IS_FD | FUSE_BUF_FD_SEEK);
+        bufv.buf[0].fd = fd;
+        bufv.buf[0].pos = pos;
+        fuse_reply_data(req, &bufv, FUSE_BUF_SPLICE_MOVE);
+        return;
+    }
+#endif
+
+    std::vector<char> buf(size ? size : 1);
+    int n = dep->read(offset, &buf[0], size);
+    if (n < 0)
+    {
+        fuse_reply_err(req, -n);
+        return;
+    }
+    fuse_reply_buf(req, &buf[0], n);
 }
 
 
@@ -296,53 +641,208 @@ read_callback(const char *path, char *buf, size_t size, off_t offset,
   * Write data to an open file
   *
   * Write should return exactly the number of bytes requested
-  * except on error.  An exception to this is when the 'direct_io' mount
-  * option is specified (see read operation).
+  * except on error.
   */
-static int
-write_callback(const char *path, const char *buf, size_t size, off_t offset,
-    fuse_file_info *fi)
+static void
+write_callback(fuse_req_t req, fuse_ino_t ino, const char *buf, size_t size,
+    off_t offset, fuse_file_info *fi)
+{
+    op_stats::timer timing(op_stats::op_write);
+    DEBUG(1, "write(ino = %lu, buf = %p, size = %ld, offset = %ld, "
+        "fi = %p)", (unsigned long)ino, buf, (long)size, (long)offset, fi);
+    boost::shared_ptr<mutex> contents = inodes.get_lock(ino);
+    if (!contents)
+    {
+        fuse_reply_err(req, ESTALE);
+        return;
+    }
+    mutex::locker hold_contents(*contents);
+    rwlock::writer hold_volume(volume_lock);
+    directory_entry::pointer dep = inodes.find(ino);
+    if (!dep)
+    {
+        fuse_reply_err(req, ESTALE);
+        return;
+    }
+    inodes.set_changed(ino);
+    int err = dep->write(offset, buf, size);
+    if (err < 0)
+    {
+        fuse_reply_err(req, -err);
+        return;
+    }
+    fuse_reply_write(req, size);
+}
+
+
+#if FUSE_VERSION >= 29
+
+/**
+  * Write data to an open file, from a buffer which may be a pipe
+  *
+  * When the data overwrites part of a file which is stored as is in
+  * the disk image file, libfuse can splice it straight from the kernel
+  * into the disk image file.  Otherwise it is gathered into memory,
+  * and written as for the write operation.
+  */
+static void
+write_buf_callback(fuse_req_t req, fuse_ino_t ino, fuse_bufvec *in,
+    off_t offset, fuse_file_info *fi)
 {
-    DEBUG(1, "write(path = \"%s\", buf = %p, size = %ld, offset = %ld, "
-        "fi = %p)", path, buf, (long)size, (long)offset, fi);
-    directory_entry::pointer *depp = (directory_entry::pointer *)fi->fh;
-    directory_entry::pointer dep(depp ? *depp : directory_entry::pointer());
+    op_stats::timer timing(op_stats::op_write_buf);
+    size_t size = fuse_buf_size(in);
+    DEBUG(1, "write_buf(ino = %lu, size = %ld, offset = %ld, fi = %p)",
+        (unsigned long)ino, (long)size, (long)offset, fi);
+    boost::shared_ptr<mutex> contents = inodes.get_lock(ino);
+    if (!contents)
+    {
+        fuse_reply_err(req, ESTALE);
+        return;
+    }
+    mutex::locker hold_contents(*contents);
+    rwlock::writer hold_volume(volume_lock);
+    directory_entry::pointer dep = inodes.find(ino);
     if (!dep)
     {
-        assert(volume);
-        dep = volume->find(path);
-        if (dep)
+        fuse_reply_err(req, ESTALE);
+        return;
+    }
+    inodes.set_changed(ino);
+
+    size_t nbytes = size;
+    off_t pos = 0;
+    int fd = dep->get_backing_fd(offset, nbytes, pos, true);
+    if (fd >= 0)
+    {
+        fuse_bufvec out = FUSE_BUFVEC_INIT(size);
+        out.buf[0].flags = fuse_buf_flags(FUSE_BUF_IS_FD | FUSE_BUF_FD_SEEK);
+        out.buf[0].fd = fd;
+        out.buf[0].pos = pos;
+        ssize_t n = fuse_buf_copy(&out, in, fuse_buf_copy_flags(0));
+        if (n < 0)
+        {
+            fuse_reply_err(req, -n);
+            return;
+        }
+        int err = dep->touch();
+        if (err < 0)
         {
-            delete depp;
-            fi->fh = (long)new directory_entry::pointer(dep);
+            fuse_reply_err(req, -err);
+            return;
         }
+        fuse_reply_write(req, n);
+        return;
     }
-    if (!dep)
-        return -ENOENT;
-     int err = dep->write(offset, buf, size);
-     if (err < 0)
-         return err;
-     return size;
+
+    const char *data = 0;
+    std::vector<char> buf;
+    if (in->count == 1 && !(in->buf[0].flags & FUSE_BUF_IS_FD))
+        data = (const char *)in->buf[0].mem + in->off;
+    else
+    {
+        buf.resize(size ? size : 1);
+        fuse_bufvec out = FUSE_BUFVEC_INIT(size);
+        out.buf[0].mem = &buf[0];
+        ssize_t n = fuse_buf_copy(&out, in, fuse_buf_copy_flags(0));
+        if (n < 0)
+        {
+            fuse_reply_err(req, -n);
+            return;
+        }
+        size = n;
+        data = &buf[0];
+    }
+    int err = dep->write(offset, data, size);
+    if (err < 0)
+    {
+        fuse_reply_err(req, -err);
+        return;
+    }
+    fuse_reply_write(req, size);
 }
 
+#endif
+
 
 /**
   * Get file system statistics
+  */
+static void
+statfs_callback(fuse_req_t req, fuse_ino_t ino)
+{
+    op_stats::timer timing(op_stats::op_statfs);
+    DEBUG(1, "statfs(ino = %lu)", (unsigned long)ino);
+    rwlock::reader hold_volume(volume_lock);
+    directory_entry::pointer dep = inodes.find(ino);
+    if (!dep)
+        dep = inodes.find(FUSE_ROOT_ID);
+    struct statvfs buf;
+    memset(&buf, 0, sizeof(buf));
+    int err = dep->statfs(&buf);
+    if (err < 0)
+    {
+        fuse_reply_err(req, -err);
+        return;
+    }
+    fuse_reply_statfs(req, &buf);
+}
+
+
+/**
+  * The simple_request function is used to perform the many requests
+  * which change the volume, and whose reply is just an error code.
   *
-  * The 'f_frsize', 'f_favail', 'f_fsid' and 'f_flag' fields are ignored
-  *
-  * Replaced 'struct statfs' parameter with 'struct statvfs' in
-  * FUSE version 2.5
+  * @param req
+  *     The request being replied to.
+  * @param ino
+  *     The node ID of the directory entry of interest.
+  * @param op
+  *     The operation to perform.
+  * @param arg
+  *     The argument to pass to the operation.
   */
+static void
+simple_request(fuse_req_t req, fuse_ino_t ino,
+    int (*op)(directory_entry &, int), int arg)
+{
+    //
+    // The file's own lock is held throughout, so that no write to the
+    // file can slip in between preparing its on-disk form and storing
+    // it.
+    //
+    boost::shared_ptr<mutex> contents = inodes.get_lock(ino);
+    if (!contents)
+    {
+        fuse_reply_err(req, ESTALE);
+        return;
+    }
+    mutex::locker hold_contents(*contents);
+    directory_entry::pointer dep;
+    {
+        rwlock::reader hold_volume(volume_lock);
+        dep = inodes.find(ino);
+        if (!dep)
+        {
+            fuse_reply_err(req, ESTALE);
+            return;
+        }
+        int err = dep->prepare_write_back();
+        if (err < 0)
+        {
+            fuse_reply_err(req, -err);
+            return;
+        }
+    }
+    rwlock::writer hold_volume(volume_lock);
+    int err = op(*dep, arg);
+    fuse_reply_err(req, err < 0 ? -err : 0);
+}
+
+
 static int
-statfs_callback(const char *path, struct statvfs *buf)
+flush_op(directory_entry &de, int)
 {
-    DEBUG(1, "statfs(path = \"%s\", buf = %p)", path, buf);
-    assert(volume);
-    directory_entry::pointer dep = volume->find(path);
-    if (!dep)
-        return -ENOENT;
-    return dep->statfs(buf);
+    return de.flush();
 }
 
 
@@ -368,20 +868,19 @@ statfs_callback(const char *path, struct statvfs *buf)
 // Filesystems shouldn't assume that flush will always be called after
 // some writes, or that if will be called at all.
 //
+static void
+flush_callback(fuse_req_t req, fuse_ino_t ino, fuse_file_info *fi)
+{
+    op_stats::timer timing(op_stats::op_flush);
+    DEBUG(1, "flush(ino = %lu, fi = %p)", (unsigned long)ino, fi);
+    simple_request(req, ino, flush_op, 0);
+}
+
+
 static int
-flush_callback(const char *path, fuse_file_info *fi)
+release_op(directory_entry &de, int)
 {
-    DEBUG(1, "flush(path = \"%s\", fi = %p)", path, fi);
-    directory_entry::pointer *depp = (directory_entry::pointer *)fi->fh;
-    directory_entry::pointer dep(depp? *depp : directory_entry::pointer());
-    if (!dep)
-    {
-        assert(volume);
-        dep = volume->find(path);
-    }
-    if (!dep)
-        return -ENOENT;
-    return dep->flush();
+    return de.release();
 }
 
 
@@ -397,22 +896,19 @@ flush_callback(const char *path, fuse_file_info *fi)
 // that no more reads/writes will happen on the file.  The return value
 // of release is ignored.
 //
+static void
+release_callback(fuse_req_t req, fuse_ino_t ino, fuse_file_info *fi)
+{
+    op_stats::timer timing(op_stats::op_release);
+    DEBUG(1, "release(ino = %lu, fi = %p)", (unsigned long)ino, fi);
+    simple_request(req, ino, release_op, 0);
+}
+
+
 static int
-release_callback(const char *path, fuse_file_info *fi)
+fsync_op(directory_entry &de, int datasync)
 {
-    DEBUG(1, "release(path = \"%s\", fi = %p)", path, fi);
-    directory_entry::pointer *depp = (directory_entry::pointer *)fi->fh;
-    directory_entry::pointer dep(depp ? *depp : directory_entry::pointer());
-    delete depp;
-    fi->fh = 0;
-    if (!dep)
-    {
-        assert(volume);
-        dep = volume->find(path);
-    }
-    if (!dep)
-        return -ENOENT;
-    return dep->release();
+    return de.fsync(datasync);
 }
 
 
@@ -422,78 +918,150 @@ release_callback(const char *path, fuse_file_info *fi)
   * If the datasync parameter is non-zero, then only the user data
   * should be flushed, not the meta data.
   */
-static int
-fsync_callback(const char *path, int arg, fuse_file_info *fi)
+static void
+fsync_callback(fuse_req_t req, fuse_ino_t ino, int datasync,
+    fuse_file_info *fi)
 {
-    DEBUG(1, "fsync(path = \"%s\", arg = %d, fi = %p)", path, arg, fi);
-    directory_entry::pointer *depp = (directory_entry::pointer *)fi->fh;
-    directory_entry::pointer dep(depp ? *depp : directory_entry::pointer());
-    if (!dep)
+    op_stats::timer timing(op_stats::op_fsync);
+    DEBUG(1, "fsync(ino = %lu, datasync = %d, fi = %p)", (unsigned long)ino,
+        datasync, fi);
+    simple_request(req, ino, fsync_op, datasync);
+}
+
+
+static void
+setxattr_callback(fuse_req_t req, fuse_ino_t ino, const char *name,
+    const char *value, size_t size, int flags)
+{
+    op_stats::timer timing(op_stats::op_setxattr);
+    DEBUG(1, "setxattr(ino = %lu, name = \"%s\", value = %s, size = %ld, "
+        "flags = %d)", (unsigned long)ino, name,
+        rcstring(value, size).quote_c().c_str(), (long)size, flags);
+    if (ino == FUSE_ROOT_ID && !strcmp(name, op_stats::xattr_name))
     {
-        assert(volume);
-        dep = volume->find(path);
-        if (dep)
-        {
-            delete depp;
-            fi->fh = (long)new directory_entry::pointer(dep);
-        }
+        int err = op_stats::setxattr(value, size);
+        fuse_reply_err(req, err < 0 ? -err : 0);
+        return;
     }
+    rwlock::writer hold_volume(volume_lock);
+    directory_entry::pointer dep = inodes.find(ino);
     if (!dep)
-        return -ENOENT;
-    return dep->fsync(arg);
+    {
+        fuse_reply_err(req, ESTALE);
+        return;
+    }
+    int err = dep->setxattr(name, value, size, flags);
+    fuse_reply_err(req, err < 0 ? -err : 0);
 }
 
 
-static int
-setxattr_callback(const char *path, const char *name, const char *value,
-    size_t size, int arg)
+/**
+  * The reply_xattr function is used to reply to the getxattr and
+  * listxattr requests.  If the size is zero, the size of the value is
+  * wanted, otherwise the value itself.
+  *
+  * @param req
+  *     The request being replied to.
+  * @param n
+  *     The size of the value, or -errno on error.
+  * @param size
+  *     The size requested.
+  * @param buf
+  *     The value.
+  */
+static void
+reply_xattr(fuse_req_t req, int n, size_t size, const char *buf)
 {
-    DEBUG(1, "setxattr(path = \"%s\", name = \"%s\", value = %s, size = %ld, "
-        "arg = %d)", path, name, rcstring(value, size).quote_c().c_str(),
-        (long)size, arg);
-    assert(volume);
-    directory_entry::pointer dep = volume->find(path);
-    if (!dep)
-        return -ENOENT;
-    return dep->setxattr(name, value, size, arg);
+    if (n < 0)
+        fuse_reply_err(req, -n);
+    else if (size == 0)
+        fuse_reply_xattr(req, n);
+    else
+        fuse_reply_buf(req, buf, n);
 }
 
 
-static int
-getxattr_callback(const char *path, const char *name, char *value, size_t size)
+static void
+getxattr_callback(fuse_req_t req, fuse_ino_t ino, const char *name,
+    size_t size)
 {
-    DEBUG(1, "getxattr(path = \"%s\", name = \"%s\", value = %p, size = %ld)",
-        path, name, value, (long)size);
-    assert(volume);
-    directory_entry::pointer dep = volume->find(path);
+    op_stats::timer timing(op_stats::op_getxattr);
+    DEBUG(1, "getxattr(ino = %lu, name = \"%s\", size = %ld)",
+        (unsigned long)ino, name, (long)size);
+    std::vector<char> buf(size ? size : 1);
+    if (ino == FUSE_ROOT_ID && !strcmp(name, op_stats::xattr_name))
+    {
+        int n = op_stats::getxattr(size ? &buf[0] : 0, size);
+        reply_xattr(req, n, size, &buf[0]);
+        return;
+    }
+    rwlock::reader hold_volume(volume_lock);
+    directory_entry::pointer dep = inodes.find(ino);
     if (!dep)
-        return -ENOENT;
-    return dep->getxattr(name, value, size);
+    {
+        fuse_reply_err(req, ESTALE);
+        return;
+    }
+    int n = dep->getxattr(name, size ? &buf[0] : 0, size);
+    reply_xattr(req, n, size, &buf[0]);
 }
 
 
-static int
-listxattr_callback(const char *path, char *buf, size_t size)
+static void
+listxattr_callback(fuse_req_t req, fuse_ino_t ino, size_t size)
 {
-    DEBUG(1, "listxattr(path = \"%s\", buf = %p, size = %ld)", path, buf,
+    op_stats::timer timing(op_stats::op_listxattr);
+    DEBUG(1, "listxattr(ino = %lu, size = %ld)", (unsigned long)ino,
         (long)size);
-    assert(volume);
-    directory_entry::pointer dep = volume->find(path);
+    rwlock::reader hold_volume(volume_lock);
+    directory_entry::pointer dep = inodes.find(ino);
     if (!dep)
-        return -ENOENT;
-    return dep->listxattr(buf, size);
+    {
+        fuse_reply_err(req, ESTALE);
+        return;
+    }
+    std::vector<char> buf(size ? size : 1);
+    int n = dep->listxattr(size ? &buf[0] : 0, size);
+    if (ino == FUSE_ROOT_ID)
+    {
+        //
+        // The root directory also has the statistics attribute, see
+        // the ucsdpsys_stat(1) command.
+        //
+        if (n == -ENOSYS)
+            n = 0;
+        if (n >= 0)
+        {
+            size_t len = strlen(op_stats::xattr_name) + 1;
+            if (size && n + len > size)
+                n = -ERANGE;
+            else
+            {
+                if (size)
+                    memcpy(&buf[n], op_stats::xattr_name, len);
+                n += len;
+            }
+        }
+    }
+    reply_xattr(req, n, size, &buf[0]);
 }
 
 
-static int
-removexattr_callback(const char *path, const char *name)
+static void
+removexattr_callback(fuse_req_t req, fuse_ino_t ino, const char *name)
 {
-    DEBUG(1, "removexattr(path = \"%s\", name = \"%s\")", path, name);
-    assert(volume);
-    directory_entry::pointer dep = volume->find(path);
+    op_stats::timer timing(op_stats::op_removexattr);
+    DEBUG(1, "removexattr(ino = %lu, name = \"%s\")", (unsigned long)ino,
+        name);
+    rwlock::writer hold_volume(volume_lock);
+    directory_entry::pointer dep = inodes.find(ino);
     if (!dep)
-        return -ENOENT;
-    return dep->removexattr(name);
+    {
+        fuse_reply_err(req, ESTALE);
+        return;
+    }
+    int err = dep->removexattr(name);
+    fuse_reply_err(req, err < 0 ? -err : 0);
 }
 
 
@@ -503,96 +1071,120 @@ removexattr_callback(const char *path, const char *name)
   * This method should check if the open operation is permitted for
   * this  directory
   */
-static int
-opendir_callback(const char *path, fuse_file_info *fi)
+static void
+opendir_callback(fuse_req_t req, fuse_ino_t ino, fuse_file_info *fi)
 {
-    DEBUG(1, "opendir(path = \"%s\", fi = %p)", path, fi);
-    assert(volume);
-    directory_entry::pointer dep = volume->find(path);
+    op_stats::timer timing(op_stats::op_opendir);
+    DEBUG(1, "opendir(ino = %lu, fi = %p)", (unsigned long)ino, fi);
+    rwlock::reader hold_volume(volume_lock);
+    directory_entry::pointer dep = inodes.find(ino);
     if (!dep)
-        return -ENOENT;
-    fi->fh = (long)new directory_entry::pointer(dep);
-    return dep->opendir();
+    {
+        fuse_reply_err(req, ESTALE);
+        return;
+    }
+    int err = dep->opendir();
+    if (err < 0)
+    {
+        fuse_reply_err(req, -err);
+        return;
+    }
+    fuse_reply_open(req, fi);
 }
 
 
 /**
   * Read directory
   *
-  * This supersedes the old getdir() interface.  New applications
-  * should use this.
-  *
-  * The filesystem may choose between two modes of operation:
-  *
-  * 1) The readdir implementation ignores the offset parameter,
-  * and passes zero to the filler function's offset.  The filler
-  * function will not return '1' (unless an error happens), so the
-  * whole directory is read in a single readdir operation.  This
-  * works just like the old getdir() method.
+  * Send a buffer filled using fuse_add_direntry(), with size not
+  * exceeding the requested size.  Send an empty buffer on end of
+  * stream.  The offset of each entry is the index of the next entry,
+  * where "." and ".." are the first two, so that reading may resume
+  * part way through the directory.
   *
-  * 2) The readdir implementation keeps track of the offsets of the
-  * directory entries.  It uses the offset parameter and always
-  * passes non-zero offset to the filler function.  When the buffer
-  * is full (or an error happens) the filler function will return
-  * '1'.
-  *
-  * @returns
-  *     zero on success, -errno on error.
+  * Each entry carries the inode number and file type of the
+  * directory entry, so that "ls" and "find" need not ask for them.
   */
-static int
-readdir_callback(const char *path, void *buf, fuse_fill_dir_t filler,
-    off_t offset, fuse_file_info *fi)
+static void
+readdir_callback(fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset,
+    fuse_file_info *fi)
 {
-    DEBUG(1, "readdir(path = \"%s\", buf = %p, filler = %p, offset = %ld, "
-        "fi = %p)", path, buf, filler, (long)offset, fi);
-    directory_entry::pointer *depp = (directory_entry::pointer *)fi->fh;
-    directory_entry::pointer dep(depp ? *depp : directory_entry::pointer());
+    op_stats::timer timing(op_stats::op_readdir);
+    DEBUG(1, "readdir(ino = %lu, size = %ld, offset = %ld, fi = %p)",
+        (unsigned long)ino, (long)size, (long)offset, fi);
+    rwlock::reader hold_volume(volume_lock);
+    directory_entry::pointer dep = inodes.find(ino);
     if (!dep)
     {
-        assert(volume);
-        dep = volume->find(path);
-        if (dep)
-        {
-            delete depp;
-            fi->fh = (long)new directory_entry::pointer(dep);
-        }
+        fuse_reply_err(req, ESTALE);
+        return;
     }
-    if (!dep)
-        return -ENOENT;
     rcstring_list names;
     int err = dep->get_directory_entry_names(names);
     if (err < 0)
-        return err;
+    {
+        fuse_reply_err(req, -err);
+        return;
+    }
 
-    struct stat st;
-    memset(&st, 0, sizeof(st));
-    filler(buf, ".", &st, 0);
-    filler(buf, "..", &st, 0);
-    for (size_t j = 0; j < names.size(); ++j)
+    std::vector<char> buf(size ? size : 1);
+    size_t pos = 0;
+    for (size_t j = offset; j < names.size() + 2; ++j)
     {
-        if (filler(buf, names[j].c_str(), &st, 0))
+        struct stat st;
+        memset(&st, 0, sizeof(st));
+        rcstring name;
+        if (j < 2)
+        {
+            name = (j ? ".." : ".");
+            dep->getattr(&st);
+        }
+        else
+        {
+            name = names[j - 2];
+            directory_entry::pointer child = volume->find(name);
+            if (!child || child->getattr(&st) < 0)
+                continue;
+        }
+        size_t len =
+            fuse_add_direntry
+            (
+                req,
+                &buf[pos],
+                size - pos,
+                name.c_str(),
+                &st,
+                j + 1
+            );
+        if (len > size - pos)
             break;
+        pos += len;
     }
-    return 0;
+    fuse_reply_buf(req, &buf[0], pos);
 }
 
 
-static int
-releasedir_callback(const char *path, fuse_file_info *fi)
+static void
+releasedir_callback(fuse_req_t req, fuse_ino_t ino, fuse_file_info *fi)
 {
-    DEBUG(1, "releasedir(path = \"%s\", fi = %p)", path, fi);
-    directory_entry::pointer *depp = (directory_entry::pointer *)fi->fh;
-    directory_entry::pointer dep(depp ? *depp : directory_entry::pointer());
-    delete depp;
-    fi->fh = 0;
+    op_stats::timer timing(op_stats::op_releasedir);
+    DEBUG(1, "releasedir(ino = %lu, fi = %p)", (unsigned long)ino, fi);
+    rwlock::reader hold_volume(volume_lock);
+    directory_entry::pointer dep = inodes.find(ino);
     if (!dep)
     {
-        assert(volume);
-        dep = volume->find(path);
+        fuse_reply_err(req, ESTALE);
+        return;
     }
-    if (!dep)
-        return -ENOENT;
-    return dep->releasedir();
+    int err = dep->releasedir();
+    fuse_reply_err(req, err < 0 ? -err : 0);
+}
+
+
+static int
+fsyncdir_op(directory_entry &de, int datasync)
+{
+    return de.fsyncdir(datasync);
 }
 
 
@@ -602,64 +1194,137 @@ releasedir_callback(const char *path, fuse_file_info *fi)
   * If the datasync parameter is non-zero, then only the user data
   * should be flushed, not the meta data
   */
-static int
-fsyncdir_callback(const char *path, int arg, fuse_file_info *fi)
+static void
+fsyncdir_callback(fuse_req_t req, fuse_ino_t ino, int datasync,
+    fuse_file_info *fi)
 {
-    DEBUG(1, "fsyncdir(path = \"%s\", arg = %d, fi = %p)", path, arg, fi);
-    directory_entry::pointer *depp = (directory_entry::pointer *)fi->fh;
-    directory_entry::pointer dep(depp ? *depp : directory_entry::pointer());
-    if (!dep)
+    op_stats::timer timing(op_stats::op_fsyncdir);
+    DEBUG(1, "fsyncdir(ino = %lu, datasync = %d, fi = %p)",
+        (unsigned long)ino, datasync, fi);
+    simple_request(req, ino, fsyncdir_op, datasync);
+}
+
+
+/**
+  * Initialize the file system
+  *
+  * This is called once the connection to the kernel is established,
+  * before any other request.  It is used to tell the kernel which
+  * optional features we would like.
+  */
+static void
+init_callback(void *, fuse_conn_info *conn)
+{
+    op_stats::timer timing(op_stats::op_init);
+    DEBUG(1, "init(capable = 0x%X)", conn->capable);
+
+    //
+    // Allow writes larger than one page, so that copying a file onto
+    // the volume takes fewer round trips.
+    //
+    if (!read_only && (conn->capable & FUSE_CAP_BIG_WRITES))
+        conn->want |= FUSE_CAP_BIG_WRITES;
+
+#if FUSE_VERSION >= 29
+    //
+    // Allow file data to be spliced between the kernel and the disk
+    // image file, see the read and write_buf operations.
+    //
+    unsigned splice = FUSE_CAP_SPLICE_WRITE | FUSE_CAP_SPLICE_MOVE;
+    if (!read_only)
+        splice |= FUSE_CAP_SPLICE_READ;
+    conn->want |= (conn->capable & splice);
+#endif
+}
+
+
+static fuse_lowlevel_ops ops;
+
+
+/**
+  * The init_ops function is used to fill in the table of low-level
+  * operations.  Members are assigned by name, because their order
+  * varies between libfuse versions.
+  */
+static void
+init_ops(void)
+{
+    ops.init = init_callback;
+    ops.lookup = lookup_callback;
+    ops.forget = forget_callback;
+    ops.getattr = getattr_callback;
+    ops.setattr = setattr_callback;
+    ops.readlink = readlink_callback;
+    ops.mknod = mknod_callback;
+    ops.mkdir = mkdir_callback;
+    ops.unlink = unlink_callback;
+    ops.rmdir = rmdir_callback;
+    ops.symlink = symlink_callback;
+    ops.rename = rename_callback;
+    ops.link = link_callback;
+    ops.open = open_callback;
+    ops.read = read_callback;
+    ops.write = write_callback;
+#if FUSE_VERSION >= 29
+    ops.write_buf = write_buf_callback;
+#endif
+    ops.flush = flush_callback;
+    ops.release = release_callback;
+    ops.fsync = fsync_callback;
+    ops.opendir = opendir_callback;
+    ops.readdir = readdir_callback;
+    ops.releasedir = releasedir_callback;
+    ops.fsyncdir = fsyncdir_callback;
+    ops.statfs = statfs_callback;
+    ops.setxattr = setxattr_callback;
+    ops.getxattr = getxattr_callback;
+    ops.listxattr = listxattr_callback;
+    ops.removexattr = removexattr_callback;
+}
+
+
+/**
+  * The serve function is used to mount the file system and run the
+  * FUSE low-level session loop until it is unmounted.  This is what
+  * fuse_main does for the high-level API.
+  *
+  * @param argc
+  *     The number of FUSE command line arguments.
+  * @param argv
+  *     The FUSE command line arguments.
+  */
+static void
+serve(int argc, char **argv)
+{
+    fuse_args args = FUSE_ARGS_INIT(argc, argv);
+    char *mount_point = 0;
+    int multi_threaded = 0;
+    int foreground = 0;
+    if (fuse_parse_cmdline(&args, &mount_point, &multi_threaded, &foreground))
+        explain_output_error_and_die("unable to parse FUSE arguments");
+    fuse_chan *ch = fuse_mount(mount_point, &args);
+    if (!ch)
+        explain_output_error_and_die("%s: unable to mount", mount_point);
+    fuse_session *se = fuse_lowlevel_new(&args, &ops, sizeof(ops), 0);
+    if (se)
     {
-        assert(volume);
-        dep = volume->find(path);
+        if (fuse_set_signal_handlers(se) == 0)
+        {
+            fuse_session_add_chan(se, ch);
+            fuse_daemonize(foreground);
+            if (multi_threaded)
+                fuse_session_loop_mt(se);
+            else
+                fuse_session_loop(se);
+            fuse_remove_signal_handlers(se);
+            fuse_session_remove_chan(ch);
+        }
+        fuse_session_destroy(se);
     }
-    if (!dep)
-        return -ENOENT;
-    return dep->fsyncdir(arg);
-}
-
-
-static fuse_operations ops =
-{
-    getattr_callback,
-    readlink_callback,
-    0, // getdir, deprecated
-    mknod_callback,
-    mkdir_callback,
-    unlink_callback,
-    rmdir_callback,
-    symlink_callback,
-    rename_callback,
-    link_callback,
-    chmod_callback,
-    chown_callback,
-    truncate_callback,
-    0, // utime, deprecated
-    open_callback,
-    read_callback,
-    write_callback,
-    statfs_callback,
-    flush_callback,
-    release_callback,
-    fsync_callback,
-    setxattr_callback,
-    getxattr_callback,
-    listxattr_callback,
-    removexattr_callback,
-    opendir_callback,
-    readdir_callback,
-    releasedir_callback,
-    fsyncdir_callback,
-    0, // init
-    0, // destroy
-    0, // access
-    0, // create
-    0, // ftruncate
-    0, // fgetattr
-    0, // lock
-    utimens_callback,
-    0, // bmap
-};
+    fuse_unmount(mount_point, ch);
+    free(mount_point);
+    fuse_opt_free_args(&args);
+}
 
 
 static void
@@ -667,6 +1332,7 @@ usage(void)
 {
     const char *prog = explain_program_name_get();
     fprintf(stderr, "Usage: %s [ <option>... ] <volume> <dir>\n", prog);
+    fprintf(stderr, "       %s -c [ <option>... ] <host-dir> <dir>\n", prog);
     fprintf(stderr, "       %s -V\n", prog);
     exit(1);
 }
@@ -687,25 +1353,33 @@ main(int argc, char **argv)
     bool read_only_flag = false;
     bool text_on_the_fly = false;
     bool foreground = false;
+    bool multi_threaded = false;
+    bool collection = false;
     for (;;)
     {
         static const struct option options[] =
         {
+            { "collection", 0, 0, 'c' },
             { "debug", 0, 0, 'D' },
             { "fuse-debug", 0, 0, 'd' },
             { "foreground", 0, 0, 'f' },
             { "help", 0, 0, 'h' },
+            { "multi-threaded", 0, 0, 'm' },
             { "options", 1, 0, 'o' },
             { "read-only", 0, 0, 'r' },
             { "text", 0, 0, 't' },
             { "version", 0, 0, 'V' },
             { 0, 0, 0, 0 }
         };
-        int c = getopt_long(argc, argv, "Ddfho:rtV", options, 0);
+        int c = getopt_long(argc, argv, "cDdfhmo:rtV", options, 0);
         if (c < 0)
             break;
         switch (c)
         {
+        case 'c':
+            collection = true;
+            break;
+
         case 'D':
             ++debug_level;
             break;
@@ -726,6 +1400,10 @@ main(int argc, char **argv)
             version_print();
             return 0;
 
+        case 'm':
+            multi_threaded = true;
+            break;
+
         case 'o':
             // mount option
             mount_options.split(optarg, ",");
@@ -768,6 +1446,51 @@ main(int argc, char **argv)
         }
     }
 
+    //
+    // A directory tree of disk images is always served read-only.
+    //
+    if (collection && !read_only_flag)
+    {
+        subset.push_back("-r");
+        read_only_flag = true;
+    }
+
+    //
+    // Pick the cache profile.  A read-only volume can not change
+    // while it is mounted, so the kernel may cache names, attributes
+    // and file contents for as long as it likes.  A read-write volume
+    // can only be changed through this mount, so the kernel sees every
+    // change, and short timeouts are enough to pick up the rest.
+    //
+    read_only = read_only_flag;
+    if (read_only)
+    {
+        attr_timeout = 3600;
+        entry_timeout = 3600;
+    }
+
+    //
+    // Look in the mount options to see if there are attr_timeout=N,
+    // entry_timeout=N or max_images=N options.  They override the
+    // profile, and are not passed on to fusermount.
+    //
+    for (size_t j = 0; j < mount_options.size(); )
+    {
+        const char *opt = mount_options[j].c_str();
+        if (0 == strncmp(opt, "attr_timeout=", 13))
+            attr_timeout = atof(opt + 13);
+        else if (0 == strncmp(opt, "entry_timeout=", 14))
+            entry_timeout = atof(opt + 14);
+        else if (0 == strncmp(opt, "max_images=", 11))
+            image::set_max_open(atol(opt + 11));
+        else
+        {
+            ++j;
+            continue;
+        }
+        mount_options.remove(j);
+    }
+
     //
     // Look in the mount options to see if there is a umask=NNN option.
     // If not, insert one based on the current process' umask.
@@ -795,12 +1518,12 @@ main(int argc, char **argv)
     subset.push_back("-o" + mount_options.unsplit(","));
 
     //
-    // Always run single threaded, that we we don't need locks.  It's
-    // a pretty small and simple file system, mainly intended for
-    // retrieving historical files, so performance is unlikely to matter
-    // much.
+    // Run single threaded, unless asked otherwise.  When several
+    // requests are handled at once, the volume_lock serializes the
+    // ones which change the volume.
     //
-    subset.push_back("-s");
+    if (!multi_threaded)
+        subset.push_back("-s");
 
     //
     // Add the mount point as the last command line option
@@ -808,17 +1531,42 @@ main(int argc, char **argv)
     //
     subset.push_back(mount_point);
 
-    //
-    // Open the volume, and make sure it has the right format.
-    //
-    volume = directory::factory(filename, read_only_flag);
-    if (text_on_the_fly)
-        volume->convert_text_on_the_fly();
+    if (collection)
+    {
+        //
+        // The disk images are opened as they are needed.  The path must
+        // be absolute, because the daemon changes directory to "/".
+        //
+        char path[PATH_MAX];
+        explain_realpath_or_die(filename, path);
+        struct stat st;
+        explain_stat_or_die(path, &st);
+        if (!S_ISDIR(st.st_mode))
+            explain_output_error_and_die("%s: not a directory", path);
+        image::set_text(text_on_the_fly);
+        collection_init(path, attr_timeout, entry_timeout);
+        collection_init_ops(ops);
+    }
+    else
+    {
+        //
+        // Open the volume, and make sure it has the right format.
+        //
+        volume = directory::factory(filename, read_only_flag);
+        if (text_on_the_fly)
+            volume->convert_text_on_the_fly();
+        inodes.set_root(volume->find("/"));
+        init_ops();
+    }
 
     //
-    // Send any future error messages to syslog
+    // Send any future error messages to syslog.  A collection opens
+    // its disk images as it goes, and one which is damaged must not
+    // take the whole daemon with it.
     //
-    if (!foreground)
+    if (collection)
+        image::register_output(!foreground);
+    else if (!foreground)
         explain_output_register(explain_output_syslog_new());
 
     //
@@ -829,7 +1577,8 @@ main(int argc, char **argv)
     for (size_t j = 0; j < subset.size(); ++j)
         av[j] = (char *)subset[j].c_str();
     av[subset.size()] = 0;
-    fuse_main(subset.size(), av, &ops, 0);
+    serve(subset.size(), av);
+    delete [] av;
 
     //
     // Close down the volume.
@@ -0,0 +1,174 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+#include <lib/rcstring/accumulator.h>
+#include <lib/statistics.h>
+
+#include <ucsdpsys_mount/op_stats.h>
+
+
+const char op_stats::xattr_name[] = "user.ucsdpsys.stats";
+
+unsigned long op_stats::count[op_max];
+unsigned long op_stats::total_us[op_max];
+unsigned long op_stats::max_us[op_max];
+unsigned long op_stats::kept;
+unsigned long op_stats::dropped;
+time_t op_stats::since = time(0);
+
+
+static const char *const op_names[op_stats::op_max] =
+{
+    "init",
+    "lookup",
+    "forget",
+    "getattr",
+    "setattr",
+    "readlink",
+    "mknod",
+    "mkdir",
+    "unlink",
+    "rmdir",
+    "symlink",
+    "rename",
+    "link",
+    "open",
+    "read",
+    "write",
+    "write_buf",
+    "flush",
+    "release",
+    "fsync",
+    "opendir",
+    "readdir",
+    "releasedir",
+    "fsyncdir",
+    "statfs",
+    "setxattr",
+    "getxattr",
+    "listxattr",
+    "removexattr",
+};
+
+
+op_stats::timer::~timer()
+{
+    struct timespec stop;
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    long us =
+        (stop.tv_sec - start.tv_sec) * 1000000L
+    +
+        (stop.tv_nsec - start.tv_nsec) / 1000L;
+    unsigned long elapsed = (us < 0 ? 0 : us);
+
+    __sync_fetch_and_add(&count[op], 1);
+    __sync_fetch_and_add(&total_us[op], elapsed);
+    for (;;)
+    {
+        unsigned long old = max_us[op];
+        if (old >= elapsed)
+            break;
+        if (__sync_bool_compare_and_swap(&max_us[op], old, elapsed))
+            break;
+    }
+}
+
+
+op_stats::timer::timer(op_t a_op) :
+    op(a_op)
+{
+    assert(op >= 0 && op < op_max);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+}
+
+
+void
+op_stats::page_cache(bool yesno)
+{
+    __sync_fetch_and_add(yesno ? &kept : &dropped, 1);
+}
+
+
+rcstring
+op_stats::report(void)
+{
+    rcstring_accumulator ac;
+    ac.printf("uptime %ld\n", (long)(time(0) - since));
+    for (int j = 0; j < op_max; ++j)
+    {
+        unsigned long n = __sync_fetch_and_add(&count[j], 0);
+        if (n == 0)
+            continue;
+        ac.printf("op.%s.count %lu\n", op_names[j], n);
+        ac.printf("op.%s.total_us %lu\n", op_names[j], total_us[j]);
+        ac.printf("op.%s.max_us %lu\n", op_names[j], max_us[j]);
+    }
+    ac.printf("page_cache.kept %lu\n", kept);
+    ac.printf("page_cache.dropped %lu\n", dropped);
+    for (int j = 0; j < statistics::counter_max; ++j)
+    {
+        statistics::counter_t c = statistics::counter_t(j);
+        ac.printf("%s %lu\n", statistics::name(c), statistics::get(c));
+    }
+    return ac.mkstr();
+}
+
+
+void
+op_stats::reset(void)
+{
+    for (int j = 0; j < op_max; ++j)
+    {
+        __sync_lock_test_and_set(&count[j], 0);
+        __sync_lock_test_and_set(&total_us[j], 0);
+        __sync_lock_test_and_set(&max_us[j], 0);
+    }
+    __sync_lock_test_and_set(&kept, 0);
+    __sync_lock_test_and_set(&dropped, 0);
+    statistics::reset();
+    since = time(0);
+}
+
+
+int
+op_stats::getxattr(char *buf, size_t size)
+{
+    rcstring text = report();
+    if (!buf)
+        return text.size();
+    if (size < text.size())
+        return -ERANGE;
+    memcpy(buf, text.c_str(), text.size());
+    return text.size();
+}
+
+
+int
+op_stats::setxattr(const char *value, size_t size)
+{
+    rcstring cmd = rcstring(value, size).trim();
+    if (cmd != "reset")
+        return -EINVAL;
+    reset();
+    return 0;
+}
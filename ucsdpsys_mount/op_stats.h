@@ -0,0 +1,224 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#ifndef UCSDPSYS_MOUNT_OP_STATS_H
+#define UCSDPSYS_MOUNT_OP_STATS_H
+
+#include <ctime>
+
+#include <lib/rcstring.h>
+
+/**
+  * The op_stats class is used to count the requests a running
+  * ucsdpsys_mount serves, and how long they take.  Together with the
+  * library's statistics counters, they are reported as the value of
+  * the "user.ucsdpsys.stats" extended attribute of the mount point,
+  * for the ucsdpsys_stat command to display.
+  */
+class op_stats
+{
+public:
+    enum op_t
+    {
+        op_init,
+        op_lookup,
+        op_forget,
+        op_getattr,
+        op_setattr,
+        op_readlink,
+        op_mknod,
+        op_mkdir,
+        op_unlink,
+        op_rmdir,
+        op_symlink,
+        op_rename,
+        op_link,
+        op_open,
+        op_read,
+        op_write,
+        op_write_buf,
+        op_flush,
+        op_release,
+        op_fsync,
+        op_opendir,
+        op_readdir,
+        op_releasedir,
+        op_fsyncdir,
+        op_statfs,
+        op_setxattr,
+        op_getxattr,
+        op_listxattr,
+        op_removexattr,
+        op_max
+    };
+
+    /**
+      * The timer class is used to time a request, from the time it is
+      * constructed (at the top of the callback) until it is destroyed
+      * (when the callback returns, having replied).
+      */
+    class timer
+    {
+    public:
+        /**
+          * The destructor.
+          */
+        ~timer();
+
+        /**
+          * The constructor.
+          *
+          * @param op
+          *     The request being timed.
+          */
+        timer(op_t op);
+
+    private:
+        /**
+          * The op instance variable is used to remember which request
+          * is being timed.
+          */
+        op_t op;
+
+        /**
+          * The start instance variable is used to remember when the
+          * request started.
+          */
+        struct timespec start;
+
+        /**
+          * The default constructor.  Do not use.
+          */
+        timer();
+
+        /**
+          * The copy constructor.  Do not use.
+          */
+        timer(const timer &);
+
+        /**
+          * The assignment operator.  Do not use.
+          */
+        timer &operator=(const timer &);
+    };
+
+    /**
+      * The xattr_name class constant is the name of the extended
+      * attribute of the root directory which reports the statistics.
+      */
+    static const char xattr_name[];
+
+    /**
+      * The page_cache class method is used to count whether the kernel
+      * was allowed to keep a file's cached pages when it was opened.
+      *
+      * @param kept
+      *     true if the cached pages were kept, false if not.
+      */
+    static void page_cache(bool kept);
+
+    /**
+      * The getxattr class method is used to obtain the report, as the
+      * value of the #xattr_name extended attribute.
+      *
+      * @param buf
+      *     Where to put the value, or NULL if only its size is wanted.
+      * @param size
+      *     The size of the buffer.
+      * @returns
+      *     the size of the value, or -errno on error.
+      */
+    static int getxattr(char *buf, size_t size);
+
+    /**
+      * The setxattr class method is used to control the statistics, by
+      * setting the #xattr_name extended attribute.  The only value
+      * understood is "reset", which sets all of the statistics back to
+      * zero.
+      *
+      * @returns
+      *     zero on success, -errno on error.
+      */
+    static int setxattr(const char *value, size_t size);
+
+private:
+    /**
+      * The report class method is used to build the text of the
+      * report, one "name value" pair per line.
+      */
+    static rcstring report(void);
+
+    /**
+      * The reset class method is used to set all of the statistics
+      * back to zero.
+      */
+    static void reset(void);
+
+    /**
+      * The count class variable is used to remember how many of each
+      * request have been served.
+      */
+    static unsigned long count[op_max];
+
+    /**
+      * The total_us class variable is used to remember the total time
+      * spent serving each request, in microseconds.
+      */
+    static unsigned long total_us[op_max];
+
+    /**
+      * The max_us class variable is used to remember the longest time
+      * spent serving each request, in microseconds.
+      */
+    static unsigned long max_us[op_max];
+
+    /**
+      * The kept class variable is used to remember how many opens let
+      * the kernel keep its cached pages.
+      */
+    static unsigned long kept;
+
+    /**
+      * The dropped class variable is used to remember how many opens
+      * made the kernel drop its cached pages.
+      */
+    static unsigned long dropped;
+
+    /**
+      * The since class variable is used to remember when the statistics
+      * were last reset.
+      */
+    static time_t since;
+
+    /**
+      * The default constructor.  Do not use.
+      */
+    op_stats();
+
+    /**
+      * The copy constructor.  Do not use.
+      */
+    op_stats(const op_stats &);
+
+    /**
+      * The assignment operator.  Do not use.
+      */
+    op_stats &operator=(const op_stats &);
+};
+
+#endif // UCSDPSYS_MOUNT_OP_STATS_H
@@ -0,0 +1,315 @@
+//
+// UCSD p-System filesystem in user space
+// Copyright (C) 2026 Peter Miller
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or (at
+// you option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program. If not, see <http://www.gnu.org/licenses/>
+//
+
+#include <lib/config.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include <libexplain/output.h>
+#include <libexplain/program_name.h>
+#include <map>
+#include <sys/xattr.h>
+#include <unistd.h>
+#include <vector>
+
+#include <lib/rcstring.h>
+#include <lib/version.h>
+
+
+//
+// The name of the extended attribute of the mount point which holds
+// the statistics.  See ucsdpsys_mount/op_stats.h
+//
+static const char xattr_name[] = "user.ucsdpsys.stats";
+
+typedef std::map<rcstring, unsigned long> values_t;
+
+
+static void
+usage(void)
+{
+    const char *prog = explain_program_name_get();
+    fprintf(stderr, "Usage: %s [ <option>... ] <mount-point>\n", prog);
+    fprintf(stderr, "       %s -V\n", prog);
+    exit(1);
+}
+
+
+/**
+  * The read_values function is used to obtain the statistics of a
+  * running ucsdpsys_mount, and split them into name and value pairs.
+  *
+  * @param mount_point
+  *     The directory the disk image is mounted on.
+  * @param values
+  *     Where to put the statistics.
+  */
+static void
+read_values(const rcstring &mount_point, values_t &values)
+{
+    //
+    // The value grows a little from one moment to the next, so ask
+    // for it with a generous buffer, rather than asking for its size
+    // first.
+    //
+    std::vector<char> buf(1 << 16);
+    ssize_t n =
+        getxattr(mount_point.c_str(), xattr_name, &buf[0], buf.size());
+    if (n < 0)
+    {
+        int err = errno;
+        if (err == ENODATA || err == ENOTSUP)
+        {
+            explain_output_error_and_die
+            (
+                "%s: not a ucsdpsys_mount mount point",
+                mount_point.c_str()
+            );
+        }
+        explain_output_error_and_die
+        (
+            "getxattr %s: %s",
+            mount_point.c_str(),
+            strerror(err)
+        );
+    }
+
+    //
+    // Each line is a name and a value, separated by a space.
+    //
+    values.clear();
+    const char *cp = &buf[0];
+    const char *end = cp + n;
+    while (cp < end)
+    {
+        const char *eol = (const char *)memchr(cp, '\n', end - cp);
+        if (!eol)
+            eol = end;
+        const char *sp = (const char *)memchr(cp, ' ', eol - cp);
+        if (sp)
+        {
+            rcstring name(cp, sp - cp);
+            rcstring value(sp + 1, eol - sp - 1);
+            values[name] = strtoul(value.c_str(), 0, 10);
+        }
+        cp = eol + 1;
+    }
+}
+
+
+/**
+  * The reset function is used to set the statistics of a running
+  * ucsdpsys_mount back to zero.
+  */
+static void
+reset(const rcstring &mount_point)
+{
+    static const char value[] = "reset";
+    if
+    (
+        setxattr
+        (
+            mount_point.c_str(),
+            xattr_name,
+            value,
+            sizeof(value) - 1,
+            0
+        )
+    <
+        0
+    )
+    {
+        explain_output_error_and_die
+        (
+            "setxattr %s: %s",
+            mount_point.c_str(),
+            strerror(errno)
+        );
+    }
+}
+
+
+static unsigned long
+get(const values_t &values, const char *name)
+{
+    values_t::const_iterator it = values.find(name);
+    return (it == values.end() ? 0 : it->second);
+}
+
+
+static double
+percent(unsigned long part, unsigned long whole)
+{
+    return (whole ? 100. * part / whole : 0.);
+}
+
+
+/**
+  * The print_report function is used to print the statistics in a
+  * form suitable for humans.
+  *
+  * @param values
+  *     The statistics to print.
+  * @param before
+  *     The statistics at the start of the interval, or NULL to print
+  *     the totals since the statistics were last reset.
+  */
+static void
+print_report(const values_t &values, const values_t *before)
+{
+    values_t v = values;
+    if (before)
+    {
+        for (values_t::iterator it = v.begin(); it != v.end(); ++it)
+        {
+            // The longest time is not a total, so leave it alone.
+            if (it->first.ends_with(".max_us"))
+                continue;
+            values_t::const_iterator bit = before->find(it->first);
+            if (bit != before->end() && bit->second <= it->second)
+                it->second -= bit->second;
+        }
+    }
+
+    printf("%-16s %10s %12s %10s %10s\n", "operation", "count",
+        "total ms", "avg us", "max us");
+    for (values_t::const_iterator it = v.begin(); it != v.end(); ++it)
+    {
+        if (!it->first.starts_with("op.") || !it->first.ends_with(".count"))
+            continue;
+        rcstring op = it->first.substring(3, it->first.size() - 9);
+        unsigned long count = it->second;
+        if (count == 0)
+            continue;
+        unsigned long total = get(v, ("op." + op + ".total_us").c_str());
+        unsigned long longest = get(v, ("op." + op + ".max_us").c_str());
+        printf
+        (
+            "%-16s %10lu %12.1f %10lu %10lu\n",
+            op.c_str(),
+            count,
+            total / 1000.,
+            total / count,
+            longest
+        );
+    }
+    printf("\n");
+
+    unsigned long kept = get(v, "page_cache.kept");
+    unsigned long dropped = get(v, "page_cache.dropped");
+    printf("page cache:     %lu kept, %lu dropped (%.1f%% kept)\n", kept,
+        dropped, percent(kept, kept + dropped));
+    unsigned long hits = get(v, "text_index.hits");
+    unsigned long misses = get(v, "text_index.misses");
+    printf("text index:     %lu hits, %lu misses (%.1f%% hits)\n", hits,
+        misses, percent(hits, hits + misses));
+    unsigned long syncs = get(v, "meta.syncs");
+    unsigned long avoided = get(v, "meta.syncs_avoided");
+    printf("directory:      %lu syncs, %lu writes avoided (%.1f%%)\n", syncs,
+        avoided, percent(avoided, syncs));
+    printf("relocations:    %lu extents, %lu bytes\n",
+        get(v, "relocate.extents"), get(v, "relocate.bytes"));
+    printf("image reads:    %lu, %lu bytes\n", get(v, "image.reads"),
+        get(v, "image.read_bytes"));
+    printf("image writes:   %lu, %lu bytes\n", get(v, "image.writes"),
+        get(v, "image.write_bytes"));
+    printf("image syncs:    %lu\n", get(v, "image.syncs"));
+}
+
+
+int
+main(int argc, char **argv)
+{
+    explain_program_name_set(argv[0]);
+    explain_option_hanging_indent_set(4);
+    int interval = 0;
+    bool raw = false;
+    bool zero = false;
+    for (;;)
+    {
+        static const struct option options[] =
+        {
+            { "interval", 1, 0, 'i' },
+            { "raw", 0, 0, 'r' },
+            { "reset", 0, 0, 'z' },
+            { "version", 0, 0, 'V' },
+            { 0, 0, 0, 0 }
+        };
+        int c = getopt_long(argc, argv, "i:rVz", options, 0);
+        if (c == EOF)
+            break;
+        switch (c)
+        {
+        case 'i':
+            interval = atoi(optarg);
+            if (interval < 1)
+                usage();
+            break;
+
+        case 'r':
+            raw = true;
+            break;
+
+        case 'V':
+            version_print();
+            return 0;
+
+        case 'z':
+            zero = true;
+            break;
+
+        default:
+            usage();
+        }
+    }
+    if (optind + 1 != argc)
+        usage();
+    rcstring mount_point(argv[optind]);
+
+    if (zero)
+    {
+        reset(mount_point);
+        return 0;
+    }
+
+    values_t values;
+    read_values(mount_point, values);
+    if (raw)
+    {
+        for (values_t::const_iterator it = values.begin();
+            it != values.end(); ++it)
+            printf("%s %lu\n", it->first.c_str(), it->second);
+        return 0;
+    }
+    if (!interval)
+    {
+        print_report(values, 0);
+        return 0;
+    }
+    for (;;)
+    {
+        sleep(interval);
+        values_t before = values;
+        read_values(mount_point, values);
+        print_report(values, &before);
+        printf("\n");
+        fflush(stdout);
+    }
+}
@@ -27,6 +27,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <utime.h>
+#include <vector>
 
 #include <lib/input/file.h>
 #include <lib/input/stdin.h>
@@ -52,6 +53,57 @@ static bool do_decode;
 static bool do_encode;
 static bool use_tabs = true;
 static bool nul_guarantee = true;
+static unsigned jobs = 1;
+
+
+static void
+decode_in_parallel(const input::pointer &in, const output::pointer &out)
+{
+    //
+    // The parallel decoder needs the whole file in memory.
+    //
+    std::vector<char> buffer;
+    long length = in->length();
+    if (length > 0)
+        buffer.reserve(length);
+    for (;;)
+    {
+        char data[1 << 16];
+        long n = in->read(data, sizeof(data));
+        if (n <= 0)
+            break;
+        buffer.insert(buffer.end(), data, data + n);
+    }
+    output_text_decode::decode_parallel
+    (
+        (buffer.empty() ? 0 : &buffer[0]),
+        buffer.size(),
+        out,
+        use_tabs,
+        jobs
+    );
+    out->flush();
+}
+
+
+static void
+translate(const input::pointer &in, output::pointer out)
+{
+    if (do_decode && jobs != 1)
+    {
+        decode_in_parallel(in, out);
+        return;
+    }
+    if (do_decode)
+        out = output_text_decode::create(out, use_tabs);
+    if (do_encode)
+        out = output_text_encode::create(out, use_tabs, nul_guarantee);
+
+    //
+    // Copy the input to the output.
+    //
+    out->write(in);
+}
 
 
 static void
@@ -91,17 +143,10 @@ insitu(const rcstring &ifn)
             break;
     }
 
-    output::pointer out = output_file::create(ofn);
-    if (do_decode)
-        out = output_text_decode::create(out, use_tabs);
-    if (do_encode)
-        out = output_text_encode::create(out, use_tabs, nul_guarantee);
-
-    //
-    // Copy the input to the output.
-    //
-    out->write(in);
-    out.reset();
+    {
+        output::pointer out = output_file::create(ofn);
+        translate(in, out);
+    }
 
     //
     // Now rename the new file over the top of the old file.
@@ -125,15 +170,7 @@ run(int argc, char **argv)
     {
         input::pointer in = input_stdin::create();
         output::pointer out = output_stdout::create();
-        if (do_decode)
-            out = output_text_decode::create(out, use_tabs);
-        if (do_encode)
-            out = output_text_encode::create(out, use_tabs, nul_guarantee);
-
-        //
-        // Copy the input to the output.
-        //
-        out->write(in);
+        translate(in, out);
     }
     else
     {
@@ -154,12 +191,13 @@ main(int argc, char **argv)
         {
             { "decode", 0, 0, 'd' },
             { "encode", 0, 0, 'e' },
+            { "jobs", 1, 0, 'j' },
             { "nul", 0, 0, 'N' },
             { "tabs", 0, 0, 't' },
             { "version", 0, 0, 'V' },
             { 0, 0, 0, 0 }
         };
-        int c = getopt_long(argc, argv, "deNtV", options, 0);
+        int c = getopt_long(argc, argv, "dej:NtV", options, 0);
         if (c == EOF)
             break;
         switch (c)
@@ -172,6 +210,10 @@ main(int argc, char **argv)
             do_encode = true;
             break;
 
+        case 'j':
+            jobs = atoi(optarg);
+            break;
+
         case 'N':
             nul_guarantee = false;
             break;